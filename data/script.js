@@ -0,0 +1,116 @@
+// WiFly485 Web界面脚本
+var WiFly485 = (function () {
+  function $(id) {
+    return document.getElementById(id);
+  }
+
+  function getJson(url, done) {
+    var xhr = new XMLHttpRequest();
+    xhr.open("GET", url);
+    xhr.onload = function () {
+      if (xhr.status === 200) {
+        done(JSON.parse(xhr.responseText));
+      } else {
+        done(null);
+      }
+    };
+    xhr.onerror = function () {
+      done(null);
+    };
+    xhr.send();
+  }
+
+  function fillList(el, obj) {
+    var html = "";
+    for (var key in obj) {
+      html += "<dt>" + key + "</dt><dd>" + obj[key] + "</dd>";
+    }
+    el.innerHTML = html;
+  }
+
+  function fillTable(el, header, rows) {
+    var html = "<tr><th>" + header.join("</th><th>") + "</th></tr>";
+    for (var i = 0; i < rows.length; i++) {
+      html += "<tr><td>" + rows[i].join("</td><td>") + "</td></tr>";
+    }
+    el.innerHTML = html;
+  }
+
+  function renderStatus(status) {
+    fillList($("device"), status.device);
+
+    var counters = [];
+    for (var name in status.counters) {
+      counters.push([name, status.counters[name]]);
+    }
+    fillTable($("counters"), ["名称", "值"], counters);
+
+    var trace = [];
+    for (var stage in status.trace.stages) {
+      var s = status.trace.stages[stage];
+      trace.push([stage, s.count, s.p50, s.p99, s.max]);
+    }
+    fillTable($("trace"), ["阶段", "次数", "p50", "p99", "最大"], trace);
+
+    if (status.scheduler) {
+      var tasks = [];
+      for (var j = 0; j < status.scheduler.tasks.length; j++) {
+        var t = status.scheduler.tasks[j];
+        tasks.push([t.name, t.runs, t.avg_us, t.max_us, t.overruns, t.deferrals]);
+      }
+      fillTable($("scheduler"), ["任务", "次数", "平均", "最长", "超时", "推迟"], tasks);
+    }
+  }
+
+  // 详细状态只在打开页面和点击刷新时读取，实时数据由 /events 推送
+  function refreshStatus() {
+    getJson("/api/status", function (status) {
+      if (status) {
+        renderStatus(status);
+      }
+    });
+  }
+
+  // 实时状态：服务器只推送变化的字段，合并后显示
+  function startLive() {
+    var live = {};
+    if (!window.EventSource) {
+      $("liveState").textContent = "浏览器不支持";
+      return;
+    }
+    var source = new EventSource("/events");
+    source.onopen = function () {
+      $("liveState").textContent = "已连接";
+    };
+    source.onerror = function () {
+      $("liveState").textContent = "重连中";
+    };
+    source.onmessage = function (event) {
+      var delta = JSON.parse(event.data);
+      for (var key in delta) {
+        live[key] = delta[key];
+      }
+      fillList($("live"), live);
+    };
+  }
+
+  function startStatus() {
+    $("refresh").onclick = refreshStatus;
+    refreshStatus();
+    startLive();
+  }
+
+  function loadConfig() {
+    getJson("/api/config", function (config) {
+      if (!config) {
+        $("network").innerHTML = '<dd class="error">无法读取配置</dd>';
+        return;
+      }
+      fillList($("network"), config.network);
+      fillList($("rs485"), config.rs485);
+      fillList($("deviceConfig"), config.device);
+    });
+  }
+
+  return { startStatus: startStatus, loadConfig: loadConfig };
+})();
@@ -0,0 +1,46 @@
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+
+#define BOOT_MAX_PHASES 12
+
+// 启动阶段计时
+// 每个阶段结束时调用mark()，记录距启动的时间 (millis()从SDK初始化开始计时，
+// 第一个阶段 "sdk" 是进入setup()之前ROM和SDK的初始化时间)
+struct BootPhase {
+  const char* name;
+  uint32_t endUs;       // 阶段结束时距启动的时间
+  uint32_t durationUs;
+};
+
+class BootProfiler {
+public:
+  BootProfiler();
+
+  // 在setup()开头调用
+  void begin();
+
+  // 记录一个阶段结束
+  void mark(const char* name);
+
+  // 启动完成：记录最后一个阶段并输出日志
+  void finish();
+
+  uint8_t getPhaseCount() { return phaseCount; }
+  const BootPhase& getPhase(uint8_t index) { return phases[index]; }
+  uint32_t getTotalUs() { return lastUs; }
+
+  // 以JSON对象输出各阶段 (状态接口使用)
+  void printJson(Print& out);
+
+private:
+  BootPhase phases[BOOT_MAX_PHASES];
+  uint8_t phaseCount;
+  uint32_t lastUs;
+};
+
+// 全局启动计时实例
+extern BootProfiler bootProfiler;
+
+#endif // BOOT_PROFILER_H
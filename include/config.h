@@ -20,15 +20,107 @@
 #define DEFAULT_DATA_BITS 8
 #define DEFAULT_PARITY 0  // 0: None, 1: Odd, 2: Even
 #define DEFAULT_STOP_BITS 1
+#define DEFAULT_REPLAY_TIMING false  // 默认不记录和重现帧内字节间隔
 
 // 设备配置默认值
 #define DEFAULT_MASTER_NAME "WiFly485_Master"
 #define DEFAULT_SLAVE_NAME "WiFly485_Slave"
 #define DEFAULT_MASTER_TCP_PORT 8888
 #define DEFAULT_SYNC_PORT 8889
+#define DEFAULT_MASTER_HOST "wifly485-master"  // 从设备连接的主设备主机名
+
+// RS485引脚定义
+#define RS485_DE_PIN 4  // GPIO4: 方向控制 (高电平发送，低电平接收)
+#define RS485_RX_PIN 3  // GPIO3: UART0接收，浅睡眠时起始位 (低电平) 唤醒CPU
+
+// 数据中继配置
+#define RS485_FRAME_BUFFER_SIZE 256       // 帧缓冲区大小 (Modbus RTU最大帧长)
+#define RS485_TIMING_MAX_GAPS 8           // 定时重现：每帧最多记录的字节间隔数 (超出部分连续发送)
+#define RS485_TIMING_UNITS_PER_CHAR 8     // 间隔的量化单位：1/8字符时间
+#define RS485_TIMING_MAX_TOTAL_US 20000   // 定时重现：每帧忙等重现的间隔总和上限 (超出部分连续发送)
+#define RS485_RX_BUFFER_SIZE 1024         // 串口接收缓冲区：115200下约88ms，覆盖最长的扇区擦除 (约50ms) 和升级时间片 (OTA_SLICE_BUDGET_US)
+#define ROUTER_LANE_BUFFER_SIZE 512       // 链路→总线每个优先级队列的大小 (按实际帧长保存，约30个8字节的轮询请求)
+#define TCP_RECONNECT_INTERVAL_MS 1000    // 从设备断线重连间隔
+#define TCP_REPLAY_BUFFER_SIZE 1024       // 重传缓冲区 (未确认的帧，重连后重发)
+#define TCP_REPLAY_MAX_AGE_MS 1000        // 超过该时间未确认的帧重连后不再重发
+#define TCP_ACK_DELAY_MS 20               // 没有反向数据时单独发送确认的延迟
+#define TCP_ACK_EVERY_FRAMES 4            // 或累计收到该数量的帧时立即确认
+#define TCP_BATCH_BUFFER_SIZE 512         // 聚合发送：一个数据包中合并的帧的最大总长
+#define TCP_BATCH_HOLD_CHARS 8            // 聚合等待的上限 (总线字符时间，约一个短帧在总线上的时间)
+#define TCP_BATCH_TARGET_FRAMES 4         // 按最近的帧间隔估计，最多等待凑齐该数量的帧
+#define TCP_PACKET_AIRTIME_US 200         // 估计每个WiFi数据包的固定空口开销 (信道竞争、前导码、MAC确认和协议头部)
+#define RESPONSE_TIMEOUT_ADDRESSES 16     // 从设备按从站地址估计应答时间，同时跟踪的地址数 (超出时替换最久未用的)
+#define RESPONSE_TIMEOUT_INITIAL_MS 500   // 还没有应答样本的地址的等待时间
+#define RESPONSE_TIMEOUT_MAX_MS 1000      // 等待时间 (含超时后的退避) 的上限
+#define RESPONSE_TIMEOUT_FLOOR_CHARS 8    // 估计值之上的最小余量：帧间隔再加该数量的字符时间
+
+// 流量捕获配置
+#define CAPTURE_FILE_PATH "/capture.bin"
+#define CAPTURE_FILE_SIZE 65536           // 捕获文件大小 (环形覆盖)
+#define CAPTURE_SEGMENT_SIZE 4096         // 文件按段循环写入，记录不跨段
+#define CAPTURE_RAM_BUFFER_SIZE 2048      // 热路径写入的内存环形缓冲区
+#define CAPTURE_FLUSH_THRESHOLD 512       // 缓冲数据达到该字节数时写入文件
+#define CAPTURE_FLUSH_INTERVAL_MS 1000    // 或距上次写入超过该时间
+
+// Web服务器配置
+#define WEB_SERVER_PORT 80
+#define WEB_RESPONSE_CHUNK_SIZE 512       // 流式响应的分块大小
+#define WEB_ASSET_MAX_STREAMS 4           // 同时分块发送的静态资源数 (浏览器并行加载)
+#define WEB_ASSET_CACHE_CONTROL "no-cache" // 浏览器缓存资源，每次用ETag验证 (固件更新后立即生效)
+#define WEB_EVENT_MAX_CLIENTS 2           // 状态推送 (/events) 的最大连接数
+#define WEB_EVENT_INTERVAL_MS 1000        // 状态推送的最小间隔 (速率上限)
+#define WEB_EVENT_KEEPALIVE_MS 15000      // 无变化时发送保活注释的间隔
+#define WEB_EVENT_BUFFER_SIZE 512         // 单个事件的格式化缓冲区
+
+// 固件升级 (OTA)
+#define OTA_TCP_PORT 8890                   // 接收固件映像的端口
+#define DEFAULT_OTA_PASSWORD ""             // 升级口令 (device.otaPassword)，为空时不开启升级端口
+#define OTA_NONCE_SIZE 16                   // 每次连接的随机挑战长度
+#define OTA_PAGE_SIZE 256                   // 每个时间片最多写入或读回的字节数 (闪存页)
+#define OTA_TIMEOUT_MS 10000                // 超过该时间没有收到数据时放弃本次升级
+#define OTA_RESTART_DELAY_MS 500            // 校验通过后等待回复发出再重启
+#define OTA_SLICE_BUDGET_US 60000           // 升级任务的单次预算：覆盖一次扇区擦除
+
+// 调度器配置
+#define SCHEDULER_MAX_TASKS 12
+#define SCHEDULER_SLICE_BUDGET_US 3000      // 每次循环后台任务的总预算
+#define SCHEDULER_DEFAULT_BUDGET_US 1000    // 后台任务的默认单次预算
+#define SCHEDULER_OVERRUN_PENALTY_LOOPS 8   // 超时后暂停的循环次数
+#define SCHEDULER_STATS_INTERVAL_MS 60000   // 调度统计日志间隔
+
+// 堆和栈统计
+#define STACK_LOOP_SIZE 4096                // 主循环 (cont) 栈大小，与核心的CONT_STACKSIZE一致
+#define STACK_SYS_PAINT_BYTES 1536          // 系统栈填充窗口，超出时高水位只报告窗口下界
+#define STACK_SYS_GUARD_BYTES 256           // 填充时在当前栈指针以下留出的保护区
+
+// WiFi连接配置
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 2000   // 快速连接 (缓存的BSSID/信道/租约) 超时后退回完整连接
+#define WIFI_LEASE_MAX_REUSE 8              // 缓存的DHCP租约最多连续复用的次数
+
+// 省电配置
+#define DEFAULT_POWER_MODE "modem"          // none / modem / light
+#define DEFAULT_MAX_WAKE_LATENCY_MS 200     // 省电允许增加的首字节时延上限
+#define POWER_BEACON_INTERVAL_MS 102        // AP信标间隔 (100 TU)，射频睡眠时按信标醒来接收缓存的数据
+#define POWER_MAX_LISTEN_INTERVAL 10        // SDK支持的最大监听间隔 (信标数)
+#define POWER_IDLE_HOLD_MS 500              // 转发一帧后保持唤醒的时间 (一次轮询事务中不睡眠)
+#define POWER_MIN_SLEEP_MS 3                // 短于该时间的空闲不进入睡眠
+
+// 主设备发现 (从设备)
+#define MASTER_MDNS_SERVICE "wifly485"      // 主设备发布的数据服务 (_wifly485._tcp)
+#define MASTER_MDNS_TIMEOUT_MS 1000         // mDNS查询超时 (查询期间阻塞主循环)
+#define MASTER_RESOLVE_RETRY_MS 5000        // 解析失败后再次查询的最小间隔 (主设备离线时限制组播)
+#define MASTER_CACHE_MAX_FAILURES 2         // 缓存的地址连续连接失败该次数后重新解析
+#define MASTER_CACHE_FILE_PATH "/master.bin"
+
+// RTC用户内存分配 (4字节块，0~31由OTA使用)
+#define RTC_WIFI_CACHE_OFFSET 32            // WiFi连接缓存，占10块
+#define RTC_BOOT_CONFIG_OFFSET 48           // 启动用配置缓存，占32块
+#define RTC_MASTER_CACHE_OFFSET 80          // 主设备地址缓存，占4块
 
 // 系统配置
 #define DEFAULT_CONFIG_FILE_PATH "/config.json"
+#define CONFIG_TEMP_FILE_PATH "/config.tmp"     // 写入中的新配置
+#define CONFIG_BACKUP_FILE_PATH "/config.bak"   // 上一次的配置 (配置文件损坏时使用)
 #define SPIFFS_MAX_SIZE 4096
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -3,7 +3,8 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <FS.h>
+#include "config.h"
+#include "file_system.h"
 
 // 配置结构体定义
 struct NetworkConfig {
@@ -20,6 +21,7 @@ struct RS485Config {
   uint8_t dataBits;
   uint8_t parity;
   uint8_t stopBits;
+  bool replayTiming;  // 记录总线帧内的字节间隔，远端发送时按原间隔重现 (主从两端需一致)
 };
 
 struct DeviceConfig {
@@ -27,6 +29,9 @@ struct DeviceConfig {
   String role;  // "master" or "slave"
   uint16_t tcpPort;
   uint16_t syncPort;
+  String powerMode;           // "none", "modem" 或 "light"
+  uint16_t maxWakeLatencyMs;  // 省电模式允许增加的首字节时延上限
+  String otaPassword;         // 固件升级口令，为空时不监听升级端口
 };
 
 class ConfigManager {
@@ -59,12 +64,26 @@ public:
   void setRS485Config(const RS485Config& config);
   void setDeviceConfig(const DeviceConfig& config);
   
+  // 将配置写入JSON文档 (配置文件和Web接口使用)，skipFlags中任一标志的字段不写入
+  void toJson(JsonDocument& doc, uint8_t skipFlags = 0);
+
+  // 与之前的配置比较，返回所有不同字段的标志 (CONFIG_FLAG_*，见config_schema.h)
+  uint8_t changedFlags(const NetworkConfig& network, const RS485Config& rs485, const DeviceConfig& device);
+  
   // 检查配置文件是否存在
   bool configFileExists();
   
-  // 删除配置文件
+  // 删除配置文件 (包括备份和临时文件)
   bool deleteConfigFile();
 
+  // 指定配置文件所在的文件系统 (默认FILE_SYSTEM，测试和基准测试使用)
+  void setFileSystem(FS& fs) { fileSystem = &fs; }
+
+  // 启动用配置缓存 (RTC内存)：热启动时不挂载文件系统即可得到上次使用的配置，
+  // 用于尽早启动串口桥接和WiFi；缓存无效时返回false，配置保持不变
+  bool loadCachedConfig();
+  bool saveCachedConfig();
+
 private:
   // 配置数据
   NetworkConfig networkConfig;
@@ -72,15 +91,19 @@ private:
   DeviceConfig deviceConfig;
   
   // 配置文件路径
-  const char* CONFIG_FILE_PATH = "/config.json";
+  const char* CONFIG_FILE_PATH = DEFAULT_CONFIG_FILE_PATH;
+
+  // 配置文件所在的文件系统
+  FS* fileSystem;
   
-  // SPIFFS相关操作
-  bool mountSPIFFS();
-  void unmountSPIFFS();
+  // 文件系统相关操作
+  bool mountFileSystem();
+  void unmountFileSystem();
   
   // 内部辅助函数
-  bool parseConfigFile();
+  bool parseConfigFile(const char* path);
   bool writeConfigFile();
+  String readFile(const char* path);
 };
 
 #endif // CONFIG_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include "config_manager.h"
+
+// 配置字段描述表
+// 每个配置字段在表中描述一次 (所在配置段、JSON键名、类型、取值范围)，
+// 解析、写入、验证、比较和Web接口都遍历这张表，增加字段只需要修改配置结构体和这张表
+
+// 配置段：对应配置文件中的一个JSON对象，也对应ConfigManager中的一个配置结构体
+enum ConfigSection : uint8_t {
+  CONFIG_SECTION_NETWORK = 0,
+  CONFIG_SECTION_RS485,
+  CONFIG_SECTION_DEVICE,
+  CONFIG_SECTION_COUNT
+};
+
+enum ConfigFieldType : uint8_t {
+  CONFIG_FIELD_STRING = 0,   // String，范围为长度
+  CONFIG_FIELD_IP,           // String形式的IPv4地址
+  CONFIG_FIELD_CHOICE,       // String，取值必须是choices中的一个
+  CONFIG_FIELD_BOOL,
+  CONFIG_FIELD_U8,
+  CONFIG_FIELD_U16,
+  CONFIG_FIELD_U32
+};
+
+// 字段标志
+enum ConfigFieldFlag : uint8_t {
+  CONFIG_FLAG_SECRET = 0x01,     // 不通过Web接口输出
+  CONFIG_FLAG_STATIC_IP = 0x02,  // 只在关闭DHCP时验证
+  CONFIG_FLAG_WIFI = 0x04,       // 改变后需要重新连接WiFi
+  CONFIG_FLAG_BRIDGE = 0x08      // 改变后需要重新启动串口桥接
+};
+
+struct ConfigField {
+  ConfigSection section;
+  const char* key;
+  ConfigFieldType type;
+  uint8_t flags;
+  uint16_t offset;           // 字段在配置结构体中的偏移
+  uint32_t minValue;         // 数值范围，字符串类型为长度范围
+  uint32_t maxValue;
+  const char* const* choices;  // CONFIG_FIELD_CHOICE的可选值，以nullptr结尾
+};
+
+inline constexpr const char* CONFIG_SECTION_NAMES[CONFIG_SECTION_COUNT] = {"network", "rs485", "device"};
+inline constexpr const char* CONFIG_ROLE_CHOICES[] = {"master", "slave", nullptr};
+inline constexpr const char* CONFIG_POWER_CHOICES[] = {"none", "modem", "light", nullptr};
+
+inline constexpr ConfigField CONFIG_FIELDS[] = {
+  {CONFIG_SECTION_NETWORK, "ssid", CONFIG_FIELD_STRING, CONFIG_FLAG_WIFI,
+   offsetof(NetworkConfig, ssid), 1, 32, nullptr},
+  {CONFIG_SECTION_NETWORK, "password", CONFIG_FIELD_STRING, CONFIG_FLAG_SECRET | CONFIG_FLAG_WIFI,
+   offsetof(NetworkConfig, password), 1, 64, nullptr},
+  {CONFIG_SECTION_NETWORK, "dhcpEnabled", CONFIG_FIELD_BOOL, CONFIG_FLAG_WIFI,
+   offsetof(NetworkConfig, dhcpEnabled), 0, 1, nullptr},
+  {CONFIG_SECTION_NETWORK, "ip", CONFIG_FIELD_IP, CONFIG_FLAG_STATIC_IP | CONFIG_FLAG_WIFI,
+   offsetof(NetworkConfig, ip), 0, 0, nullptr},
+  {CONFIG_SECTION_NETWORK, "gateway", CONFIG_FIELD_IP, CONFIG_FLAG_STATIC_IP | CONFIG_FLAG_WIFI,
+   offsetof(NetworkConfig, gateway), 0, 0, nullptr},
+  {CONFIG_SECTION_NETWORK, "subnet", CONFIG_FIELD_IP, CONFIG_FLAG_STATIC_IP | CONFIG_FLAG_WIFI,
+   offsetof(NetworkConfig, subnet), 0, 0, nullptr},
+
+  {CONFIG_SECTION_RS485, "baudRate", CONFIG_FIELD_U32, CONFIG_FLAG_BRIDGE,
+   offsetof(RS485Config, baudRate), 1200, 115200, nullptr},
+  {CONFIG_SECTION_RS485, "dataBits", CONFIG_FIELD_U8, CONFIG_FLAG_BRIDGE,
+   offsetof(RS485Config, dataBits), 5, 8, nullptr},
+  {CONFIG_SECTION_RS485, "parity", CONFIG_FIELD_U8, CONFIG_FLAG_BRIDGE,
+   offsetof(RS485Config, parity), 0, 2, nullptr},
+  {CONFIG_SECTION_RS485, "stopBits", CONFIG_FIELD_U8, CONFIG_FLAG_BRIDGE,
+   offsetof(RS485Config, stopBits), 1, 2, nullptr},
+  {CONFIG_SECTION_RS485, "replayTiming", CONFIG_FIELD_BOOL, CONFIG_FLAG_BRIDGE,
+   offsetof(RS485Config, replayTiming), 0, 1, nullptr},
+
+  {CONFIG_SECTION_DEVICE, "name", CONFIG_FIELD_STRING, 0,
+   offsetof(DeviceConfig, name), 1, 32, nullptr},
+  {CONFIG_SECTION_DEVICE, "role", CONFIG_FIELD_CHOICE, 0,
+   offsetof(DeviceConfig, role), 0, 0, CONFIG_ROLE_CHOICES},
+  {CONFIG_SECTION_DEVICE, "tcpPort", CONFIG_FIELD_U16, CONFIG_FLAG_BRIDGE,
+   offsetof(DeviceConfig, tcpPort), 0, 65535, nullptr},
+  {CONFIG_SECTION_DEVICE, "syncPort", CONFIG_FIELD_U16, 0,
+   offsetof(DeviceConfig, syncPort), 0, 65535, nullptr},
+  {CONFIG_SECTION_DEVICE, "powerMode", CONFIG_FIELD_CHOICE, 0,
+   offsetof(DeviceConfig, powerMode), 0, 0, CONFIG_POWER_CHOICES},
+  {CONFIG_SECTION_DEVICE, "maxWakeLatencyMs", CONFIG_FIELD_U16, 0,
+   offsetof(DeviceConfig, maxWakeLatencyMs), 0, POWER_BEACON_INTERVAL_MS * POWER_MAX_LISTEN_INTERVAL, nullptr},
+  {CONFIG_SECTION_DEVICE, "otaPassword", CONFIG_FIELD_STRING, CONFIG_FLAG_SECRET,
+   offsetof(DeviceConfig, otaPassword), 0, 64, nullptr},
+};
+
+inline constexpr uint8_t CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+
+// 比较结果以字段位图表示
+static_assert(CONFIG_FIELD_COUNT <= 32, "配置字段超过32个");
+
+// 以下函数的sections参数是每个配置段对应的配置结构体，按ConfigSection编号
+
+// 从JSON文档读取所有字段；文档中没有的字段保持原值。
+// 数值超出字段范围 (或不是非负整数) 时该字段保持原值并返回false
+bool configFromJson(JsonVariantConst root, void* const sections[]);
+
+// 将所有字段写入JSON文档，skipFlags中任一标志的字段不写入 (如CONFIG_FLAG_SECRET)
+void configToJson(JsonDocument& doc, const void* const sections[], uint8_t skipFlags = 0);
+
+// 验证单个字段，失败时返回false
+bool configValidateField(const ConfigField& field, const void* section);
+
+// 比较两组配置，返回不同字段的位图 (第i位对应CONFIG_FIELDS[i])
+uint32_t configDiff(const void* const a[], const void* const b[]);
+
+// 位图中所有字段的标志之和
+uint8_t configDiffFlags(uint32_t changed);
+
+#endif // CONFIG_SCHEMA_H
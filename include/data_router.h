@@ -0,0 +1,107 @@
+#ifndef DATA_ROUTER_H
+#define DATA_ROUTER_H
+
+#include <Arduino.h>
+#include "frame_queue.h"
+#include "modbus.h"
+#include "response_timeout.h"
+#include "rs485.h"
+#include "tcp_protocol.h"
+#include "traffic_capture.h"
+
+// 数据路由器：在RS485总线和主从TCP连接之间透明转发帧
+// 主设备和从设备使用相同的转发逻辑；从设备另外按应答超时估计等待总线应答 (见 response_timeout.h)
+//
+// 优先级：链路收到的帧按功能码 (modbusClassify) 分入两个队列，总线空闲时先发送高优先级队列 (写命令、异常应答)，
+// 排队的轮询不会推迟控制器的设定和开关命令；总线→链路方向的高优先级帧不等待聚合。
+// 每个循环取出链路中所有已到达的帧，队列满时其后的帧留在链路的接收缓冲区 (TCP流量控制)
+class DataRouter {
+public:
+  DataRouter();
+  ~DataRouter();
+
+  // 初始化
+  bool begin(RS485* bus, TcpProtocol* link);
+
+  // 设置流量捕获 (nullptr表示不捕获)
+  void setCapture(TrafficCapture* capture) { this->capture = capture; }
+
+  // 设置应答超时估计 (nullptr表示不等待应答，主设备使用)
+  // 设置后发到总线的单播请求等待同一地址的应答或超时，之后才发送下一个请求
+  void setResponseTimeouts(ResponseTimeouts* timeouts);
+
+  // 正在等待应答的从站地址 (0表示没有)
+  uint8_t getAwaitingAddress() { return awaitingAddress; }
+
+  // 转发一轮：总线→网络，网络→总线 (每次主循环调用)
+  void loop();
+
+  // 统计信息
+  uint32_t getBusToLinkFrames() { return busToLinkFrames; }
+  uint32_t getLinkToBusFrames() { return linkToBusFrames; }
+  uint32_t getDroppedFrames() { return droppedFrames; }
+
+  // 没有等待发送到总线的帧，总线上也没有正在接收的帧
+  bool isIdle() { return !hasPendingFrame && lanesEmpty() && (bus == nullptr || bus->isBusIdle()); }
+
+  // 等待发送到总线的帧数
+  uint16_t getQueuedFrames(ModbusPriority priority) { return lanes[priority].getFrames(); }
+
+  // 最近一次转发帧的时间 (millis)
+  uint32_t getLastActivityMs() { return lastActivityMs; }
+
+private:
+  RS485* bus;
+  TcpProtocol* link;
+  TrafficCapture* capture;
+
+  // 总线上收到的帧
+  RS485Frame busFrame;
+
+  // 从链路取出、还没有放入队列的帧 (对应的队列已满)
+  RS485Frame pendingFrame;
+  bool hasPendingFrame;
+
+  // 等待总线空闲后发送的帧，按ModbusPriority分队列
+  FrameQueue lanes[2];
+  RS485Frame txFrame;
+
+  // 帧追踪：等待应答的发送时间 (0表示没有)
+  uint32_t linkSentAt;
+  uint32_t busSentAt;
+
+  // 等待总线应答：请求的地址、请求发送完成的时间和等待时间
+  ResponseTimeouts* responseTimeouts;
+  uint8_t awaitingAddress;
+  uint32_t awaitingSince;
+  uint32_t awaitingTimeoutUs;
+  uint8_t lateAddress;   // 最近一次超时的地址，它的应答迟到时仍作为样本
+
+  // 统计
+  uint32_t busToLinkFrames;
+  uint32_t linkToBusFrames;
+  uint32_t droppedFrames;
+  uint32_t lastActivityMs;
+
+  // 记录最近一次和启动后第一次转发的时间
+  void markForwarded();
+
+  bool lanesEmpty() { return lanes[MODBUS_PRIORITY_HIGH].isEmpty() && lanes[MODBUS_PRIORITY_NORMAL].isEmpty(); }
+
+  // 把链路中已到达的帧放入对应优先级的队列
+  void receiveFromLink();
+
+  // 发送一帧到总线：高优先级队列优先
+  void sendToBus();
+
+  // 发到总线的请求开始等待应答 (广播和无法识别的帧不等待)
+  void awaitResponse(const RS485Frame& request);
+
+  // 总线上收到的帧是否是等待中 (或刚超时) 的应答
+  void matchResponse(const RS485Frame& frame);
+
+  // 等待超时时放弃
+  void checkResponseTimeout();
+};
+
+#endif // DATA_ROUTER_H
\ No newline at end of file
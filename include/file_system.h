@@ -0,0 +1,18 @@
+#ifndef FILE_SYSTEM_H
+#define FILE_SYSTEM_H
+
+// 文件系统后端选择
+// 默认使用SPIFFS；定义WIFLY485_LITTLEFS时使用LittleFS (platformio.ini中需同时设置
+// board_build.filesystem = littlefs，两者的分区格式不兼容)。
+// 两者都实现fs::FS接口，上层只通过FILE_SYSTEM访问
+#ifdef WIFLY485_LITTLEFS
+#include <LittleFS.h>
+#define FILE_SYSTEM LittleFS
+#define FILE_SYSTEM_NAME "LittleFS"
+#else
+#include <FS.h>
+#define FILE_SYSTEM SPIFFS
+#define FILE_SYSTEM_NAME "SPIFFS"
+#endif
+
+#endif // FILE_SYSTEM_H
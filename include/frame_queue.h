@@ -0,0 +1,39 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "rs485.h"
+
+// 等待发送到总线的帧队列 (一个优先级)
+// 按到达顺序保存在环形缓冲区中，每项只占帧的实际长度：
+// [帧长 2][间隔记录长度 1][首字节时间 4][末字节时间 4][帧][间隔记录]
+#define FRAME_QUEUE_ENTRY_HEADER 11
+
+class FrameQueue {
+public:
+  FrameQueue();
+
+  // 加入队尾，空间不足时返回false (帧保持不变)
+  bool push(const RS485Frame& frame);
+
+  // 取出队首
+  bool pop(RS485Frame& frame);
+
+  void clear();
+
+  bool isEmpty() { return frames == 0; }
+  uint16_t getFrames() { return frames; }
+  uint16_t getUsedBytes() { return used; }
+
+private:
+  uint8_t buffer[ROUTER_LANE_BUFFER_SIZE];
+  uint16_t head;
+  uint16_t used;
+  uint16_t frames;
+
+  void ringWrite(uint16_t offset, const uint8_t* data, uint16_t length);
+  void ringRead(uint16_t offset, uint8_t* data, uint16_t length);
+};
+
+#endif // FRAME_QUEUE_H
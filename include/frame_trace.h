@@ -0,0 +1,106 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <Arduino.h>
+
+// 帧时延追踪：在转发流水线的每个阶段记录耗时，按阶段累计到固定桶的直方图
+// 编译时定义 WIFLY485_TRACE 启用；未定义时下面的宏全部展开为空操作
+//
+// 直方图按2的幂分桶：桶0为 [0, 2)us，桶i为 [2^i, 2^(i+1))us，最后一个桶包含所有更大的值
+#define TRACE_BUCKET_COUNT 24
+#define TRACE_SUMMARY_INTERVAL_MS 60000   // 通过Logger输出摘要的间隔
+
+// 流水线阶段 (时间均为本机micros()，主从设备时钟不同步，因此跨设备的时延以往返形式测量)
+enum TraceStage {
+  TRACE_UART_RX = 0,       // 总线帧首字节 → 末字节 (帧在线路上的时间)
+  TRACE_FRAMING,           // 末字节 → 帧间隔检测完成
+  TRACE_TCP_SEND,          // 帧完成 → TCP写入返回
+  TRACE_TCP_RECV,          // 数据包首字节 → 数据包接收完成
+  TRACE_BUS_WAIT,          // 数据包接收完成 → 总线空闲开始发送
+  TRACE_BUS_SEND,          // 开始发送 → 发送完成 (含方向切换)
+  TRACE_LINK_RTT,          // 向对端发出一帧 → 收到对端的下一帧 (两次空中传输 + 对端总线往返)
+  TRACE_BUS_TURNAROUND,    // 向总线发出一帧 → 总线上收到应答首字节
+  TRACE_WAKE,              // 浅睡眠空闲中UART RX唤醒中断 → 主循环恢复运行
+  TRACE_GAP_JITTER,        // 定时重现：一段字节的计划开始时间 → 实际写入 (字节间隔的重现误差)
+  TRACE_OTA_SLICE,         // 固件升级的一个时间片 (一次闪存操作)，即升级给转发增加的最大等待
+  TRACE_BATCH_HOLD,        // 聚合发送：一个数据包中最早的帧交给链路 → 数据包写入 (聚合增加的时延)
+  TRACE_BUS_WAIT_PRIORITY, // 高优先级的帧 (写命令、异常应答) 的 bus_wait
+  TRACE_STAGE_COUNT
+};
+
+// 主设备上 link_rtt 是请求经WiFi、从设备和新风设备返回的完整远端往返；
+// 从设备上 bus_turnaround 是新风设备的应答时间，两者之差即空中和中继本身的开销
+
+// 一个阶段的直方图
+// 每个阶段只由一个执行上下文写入 (单写者)，计数器为对齐的32位volatile变量，
+// ESP8266上32位读写是原子的，因此中断和状态接口读取时都不需要加锁；
+// 读取到的各个桶之间可能相差正在进行的一次记录
+struct TraceHistogram {
+  volatile uint32_t buckets[TRACE_BUCKET_COUNT];
+  volatile uint32_t count;
+  volatile uint32_t maxUs;
+};
+
+class FrameTrace {
+public:
+  FrameTrace();
+
+  // 记录一个阶段的耗时 (可在中断中调用)
+  inline void IRAM_ATTR record(TraceStage stage, uint32_t us) {
+    TraceHistogram& h = histograms[stage];
+    h.buckets[bucketOf(us)]++;
+    h.count++;
+    if (us > h.maxUs) {
+      h.maxUs = us;
+    }
+  }
+
+  // 清空所有直方图
+  void reset();
+
+  // 统计信息
+  uint32_t getCount(TraceStage stage) { return histograms[stage].count; }
+  uint32_t getMaxUs(TraceStage stage) { return histograms[stage].maxUs; }
+
+  // 百分位数的估计值：所在桶的上界 (us)
+  uint32_t getPercentileUs(TraceStage stage, uint8_t percentile);
+
+  // 以JSON对象输出所有阶段 (状态接口使用)
+  void printJson(Print& out);
+
+  // 通过Logger输出每个阶段的摘要
+  void logSummary();
+
+  // 按间隔输出摘要 (主循环调用)
+  void loop();
+
+  static const char* getStageName(TraceStage stage);
+
+  // 桶i的上界 (us)
+  static uint32_t bucketUpperUs(uint8_t bucket) {
+    return bucket >= 31 ? 0xFFFFFFFFUL : (2UL << bucket) - 1;
+  }
+
+private:
+  TraceHistogram histograms[TRACE_STAGE_COUNT];
+  uint32_t lastSummary;
+
+  static inline uint8_t bucketOf(uint32_t us) {
+    // 31 - clz(us) 即最高位的位置；Xtensa使用NSAU单条指令完成
+    uint8_t bucket = us < 2 ? 0 : (uint8_t)(31 - __builtin_clz(us));
+    return bucket < TRACE_BUCKET_COUNT ? bucket : TRACE_BUCKET_COUNT - 1;
+  }
+};
+
+// 全局追踪实例
+extern FrameTrace frameTrace;
+
+#ifdef WIFLY485_TRACE
+#define TRACE_NOW() micros()
+#define TRACE_STAGE(stage, us) frameTrace.record(stage, us)
+#else
+#define TRACE_NOW() 0UL
+#define TRACE_STAGE(stage, us) do { (void)(us); } while (0)
+#endif
+
+#endif // FRAME_TRACE_H
\ No newline at end of file
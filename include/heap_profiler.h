@@ -0,0 +1,93 @@
+#ifndef HEAP_PROFILER_H
+#define HEAP_PROFILER_H
+
+#include <Arduino.h>
+
+// 按模块统计堆占用和栈高水位
+//
+// 堆：进入和离开模块的作用域 (HEAP_SCOPE) 时读取可用堆，两次读取之差记到当前模块。
+// ESP8266的可用堆读取是O(1)的，每次循环经过几个作用域的开销可以忽略；碎片率需要遍历堆，
+// 只在模块的占用变化时读取。在一个模块中分配、在另一个模块中释放的内存 (如跨模块传递的String)
+// 会分别记到两个模块，因此单个模块的当前值可能为负，各模块之和仍等于启动以来的堆变化。
+// 作用域之外 (SDK回调、WiFi协议栈) 的变化记到system。
+//
+// 栈：主循环 (cont) 的栈由核心在启动时填充标记，ESP.getFreeContStack()扫描得到高水位；
+// 系统上下文 (SDK) 的栈没有标记，由一次系统定时器回调在当前栈指针以下填充一段窗口，
+// 之后扫描窗口中被改写的最低地址。使用量超过窗口时只能报告窗口下界 (saturated)
+enum HeapTag {
+  HEAP_TAG_SYSTEM = 0,   // 作用域之外：SDK、WiFi协议栈
+  HEAP_TAG_CONFIG,       // 配置文件加载和保存
+  HEAP_TAG_LOGGER,       // 日志和统计输出
+  HEAP_TAG_WEB,          // Web服务器和状态推送
+  HEAP_TAG_RELAY,        // 总线、主从链路和转发
+  HEAP_TAG_SYNC,         // 主设备发现：mDNS和地址缓存
+  HEAP_TAG_COUNT
+};
+
+struct HeapTagStats {
+  int32_t currentBytes;     // 启动以来的净分配
+  int32_t peakBytes;        // currentBytes的最大值
+  uint8_t fragmentation;    // 该模块最近一次改变占用后的堆碎片率 (%)
+  uint8_t maxFragmentation;
+};
+
+class HeapProfiler {
+public:
+  HeapProfiler();
+
+  // 在setup()开头调用：记录起始的可用堆并填充系统栈窗口
+  void begin();
+
+  // 进入模块，返回之前的模块 (由leave()恢复)
+  HeapTag enter(HeapTag tag);
+  void leave(HeapTag previous);
+
+  // 把上次读取以来的变化记到当前模块 (输出统计前调用)
+  void account();
+
+  const HeapTagStats& getStats(HeapTag tag) { return stats[tag]; }
+  HeapTag getCurrentTag() { return current; }
+
+  // 主循环栈的最大使用量 (字节)
+  uint32_t getLoopStackUsed();
+
+  // 系统栈的最大使用量 (字节，距系统栈顶)；saturated表示超出了填充窗口
+  uint32_t getSysStackUsed(bool& saturated);
+
+  // 清除栈高水位和各模块的峰值，从当前状态重新开始统计
+  void resetPeaks();
+
+  // 以JSON对象输出 (状态接口和测试程序使用)
+  void printJson(Print& out);
+
+  // 通过Logger输出每个模块的摘要
+  void logSummary();
+
+  static const char* getTagName(HeapTag tag);
+
+private:
+  HeapTagStats stats[HEAP_TAG_COUNT];
+  HeapTag current;
+  uint32_t lastFree;
+
+  void paintSysStack();
+};
+
+// 全局堆统计实例
+extern HeapProfiler heapProfiler;
+
+// 在作用域内把堆变化记到指定模块，可以嵌套
+class HeapScope {
+public:
+  explicit HeapScope(HeapTag tag) : previous(heapProfiler.enter(tag)) {}
+  ~HeapScope() { heapProfiler.leave(previous); }
+
+private:
+  HeapTag previous;
+};
+
+#define HEAP_SCOPE_NAME2(line) heapScope_##line
+#define HEAP_SCOPE_NAME(line) HEAP_SCOPE_NAME2(line)
+#define HEAP_SCOPE(tag) HeapScope HEAP_SCOPE_NAME(__LINE__)(tag)
+
+#endif // HEAP_PROFILER_H
@@ -18,8 +18,12 @@ public:
   Logger();
   ~Logger();
 
-  // 初始化日志系统
+  // 初始化日志系统 (默认输出到Serial)
   void begin();
+
+  // 初始化日志系统并输出到指定串口
+  // 中继固件的Serial (UART0) 用于RS485总线，日志必须改用Serial1 (GPIO2，仅发送)
+  void begin(HardwareSerial& port);
   
   // 设置日志级别
   void setLogLevel(LogLevel level);
@@ -39,6 +43,7 @@ public:
 
 private:
   LogLevel currentLogLevel;
+  Print* output;
   
   // 获取日志级别字符串
   const char* getLogLevelString(LogLevel level);
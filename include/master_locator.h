@@ -0,0 +1,66 @@
+#ifndef MASTER_LOCATOR_H
+#define MASTER_LOCATOR_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "file_system.h"
+
+// 上次连接成功的主设备地址，保存在RTC内存和文件系统中
+struct MasterAddressCache {
+  uint32_t ip;
+  uint16_t port;
+  uint16_t reserved;
+};
+
+// 从设备查找主设备
+// 主设备通过mDNS发布 _wifly485._tcp 服务。从设备直接连接上次成功的地址：
+// 热启动时从RTC内存读取，冷启动时从文件系统读取；没有缓存，或缓存的地址连续
+// MASTER_CACHE_MAX_FAILURES次连接失败时才查询mDNS (查询失败再用DNS解析主机名)。
+// 重新解析只由连接失败触发，不定时查询；WiFi未连接时不尝试连接，也不计为失败
+class MasterLocator {
+public:
+  MasterLocator();
+  ~MasterLocator();
+
+  // 设置主设备主机名，从RTC内存加载缓存的地址
+  void begin(const char* hostname);
+
+  // RTC内存中没有缓存时从文件系统加载 (文件系统挂载后调用)
+  void loadFileCache(FS& fs);
+
+  // 是否可以尝试连接 (WiFi已连接)
+  bool canConnect();
+
+  // 下一次连接使用的地址：缓存的地址优先，没有时解析 (阻塞，最长MASTER_MDNS_TIMEOUT_MS)；
+  // port传入默认端口，mDNS应答或缓存中有端口时替换；无法得到地址时返回false
+  bool resolve(IPAddress& ip, uint16_t& port);
+
+  // 连接结果和断线通知 (TcpProtocol调用)
+  void onConnected();
+  void onConnectFailed();
+  void onDisconnected();
+
+  bool hasAddress() { return hasCachedAddress; }
+  IPAddress getAddress() { return IPAddress(address.ip); }
+  uint16_t getPort() { return address.port; }
+
+private:
+  String hostname;
+  FS* fileSystem;
+  MasterAddressCache address;
+  MasterAddressCache fileAddress;  // 文件中的地址，相同时不重写
+  bool hasCachedAddress;
+  bool fromCache;                  // 地址未经本次解析 (计入缓存命中)
+  uint8_t failures;
+  uint32_t lostAt;                 // 断线 (或启动) 的时间，用于计算重连耗时
+  uint32_t lastResolveFailure;
+  bool resolveFailed;
+
+  bool queryMdns();
+  bool queryDns();
+  void saveCache();
+  void invalidateCache();
+};
+
+#endif // MASTER_LOCATOR_H
@@ -0,0 +1,111 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// 指标名前缀
+#define METRIC_PREFIX "wifly485_"
+
+// 运行计数器
+// 计数器在编译期固定编号，转发路径上只做一次32位加法；
+// 每个计数器只由一个执行上下文写入 (单写者)，对齐的32位读写在ESP8266上是原子的，
+// 因此可以在中断中递增，导出时也不需要加锁
+enum MetricId {
+  METRIC_BUS_RX_BYTES = 0,
+  METRIC_BUS_TX_BYTES,
+  METRIC_BUS_RX_FRAMES,
+  METRIC_BUS_TX_FRAMES,
+  METRIC_BUS_CRC_ERRORS,
+  METRIC_BUS_OVERRUNS,
+  METRIC_LINK_TX_BYTES,
+  METRIC_LINK_RX_BYTES,
+  METRIC_LINK_TX_FRAMES,
+  METRIC_LINK_RX_FRAMES,
+  METRIC_LINK_CONNECTS,
+  METRIC_LINK_PROTOCOL_ERRORS,
+  METRIC_ROUTER_DROPPED_FRAMES,
+  METRIC_CAPTURE_DROPPED_RECORDS,
+  METRIC_SCRAPES,
+  METRIC_MASTER_MDNS_QUERIES,
+  METRIC_MASTER_CACHE_CONNECTS,
+  METRIC_LINK_RESUMES,
+  METRIC_LINK_RETRANSMITS,
+  METRIC_LINK_DUPLICATES,
+  METRIC_LINK_REPLAY_DROPPED,
+  METRIC_POWER_SLEEPS,
+  METRIC_POWER_SLEEP_MS,
+  METRIC_POWER_UART_WAKES,
+  METRIC_BUS_TIMED_FRAMES,
+  METRIC_LINK_TX_PACKETS,
+  METRIC_LINK_BATCHED_FRAMES,
+  METRIC_LINK_AIRTIME_SAVED_US,
+  METRIC_BUS_RESPONSE_TIMEOUTS,
+  METRIC_BUS_LATE_RESPONSES,
+  METRIC_ROUTER_PRIORITY_FRAMES,
+  METRIC_ROUTER_PRIORITY_WAIT_US,
+  METRIC_ROUTER_NORMAL_FRAMES,
+  METRIC_ROUTER_NORMAL_WAIT_US,
+  METRIC_ROUTER_OVERTAKES,
+  METRIC_COUNT
+};
+
+// 状态量：启动过程中记录一次的时间等，导出时原样输出
+enum GaugeId {
+  GAUGE_WIFI_CONNECT_MS = 0,    // 启动到WiFi连接的时间
+  GAUGE_WIFI_FAST_CONNECT,      // 本次启动是否使用RTC缓存快速连接 (1/0)
+  GAUGE_FIRST_FORWARD_MS,       // 启动到第一次转发帧的时间 (0表示尚未转发)
+  GAUGE_BUS_READY_MS,           // 启动到串口桥接就绪 (总线和链路开始监听) 的时间
+  GAUGE_MASTER_RECONNECT_CACHED_MS,    // 从设备最近一次使用缓存地址连接主设备的耗时
+  GAUGE_MASTER_RECONNECT_RESOLVED_MS,  // 从设备最近一次重新解析地址后连接主设备的耗时
+  GAUGE_LINK_FAILOVER_MS,       // 最近一次断线到会话恢复 (断线期间的帧重发完成) 的时间
+  GAUGE_COUNT
+};
+
+// 计数器描述：Prometheus指标名 (不含前缀和 _total 后缀)、说明
+struct MetricDescriptor {
+  const char* name;
+  const char* help;
+};
+
+class Metrics {
+public:
+  Metrics();
+
+  // 递增计数器 (可在中断中调用)
+  inline void IRAM_ATTR add(MetricId id, uint32_t n = 1) {
+    values[id] += n;
+  }
+
+  uint32_t get(MetricId id) { return values[id]; }
+
+  void setGauge(GaugeId id, uint32_t value) { gauges[id] = value; }
+  uint32_t getGauge(GaugeId id) { return gauges[id]; }
+
+  // 清零所有计数器和状态量
+  void reset();
+
+  // 以Prometheus文本格式输出所有计数器和运行状态 (堆内存、运行时间等)
+  void writePrometheus(Print& out);
+
+  // 以JSON对象输出所有计数器 (状态接口使用)
+  void writeJson(Print& out);
+
+  // 记录一次导出的耗时，下一次导出时作为 scrape_duration 输出
+  void recordScrape(uint32_t us);
+
+  static const MetricDescriptor& getDescriptor(MetricId id);
+
+private:
+  volatile uint32_t values[METRIC_COUNT];
+  uint32_t gauges[GAUGE_COUNT];
+  volatile uint32_t lastScrapeUs;
+  volatile uint32_t maxScrapeUs;
+};
+
+// 全局计数器实例
+extern Metrics metrics;
+
+#define METRIC_ADD(id, n) metrics.add(id, n)
+#define METRIC_INC(id) metrics.add(id, 1)
+
+#endif // METRICS_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <Arduino.h>
+
+// Modbus RTU辅助函数
+// 中继本身透明转发，不解析帧内容；这些函数用于诊断、统计和测试
+
+// Modbus RTU帧长度限制
+#define MODBUS_MIN_FRAME_SIZE 4    // 地址 + 功能码 + CRC
+#define MODBUS_MAX_FRAME_SIZE 256
+
+// 计算Modbus CRC16 (多项式0xA001，初值0xFFFF)
+uint16_t modbusCrc16(const uint8_t* data, uint16_t length);
+
+// 检查帧末尾的CRC (低字节在前)
+bool modbusCheckCrc(const uint8_t* frame, uint16_t length);
+
+// 在帧末尾追加CRC，返回追加后的长度
+uint16_t modbusAppendCrc(uint8_t* frame, uint16_t length);
+
+// 开头第一段CRC正确的帧的长度 (不小于MODBUS_MIN_FRAME_SIZE)，没有时返回0
+uint16_t modbusFrameLength(const uint8_t* data, uint16_t length);
+
+// 转发优先级
+enum ModbusPriority {
+  MODBUS_PRIORITY_NORMAL = 0,   // 轮询读取等例行流量
+  MODBUS_PRIORITY_HIGH          // 写命令和异常应答
+};
+
+// 按功能码分类：写命令 (05/06/0F/10，以及16屏蔽写、17读写寄存器) 及其应答、异常应答 (功能码最高位为1)
+// 为高优先级，不能识别的帧为普通优先级。只看功能码，不检查CRC
+ModbusPriority modbusClassify(const uint8_t* frame, uint16_t length);
+
+#endif // MODBUS_H
\ No newline at end of file
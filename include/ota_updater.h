@@ -0,0 +1,122 @@
+#ifndef OTA_UPDATER_H
+#define OTA_UPDATER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <MD5Builder.h>
+#include "config.h"
+
+// 固件升级：通过独立的TCP端口接收固件映像，分散到调度器的多个时间片中写入闪存，升级期间总线继续转发
+//
+// 协议：客户端连接 OTA_TCP_PORT 后设备先发送一行 "AUTH <随机挑战的十六进制>"，客户端发送
+// [魔数 "WOTA"][映像长度 4][映像的MD5 16][认证码 16]，随后是映像本身。认证码是以升级口令为密钥、
+// 对 [随机挑战][映像的MD5] 计算的HMAC-MD5 (与ArduinoOTA的挑战应答相同，口令不在网络上传输)，
+// 不一致时在擦除闪存之前拒绝。设备校验完成后回复一行 "OK" 或 "ERR <原因>" 并关闭连接，
+// 成功时稍后重启进入新固件 (tools/ota_upload.py 是对应的发送工具)。没有设置口令时不监听升级端口。
+//
+// 每个时间片最多执行一次闪存操作：擦除一个扇区、写入一页或读回一页，中继任务在两次操作之间运行。
+// 每次只从连接中读取一页，TCP接收窗口让发送端按闪存写入的速度发送，不需要缓存整个映像。
+// 擦除扇区 (约数十毫秒) 是不能再拆分的最长操作，期间到达的总线字节保存在串口接收缓冲区中。
+// 映像写入当前固件之后的空闲区域，全部写完后从闪存读回计算MD5，与头部一致才写入引导程序的复制命令，
+// 重启时由引导程序复制到程序区；失败时当前固件不受影响
+#define OTA_HEADER_SIZE 40
+#define OTA_MAGIC "WOTA"
+
+enum OtaState {
+  OTA_IDLE = 0,     // 等待连接
+  OTA_HEADER,       // 接收头部
+  OTA_RECEIVING,    // 接收并写入映像
+  OTA_VERIFYING,    // 读回校验
+  OTA_DONE,         // 校验通过，等待重启
+  OTA_FAILED        // 最近一次升级失败 (可以重新连接)
+};
+
+class OtaUpdater {
+public:
+  OtaUpdater();
+  ~OtaUpdater();
+
+  // 在指定端口监听升级连接，连接需要用password认证；口令为空时不监听并返回false
+  bool begin(uint16_t port, const String& password);
+  void end();
+
+  // 运行一个时间片 (调度任务调用)
+  void loop();
+
+  OtaState getState() { return state; }
+
+  // 正在接收或校验
+  bool isActive() { return state == OTA_HEADER || state == OTA_RECEIVING || state == OTA_VERIFYING; }
+
+  // 校验通过并已回复，可以重启
+  bool isRestartDue() { return state == OTA_DONE && (millis() - doneAt) >= OTA_RESTART_DELAY_MS; }
+
+  // 统计信息
+  const char* getLastError() { return lastError; }
+  uint32_t getImageSize() { return imageSize; }
+  uint32_t getBytesWritten() { return written; }
+  uint32_t getRegionStart() { return regionStart; }
+  uint32_t getUpdates() { return updates; }
+  uint32_t getFailures() { return failures; }
+  uint32_t getMaxSliceUs() { return maxSliceUs; }
+  uint32_t getMaxEraseUs() { return maxEraseUs; }
+
+  // 以JSON对象输出升级状态 (状态接口使用)
+  void printJson(Print& out);
+
+  static const char* getStateName(OtaState state);
+
+  // HMAC-MD5 (RFC 2104)，认证码的计算方法
+  static void hmacMd5(const String& key, const uint8_t* message, size_t length, uint8_t digest[16]);
+
+private:
+  WiFiServer* server;
+  WiFiClient client;
+  String password;
+  uint8_t nonce[OTA_NONCE_SIZE];
+  OtaState state;
+  const char* lastError;
+
+  // 当前映像
+  uint8_t header[OTA_HEADER_SIZE];
+  uint8_t headerLength;
+  uint32_t imageSize;
+  uint8_t expectedMd5[16];
+  uint32_t regionStart;     // 映像写入的闪存地址
+  uint32_t written;         // 已写入闪存的字节数
+  uint32_t erased;          // 已擦除的字节数 (扇区对齐)
+  uint32_t verified;        // 已读回校验的字节数
+  uint32_t page[OTA_PAGE_SIZE / 4];
+  uint16_t pageLength;
+  MD5Builder md5;
+  uint32_t startedAt;
+  uint32_t lastDataAt;
+  uint32_t doneAt;
+
+  // 统计
+  uint32_t updates;
+  uint32_t failures;
+  uint32_t maxSliceUs;
+  uint32_t maxEraseUs;
+
+  void acceptClient();
+  void receiveHeader();
+
+  // 检查头部中的认证码
+  bool authenticate();
+  void receiveImage();
+  void verifyImage();
+
+  // 按映像长度选择写入区域，空间不足时返回false
+  bool allocateRegion();
+
+  // 写入引导程序的复制命令
+  bool commitImage();
+
+  void fail(const char* reason);
+};
+
+// 全局升级实例
+extern OtaUpdater otaUpdater;
+
+#endif // OTA_UPDATER_H
@@ -0,0 +1,61 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// 省电模式
+enum PowerMode : uint8_t {
+  POWER_MODE_NONE = 0,   // 射频和CPU始终唤醒，时延最低
+  POWER_MODE_MODEM,      // 射频在信标之间睡眠 (SDK默认)，CPU始终运行
+  POWER_MODE_LIGHT       // 射频睡眠，转发空闲时CPU也进入浅睡眠，UART RX起始位唤醒
+};
+
+// 省电管理
+// 射频睡眠时AP缓存发给本机的数据，每隔监听间隔个信标醒来接收一次，监听间隔按
+// maxWakeLatencyMs 计算；最大时延小于一个信标间隔时射频无法睡眠，退回 POWER_MODE_NONE。
+// 浅睡眠模式下主循环在转发空闲时等待 (最长到下一个定时任务或 maxWakeLatencyMs)，
+// SDK在等待期间使CPU进入浅睡眠；总线起始位将RX拉低时中断唤醒并立即结束等待。
+// 转发一帧后 POWER_IDLE_HOLD_MS 内不睡眠，同一次轮询事务的后续帧没有额外时延；
+// 唤醒需要时间，睡眠中到达的第一帧可能丢失开头的字节，由总线主站重试
+class PowerManager {
+public:
+  PowerManager();
+  ~PowerManager();
+
+  // 按配置设置省电模式 (mode为 "none"/"modem"/"light")
+  void begin(const String& mode, uint16_t maxWakeLatencyMs);
+
+  // 主循环在转发空闲时调用：lastActivityMs为最近一次转发的时间，idleMs为下一个定时任务到期前的时间
+  void idle(uint32_t lastActivityMs, uint32_t idleMs);
+
+  static PowerMode parseMode(const String& mode);
+  static const char* getModeName(PowerMode mode);
+
+  // 状态
+  PowerMode getMode() { return mode; }
+  uint16_t getMaxWakeLatencyMs() { return maxWakeLatencyMs; }
+  uint8_t getListenInterval() { return listenInterval; }
+  uint32_t getSleeps() { return sleeps; }
+  uint32_t getSleepMs() { return (uint32_t)(sleepUs / 1000); }
+  uint32_t getUartWakes() { return uartWakes; }
+
+private:
+  PowerMode mode;
+  uint16_t maxWakeLatencyMs;
+  uint8_t listenInterval;
+
+  // 统计
+  uint32_t sleeps;
+  uint64_t sleepUs;
+  uint32_t uartWakes;
+
+  // 中断记录的唤醒时间 (micros，0表示没有唤醒)
+  static volatile uint32_t wakeAt;
+  static void IRAM_ATTR onRxWake();
+};
+
+// 全局实例
+extern PowerManager powerManager;
+
+#endif // POWER_MANAGER_H
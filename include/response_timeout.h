@@ -0,0 +1,68 @@
+#ifndef RESPONSE_TIMEOUT_H
+#define RESPONSE_TIMEOUT_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "rs485.h"
+
+// 按从站地址估计总线应答时间 (从设备使用)
+//
+// 从设备把主设备转来的请求发到总线后等待该地址的应答，等待期间不发送下一个请求。
+// 应答时间 (请求发送完成到应答首字节) 按TCP估计重传超时的方法 (RFC 6298) 平滑：
+// SRTT = 7/8 SRTT + 1/8 R，RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|，
+// 等待时间 = SRTT + max(4 RTTVAR, 下限)。下限是一个帧间隔加 RESPONSE_TIMEOUT_FLOOR_CHARS 个字符时间，
+// 应答稳定的设备 (RTTVAR趋于0) 也保留组帧和设备处理的余量。
+// 超时后放弃等待，总线转向下一个请求，该地址的等待时间加倍 (不超过 RESPONSE_TIMEOUT_MAX_MS)，
+// 直到下一个应答样本重新计算。离线的设备只让各自的请求等待，不拖慢其他地址
+struct ResponseEstimate {
+  uint8_t address;       // 从站地址，0表示空闲表项
+  uint32_t srttUs;       // 平滑的应答时间
+  uint32_t rttvarUs;     // 应答时间的平均偏差
+  uint32_t timeoutUs;    // 当前的等待时间
+  uint32_t samples;
+  uint32_t timeouts;
+  uint32_t lastUsedMs;   // 表满时替换最久未用的表项
+};
+
+class ResponseTimeouts {
+public:
+  ResponseTimeouts();
+
+  // 按总线参数计算下限并清除所有估计 (波特率改变后应答时间不再可比)
+  void begin(const RS485Config& config);
+  void reset();
+
+  // 向该地址发出请求后的等待时间 (微秒)
+  uint32_t getTimeoutUs(uint8_t address);
+
+  // 收到应答：responseUs为请求发送完成到应答首字节的时间
+  void addSample(uint8_t address, uint32_t responseUs);
+
+  // 等待超时：退避
+  void onTimeout(uint8_t address);
+
+  uint32_t getFloorUs() { return floorUs; }
+
+  // 查找地址的估计，未跟踪时返回nullptr
+  const ResponseEstimate* find(uint8_t address);
+
+  // 以Prometheus文本格式输出每个地址的估计 (标签address)
+  void writePrometheus(Print& out);
+
+  // 以JSON数组输出 (状态接口使用)
+  void printJson(Print& out);
+
+private:
+  ResponseEstimate entries[RESPONSE_TIMEOUT_ADDRESSES];
+  uint32_t floorUs;
+
+  // 查找或分配表项
+  ResponseEstimate& lookup(uint8_t address);
+
+  void updateTimeout(ResponseEstimate& entry);
+};
+
+// 全局应答超时估计实例
+extern ResponseTimeouts responseTimeouts;
+
+#endif // RESPONSE_TIMEOUT_H
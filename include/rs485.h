@@ -0,0 +1,118 @@
+#ifndef RS485_H
+#define RS485_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "config_manager.h"
+
+// 字节间隔记录的最大长度：每个间隔2字节
+#define RS485_TIMING_MAX_SIZE (RS485_TIMING_MAX_GAPS * 2)
+
+// 一个完整的总线帧
+struct RS485Frame {
+  uint8_t data[RS485_FRAME_BUFFER_SIZE];
+  uint16_t length;
+  uint32_t firstByteTime;  // 首字节接收时间 (micros)
+  uint32_t lastByteTime;   // 末字节接收时间 (micros)
+  // 帧内字节间隔 (定时重现模式)：每项 [字节序号][该字节之前多出的静默时间，单位1/8字符时间]，
+  // 按序号递增排列，只记录超过半个字符时间的间隔；timingLength为0表示字节连续发送
+  uint8_t timing[RS485_TIMING_MAX_SIZE];
+  uint8_t timingLength;
+};
+
+// RS485半双工通信类
+// 按Modbus RTU的帧间静默时间(3.5个字符)组帧，不解析帧内容
+//
+// 主循环被阻塞超过一个帧间隔 (如固件升级擦除扇区) 时，期间到达的多帧在串口缓冲区中连在一起，
+// 无法再从到达时间判断边界：这样读到的字节组成的帧整体CRC不正确、而开头一段CRC正确时，
+// 在该处分开，其余字节作为下一帧 (只在积压时检查CRC，正常接收的帧仍然透明转发)
+//
+// 定时重现 (RS485Config::replayTiming)：接收时记录帧内超过半个字符时间的字节间隔，
+// 发送带间隔记录的帧时按原间隔分段发送，使远端总线上的字节时序与原始帧一致
+// (部分设备按字节间隔判断帧内结构或对连续字节的处理能力有限)
+class RS485 {
+public:
+  RS485();
+  ~RS485();
+
+  // 初始化：按配置打开硬件串口并开始接收
+  bool begin(HardwareSerial& serial, const RS485Config& config, int8_t dePin = RS485_DE_PIN);
+
+  // 初始化：使用任意Stream作为总线 (主机模拟器使用伪终端)，dePin为-1时不控制方向引脚
+  bool begin(Stream& stream, const RS485Config& config, int8_t dePin = -1);
+
+  // 更新串口参数并重新计算时间参数
+  void setConfig(const RS485Config& config);
+  RS485Config getConfig();
+
+  // 轮询串口接收并组帧，有完整帧等待读取时返回true
+  bool poll();
+
+  // 取出已完成的帧
+  bool readFrame(RS485Frame& frame);
+
+  // 发送一帧：切换到发送模式，发送完成后切回接收模式
+  // timing为帧的字节间隔记录，开启定时重现时按记录的间隔发送，否则连续发送
+  bool sendFrame(const uint8_t* data, uint16_t length, const uint8_t* timing = nullptr, uint8_t timingLength = 0);
+
+  // 总线空闲：没有正在接收的帧
+  bool isBusIdle();
+
+  // 时间参数 (微秒)
+  uint32_t getCharTimeUs();
+  uint32_t getFrameGapUs();
+  static uint32_t calcCharTimeUs(const RS485Config& config);
+  static uint32_t calcFrameGapUs(const RS485Config& config);
+
+  // 统计信息
+  uint32_t getRxFrames() { return rxFrames; }
+  uint32_t getTxFrames() { return txFrames; }
+  uint32_t getRxBytes() { return rxBytes; }
+  uint32_t getTxBytes() { return txBytes; }
+  uint32_t getOverruns() { return overruns; }
+  uint32_t getTimedFrames() { return timedFrames; }
+  uint32_t getTimingTruncated() { return timingTruncated; }
+  uint32_t getSplitFrames() { return splitFrames; }
+
+private:
+  Stream* port;
+  HardwareSerial* serial;
+  RS485Config config;
+  int8_t dePin;
+  uint32_t charTimeUs;
+  uint32_t frameGapUs;
+
+  // 接收状态
+  RS485Frame rxFrame;
+  bool frameReady;
+  bool frameOverflow;
+  uint32_t rxLastArrival;   // 上一个字节到达时间的估计值 (按字符时间回推，用于记录字节间隔)
+  bool timingOverflow;      // 当前帧的间隔超过RS485_TIMING_MAX_GAPS
+  uint32_t lastReadTime;    // 上一次读取串口的时间
+  bool rxBacklog;           // 当前帧含有距上一次读取超过一个帧间隔后积压的字节
+  uint16_t rxRemainder;     // 分开后留给下一帧的字节数 (位于rxFrame.length之后)
+
+  // 统计
+  uint32_t rxFrames;
+  uint32_t txFrames;
+  uint32_t rxBytes;
+  uint32_t txBytes;
+  uint32_t overruns;
+  uint32_t timedFrames;
+  uint32_t timingTruncated;
+  uint32_t splitFrames;
+
+  // 帧接收完成：积压的字节按Modbus帧边界分开
+  void completeFrame();
+
+  // 记录字节到达：计算与上一个字节之间多出的静默时间
+  void recordArrival(uint32_t arrival);
+
+  // 按字节间隔记录分段写入串口，返回写入的字节数
+  size_t writeTimed(const uint8_t* data, uint16_t length, const uint8_t* timing, uint8_t timingLength);
+
+  // 将RS485配置转换为ESP8266串口配置
+  static SerialConfig toSerialConfig(const RS485Config& config);
+};
+
+#endif // RS485_H
\ No newline at end of file
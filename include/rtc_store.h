@@ -0,0 +1,26 @@
+#ifndef RTC_STORE_H
+#define RTC_STORE_H
+
+#include <Arduino.h>
+
+// RTC用户内存中的缓存记录
+// RTC内存在软件复位、看门狗复位和深度睡眠后保留，断电后内容随机；
+// 每条记录以 [magic][crc32] 开头，读取时校验两者，任何一个不符都视为无效
+//
+// offset以4字节为单位 (0~127)。前32块 (128字节) 由OTA升级的eboot命令使用，不能占用
+
+// 计算CRC-32 (IEEE 802.3)
+uint32_t rtcCrc32(const void* data, size_t size, uint32_t crc = 0);
+
+// 读取记录，magic或CRC不符时返回false
+bool rtcLoad(uint32_t offset, uint32_t magic, void* data, size_t size);
+
+// 写入记录 (size不超过RTC_STORE_MAX_SIZE)
+bool rtcSave(uint32_t offset, uint32_t magic, const void* data, size_t size);
+
+// 使记录失效
+void rtcInvalidate(uint32_t offset);
+
+#define RTC_STORE_MAX_SIZE 120   // 单条记录的最大数据长度 (字节)
+
+#endif // RTC_STORE_H
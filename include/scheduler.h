@@ -0,0 +1,87 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// 协作式调度器
+// 所有模块在同一个Arduino loop()中运行，任何一个慢的处理函数都会推迟总线转发：
+//   - 实时任务 (中继) 在每次循环中运行，并且在每个后台任务之后再运行一次
+//   - 后台任务按优先级顺序运行，每次循环共享一个时间片预算，用完后其余任务推迟到下一次循环；
+//     第一个因时间片不足被推迟的任务在下一次循环中最先运行，预算大于时间片的任务 (如固件升级)
+//     不会被每次循环都到期的高优先级任务饿死
+//   - 后台任务单次运行超过自身预算记为一次超时，之后暂停若干次循环，把时间让给中继
+
+// 任务优先级 (数值越小越优先)
+enum TaskPriority {
+  TASK_PRIORITY_REALTIME = 0,   // 每次循环都运行，不受预算限制
+  TASK_PRIORITY_HIGH = 1,
+  TASK_PRIORITY_NORMAL = 2,
+  TASK_PRIORITY_LOW = 3
+};
+
+typedef void (*TaskFunction)(void* context);
+
+#define SCHEDULER_NO_TASK 0xFF
+
+// 任务及其运行统计
+struct SchedulerTask {
+  const char* name;
+  TaskFunction function;
+  void* context;
+  TaskPriority priority;
+  uint32_t intervalMs;     // 最小运行间隔，0表示每次循环
+  uint32_t budgetUs;       // 单次运行预算
+  uint32_t lastRunMs;
+  uint8_t penaltyLoops;    // 超时后剩余的暂停循环数
+
+  // 统计
+  uint32_t runs;
+  uint64_t totalUs;
+  uint32_t maxUs;
+  uint32_t overruns;       // 单次运行超过预算的次数
+  uint32_t deferrals;      // 到期但因时间片用完或超时暂停而推迟的次数
+};
+
+class Scheduler {
+public:
+  Scheduler();
+
+  // 添加任务，按优先级插入；返回任务编号，任务表已满时返回-1
+  int addTask(const char* name, TaskFunction function, void* context, TaskPriority priority,
+              uint32_t intervalMs = 0, uint32_t budgetUs = SCHEDULER_DEFAULT_BUDGET_US);
+
+  // 运行一次调度循环 (在Arduino loop()中调用)
+  void loop();
+
+  // 统计信息
+  uint8_t getTaskCount() { return taskCount; }
+  const SchedulerTask& getTask(uint8_t index) { return tasks[index]; }
+  uint32_t getLoops() { return loops; }
+  uint32_t getMaxLoopUs() { return maxLoopUs; }
+
+  // 下一个定时后台任务到期前的毫秒数 (每次循环都运行的任务不计)，没有定时任务时返回UINT32_MAX
+  uint32_t getIdleMs();
+
+  // 以JSON对象输出调度统计 (状态接口使用)
+  void printJson(Print& out);
+
+  // 通过Logger输出每个任务的统计
+  void logSummary();
+
+private:
+  SchedulerTask tasks[SCHEDULER_MAX_TASKS];
+  uint8_t taskCount;
+  uint8_t realtimeCount;   // 实时任务位于表头
+  uint8_t starvedTask;     // 上一次循环中第一个因时间片不足推迟的任务 (SCHEDULER_NO_TASK表示没有)
+  uint32_t loops;
+  uint32_t maxLoopUs;
+
+  void runTask(SchedulerTask& task);
+  void runRealtime();
+
+  // 运行到期的后台任务并在之后服务中继
+  void runBackground(SchedulerTask& task, uint32_t now);
+};
+
+#endif // SCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef STATUS_EVENTS_H
+#define STATUS_EVENTS_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "tcp_protocol.h"
+
+// 推送给Web界面的状态字段
+enum StatusField {
+  STATUS_LINK_UP = 0,          // 主从链路是否连接
+  STATUS_LINK_RTT_P50_US,      // 链路往返时延 (帧追踪LINK_RTT)
+  STATUS_LINK_RTT_P99_US,
+  STATUS_BUS_RX_BPS,           // 吞吐量 (字节/秒)
+  STATUS_BUS_TX_BPS,
+  STATUS_LINK_RX_BPS,
+  STATUS_LINK_TX_BPS,
+  STATUS_BUS_CRC_ERRORS,       // 错误计数器
+  STATUS_BUS_OVERRUNS,
+  STATUS_LINK_PROTOCOL_ERRORS,
+  STATUS_LINK_CONNECTS,
+  STATUS_ROUTER_DROPPED_FRAMES,
+  STATUS_HEAP_FREE,
+  STATUS_FIELD_COUNT
+};
+
+struct StatusSnapshot {
+  uint32_t values[STATUS_FIELD_COUNT];
+};
+
+// 通过Server-Sent Events推送状态增量
+//   - 每个连接只推送与上次发送相比变化的字段，新连接先收到一次完整状态
+//   - 采样和推送间隔不小于WEB_EVENT_INTERVAL_MS (速率上限)，无变化时只发送保活注释
+//   - 事件直接格式化到固定缓冲区，发送缓冲区空间不足时跳过本次，下次推送累积的变化
+class StatusEvents {
+public:
+  StatusEvents();
+  ~StatusEvents();
+
+  // 设置链路 (用于链路状态，可为nullptr)
+  void begin(TcpProtocol* link);
+
+  // 接管一个已发送响应头的事件流连接；连接数已满时返回false
+  bool addClient(WiFiClient& client);
+
+  // 采样并推送 (主循环调用)
+  void loop();
+
+  uint8_t getClientCount();
+  uint32_t getEventsSent() { return eventsSent; }
+  uint32_t getEventsSkipped() { return eventsSkipped; }
+
+  // 采样当前状态，吞吐量按距上次采样的时间计算
+  void sample(StatusSnapshot& snapshot);
+
+  // 把与previous不同的字段格式化为一个SSE事件 (previous为nullptr时输出全部字段)
+  // 返回事件长度，没有变化或缓冲区不足时返回0
+  static size_t formatDelta(const StatusSnapshot& current, const StatusSnapshot* previous, char* buffer, size_t size);
+
+  static const char* getFieldName(StatusField field);
+
+private:
+  struct EventClient {
+    WiFiClient client;
+    StatusSnapshot lastSent;
+    bool active;
+    bool sentFull;
+    uint32_t lastWriteMs;
+  };
+
+  TcpProtocol* link;
+  EventClient clients[WEB_EVENT_MAX_CLIENTS];
+  char buffer[WEB_EVENT_BUFFER_SIZE];
+
+  uint32_t lastSampleMs;
+  uint32_t lastBusRxBytes;
+  uint32_t lastBusTxBytes;
+  uint32_t lastLinkRxBytes;
+  uint32_t lastLinkTxBytes;
+
+  uint32_t eventsSent;
+  uint32_t eventsSkipped;
+
+  void push(EventClient& client, const StatusSnapshot& snapshot, uint32_t now);
+};
+
+#endif // STATUS_EVENTS_H
@@ -0,0 +1,214 @@
+#ifndef TCP_PROTOCOL_H
+#define TCP_PROTOCOL_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "master_locator.h"
+#include "rs485.h"
+
+// 主从设备之间的数据包格式：
+//   [魔数 0xA5][类型][长度低字节][长度高字节][负载...]
+// 多字节字段均为小端
+#define TCP_PACKET_MAGIC 0xA5
+#define TCP_PACKET_HEADER_SIZE 4
+
+// 数据包类型
+enum TcpPacketType {
+  TCP_PACKET_DATA = 0x01,       // [序号 2][确认号 2][一个完整的RS485帧]
+  TCP_PACKET_HEARTBEAT = 0x02,  // 心跳 (预留)
+  TCP_PACKET_HELLO = 0x03,      // 连接建立后双方各发送一次：[本端会话ID 4][上次连接的对端会话ID 4][确认号 2][下一个发送序号 2]
+  TCP_PACKET_ACK = 0x04,        // [确认号 2]，没有反向数据时单独确认
+  TCP_PACKET_DATA_TIMED = 0x05, // [序号 2][确认号 2][间隔记录长度 1][间隔记录][RS485帧]，帧内有字节间隔时代替DATA
+  TCP_PACKET_DATA_BATCH = 0x06  // [首帧序号 2][确认号 2][帧数 1]，之后每帧 [类型 1][长度 1][DATA或DATA_TIMED负载中确认号之后的部分]，序号依次加1
+};
+
+#define TCP_DATA_HEADER_SIZE 4      // 数据包负载中RS485帧之前的序号和确认号
+#define TCP_DATA_MAX_SIZE (1 + RS485_TIMING_MAX_SIZE + RS485_FRAME_BUFFER_SIZE)  // 序号和确认号之后的最大长度
+#define TCP_HELLO_SIZE 12
+#define TCP_ACK_SIZE 2
+#define TCP_BATCH_HEADER_SIZE 5     // 聚合数据包负载中第一帧之前的首帧序号、确认号和帧数
+#define TCP_BATCH_ENTRY_HEADER 2    // 每帧之前的类型和长度
+#define TCP_BATCH_MAX_ENTRY 255     // 更长的帧单独发送
+
+// 主从设备TCP通信协议
+// 主设备监听端口等待从设备连接，从设备主动连接并在断线后自动重连。
+//
+// 会话恢复：每个设备启动时生成随机的会话ID，每个方向的数据帧带16位序号，确认号是下一个
+// 期望接收的序号。已发送未确认的帧保存在重传缓冲区中；重新连接后双方交换HELLO，
+// 双方都没有重启 (会话ID与上次连接相同) 时恢复会话：对端未收到的帧从缓冲区重发，
+// 重复的帧由接收方按序号丢弃。任一方重启时开始新会话，丢弃缓冲区中上次连接的帧。
+// 超过TCP_REPLAY_MAX_AGE_MS的帧不再重发 (总线主站已超时重试，过期的请求不应再到达总线)
+//
+// 聚合发送：WiFi上每个数据包都有与长度无关的空口开销，总线繁忙时连续的短帧合并为一个DATA_BATCH。
+// 等待时间按最近的帧间隔自适应：预计预算内凑不到下一帧时 (轻负载) 立即发送，不增加时延；
+// 帧密集时最多等待凑齐TCP_BATCH_TARGET_FRAMES帧，且不超过预算 (由总线字符时间得出)。
+// 聚合只改变写入方式，每帧仍有自己的序号并单独保存在重传缓冲区中，恢复会话时逐帧重发
+class TcpProtocol {
+public:
+  TcpProtocol();
+  ~TcpProtocol();
+
+  // 主设备：在指定端口监听从设备连接
+  bool beginServer(uint16_t port);
+
+  // 从设备：连接主设备
+  bool beginClient(const String& host, uint16_t port);
+
+  // 从设备：通过locator取得主设备地址 (缓存优先，失败时重新解析)；未设置时按主机名连接
+  void setLocator(MasterLocator* locator) { this->locator = locator; }
+
+  // 是否在重连后恢复会话 (默认开启，主从两端需一致；关闭时每次连接都是新会话)
+  void setResumeEnabled(bool enabled) { resumeEnabled = enabled; }
+
+  // 关闭连接
+  void end();
+
+  // 维护连接：主设备接受新连接，从设备断线重连，发送延迟的确认
+  void loop();
+
+  // 是否已连接
+  bool isConnected();
+
+  // 聚合发送的等待预算 (微秒)，0表示不聚合 (默认)
+  void setBatchBudgetUs(uint32_t budgetUs);
+  uint32_t getBatchBudgetUs() { return batchBudgetUs; }
+
+  // 没有未读取的数据、待发送的确认和等待聚合的帧
+  bool isIdle() {
+    return rxHeaderLength == 0 && rxUnacked == 0 && rxBatchRemaining == 0 && txBatchCount == 0 &&
+           client.available() == 0;
+  }
+
+  // 发送一个RS485帧；会话建立后断线期间帧进入重传缓冲区，恢复会话后发送
+  // 有字节间隔记录时以DATA_TIMED发送，对端收到的帧带相同的记录；urgent为true时不等待聚合
+  bool sendFrame(const uint8_t* data, uint16_t length, const uint8_t* timing = nullptr, uint8_t timingLength = 0,
+                 bool urgent = false);
+
+  // 非阻塞接收一个RS485帧，收到完整帧时返回true
+  bool receiveFrame(RS485Frame& frame);
+
+  // 统计信息
+  uint32_t getFramesSent() { return framesSent; }
+  uint32_t getFramesReceived() { return framesReceived; }
+  uint32_t getConnects() { return connects; }
+  uint32_t getProtocolErrors() { return protocolErrors; }
+  uint32_t getResumes() { return resumes; }
+  uint32_t getRetransmits() { return retransmits; }
+  uint32_t getDuplicates() { return duplicates; }
+  uint32_t getReplayDropped() { return replayDropped; }
+  uint32_t getLastFailoverMs() { return lastFailoverMs; }
+  uint32_t getMaxFailoverMs() { return maxFailoverMs; }
+  uint32_t getPacketsSent() { return packetsSent; }
+  uint32_t getBatchedFrames() { return batchedFrames; }
+  uint32_t getPacketsSaved() { return packetsSaved; }
+  uint32_t getMaxBatchHoldUs() { return maxBatchHoldUs; }
+
+private:
+  WiFiServer* server;
+  WiFiClient client;
+  bool isServer;
+  String host;
+  uint16_t port;
+  uint32_t lastConnectAttempt;
+  MasterLocator* locator;
+  bool clientConnected;     // 上一次检查时连接是否建立 (用于发现断线)
+  uint32_t lostAt;          // 发现断线的时间，0表示没有断线
+
+  // 会话
+  bool resumeEnabled;
+  uint32_t localSession;    // 本端会话ID (启动时生成)
+  uint32_t peerSession;     // 对端会话ID，0表示还没有建立过会话
+  bool helloReceived;       // 本次连接已收到对端HELLO
+  uint16_t txSeq;           // 下一个发送帧的序号
+  uint16_t txUnsent;        // 第一个还没有发送过的帧序号 (之前的帧已写入过某个连接)
+  uint16_t rxNext;          // 下一个期望接收的序号
+  uint8_t rxUnacked;        // 已接收未确认的帧数
+  uint32_t rxUnackedSince;
+
+  // 重传缓冲区：环形存放未确认的帧，每帧 [序号 2][长度 2][入队时间 4][类型 1][数据包负载中确认号之后的部分]
+  uint8_t replay[TCP_REPLAY_BUFFER_SIZE];
+  uint16_t replayHead;
+  uint16_t replayUsed;
+  uint16_t replayFrames;
+
+  // 接收状态机
+  uint8_t rxHeader[TCP_PACKET_HEADER_SIZE];
+  uint8_t rxHeaderLength;
+  uint16_t rxPayloadLength;
+  uint16_t rxPayloadReceived;
+  uint8_t rxType;
+  uint32_t rxFirstByteTime;
+  uint8_t rxPayload[TCP_BATCH_HEADER_SIZE + TCP_BATCH_BUFFER_SIZE];  // 不小于单帧数据包的负载
+  uint8_t rxBatchRemaining;   // 聚合数据包中还没有取出的帧数
+  uint16_t rxBatchOffset;     // 下一帧在rxPayload中的位置
+  uint16_t rxBatchSeq;        // 下一帧的序号
+
+  // 聚合发送：帧依次追加为 [类型 1][长度 1][负载]，写入时在前面补上包头
+  uint32_t batchBudgetUs;
+  uint8_t txBatch[TCP_PACKET_HEADER_SIZE + TCP_BATCH_HEADER_SIZE + TCP_BATCH_BUFFER_SIZE];
+  uint16_t txBatchLength;     // 已追加的长度 (不含包头)
+  uint8_t txBatchCount;
+  uint16_t txBatchSeq;        // 第一帧的序号
+  uint32_t txBatchStartUs;    // 第一帧加入的时间
+  uint32_t txBatchHoldUs;     // 本次聚合的等待时间
+  uint32_t lastFrameUs;       // 上一帧交给链路的时间
+  uint32_t frameIntervalUs;   // 帧间隔的滑动平均，0表示还没有估计
+
+  // 统计
+  uint32_t framesSent;
+  uint32_t framesReceived;
+  uint32_t connects;
+  uint32_t protocolErrors;
+  uint32_t resumes;
+  uint32_t retransmits;
+  uint32_t duplicates;
+  uint32_t replayDropped;
+  uint32_t lastFailoverMs;
+  uint32_t maxFailoverMs;
+  uint32_t packetsSent;
+  uint32_t batchedFrames;
+  uint32_t packetsSaved;
+  uint32_t maxBatchHoldUs;
+
+  // 从设备：尝试连接一次主设备
+  bool connectToMaster();
+
+  // 连接建立后重置接收状态并发送HELLO
+  void onConnected();
+
+  // 发现连接断开
+  void checkDisconnected();
+
+  // 协议错误：断开连接，由对端或重连逻辑重新建立
+  void dropConnection();
+
+  // 处理对端的HELLO和确认号
+  void handleHello();
+  void handleAck(uint16_t ack);
+
+  bool writePacket(uint8_t type, const uint8_t* payload, uint16_t length);
+  bool writeData(uint8_t type, uint16_t seq, const uint8_t* data, uint16_t length);
+  void sendAck();
+
+  // 聚合发送：按帧间隔估计本次的等待时间 (0表示立即发送)，写入等待中的帧
+  void updateFrameInterval();
+  uint32_t batchHoldUs();
+  bool flushBatch();
+  void clearBatch();
+
+  // 接收：校验并交付一帧的负载 (确认号之后的部分)，重复帧返回false
+  bool acceptData(uint8_t type, uint16_t seq, const uint8_t* data, uint16_t length, RS485Frame& frame);
+
+  // 从当前的聚合数据包中取出下一帧
+  bool nextBatchFrame(RS485Frame& frame);
+
+  // 重传缓冲区操作
+  bool replayPush(uint8_t type, uint16_t seq, const uint8_t* data, uint16_t length);
+  void replayPop();
+  void replayPeek(uint16_t offset, uint16_t& seq, uint16_t& length, uint32_t& queuedAt, uint8_t* type = nullptr);
+  void replayResend();
+  void replayClear(bool writtenOnly);
+};
+
+#endif // TCP_PROTOCOL_H
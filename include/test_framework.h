@@ -3,7 +3,50 @@
 
 #include <Arduino.h>
 
+// 基准测试参数
+#define BENCH_WARMUP_US 20000         // 预热时长(微秒)
+#define BENCH_SAMPLE_TARGET_US 1000   // 每个样本的目标耗时(微秒)，据此自动调整迭代次数
+#define BENCH_SAMPLE_COUNT 100        // 每个基准测试采集的样本数
+#define BENCH_MAX_ITERATIONS 1000000  // 每个样本的最大迭代次数
+
+// 基准测试结果 (时间和周期均为单次迭代的平均值)
+struct BenchmarkResult {
+  const char* name;
+  uint32_t iterations;  // 每个样本的迭代次数
+  uint16_t samples;     // 样本数
+  float minUs;
+  float medianUs;
+  float p99Us;
+  uint32_t minCycles;
+  uint32_t medianCycles;
+  uint32_t p99Cycles;
+};
+
+// 并行运行时不放入分片、在本进程中依次运行的测试标签
+#define TEST_TAG_SERIAL "serial"
+
+// 测试项：由TEST/BENCHMARK宏定义为静态对象，在静态初始化时加入列表，不分配堆内存
+struct TestItem {
+  TestItem(void (*func)(), const char* name, const char* tags, bool benchmark);
+
+  void (*func)();
+  const char* name;
+  const char* tags;   // 空格分隔的标签
+  TestItem* next;
+};
+
+// 测试项列表：只含指针和计数，在任何构造函数运行之前即为零 (静态初始化)，
+// 其它文件中的测试项可以在测试框架构造之前注册；同一文件中按定义顺序排列
+struct TestList {
+  TestItem* head;
+  TestItem* tail;
+  uint16_t count;
+};
+
 // 测试框架类
+//
+// 过滤条件：空格或逗号分隔的多项，名称中可以使用通配符 *，以 @ 开头的项按标签匹配，
+// 以 - 开头的项排除匹配的测试；没有肯定项时匹配全部。例如 "@wifi -OtaUpdate"、"Config*"
 class TestFramework {
 public:
   TestFramework();
@@ -12,11 +55,33 @@ public:
   // 初始化测试框架
   void begin();
   
-  // 运行所有测试
-  void runAllTests();
+  // 运行匹配过滤条件的测试 (nullptr或空串运行全部)，返回运行的测试数
+  int runAllTests(const char* filter = nullptr);
+
+#ifdef WIFLY485_NATIVE
+  // 本机构建：匹配的测试按序号轮流分成jobs个分片，各在一个fork出的子进程中并行运行，
+  // 子进程使用文件系统的独立副本；每个分片的输出在结束后整体输出，断言计数合并。
+  // 带serial标签的测试在分片结束后依次运行
+  int runTestsParallel(const char* filter, uint8_t jobs);
+#endif
+
+  // 列出匹配的测试和基准测试
+  void listTests(const char* filter = nullptr);
+
+  // 测试项是否匹配过滤条件
+  static bool matchesFilter(const TestItem& item, const char* filter);
+
+  // 加入列表 (TestItem的构造函数调用)
+  static void addItem(TestItem* item, bool benchmark);
+  
+  // 运行匹配的基准测试，每个结果输出一行JSON
+  void runAllBenchmarks(const char* filter = nullptr);
+  
+  // 运行单个基准测试：预热、自动确定迭代次数、采样并统计
+  BenchmarkResult runBenchmark(void (*benchFunc)(), const char* benchName);
   
-  // 注册测试函数
-  void registerTest(void (*testFunc)(), const char* testName);
+  // 以JSON行格式输出基准测试结果
+  void printBenchmarkResult(const BenchmarkResult& result);
   
   // 断言函数
   void assertTrue(bool condition, const char* testName, const char* message);
@@ -25,32 +90,44 @@ public:
   
   // 测试结果统计
   void printTestResults();
+  int getFailedTests() const { return failedTests; }
 
 private:
-  // 测试项结构
-  struct TestItem {
-    void (*testFunc)();
-    const char* testName;
-    TestItem* next;
-  };
-  
-  TestItem* testList;
+  static TestList testList;
+  static TestList benchmarkList;
   int totalTests;
   int passedTests;
   int failedTests;
+
+  void resetCounters();
   
-  // 添加测试项到列表
-  void addTestItem(TestItem* item);
+  // 测量一批迭代的耗时
+  void measureBatch(void (*benchFunc)(), uint32_t iterations, uint32_t& elapsedUs, uint32_t& elapsedCycles);
 };
 
 // 全局测试框架实例
 extern TestFramework testFramework;
 
-// 测试宏定义
-#define TEST(name) void test_##name()
-#define RUN_TEST(name) testFramework.registerTest(test_##name, #name)
+// 测试宏定义：TEST(name) 或 TEST(name, "标签1 标签2")，定义即注册
+#define TEST(name, ...) \
+  void test_##name(); \
+  static TestItem testItem_##name(test_##name, #name, "" __VA_ARGS__, false); \
+  void test_##name()
 #define ASSERT_TRUE(condition) testFramework.assertTrue(condition, __FUNCTION__, #condition)
 #define ASSERT_EQUAL(expected, actual) testFramework.assertEquals(expected, actual, __FUNCTION__, #expected " == " #actual)
 #define ASSERT_STRING_EQUAL(expected, actual) testFramework.assertStringEquals(expected, actual, __FUNCTION__, #expected " == " #actual)
 
+// 基准测试宏定义
+#define BENCHMARK(name, ...) \
+  void bench_##name(); \
+  static TestItem benchItem_##name(bench_##name, #name, "" __VA_ARGS__, true); \
+  void bench_##name()
+
+// 防止编译器把基准测试中的计算结果优化掉
+template <typename T>
+inline void benchDoNotOptimize(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+#define BENCH_KEEP(value) benchDoNotOptimize(value)
+
 #endif // TEST_FRAMEWORK_H
\ No newline at end of file
@@ -0,0 +1,179 @@
+#ifndef TRAFFIC_CAPTURE_H
+#define TRAFFIC_CAPTURE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "config.h"
+#include "config_manager.h"
+#include "rs485.h"
+
+// 捕获文件格式
+//   文件由若干固定大小的段组成，按段循环覆盖，开始写入新段时先将整段清零
+//   段头: [魔数 "W4CP"][段序号 u32][波特率 u32][数据位][校验][停止位][角色]
+//   记录: [时间戳 u32 (micros)][方向/标志 u8][保留 u8][长度 u16][数据...]
+//   所有整数均为小端；长度为0表示段内记录结束
+#define CAPTURE_MAGIC 0x50433457UL  // "W4CP"
+#define CAPTURE_SEGMENT_HEADER_SIZE 16
+#define CAPTURE_RECORD_HEADER_SIZE 8
+#define CAPTURE_MAX_SEGMENTS 64
+
+// 记录方向
+enum CaptureDirection {
+  CAPTURE_BUS_TO_LINK = 0,   // 从本机总线收到，转发到对端
+  CAPTURE_LINK_TO_BUS = 1    // 从对端收到，发送到本机总线
+};
+
+// 记录标志 (与方向共用一个字节)
+#define CAPTURE_FLAG_DIRECTION_MASK 0x01
+#define CAPTURE_FLAG_GAP 0x80        // 此记录之前有记录因缓冲区满被丢弃
+
+// 捕获角色 (段头)
+enum CaptureRole {
+  CAPTURE_ROLE_MASTER = 0,
+  CAPTURE_ROLE_SLAVE = 1
+};
+
+// 一条捕获记录
+struct CaptureRecord {
+  uint32_t timestamp;   // micros()
+  uint8_t flags;        // 方向和标志
+  uint16_t length;
+  uint8_t data[RS485_FRAME_BUFFER_SIZE];
+
+  CaptureDirection direction() const { return (CaptureDirection)(flags & CAPTURE_FLAG_DIRECTION_MASK); }
+};
+
+// 总线流量捕获
+// record() 只把记录复制到内存环形缓冲区，由 loop() 在总线空闲时批量写入文件
+class TrafficCapture {
+public:
+  TrafficCapture();
+  ~TrafficCapture();
+
+  // 创建捕获文件并开始捕获，fileSize向下取整到段大小的整数倍 (最多CAPTURE_MAX_SEGMENTS段)
+  bool begin(FS& fs, const RS485Config& config, CaptureRole role,
+             const char* path = CAPTURE_FILE_PATH, uint32_t fileSize = CAPTURE_FILE_SIZE);
+
+  // 使用已打开的可读写文件 (主机工具直接打开主机上的文件)
+  bool begin(File file, const RS485Config& config, CaptureRole role, uint32_t fileSize = CAPTURE_FILE_SIZE);
+
+  // 写入剩余数据并关闭文件
+  void end();
+
+  bool isActive() { return active; }
+
+  // 热路径：记录一帧 (缓冲区满时丢弃并在下一条记录上标记)
+  void record(CaptureDirection direction, const uint8_t* data, uint16_t length, uint32_t timestamp);
+
+  // 缓冲数据达到阈值或超时后写入文件 (主循环调用)
+  void loop();
+
+  // 立即写入所有缓冲数据
+  void flush();
+
+  // 统计信息
+  uint32_t getRecordsCaptured() { return recordsCaptured; }
+  uint32_t getRecordsDropped() { return recordsDropped; }
+  uint32_t getBytesWritten() { return bytesWritten; }
+  uint32_t getSegmentsWritten() { return segmentsWritten; }
+
+private:
+  File file;
+  bool active;
+  RS485Config config;
+  CaptureRole role;
+  uint32_t segmentCount;
+
+  // 内存环形缓冲区 (字节流，记录可能跨越缓冲区末尾)
+  uint8_t ring[CAPTURE_RAM_BUFFER_SIZE];
+  uint16_t ringHead;    // 写入位置
+  uint16_t ringTail;    // 读取位置
+  uint16_t ringUsed;
+  bool pendingGap;
+
+  // 当前段
+  uint32_t segmentSequence;
+  uint32_t segmentIndex;
+  uint32_t segmentOffset;  // 段内写入位置
+  uint32_t lastFlush;
+
+  // 统计
+  uint32_t recordsCaptured;
+  uint32_t recordsDropped;
+  uint32_t bytesWritten;
+  uint32_t segmentsWritten;
+
+  void ringWrite(const uint8_t* data, uint16_t length);
+  void ringRead(uint8_t* data, uint16_t length);
+  void ringPeek(uint8_t* data, uint16_t length);
+
+  // 在文件中开始下一段
+  void startSegment();
+};
+
+// 捕获文件读取：按段序号顺序遍历所有记录
+class CaptureReader {
+public:
+  CaptureReader();
+  ~CaptureReader();
+
+  bool begin(FS& fs, const char* path = CAPTURE_FILE_PATH);
+  bool begin(File file);
+  void end();
+
+  // 读取下一条记录，没有更多记录时返回false
+  bool next(CaptureRecord& record);
+
+  // 从头重新读取
+  void rewind();
+
+  // 捕获时的串口配置和设备角色 (取自最早的段)
+  RS485Config getConfig() { return config; }
+  CaptureRole getRole() { return role; }
+  uint32_t getSegmentCount() { return orderCount; }
+
+private:
+  File file;
+  RS485Config config;
+  CaptureRole role;
+
+  // 按段序号排序后的段索引
+  uint16_t order[CAPTURE_MAX_SEGMENTS];
+  uint16_t orderCount;
+  uint16_t orderPosition;
+  uint32_t segmentOffset;
+};
+
+// 设备上的回放：按原始时间间隔将捕获中的总线帧从本机总线发出
+// 用作台架上的VRF控制器替身，对另一台中继施加真实负载
+class TrafficReplay {
+public:
+  TrafficReplay();
+
+  // direction指定回放哪个方向的记录 (通常为捕获设备从总线上收到的帧)
+  bool begin(FS& fs, RS485* bus, CaptureDirection direction = CAPTURE_BUS_TO_LINK,
+             const char* path = CAPTURE_FILE_PATH);
+  void end();
+
+  // 发送到期的帧，回放结束后返回false
+  bool loop();
+
+  uint32_t getFramesSent() { return framesSent; }
+  uint32_t getMaxLateUs() { return maxLateUs; }
+
+private:
+  CaptureReader reader;
+  RS485* bus;
+  CaptureDirection direction;
+  CaptureRecord pending;
+  bool hasPending;
+  bool active;
+  uint32_t captureStart;   // 第一条记录的捕获时间戳
+  uint32_t replayStart;    // 回放开始的micros()
+  uint32_t framesSent;
+  uint32_t maxLateUs;      // 发送时间相对原始时间的最大滞后
+
+  bool loadNext();
+};
+
+#endif // TRAFFIC_CAPTURE_H
\ No newline at end of file
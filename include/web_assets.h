@@ -0,0 +1,19 @@
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// 编译进闪存的Web界面资源 (gzip压缩)
+// 数据由 tools/build_web_assets.py 在构建前从 data/ 生成到 src/web_assets.cpp
+struct WebAsset {
+  const char* path;          // URL路径，如 "/index.html"
+  const char* contentType;
+  const char* etag;          // 带引号的强ETag
+  const uint8_t* data;       // PROGMEM，gzip压缩后的内容
+  uint32_t length;
+};
+
+extern const WebAsset WEB_ASSETS[];
+extern const uint8_t WEB_ASSET_COUNT;
+
+#endif // WEB_ASSETS_H
@@ -0,0 +1,108 @@
+#ifndef WEB_SERVER_H
+#define WEB_SERVER_H
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include "config.h"
+#include "config_manager.h"
+#include "device.h"
+#include "scheduler.h"
+#include "status_events.h"
+#include "web_assets.h"
+
+// 把Print输出按块写入HTTP响应 (分块传输编码)，响应不需要在内存中完整构建
+class WebResponseWriter : public Print {
+public:
+  explicit WebResponseWriter(ESP8266WebServer& server);
+  ~WebResponseWriter();
+
+  // 发送响应头，之后的输出作为响应体
+  void begin(int code, const char* contentType);
+
+  // 发送剩余数据并结束响应
+  void end();
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+  // 已写入的响应体字节数
+  uint32_t getBytesWritten() { return bytesWritten; }
+
+private:
+  ESP8266WebServer& server;
+  char buffer[WEB_RESPONSE_CHUNK_SIZE];
+  size_t used;
+  uint32_t bytesWritten;
+
+  void sendBuffer();
+};
+
+// 把闪存中的资源分块写入客户端
+// 响应头由WebServerManager同步发送，响应体每次loop()每个连接只写一块，块之间回到主循环运行中继
+class WebAssetStreamer {
+public:
+  WebAssetStreamer();
+  ~WebAssetStreamer();
+
+  // 开始发送资源的响应体；没有空闲的发送槽时返回false
+  bool start(WiFiClient& client, const WebAsset* asset);
+
+  // 为每个进行中的发送写一块 (主循环调用)
+  void loop();
+
+  uint8_t getActiveCount();
+
+private:
+  struct AssetTransfer {
+    WiFiClient client;
+    const WebAsset* asset;
+    uint32_t offset;
+    bool active;
+  };
+
+  AssetTransfer transfers[WEB_ASSET_MAX_STREAMS];
+};
+
+// Web服务器：Web界面、状态接口和Prometheus指标
+//   GET /, /index.html, /config.html, /style.css, /script.js
+//                    编译进闪存的Web界面 (gzip, ETag + 304)
+//   GET /metrics     Prometheus文本格式的计数器
+//   GET /api/status  设备状态、计数器、帧时延直方图和调度统计 (JSON)
+//   GET /api/config  当前配置 (JSON，不含WiFi密码)
+//   GET /events      状态增量推送 (Server-Sent Events)
+class WebServerManager {
+public:
+  WebServerManager();
+  ~WebServerManager();
+
+  // 注册路由并开始监听 (scheduler可为nullptr)
+  bool begin(Device* device, Scheduler* scheduler = nullptr, uint16_t port = WEB_SERVER_PORT);
+
+  // 设置配置来源 (nullptr表示不提供 /api/config)
+  void setConfigManager(ConfigManager* configManager) { this->configManager = configManager; }
+
+  // 设置状态推送中链路状态的来源
+  void setLink(TcpProtocol* link) { statusEvents.begin(link); }
+
+  // 处理HTTP请求并继续发送进行中的资源 (主循环调用)
+  void loop();
+
+private:
+  ESP8266WebServer* server;
+  Device* device;
+  Scheduler* scheduler;
+  ConfigManager* configManager;
+  WebAssetStreamer assetStreamer;
+  StatusEvents statusEvents;
+
+  void handleAsset(const WebAsset* asset);
+  void handleConfig();
+  void handleEvents();
+
+  void handleMetrics();
+  void handleStatus();
+  void handleNotFound();
+};
+
+#endif // WEB_SERVER_H
\ No newline at end of file
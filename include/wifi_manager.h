@@ -0,0 +1,87 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "config_manager.h"
+
+// 上次连接的接入点和地址租约，保存在RTC内存中 (见rtc_store.h)
+struct WiFiRtcCache {
+  uint32_t credentialHash;  // SSID和密码的CRC，配置改变后缓存失效
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t hasLease;         // 以下地址来自DHCP租约 (静态IP配置时为0)
+  uint8_t leaseReuses;      // 租约未经DHCP续期被快速连接复用的次数
+  uint8_t reserved[3];
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+
+// 连接方式
+enum WiFiConnectMode {
+  WIFI_CONNECT_NONE = 0,
+  WIFI_CONNECT_FAST,        // 使用缓存的BSSID/信道 (和租约)，跳过扫描 (和DHCP)
+  WIFI_CONNECT_FULL         // 扫描全部信道并运行DHCP
+};
+
+// WiFi Station连接管理
+// 热启动 (软件/看门狗复位) 时用RTC缓存直接连接上次的接入点，不扫描也不等待DHCP；
+// 缓存无效、接入点不可用或超过WIFI_FAST_CONNECT_TIMEOUT_MS未连接时清除缓存并退回完整连接。
+// 设置缓存的租约地址会关闭DHCP客户端，连接后立即重新启动DHCP，向服务器续约 (通常得到同一地址，
+// 已建立的连接不中断)，不会在租约过期后继续使用该地址；连续复用WIFI_LEASE_MAX_REUSE次后启动时运行一次DHCP；
+// 断电后RTC内存丢失，冷启动总是完整连接
+class WiFiManager {
+public:
+  WiFiManager();
+  ~WiFiManager();
+
+  // 开始连接 (不等待连接完成)
+  bool begin(const NetworkConfig& config, const char* hostname);
+
+  // 冷启动时用SDK保存的凭据 (DHCP) 开始连接，不需要挂载文件系统；没有保存的凭据时返回false
+  bool beginFromStoredCredentials(const char* hostname);
+
+  // 当前连接使用的配置是否与config一致 (配置文件加载后判断是否需要重新连接)
+  bool isConfiguredFor(const NetworkConfig& config);
+
+  // 监控连接状态：快速连接超时退回、连接后更新缓存 (主循环调用)
+  void loop();
+
+  bool isConnected();
+
+  // 本次启动使用的连接方式和从启动到连接的时间
+  WiFiConnectMode getConnectMode() { return connectMode; }
+  uint32_t getConnectTimeMs() { return connectTimeMs; }
+
+  // 复用租约连接后已重新启动DHCP续约
+  bool isRenewingLease() { return renewingLease; }
+
+private:
+  enum State {
+    STATE_IDLE,
+    STATE_CONNECTING,
+    STATE_CONNECTED,
+    STATE_DISCONNECTED
+  };
+
+  NetworkConfig config;
+  State state;
+  WiFiConnectMode connectMode;
+  uint32_t connectStartMs;
+  uint32_t connectTimeMs;
+  uint32_t credentialHash;
+  uint8_t leaseReuses;
+  bool renewingLease;
+  uint32_t leaseIp;         // 复用的租约地址，续约得到不同地址时更新缓存
+
+  bool beginFast();
+  void beginFull();
+  void onConnected();
+  void renewLease();
+  void saveCache();
+};
+
+#endif // WIFI_MANAGER_H
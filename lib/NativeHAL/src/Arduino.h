@@ -0,0 +1,351 @@
+#ifndef NATIVE_HAL_ARDUINO_H
+#define NATIVE_HAL_ARDUINO_H
+
+// 本机(Linux)构建使用的Arduino API替身
+// 只实现WiFly485实际用到的接口，行为尽量与ESP8266 Arduino核心保持一致
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+
+using std::min;
+using std::max;
+
+// 编译属性 (本机构建下无意义)
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define ICACHE_FLASH_ATTR
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define snprintf_P snprintf
+
+// 数字格式和GPIO常量
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+// 时间函数 (以进程启动为零点)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO函数 (只记录状态，不操作硬件)
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// 中断控制 (本机构建为空操作)
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// GPIO中断：与ESP8266核心的取值一致，*_WE为电平触发并可将CPU从浅睡眠唤醒
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define ONLOW 0x04
+#define ONHIGH 0x05
+#define ONLOW_WE 0x0C
+#define ONHIGH_WE 0x0D
+#define digitalPinToInterrupt(pin) (pin)
+
+// 本机没有硬件边沿：电平触发的中断在注册时和digitalWrite()使引脚到达该电平时调用处理函数
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+// 随机数
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// 字符串类 (基于std::string实现)
+class String {
+public:
+  String() {}
+  String(const char* cstr) : buffer(cstr ? cstr : "") {}
+  String(const char* cstr, size_t length) : buffer(cstr ? std::string(cstr, length) : std::string()) {}
+  String(const std::string& str) : buffer(str) {}
+  String(const String& other) = default;
+  String(String&& other) = default;
+  explicit String(char c) : buffer(1, c) {}
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+  ~String() {}
+
+  String& operator=(const String& other) = default;
+  String& operator=(String&& other) = default;
+  String& operator=(const char* cstr) {
+    buffer = cstr ? cstr : "";
+    return *this;
+  }
+
+  // 基本访问
+  unsigned int length() const { return buffer.length(); }
+  bool isEmpty() const { return buffer.empty(); }
+  const char* c_str() const { return buffer.c_str(); }
+  bool reserve(unsigned int size) {
+    buffer.reserve(size);
+    return true;
+  }
+  char charAt(unsigned int index) const { return index < buffer.length() ? buffer[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) { return buffer[index]; }
+
+  // 拼接
+  bool concat(const String& str) {
+    buffer += str.buffer;
+    return true;
+  }
+  bool concat(const char* cstr) {
+    if (cstr) buffer += cstr;
+    return true;
+  }
+  bool concat(const char* cstr, unsigned int length) {
+    if (cstr) buffer.append(cstr, length);
+    return true;
+  }
+  bool concat(char c) {
+    buffer += c;
+    return true;
+  }
+  bool concat(int value) { return concat(String(value)); }
+  bool concat(unsigned int value) { return concat(String(value)); }
+  bool concat(long value) { return concat(String(value)); }
+  bool concat(unsigned long value) { return concat(String(value)); }
+  bool concat(double value) { return concat(String(value)); }
+
+  template <typename T>
+  String& operator+=(const T& value) {
+    concat(value);
+    return *this;
+  }
+
+  // 比较
+  int compareTo(const String& other) const { return buffer.compare(other.buffer); }
+  bool equals(const String& other) const { return buffer == other.buffer; }
+  bool equals(const char* cstr) const { return buffer == (cstr ? cstr : ""); }
+  bool equalsIgnoreCase(const String& other) const;
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String& other) const { return compareTo(other) < 0; }
+  bool startsWith(const String& prefix) const { return buffer.compare(0, prefix.buffer.length(), prefix.buffer) == 0; }
+  bool endsWith(const String& suffix) const;
+
+  // 查找与截取
+  int indexOf(char c, unsigned int fromIndex = 0) const;
+  int indexOf(const String& str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char c) const;
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  // 修改
+  void trim();
+  void toLowerCase();
+  void toUpperCase();
+  void replace(const String& find, const String& replacement);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+
+  // 转换
+  long toInt() const { return atol(buffer.c_str()); }
+  float toFloat() const { return (float)atof(buffer.c_str()); }
+
+private:
+  std::string buffer;
+};
+
+// ArduinoJson依赖此类型识别字符串拼接的临时结果
+class StringSumHelper : public String {
+public:
+  StringSumHelper(const String& str) : String(str) {}
+  StringSumHelper(const char* cstr) : String(cstr) {}
+};
+
+StringSumHelper operator+(const String& lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, const char* rhs);
+StringSumHelper operator+(const char* lhs, const String& rhs);
+StringSumHelper operator+(const String& lhs, char rhs);
+inline bool operator==(const char* lhs, const String& rhs) { return rhs.equals(lhs); }
+inline bool operator!=(const char* lhs, const String& rhs) { return !rhs.equals(lhs); }
+
+// 输出基类
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const char* str) { return write(str); }
+  size_t print(const String& str) { return write(str.c_str(), str.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(long long value, int base = DEC);
+  size_t print(unsigned long long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(const T& value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  size_t printf_P(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// 输入流基类
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeout) { streamTimeout = timeout; }
+  unsigned long getTimeout() const { return streamTimeout; }
+
+  virtual size_t readBytes(char* buffer, size_t length);
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+  String readString();
+  String readStringUntil(char terminator);
+
+protected:
+  unsigned long streamTimeout = 1000;
+
+  // 带超时的单字节读取，超时返回-1
+  int timedRead();
+};
+
+// 串口替身：Serial映射到标准输入/输出，Serial1映射到标准错误(仅输出)
+class HardwareSerial : public Stream {
+public:
+  explicit HardwareSerial(int uartNumber) : uart(uartNumber), baudRate(0) {}
+
+  void begin(unsigned long baud) { baudRate = baud; }
+  void begin(unsigned long baud, int config) {
+    (void)config;
+    baudRate = baud;
+  }
+  void end() { baudRate = 0; }
+  unsigned long baud() const { return baudRate; }
+  size_t setRxBufferSize(size_t size) { return size; }
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int availableForWrite() override { return 128; }
+  void flush() override;
+  using Print::write;
+
+  operator bool() const { return true; }
+
+private:
+  int uart;
+  unsigned long baudRate;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+// 串口配置常量 (本机构建只作占位)
+#define SERIAL_8N1 0x1c
+#define SERIAL_8E1 0x1e
+#define SERIAL_8O1 0x1f
+#define SERIAL_8N2 0x3c
+typedef int SerialConfig;
+
+#define FLASH_SECTOR_SIZE 0x1000
+
+// ESP8266系统接口替身
+class EspClass {
+public:
+  // CPU周期计数器：x86上使用TSC，其它平台使用纳秒时钟
+  uint32_t getCycleCount();
+  uint8_t getCpuFreqMHz();
+  uint32_t getFreeHeap();
+  uint32_t getMaxFreeBlockSize();
+  uint8_t getHeapFragmentation();
+
+  // 主循环栈的剩余量：本机没有独立的cont栈，返回完整大小 (使用量为0)
+  uint32_t getFreeContStack();
+  void resetFreeContStack();
+
+  // 闪存：本机以进程内的4MB数组代替，擦除为0xFF并阻塞典型的擦除时间，写入只能把1写成0 (与NOR闪存一致)
+  bool flashEraseSector(uint32_t sector);
+  bool flashWrite(uint32_t address, const uint32_t* data, size_t size);
+  bool flashRead(uint32_t address, uint32_t* data, size_t size);
+  uint32_t getChipId();
+
+  // 硬件随机数
+  uint32_t random();
+
+  // RTC用户内存 (512字节，offset以4字节为单位)：本机以进程内数组代替，进程退出即丢失
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+
+  void restart();
+  void reset();
+};
+
+extern EspClass ESP;
+
+// 本机构建入口控制
+// 命令行参数会依次作为串口输入行，输入耗尽后进程以nativeSetExitCode()设置的值退出
+void nativeSetArgsInput(bool fromArgs);
+void nativeQueueInputLine(const char* line);
+bool nativeInputExhausted();
+void nativeSetExitCode(int code);
+int nativeExitCode();
+void nativeExit();
+
+// Arduino程序入口
+void setup();
+void loop();
+
+#endif // NATIVE_HAL_ARDUINO_H
\ No newline at end of file
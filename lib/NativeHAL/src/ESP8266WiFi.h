@@ -0,0 +1,222 @@
+#ifndef NATIVE_HAL_ESP8266WIFI_H
+#define NATIVE_HAL_ESP8266WIFI_H
+
+// 本机构建使用的WiFi替身
+// WiFiClient/WiFiServer基于回环地址上的TCP套接字，WiFi始终处于已连接状态
+
+#include <Arduino.h>
+
+// IPv4地址
+class IPAddress {
+public:
+  IPAddress() : address(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    bytes[0] = a;
+    bytes[1] = b;
+    bytes[2] = c;
+    bytes[3] = d;
+  }
+  IPAddress(uint32_t value) : address(value) {}
+
+  // 按网络字节序存储，与ESP8266一致
+  operator uint32_t() const { return address; }
+  uint8_t operator[](int index) const { return bytes[index]; }
+  uint8_t& operator[](int index) { return bytes[index]; }
+  bool operator==(const IPAddress& other) const { return address == other.address; }
+  bool operator!=(const IPAddress& other) const { return address != other.address; }
+
+  bool fromString(const char* str);
+  bool fromString(const String& str) { return fromString(str.c_str()); }
+  String toString() const;
+  bool isSet() const { return address != 0; }
+
+private:
+  union {
+    uint8_t bytes[4];
+    uint32_t address;
+  };
+};
+
+// 客户端基类
+class Client : public Stream {
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char* host, uint16_t port) = 0;
+  virtual int read(uint8_t* buffer, size_t size) = 0;
+  virtual uint8_t connected() = 0;
+  virtual void stop() = 0;
+  virtual operator bool() = 0;
+  using Stream::read;
+};
+
+class WiFiServer;
+
+// TCP客户端
+class WiFiClient : public Client {
+public:
+  WiFiClient();
+  ~WiFiClient();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  int connect(const String& host, uint16_t port) { return connect(host.c_str(), port); }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  size_t write_P(PGM_P buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  using Print::write;
+  int availableForWrite() override;
+
+  int available() override;
+  int read() override;
+  int read(uint8_t* buffer, size_t size) override;
+  int peek() override;
+  void flush() override {}
+
+  uint8_t connected() override;
+  void stop() override;
+  operator bool() override { return connected(); }
+
+  void setNoDelay(bool noDelay);
+  void setTimeout(unsigned long timeout) { Stream::setTimeout(timeout); }
+  IPAddress remoteIP();
+  uint16_t remotePort();
+  IPAddress localIP();
+  uint16_t localPort();
+
+  // 本机构建专用：获取底层套接字 (供select/poll使用)
+  int nativeSocket() const;
+
+private:
+  friend class WiFiServer;
+
+  // 同一连接的多个副本共享套接字，与ESP8266的ClientContext引用计数语义一致
+  struct Socket;
+  std::shared_ptr<Socket> socket;
+
+  explicit WiFiClient(int fd);
+  bool fillBuffer();
+};
+
+// TCP服务器
+class WiFiServer {
+public:
+  explicit WiFiServer(uint16_t port);
+  WiFiServer(IPAddress address, uint16_t port);
+  ~WiFiServer();
+
+  void begin();
+  void begin(uint16_t port);
+  void setNoDelay(bool noDelay) { serverNoDelay = noDelay; }
+  bool hasClient();
+  WiFiClient available();
+  WiFiClient accept() { return available(); }
+  void close();
+  void stop() { close(); }
+  uint8_t status() { return listenFd >= 0 ? 1 : 0; }
+  uint16_t port() const { return serverPort; }
+
+private:
+  IPAddress bindAddress;
+  uint16_t serverPort;
+  int listenFd;
+  bool serverNoDelay;
+  int pendingFd;
+};
+
+// WiFi连接状态
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7
+} wl_status_t;
+
+typedef enum {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3
+} WiFiMode_t;
+
+// 射频睡眠类型 (SDK默认为调制解调器睡眠)
+typedef enum {
+  WIFI_NONE_SLEEP = 0,
+  WIFI_LIGHT_SLEEP = 1,
+  WIFI_MODEM_SLEEP = 2
+} WiFiSleepType_t;
+
+// WiFi替身：本机网络始终可用，本地地址为127.0.0.1
+class ESP8266WiFiClass {
+public:
+  bool mode(WiFiMode_t wifiMode) {
+    currentMode = wifiMode;
+    return true;
+  }
+  WiFiMode_t getMode() const { return currentMode; }
+  wl_status_t begin(const char* ssid, const char* passphrase = nullptr, int32_t channel = 0, const uint8_t* bssid = nullptr, bool connect = true);
+  bool config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress()) {
+    (void)localIP;
+    (void)gateway;
+    (void)subnet;
+    (void)dns1;
+    return true;
+  }
+  bool hostname(const char* name) {
+    (void)name;
+    return true;
+  }
+  bool disconnect(bool wifiOff = false);
+  bool reconnect() { return true; }
+  bool setAutoReconnect(bool autoReconnect) {
+    (void)autoReconnect;
+    return true;
+  }
+  bool persistent(bool persistent) {
+    (void)persistent;
+    return true;
+  }
+  wl_status_t status() const { return wifiStatus; }
+  bool isConnected() const { return wifiStatus == WL_CONNECTED; }
+  IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+  IPAddress gatewayIP() const { return IPAddress(127, 0, 0, 1); }
+  IPAddress subnetMask() const { return IPAddress(255, 0, 0, 0); }
+  IPAddress dnsIP(uint8_t index = 0) const {
+    (void)index;
+    return IPAddress(127, 0, 0, 1);
+  }
+  uint8_t* BSSID() { return bssid; }
+  String SSID() const { return ssidName; }
+  String psk() const { return pskValue; }
+  int32_t RSSI() const { return -40; }
+  int32_t channel() const { return 1; }
+  String macAddress() const { return String("02:00:00:00:00:01"); }
+  int hostByName(const char* host, IPAddress& result);
+
+  // 射频睡眠：listenInterval为0时按AP的DTIM间隔醒来，1~10为按信标数
+  bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0) {
+    sleepType = type;
+    this->listenInterval = listenInterval;
+    return true;
+  }
+  WiFiSleepType_t getSleepMode() const { return sleepType; }
+  uint8_t getListenInterval() const { return listenInterval; }
+
+private:
+  WiFiMode_t currentMode = WIFI_STA;
+  WiFiSleepType_t sleepType = WIFI_MODEM_SLEEP;
+  uint8_t listenInterval = 0;
+  wl_status_t wifiStatus = WL_CONNECTED;
+  String ssidName;
+  String pskValue;
+  uint8_t bssid[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif // NATIVE_HAL_ESP8266WIFI_H
\ No newline at end of file
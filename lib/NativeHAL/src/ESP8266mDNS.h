@@ -0,0 +1,41 @@
+#ifndef NATIVE_HAL_ESP8266MDNS_H
+#define NATIVE_HAL_ESP8266MDNS_H
+
+// mDNS替身：本进程中 addService() 发布的服务可以被 queryService() 查询到，地址为回环地址
+// 接口与ESP8266mDNS (LEAmDNS) 的兼容接口一致
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <vector>
+
+class MDNSResponder {
+public:
+  bool begin(const char* hostname);
+  void end();
+  void update() {}
+
+  bool addService(const char* service, const char* protocol, uint16_t port);
+
+  // 查询服务，返回应答数；应答在下一次查询或 removeQuery() 之前有效
+  uint32_t queryService(const char* service, const char* protocol, uint16_t timeoutMs = 1000);
+  bool removeQuery();
+  const char* answerHostname(uint32_t index);
+  IPAddress answerIP(uint32_t index);
+  uint16_t answerPort(uint32_t index);
+
+private:
+  struct Service {
+    String hostname;
+    String service;
+    String protocol;
+    uint16_t port;
+  };
+
+  String hostname;
+  std::vector<Service> services;
+  std::vector<Service> answers;
+};
+
+extern MDNSResponder MDNS;
+
+#endif // NATIVE_HAL_ESP8266MDNS_H
@@ -0,0 +1,92 @@
+#ifndef NATIVE_HAL_FS_H
+#define NATIVE_HAL_FS_H
+
+// 本机构建使用的文件系统替身
+// 所有文件保存在一个临时目录中 (可通过环境变量 WIFLY485_FS_ROOT 指定，指定后退出时不删除)
+
+#include <Arduino.h>
+#include <stdio.h>
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2
+};
+
+class File : public Stream {
+public:
+  File() {}
+  File(FILE* handle, const String& path);
+
+  // Stream接口
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t readBytes(char* buffer, size_t length) override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  void flush() override;
+  using Print::write;
+
+  // 文件接口
+  size_t read(uint8_t* buffer, size_t size);
+  bool seek(uint32_t pos, SeekMode mode = SeekSet);
+  size_t position() const;
+  size_t size() const;
+  void close();
+  const char* name() const;
+  const char* fullName() const;
+  bool isFile() const { return static_cast<bool>(handle); }
+  operator bool() const { return static_cast<bool>(handle); }
+
+private:
+  // 同一文件的多个副本共享句柄，与ESP8266的File语义一致
+  std::shared_ptr<FILE> handle;
+  String path;
+};
+
+class FS {
+public:
+  explicit FS(const char* label) : label(label), mounted(false) {}
+
+  bool begin();
+  void end();
+  bool format();
+
+  File open(const char* path, const char* mode);
+  File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+  bool exists(const char* path);
+  bool exists(const String& path) { return exists(path.c_str()); }
+  bool remove(const char* path);
+  bool remove(const String& path) { return remove(path.c_str()); }
+  bool rename(const char* pathFrom, const char* pathTo);
+  bool rename(const String& pathFrom, const String& pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+
+  // 返回文件在主机上的实际路径
+  String hostPath(const char* path);
+
+private:
+  const char* label;
+  bool mounted;
+};
+
+}  // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+extern fs::FS SPIFFS;
+
+// 文件系统根目录 (首次调用时创建)
+const char* nativeFsRoot();
+
+// 改用当前根目录的一份副本 (fork出的子进程调用，之后的写入不影响父进程和其它子进程)
+void nativeFsIsolate();
+
+#endif // NATIVE_HAL_FS_H
\ No newline at end of file
@@ -0,0 +1,9 @@
+#ifndef NATIVE_HAL_LITTLEFS_H
+#define NATIVE_HAL_LITTLEFS_H
+
+// LittleFS替身：与SPIFFS替身相同的实现，文件保存在根目录下的独立子目录中
+#include "FS.h"
+
+extern fs::FS LittleFS;
+
+#endif // NATIVE_HAL_LITTLEFS_H
@@ -0,0 +1,28 @@
+#ifndef NATIVE_HAL_MD5BUILDER_H
+#define NATIVE_HAL_MD5BUILDER_H
+
+// ESP8266核心MD5Builder的替身 (RFC 1321)
+
+#include <Arduino.h>
+
+class MD5Builder {
+public:
+  void begin();
+  void add(const uint8_t* data, uint16_t length);
+  void add(const char* data) { add((const uint8_t*)data, (uint16_t)strlen(data)); }
+  void add(const String& data) { add((const uint8_t*)data.c_str(), (uint16_t)data.length()); }
+  void calculate();
+  void getBytes(uint8_t* output) const;
+  void getChars(char* output) const;
+  String toString() const;
+
+private:
+  uint32_t state[4];
+  uint64_t totalLength;
+  uint8_t block[64];
+  uint8_t digest[16];
+
+  void transform(const uint8_t* data);
+};
+
+#endif // NATIVE_HAL_MD5BUILDER_H
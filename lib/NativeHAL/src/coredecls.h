@@ -0,0 +1,27 @@
+#ifndef NATIVE_HAL_COREDECLS_H
+#define NATIVE_HAL_COREDECLS_H
+
+// ESP8266核心内部接口的替身：可被esp_schedule()提前结束的等待
+
+#include <Arduino.h>
+
+// 唤醒正在esp_delay()中等待的主循环 (可在中断中调用)
+void esp_schedule();
+
+// 等待ms毫秒，或直到esp_schedule()被调用
+void esp_delay(uint32_t ms);
+
+// 等待直到超时或blocked()返回false，每intvl_ms (或被esp_schedule()唤醒时) 检查一次
+template <typename T>
+inline void esp_delay(const uint32_t timeout_ms, T&& blocked, const uint32_t intvl_ms) {
+  const uint32_t start_ms = millis();
+  while (blocked()) {
+    uint32_t expired = millis() - start_ms;
+    if (expired >= timeout_ms) {
+      return;
+    }
+    esp_delay(std::min(timeout_ms - expired, intvl_ms));
+  }
+}
+
+#endif // NATIVE_HAL_COREDECLS_H
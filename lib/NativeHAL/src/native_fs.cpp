@@ -0,0 +1,297 @@
+#include "FS.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string>
+
+fs::FS SPIFFS("spiffs");
+fs::FS LittleFS("littlefs");
+
+// ---------------------------------------------------------------------------
+// 临时根目录
+// ---------------------------------------------------------------------------
+
+static std::string fsRoot;
+static bool fsRootOwned = false;
+static bool fsCleanupRegistered = false;
+
+static void removeTree(const std::string& path) {
+  DIR* dir = opendir(path.c_str());
+  if (dir != nullptr) {
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        continue;
+      }
+      removeTree(path + "/" + entry->d_name);
+    }
+    closedir(dir);
+    rmdir(path.c_str());
+  } else {
+    unlink(path.c_str());
+  }
+}
+
+static void cleanupFsRoot() {
+  if (fsRootOwned && !fsRoot.empty()) {
+    removeTree(fsRoot);
+  }
+}
+
+const char* nativeFsRoot() {
+  if (fsRoot.empty()) {
+    const char* configured = getenv("WIFLY485_FS_ROOT");
+    if (configured != nullptr && configured[0] != '\0') {
+      fsRoot = configured;
+      mkdir(fsRoot.c_str(), 0755);
+    } else {
+      char pattern[] = "/tmp/wifly485_fs_XXXXXX";
+      const char* created = mkdtemp(pattern);
+      fsRoot = created != nullptr ? created : "/tmp";
+      fsRootOwned = created != nullptr;
+      atexit(cleanupFsRoot);
+      fsCleanupRegistered = true;
+    }
+  }
+  return fsRoot.c_str();
+}
+
+static void copyTree(const std::string& from, const std::string& to) {
+  DIR* dir = opendir(from.c_str());
+  if (dir != nullptr) {
+    mkdir(to.c_str(), 0755);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+        copyTree(from + "/" + entry->d_name, to + "/" + entry->d_name);
+      }
+    }
+    closedir(dir);
+    return;
+  }
+  FILE* in = fopen(from.c_str(), "rb");
+  FILE* out = in != nullptr ? fopen(to.c_str(), "wb") : nullptr;
+  char buffer[4096];
+  size_t n;
+  while (out != nullptr && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    fwrite(buffer, 1, n, out);
+  }
+  if (out != nullptr) {
+    fclose(out);
+  }
+  if (in != nullptr) {
+    fclose(in);
+  }
+}
+
+void nativeFsIsolate() {
+  std::string source = nativeFsRoot();
+  char pattern[] = "/tmp/wifly485_fs_XXXXXX";
+  const char* created = mkdtemp(pattern);
+  if (created == nullptr) {
+    return;
+  }
+  copyTree(source, created);
+  fsRoot = created;
+  fsRootOwned = true;
+  if (!fsCleanupRegistered) {
+    atexit(cleanupFsRoot);
+    fsCleanupRegistered = true;
+  }
+}
+
+// 逐级创建父目录 (SPIFFS的文件名可以包含'/')
+static void makeParentDirs(const std::string& path) {
+  for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+    mkdir(path.substr(0, pos).c_str(), 0755);
+  }
+}
+
+static const char* hostMode(const char* mode) {
+  if (strcmp(mode, "r") == 0) return "rb";
+  if (strcmp(mode, "w") == 0) return "wb";
+  if (strcmp(mode, "a") == 0) return "ab";
+  if (strcmp(mode, "r+") == 0) return "r+b";
+  if (strcmp(mode, "w+") == 0) return "w+b";
+  if (strcmp(mode, "a+") == 0) return "a+b";
+  return nullptr;
+}
+
+namespace fs {
+
+// ---------------------------------------------------------------------------
+// File
+// ---------------------------------------------------------------------------
+
+File::File(FILE* file, const String& filePath) : handle(file, fclose), path(filePath) {}
+
+int File::available() {
+  if (!handle) {
+    return 0;
+  }
+  return (int)(size() - position());
+}
+
+int File::read() {
+  if (!handle) {
+    return -1;
+  }
+  int c = fgetc(handle.get());
+  return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+  if (!handle) {
+    return -1;
+  }
+  int c = fgetc(handle.get());
+  if (c == EOF) {
+    return -1;
+  }
+  ungetc(c, handle.get());
+  return c;
+}
+
+size_t File::readBytes(char* buffer, size_t length) {
+  return read((uint8_t*)buffer, length);
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+  if (!handle) {
+    return 0;
+  }
+  return fread(buffer, 1, size, handle.get());
+}
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+  if (!handle) {
+    return 0;
+  }
+  return fwrite(buffer, 1, size, handle.get());
+}
+
+void File::flush() {
+  if (handle) {
+    fflush(handle.get());
+  }
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+  if (!handle) {
+    return false;
+  }
+  int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+  return fseek(handle.get(), pos, whence) == 0;
+}
+
+size_t File::position() const {
+  if (!handle) {
+    return 0;
+  }
+  long pos = ftell(handle.get());
+  return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+  if (!handle) {
+    return 0;
+  }
+  fflush(handle.get());
+  struct stat st;
+  if (fstat(fileno(handle.get()), &st) != 0) {
+    return 0;
+  }
+  return (size_t)st.st_size;
+}
+
+void File::close() {
+  handle.reset();
+}
+
+const char* File::name() const {
+  int slash = path.lastIndexOf('/');
+  return path.c_str() + (slash >= 0 ? slash + 1 : 0);
+}
+
+const char* File::fullName() const {
+  return path.c_str();
+}
+
+// ---------------------------------------------------------------------------
+// FS
+// ---------------------------------------------------------------------------
+
+String FS::hostPath(const char* path) {
+  String result(nativeFsRoot());
+  result += "/";
+  result += label;
+  if (path == nullptr || path[0] != '/') {
+    result += "/";
+  }
+  result += path;
+  return result;
+}
+
+bool FS::begin() {
+  mkdir(hostPath("").c_str(), 0755);
+  mounted = true;
+  return true;
+}
+
+void FS::end() {
+  mounted = false;
+}
+
+bool FS::format() {
+  removeTree(hostPath("").c_str());
+  mkdir(hostPath("").c_str(), 0755);
+  return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+  const char* fopenMode = hostMode(mode);
+  if (!mounted || path == nullptr || fopenMode == nullptr) {
+    return File();
+  }
+  String fullPath = hostPath(path);
+  if (mode[0] != 'r') {
+    makeParentDirs(fullPath.c_str());
+  }
+  FILE* file = fopen(fullPath.c_str(), fopenMode);
+  if (file == nullptr) {
+    return File();
+  }
+  return File(file, String(path));
+}
+
+bool FS::exists(const char* path) {
+  if (!mounted || path == nullptr) {
+    return false;
+  }
+  struct stat st;
+  return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+  if (!mounted || path == nullptr) {
+    return false;
+  }
+  return unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+  if (!mounted || pathFrom == nullptr || pathTo == nullptr) {
+    return false;
+  }
+  String to = hostPath(pathTo);
+  makeParentDirs(to.c_str());
+  return ::rename(hostPath(pathFrom).c_str(), to.c_str()) == 0;
+}
+
+}  // namespace fs
\ No newline at end of file
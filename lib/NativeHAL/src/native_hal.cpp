@@ -0,0 +1,645 @@
+#include "Arduino.h"
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <ctype.h>
+#include <deque>
+#include <random>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// 全局实例
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+EspClass ESP;
+
+// ---------------------------------------------------------------------------
+// 时间函数
+// ---------------------------------------------------------------------------
+
+static uint64_t monotonicNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const uint64_t startNanos = monotonicNanos();
+
+unsigned long millis() {
+  return (unsigned long)((monotonicNanos() - startNanos) / 1000000ULL);
+}
+
+unsigned long micros() {
+  // 与ESP8266一致，按32位回绕
+  return (uint32_t)((monotonicNanos() - startNanos) / 1000ULL);
+}
+
+void delay(unsigned long ms) {
+  struct timespec ts;
+  ts.tv_sec = ms / 1000;
+  ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+  nanosleep(&ts, nullptr);
+}
+
+void delayMicroseconds(unsigned int us) {
+  // 短延时使用忙等待，保证精度
+  uint64_t until = monotonicNanos() + (uint64_t)us * 1000ULL;
+  while (monotonicNanos() < until) {
+  }
+}
+
+void yield() {
+}
+
+// esp_schedule()使正在进行的esp_delay()提前返回
+static volatile bool scheduled = false;
+
+void esp_schedule() {
+  scheduled = true;
+}
+
+void esp_delay(uint32_t ms) {
+  uint64_t until = monotonicNanos() + (uint64_t)ms * 1000000ULL;
+  struct timespec ts = {0, 200000L};
+  while (!scheduled && monotonicNanos() < until) {
+    nanosleep(&ts, nullptr);
+  }
+  scheduled = false;
+}
+
+// ---------------------------------------------------------------------------
+// GPIO与随机数
+// ---------------------------------------------------------------------------
+
+static uint8_t pinStates[32];
+static void (*pinHandlers[32])(void);
+static int pinInterruptModes[32];
+
+// 电平触发的中断在引脚处于该电平时触发
+static void checkPinInterrupt(uint8_t pin) {
+  if (pinHandlers[pin] == nullptr) {
+    return;
+  }
+  int mode = pinInterruptModes[pin];
+  bool low = mode == ONLOW || mode == ONLOW_WE;
+  bool high = mode == ONHIGH || mode == ONHIGH_WE;
+  if ((low && pinStates[pin] == LOW) || (high && pinStates[pin] == HIGH)) {
+    pinHandlers[pin]();
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < sizeof(pinStates)) {
+    uint8_t previous = pinStates[pin];
+    pinStates[pin] = value ? HIGH : LOW;
+    if (pinHandlers[pin] != nullptr) {
+      int mode = pinInterruptModes[pin];
+      bool rising = previous == LOW && pinStates[pin] == HIGH;
+      bool falling = previous == HIGH && pinStates[pin] == LOW;
+      if ((mode == RISING && rising) || (mode == FALLING && falling) || (mode == CHANGE && (rising || falling))) {
+        pinHandlers[pin]();
+      } else {
+        checkPinInterrupt(pin);
+      }
+    }
+  }
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode) {
+  if (pin < sizeof(pinStates)) {
+    pinHandlers[pin] = handler;
+    pinInterruptModes[pin] = mode;
+    checkPinInterrupt(pin);
+  }
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (pin < sizeof(pinStates)) {
+    pinHandlers[pin] = nullptr;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < sizeof(pinStates) ? pinStates[pin] : LOW;
+}
+
+long random(long howBig) {
+  return howBig > 0 ? ::random() % howBig : 0;
+}
+
+long random(long howSmall, long howBig) {
+  return howBig > howSmall ? howSmall + random(howBig - howSmall) : howSmall;
+}
+
+void randomSeed(unsigned long seed) {
+  srandom((unsigned int)seed);
+}
+
+// ---------------------------------------------------------------------------
+// String
+// ---------------------------------------------------------------------------
+
+static std::string formatInteger(unsigned long long value, unsigned char base, bool negative) {
+  if (base < 2 || base > 36) {
+    base = 10;
+  }
+  char digits[66];
+  int pos = sizeof(digits) - 1;
+  digits[pos] = '\0';
+  do {
+    int digit = value % base;
+    digits[--pos] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value > 0);
+  if (negative) {
+    digits[--pos] = '-';
+  }
+  return std::string(&digits[pos]);
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+  // 与Arduino一致：只有十进制显示负号，其它进制按无符号显示
+  if (base == 10 && value < 0) {
+    return formatInteger(0ULL - (unsigned long long)value, base, true);
+  }
+  return formatInteger((unsigned long long)value, base, false);
+}
+
+static std::string formatDouble(double value, unsigned char decimalPlaces) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+  return std::string(buffer);
+}
+
+String::String(unsigned char value, unsigned char base) : buffer(formatInteger(value, base, false)) {}
+String::String(int value, unsigned char base) : buffer(base == 10 ? formatSigned(value, base) : formatInteger((unsigned int)value, base, false)) {}
+String::String(unsigned int value, unsigned char base) : buffer(formatInteger(value, base, false)) {}
+String::String(long value, unsigned char base) : buffer(base == 10 ? formatSigned(value, base) : formatInteger((unsigned long)value, base, false)) {}
+String::String(unsigned long value, unsigned char base) : buffer(formatInteger(value, base, false)) {}
+String::String(float value, unsigned char decimalPlaces) : buffer(formatDouble(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : buffer(formatDouble(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String& other) const {
+  if (buffer.length() != other.buffer.length()) {
+    return false;
+  }
+  for (size_t i = 0; i < buffer.length(); i++) {
+    if (tolower((unsigned char)buffer[i]) != tolower((unsigned char)other.buffer[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+  if (suffix.buffer.length() > buffer.length()) {
+    return false;
+  }
+  return buffer.compare(buffer.length() - suffix.buffer.length(), suffix.buffer.length(), suffix.buffer) == 0;
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+  size_t pos = buffer.find(c, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+  size_t pos = buffer.find(str.buffer, fromIndex);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+  size_t pos = buffer.rfind(c);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+  return substring(beginIndex, buffer.length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    std::swap(beginIndex, endIndex);
+  }
+  if (beginIndex >= buffer.length()) {
+    return String();
+  }
+  endIndex = std::min<unsigned int>(endIndex, buffer.length());
+  return String(buffer.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::trim() {
+  size_t begin = 0;
+  while (begin < buffer.length() && isspace((unsigned char)buffer[begin])) {
+    begin++;
+  }
+  size_t end = buffer.length();
+  while (end > begin && isspace((unsigned char)buffer[end - 1])) {
+    end--;
+  }
+  buffer = buffer.substr(begin, end - begin);
+}
+
+void String::toLowerCase() {
+  for (char& c : buffer) {
+    c = (char)tolower((unsigned char)c);
+  }
+}
+
+void String::toUpperCase() {
+  for (char& c : buffer) {
+    c = (char)toupper((unsigned char)c);
+  }
+}
+
+void String::replace(const String& find, const String& replacement) {
+  if (find.buffer.empty()) {
+    return;
+  }
+  size_t pos = 0;
+  while ((pos = buffer.find(find.buffer, pos)) != std::string::npos) {
+    buffer.replace(pos, find.buffer.length(), replacement.buffer);
+    pos += replacement.buffer.length();
+  }
+}
+
+void String::remove(unsigned int index) {
+  if (index < buffer.length()) {
+    buffer.erase(index);
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < buffer.length()) {
+    buffer.erase(index, count);
+  }
+}
+
+StringSumHelper operator+(const String& lhs, const String& rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, const char* rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const char* lhs, const String& rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+StringSumHelper operator+(const String& lhs, char rhs) {
+  StringSumHelper result(lhs);
+  result.concat(rhs);
+  return result;
+}
+
+// ---------------------------------------------------------------------------
+// Print / Stream
+// ---------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (size--) {
+    written += write(*buffer++);
+  }
+  return written;
+}
+
+size_t Print::print(long value, int base) {
+  std::string str = formatSigned(value, base);
+  return write(str.c_str(), str.length());
+}
+
+size_t Print::print(unsigned long value, int base) {
+  std::string str = formatInteger(value, base, false);
+  return write(str.c_str(), str.length());
+}
+
+size_t Print::print(long long value, int base) {
+  std::string str = formatSigned(value, base);
+  return write(str.c_str(), str.length());
+}
+
+size_t Print::print(unsigned long long value, int base) {
+  std::string str = formatInteger(value, base, false);
+  return write(str.c_str(), str.length());
+}
+
+size_t Print::print(double value, int digits) {
+  std::string str = formatDouble(value, digits);
+  return write(str.c_str(), str.length());
+}
+
+static size_t vprintTo(Print& out, const char* format, va_list args) {
+  char stackBuffer[256];
+  va_list copy;
+  va_copy(copy, args);
+  int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, copy);
+  va_end(copy);
+  if (length < 0) {
+    return 0;
+  }
+  if ((size_t)length < sizeof(stackBuffer)) {
+    return out.write(stackBuffer, length);
+  }
+  std::unique_ptr<char[]> heapBuffer(new char[length + 1]);
+  vsnprintf(heapBuffer.get(), length + 1, format, args);
+  return out.write(heapBuffer.get(), length);
+}
+
+size_t Print::printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t written = vprintTo(*this, format, args);
+  va_end(args);
+  return written;
+}
+
+size_t Print::printf_P(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  size_t written = vprintTo(*this, format, args);
+  va_end(args);
+  return written;
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) {
+      return c;
+    }
+    yield();
+  } while (millis() - start < streamTimeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+String Stream::readString() {
+  String result;
+  int c = timedRead();
+  while (c >= 0) {
+    result += (char)c;
+    c = timedRead();
+  }
+  return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String result;
+  int c = timedRead();
+  while (c >= 0 && c != terminator) {
+    result += (char)c;
+    c = timedRead();
+  }
+  return result;
+}
+
+// ---------------------------------------------------------------------------
+// 串口：Serial的输入来自命令行参数或标准输入
+// ---------------------------------------------------------------------------
+
+static std::deque<uint8_t> serialInput;
+static bool inputFromArgs = false;
+static bool stdinClosed = false;
+static int exitCode = 0;
+
+static void pollStdin() {
+  if (inputFromArgs || stdinClosed) {
+    return;
+  }
+  struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+  while (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLIN | POLLHUP))) {
+    uint8_t buffer[256];
+    ssize_t n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (n <= 0) {
+      stdinClosed = true;
+      return;
+    }
+    serialInput.insert(serialInput.end(), buffer, buffer + n);
+  }
+}
+
+int HardwareSerial::available() {
+  if (uart != 0) {
+    return 0;
+  }
+  pollStdin();
+  return (int)serialInput.size();
+}
+
+int HardwareSerial::read() {
+  if (available() == 0) {
+    return -1;
+  }
+  uint8_t c = serialInput.front();
+  serialInput.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() {
+  if (available() == 0) {
+    return -1;
+  }
+  return serialInput.front();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, uart == 0 ? stdout : stderr);
+}
+
+void HardwareSerial::flush() {
+  fflush(uart == 0 ? stdout : stderr);
+}
+
+void nativeSetArgsInput(bool fromArgs) {
+  inputFromArgs = fromArgs;
+}
+
+void nativeQueueInputLine(const char* line) {
+  serialInput.insert(serialInput.end(), line, line + strlen(line));
+  serialInput.push_back('\n');
+}
+
+bool nativeInputExhausted() {
+  pollStdin();
+  return serialInput.empty() && (inputFromArgs || stdinClosed);
+}
+
+void nativeSetExitCode(int code) {
+  exitCode = code;
+}
+
+int nativeExitCode() {
+  return exitCode;
+}
+
+void nativeExit() {
+  fflush(stdout);
+  fflush(stderr);
+  exit(exitCode);
+}
+
+// ---------------------------------------------------------------------------
+// ESP
+// ---------------------------------------------------------------------------
+
+static uint8_t cpuFreqMHz = 0;
+
+uint32_t EspClass::getCycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  return (uint32_t)monotonicNanos();
+#endif
+}
+
+uint8_t EspClass::getCpuFreqMHz() {
+  // 首次调用时用单调时钟标定周期计数器频率 (超过255MHz时按255显示)
+  if (cpuFreqMHz == 0) {
+    uint64_t startNs = monotonicNanos();
+    uint32_t startCycles = getCycleCount();
+    delay(20);
+    uint32_t cycles = getCycleCount() - startCycles;
+    uint64_t elapsedNs = monotonicNanos() - startNs;
+    uint64_t mhz = elapsedNs > 0 ? (uint64_t)cycles * 1000ULL / elapsedNs : 0;
+    cpuFreqMHz = (uint8_t)std::min<uint64_t>(std::max<uint64_t>(mhz, 1), 255);
+  }
+  return cpuFreqMHz;
+}
+
+uint32_t EspClass::getFreeHeap() {
+  // 本机没有固定大小的堆，以ESP8266的典型可用值为起点，减去第一次调用以来进程堆的净分配，
+  // 以便上层的堆统计能观察到分配和释放
+  const int64_t typicalFree = 40 * 1024;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  static int64_t baseline = -1;
+  int64_t used = (int64_t)mallinfo2().uordblks;
+  if (baseline < 0) {
+    baseline = used;
+  }
+  int64_t freeHeap = typicalFree - (used - baseline);
+  return freeHeap > 0 ? (uint32_t)freeHeap : 0;
+#else
+  return (uint32_t)typicalFree;
+#endif
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+  return getFreeHeap();
+}
+
+uint8_t EspClass::getHeapFragmentation() {
+  return 0;
+}
+
+uint32_t EspClass::getFreeContStack() {
+  return 4096;  // ESP8266核心的CONT_STACKSIZE
+}
+
+void EspClass::resetFreeContStack() {
+}
+
+static const uint32_t NATIVE_FLASH_SIZE = 0x400000;
+static const uint32_t NATIVE_FLASH_ERASE_US = 20000;  // 扇区擦除的典型时间，擦除期间调用者阻塞
+
+static std::vector<uint8_t>& nativeFlash() {
+  static std::vector<uint8_t> flash(NATIVE_FLASH_SIZE, 0xFF);
+  return flash;
+}
+
+bool EspClass::flashEraseSector(uint32_t sector) {
+  uint32_t address = sector * FLASH_SECTOR_SIZE;
+  if (address + FLASH_SECTOR_SIZE > NATIVE_FLASH_SIZE) {
+    return false;
+  }
+  memset(&nativeFlash()[address], 0xFF, FLASH_SECTOR_SIZE);
+  delayMicroseconds(NATIVE_FLASH_ERASE_US);
+  return true;
+}
+
+bool EspClass::flashWrite(uint32_t address, const uint32_t* data, size_t size) {
+  if ((address & 3) != 0 || (size & 3) != 0 || address + size > NATIVE_FLASH_SIZE) {
+    return false;
+  }
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; i++) {
+    nativeFlash()[address + i] &= bytes[i];
+  }
+  return true;
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t* data, size_t size) {
+  if ((address & 3) != 0 || (size & 3) != 0 || address + size > NATIVE_FLASH_SIZE) {
+    return false;
+  }
+  memcpy(data, &nativeFlash()[address], size);
+  return true;
+}
+
+uint32_t EspClass::getChipId() {
+  return (uint32_t)getpid() & 0xFFFFFF;
+}
+
+uint32_t EspClass::random() {
+  static std::random_device device;
+  return device();
+}
+
+static uint32_t rtcUserMemory[128];
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset >= 128 || offset * 4 + size > sizeof(rtcUserMemory)) {
+    return false;
+  }
+  memcpy(data, &rtcUserMemory[offset], size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset >= 128 || offset * 4 + size > sizeof(rtcUserMemory)) {
+    return false;
+  }
+  memcpy(&rtcUserMemory[offset], data, size);
+  return true;
+}
+
+void EspClass::restart() {
+  nativeExit();
+}
+
+void EspClass::reset() {
+  nativeExit();
+}
\ No newline at end of file
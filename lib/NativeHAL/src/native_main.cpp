@@ -0,0 +1,23 @@
+#include "Arduino.h"
+
+// Arduino程序的本机入口
+// 单独放在一个文件中：程序自己定义了main()时(例如主机模拟器)，链接器不会引入本文件
+int main(int argc, char** argv) {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  nativeSetArgsInput(argc > 1);
+
+  setup();
+
+  // 命令行参数在setup()之后作为串口输入行送入，例如: program all bench
+  // (setup()通常会清空串口缓冲区)
+  for (int i = 1; i < argc; i++) {
+    nativeQueueInputLine(argv[i]);
+  }
+
+  while (!nativeInputExhausted()) {
+    loop();
+  }
+
+  nativeExit();
+  return nativeExitCode();
+}
\ No newline at end of file
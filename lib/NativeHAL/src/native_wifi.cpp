@@ -0,0 +1,403 @@
+#include "ESP8266WiFi.h"
+#include "ESP8266mDNS.h"
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <vector>
+
+ESP8266WiFiClass WiFi;
+
+// ---------------------------------------------------------------------------
+// IPAddress
+// ---------------------------------------------------------------------------
+
+bool IPAddress::fromString(const char* str) {
+  struct in_addr parsed;
+  if (str == nullptr || inet_pton(AF_INET, str, &parsed) != 1) {
+    return false;
+  }
+  address = parsed.s_addr;
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+  return String(buffer);
+}
+
+// ---------------------------------------------------------------------------
+// WiFiClient
+// ---------------------------------------------------------------------------
+
+struct WiFiClient::Socket {
+  int fd;
+  bool peerClosed;
+  std::vector<uint8_t> rxBuffer;
+  size_t rxOffset;
+
+  explicit Socket(int socketFd) : fd(socketFd), peerClosed(false), rxOffset(0) {}
+  ~Socket() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+static void setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+WiFiClient::WiFiClient() {}
+
+WiFiClient::WiFiClient(int fd) : socket(std::make_shared<Socket>(fd)) {
+  setNonBlocking(fd);
+}
+
+WiFiClient::~WiFiClient() {}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  stop();
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = (uint32_t)ip;
+
+  // 与ESP8266一致，connect()阻塞直到连接建立或失败
+  if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+    ::close(fd);
+    return 0;
+  }
+  socket = std::make_shared<Socket>(fd);
+  setNonBlocking(fd);
+  return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip)) {
+    return 0;
+  }
+  return connect(ip, port);
+}
+
+bool WiFiClient::fillBuffer() {
+  if (!socket || socket->fd < 0) {
+    return false;
+  }
+  if (socket->rxOffset >= socket->rxBuffer.size()) {
+    socket->rxBuffer.clear();
+    socket->rxOffset = 0;
+  }
+  uint8_t buffer[1460];
+  ssize_t n = recv(socket->fd, buffer, sizeof(buffer), 0);
+  if (n > 0) {
+    socket->rxBuffer.insert(socket->rxBuffer.end(), buffer, buffer + n);
+    return true;
+  }
+  if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+    socket->peerClosed = true;
+  }
+  return false;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+  if (!socket || socket->fd < 0 || socket->peerClosed) {
+    return 0;
+  }
+  // 与ESP8266一致，write()阻塞直到数据全部交给协议栈
+  size_t written = 0;
+  while (written < size) {
+    ssize_t n = send(socket->fd, buffer + written, size - written, MSG_NOSIGNAL);
+    if (n > 0) {
+      written += n;
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      delayMicroseconds(50);
+    } else {
+      socket->peerClosed = true;
+      break;
+    }
+  }
+  return written;
+}
+
+int WiFiClient::availableForWrite() {
+  if (!socket || socket->fd < 0 || socket->peerClosed) {
+    return 0;
+  }
+  int sendBuffer = 0;
+  socklen_t optionLength = sizeof(sendBuffer);
+  getsockopt(socket->fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, &optionLength);
+  int queued = 0;
+  ioctl(socket->fd, TIOCOUTQ, &queued);
+  // 限制为ESP8266 lwIP发送窗口的量级
+  return std::max(0, std::min(sendBuffer - queued, 2920));
+}
+
+int WiFiClient::available() {
+  if (!socket) {
+    return 0;
+  }
+  while (fillBuffer()) {
+  }
+  return (int)(socket->rxBuffer.size() - socket->rxOffset);
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+  if (available() == 0) {
+    return -1;
+  }
+  size_t count = std::min(size, socket->rxBuffer.size() - socket->rxOffset);
+  memcpy(buffer, socket->rxBuffer.data() + socket->rxOffset, count);
+  socket->rxOffset += count;
+  return (int)count;
+}
+
+int WiFiClient::peek() {
+  if (available() == 0) {
+    return -1;
+  }
+  return socket->rxBuffer[socket->rxOffset];
+}
+
+uint8_t WiFiClient::connected() {
+  if (!socket || socket->fd < 0) {
+    return 0;
+  }
+  // 与Arduino一致：对端关闭后，缓冲区中还有数据时仍视为已连接
+  return available() > 0 || !socket->peerClosed;
+}
+
+void WiFiClient::stop() {
+  socket.reset();
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+  if (socket && socket->fd >= 0) {
+    int flag = noDelay ? 1 : 0;
+    setsockopt(socket->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+  }
+}
+
+static bool socketAddress(int fd, bool peer, struct sockaddr_in& addr) {
+  socklen_t length = sizeof(addr);
+  int result = peer ? getpeername(fd, (struct sockaddr*)&addr, &length) : getsockname(fd, (struct sockaddr*)&addr, &length);
+  return result == 0;
+}
+
+IPAddress WiFiClient::remoteIP() {
+  struct sockaddr_in addr;
+  if (!socket || !socketAddress(socket->fd, true, addr)) {
+    return IPAddress();
+  }
+  return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
+
+uint16_t WiFiClient::remotePort() {
+  struct sockaddr_in addr;
+  if (!socket || !socketAddress(socket->fd, true, addr)) {
+    return 0;
+  }
+  return ntohs(addr.sin_port);
+}
+
+IPAddress WiFiClient::localIP() {
+  struct sockaddr_in addr;
+  if (!socket || !socketAddress(socket->fd, false, addr)) {
+    return IPAddress();
+  }
+  return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
+
+uint16_t WiFiClient::localPort() {
+  struct sockaddr_in addr;
+  if (!socket || !socketAddress(socket->fd, false, addr)) {
+    return 0;
+  }
+  return ntohs(addr.sin_port);
+}
+
+int WiFiClient::nativeSocket() const {
+  return socket ? socket->fd : -1;
+}
+
+// ---------------------------------------------------------------------------
+// WiFiServer
+// ---------------------------------------------------------------------------
+
+WiFiServer::WiFiServer(uint16_t port)
+    : bindAddress(IPAddress(127, 0, 0, 1)), serverPort(port), listenFd(-1), serverNoDelay(false), pendingFd(-1) {}
+
+WiFiServer::WiFiServer(IPAddress address, uint16_t port)
+    : bindAddress(address), serverPort(port), listenFd(-1), serverNoDelay(false), pendingFd(-1) {}
+
+WiFiServer::~WiFiServer() {
+  close();
+}
+
+void WiFiServer::begin() {
+  close();
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return;
+  }
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(serverPort);
+  addr.sin_addr.s_addr = (uint32_t)bindAddress;
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+    ::close(fd);
+    return;
+  }
+
+  // 端口为0时由系统分配，回填实际端口
+  if (serverPort == 0 && socketAddress(fd, false, addr)) {
+    serverPort = ntohs(addr.sin_port);
+  }
+  setNonBlocking(fd);
+  listenFd = fd;
+}
+
+void WiFiServer::begin(uint16_t port) {
+  serverPort = port;
+  begin();
+}
+
+bool WiFiServer::hasClient() {
+  if (pendingFd < 0 && listenFd >= 0) {
+    pendingFd = ::accept(listenFd, nullptr, nullptr);
+  }
+  return pendingFd >= 0;
+}
+
+WiFiClient WiFiServer::available() {
+  if (!hasClient()) {
+    return WiFiClient();
+  }
+  WiFiClient client(pendingFd);
+  pendingFd = -1;
+  client.setNoDelay(serverNoDelay);
+  return client;
+}
+
+void WiFiServer::close() {
+  if (pendingFd >= 0) {
+    ::close(pendingFd);
+    pendingFd = -1;
+  }
+  if (listenFd >= 0) {
+    ::close(listenFd);
+    listenFd = -1;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// WiFi
+// ---------------------------------------------------------------------------
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* bssid, bool connect) {
+  (void)channel;
+  (void)bssid;
+  ssidName = ssid;
+  pskValue = passphrase != nullptr ? passphrase : "";
+  wifiStatus = connect ? WL_CONNECTED : WL_DISCONNECTED;
+  return wifiStatus;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff) {
+  (void)wifiOff;
+  wifiStatus = WL_DISCONNECTED;
+  return true;
+}
+
+int ESP8266WiFiClass::hostByName(const char* host, IPAddress& result) {
+  if (host == nullptr) {
+    return 0;
+  }
+  if (result.fromString(host)) {
+    return 1;
+  }
+  // mDNS主机名(.local)在本机构建中统一解析为回环地址
+  size_t length = strlen(host);
+  if (length > 6 && strcmp(host + length - 6, ".local") == 0) {
+    result = IPAddress(127, 0, 0, 1);
+    return 1;
+  }
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  struct addrinfo* info = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &info) != 0 || info == nullptr) {
+    return 0;
+  }
+  result = IPAddress((uint32_t)((struct sockaddr_in*)info->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(info);
+  return 1;
+}
+MDNSResponder MDNS;
+
+bool MDNSResponder::begin(const char* hostname) {
+  this->hostname = hostname;
+  return true;
+}
+
+void MDNSResponder::end() {
+  services.clear();
+  answers.clear();
+}
+
+bool MDNSResponder::addService(const char* service, const char* protocol, uint16_t port) {
+  // 与ESP8266一致，服务名不带下划线前缀
+  services.push_back(Service{hostname, service, protocol, port});
+  return true;
+}
+
+uint32_t MDNSResponder::queryService(const char* service, const char* protocol, uint16_t timeoutMs) {
+  (void)timeoutMs;
+  answers.clear();
+  for (const Service& entry : services) {
+    if (entry.service == service && entry.protocol == protocol) {
+      answers.push_back(entry);
+    }
+  }
+  return answers.size();
+}
+
+bool MDNSResponder::removeQuery() {
+  answers.clear();
+  return true;
+}
+
+const char* MDNSResponder::answerHostname(uint32_t index) {
+  return index < answers.size() ? answers[index].hostname.c_str() : nullptr;
+}
+
+IPAddress MDNSResponder::answerIP(uint32_t index) {
+  return index < answers.size() ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+uint16_t MDNSResponder::answerPort(uint32_t index) {
+  return index < answers.size() ? answers[index].port : 0;
+}
@@ -0,0 +1,44 @@
+#include "boot_profiler.h"
+#include "logger.h"
+
+// 全局启动计时实例
+BootProfiler bootProfiler;
+
+BootProfiler::BootProfiler() : phaseCount(0), lastUs(0) {
+  // 构造函数
+}
+
+void BootProfiler::begin() {
+  phaseCount = 0;
+  lastUs = 0;
+  mark("sdk");
+}
+
+void BootProfiler::mark(const char* name) {
+  uint32_t now = micros();
+  if (phaseCount < BOOT_MAX_PHASES) {
+    BootPhase& phase = phases[phaseCount++];
+    phase.name = name;
+    phase.endUs = now;
+    phase.durationUs = now - lastUs;
+  }
+  lastUs = now;
+}
+
+void BootProfiler::finish() {
+  mark("services");
+  for (uint8_t i = 0; i < phaseCount; i++) {
+    LOG_I("Boot", "%-10s %6u us (累计 %u ms)", phases[i].name, phases[i].durationUs, phases[i].endUs / 1000);
+  }
+}
+
+void BootProfiler::printJson(Print& out) {
+  out.printf("{\"total_us\":%u,\"phases\":[", lastUs);
+  for (uint8_t i = 0; i < phaseCount; i++) {
+    if (i > 0) {
+      out.print(',');
+    }
+    out.printf("{\"name\":\"%s\",\"us\":%u,\"end_us\":%u}", phases[i].name, phases[i].durationUs, phases[i].endUs);
+  }
+  out.print("]}");
+}
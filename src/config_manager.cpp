@@ -1,9 +1,12 @@
 #include "config_manager.h"
+#include "config_schema.h"
+#include "heap_profiler.h"
+#include "logger.h"
+#include "rtc_store.h"
 #include <ESP8266WiFi.h>
 #include <ArduinoJson.h>
-#include <FS.h>
 
-ConfigManager::ConfigManager() {
+ConfigManager::ConfigManager() : fileSystem(&FILE_SYSTEM) {
   // 初始化默认配置
   generateDefaultConfig();
 }
@@ -13,60 +16,65 @@ ConfigManager::~ConfigManager() {
 }
 
 bool ConfigManager::begin() {
-  // 挂载SPIFFS
-  if (!mountSPIFFS()) {
-    Serial.println("Failed to mount SPIFFS");
+  // 挂载文件系统
+  if (!mountFileSystem()) {
     return false;
   }
   
-  // 如果配置文件存在，加载配置
-  if (configFileExists()) {
+  // 如果配置文件存在 (或上次写入中断后只剩备份)，加载配置
+  if (configFileExists() || fileSystem->exists(CONFIG_BACKUP_FILE_PATH)) {
     if (!loadConfig()) {
-      Serial.println("Failed to load config, using default config");
+      LOG_E("Config", "Failed to load config, using default config");
       generateDefaultConfig();
     }
   } else {
     // 配置文件不存在，生成默认配置并保存
-    Serial.println("Config file not found, generating default config");
+    LOG_I("Config", "Config file not found, generating default config");
     generateDefaultConfig();
     saveConfig();
   }
   
   // 验证配置
   if (!validateConfig()) {
-    Serial.println("Invalid config, using default config");
+    LOG_W("Config", "Invalid config, using default config");
     generateDefaultConfig();
   }
   
   return true;
 }
 
-bool ConfigManager::mountSPIFFS() {
-  // 挂载SPIFFS文件系统
-  if (!SPIFFS.begin()) {
-    Serial.println("Failed to mount SPIFFS");
+bool ConfigManager::mountFileSystem() {
+  // 挂载文件系统
+  if (!fileSystem->begin()) {
+    LOG_E("Config", "Failed to mount %s", FILE_SYSTEM_NAME);
     return false;
   }
   return true;
 }
 
-void ConfigManager::unmountSPIFFS() {
-  // 卸载SPIFFS文件系统
-  SPIFFS.end();
+void ConfigManager::unmountFileSystem() {
+  // 卸载文件系统
+  fileSystem->end();
 }
 
 bool ConfigManager::loadConfig() {
-  // 检查配置文件是否存在
-  if (!configFileExists()) {
-    Serial.println("Config file does not exist");
-    return false;
+  HEAP_SCOPE(HEAP_TAG_CONFIG);
+
+  // 优先使用配置文件，不存在或损坏时使用上次写入前保留的备份
+  if (configFileExists() && parseConfigFile(CONFIG_FILE_PATH)) {
+    return true;
   }
-  
-  // 解析配置文件
-  return parseConfigFile();
+  if (fileSystem->exists(CONFIG_BACKUP_FILE_PATH) && parseConfigFile(CONFIG_BACKUP_FILE_PATH)) {
+    LOG_W("Config", "Config file unavailable, loaded backup");
+    return true;
+  }
+  LOG_I("Config", "Config file does not exist");
+  return false;
 }
 
 bool ConfigManager::saveConfig() {
+  HEAP_SCOPE(HEAP_TAG_CONFIG);
+
   // 写入配置文件
   return writeConfigFile();
 }
@@ -85,6 +93,7 @@ void ConfigManager::generateDefaultConfig() {
   rs485Config.dataBits = 8;
   rs485Config.parity = 0;  // 0: None, 1: Odd, 2: Even
   rs485Config.stopBits = 1;
+  rs485Config.replayTiming = DEFAULT_REPLAY_TIMING;
   
   // 生成设备配置默认值
 #ifdef DEVICE_ROLE_MASTER
@@ -103,71 +112,24 @@ void ConfigManager::generateDefaultConfig() {
   deviceConfig.tcpPort = 8888;
   deviceConfig.syncPort = 8889;
 #endif
+  deviceConfig.powerMode = DEFAULT_POWER_MODE;
+  deviceConfig.maxWakeLatencyMs = DEFAULT_MAX_WAKE_LATENCY_MS;
+  deviceConfig.otaPassword = DEFAULT_OTA_PASSWORD;
 }
 
 bool ConfigManager::validateConfig() {
-  // 验证网络配置
-  if (networkConfig.ssid.length() == 0) {
-    Serial.println("Invalid SSID");
-    return false;
-  }
-  
-  if (networkConfig.password.length() == 0) {
-    Serial.println("Invalid password");
-    return false;
-  }
-  
-  if (!networkConfig.dhcpEnabled) {
-    if (networkConfig.ip.length() == 0 || 
-        networkConfig.gateway.length() == 0 || 
-        networkConfig.subnet.length() == 0) {
-      Serial.println("Invalid static IP configuration");
+  const void* sections[CONFIG_SECTION_COUNT] = {&networkConfig, &rs485Config, &deviceConfig};
+  for (uint8_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    const ConfigField& field = CONFIG_FIELDS[i];
+    // 使用DHCP时不检查静态IP配置
+    if ((field.flags & CONFIG_FLAG_STATIC_IP) && networkConfig.dhcpEnabled) {
+      continue;
+    }
+    if (!configValidateField(field, sections[field.section])) {
+      LOG_W("Config", "Invalid %s.%s", CONFIG_SECTION_NAMES[field.section], field.key);
       return false;
     }
   }
-  
-  // 验证RS485配置
-  if (rs485Config.baudRate < 1200 || rs485Config.baudRate > 115200) {
-    Serial.println("Invalid baud rate");
-    return false;
-  }
-  
-  if (rs485Config.dataBits < 5 || rs485Config.dataBits > 8) {
-    Serial.println("Invalid data bits");
-    return false;
-  }
-  
-  if (rs485Config.parity < 0 || rs485Config.parity > 2) {
-    Serial.println("Invalid parity");
-    return false;
-  }
-  
-  if (rs485Config.stopBits < 1 || rs485Config.stopBits > 2) {
-    Serial.println("Invalid stop bits");
-    return false;
-  }
-  
-  // 验证设备配置
-  if (deviceConfig.name.length() == 0) {
-    Serial.println("Invalid device name");
-    return false;
-  }
-  
-  if (deviceConfig.role != "master" && deviceConfig.role != "slave") {
-    Serial.println("Invalid device role");
-    return false;
-  }
-  
-  if (deviceConfig.tcpPort < 0 || deviceConfig.tcpPort > 65535) {
-    Serial.println("Invalid TCP port");
-    return false;
-  }
-  
-  if (deviceConfig.syncPort < 0 || deviceConfig.syncPort > 65535) {
-    Serial.println("Invalid sync port");
-    return false;
-  }
-  
   return true;
 }
 
@@ -195,110 +157,187 @@ void ConfigManager::setDeviceConfig(const DeviceConfig& config) {
   deviceConfig = config;
 }
 
+void ConfigManager::toJson(JsonDocument& doc, uint8_t skipFlags) {
+  const void* sections[CONFIG_SECTION_COUNT] = {&networkConfig, &rs485Config, &deviceConfig};
+  configToJson(doc, sections, skipFlags);
+}
+
+uint8_t ConfigManager::changedFlags(const NetworkConfig& network, const RS485Config& rs485,
+                                    const DeviceConfig& device) {
+  const void* previous[CONFIG_SECTION_COUNT] = {&network, &rs485, &device};
+  const void* current[CONFIG_SECTION_COUNT] = {&networkConfig, &rs485Config, &deviceConfig};
+  return configDiffFlags(configDiff(previous, current));
+}
+
 bool ConfigManager::configFileExists() {
-  return SPIFFS.exists(CONFIG_FILE_PATH);
+  return fileSystem->exists(CONFIG_FILE_PATH);
 }
 
 bool ConfigManager::deleteConfigFile() {
-  return SPIFFS.remove(CONFIG_FILE_PATH);
+  fileSystem->remove(CONFIG_BACKUP_FILE_PATH);
+  fileSystem->remove(CONFIG_TEMP_FILE_PATH);
+  return fileSystem->remove(CONFIG_FILE_PATH);
 }
 
-bool ConfigManager::parseConfigFile() {
+bool ConfigManager::parseConfigFile(const char* path) {
   // 打开配置文件
-  File configFile = SPIFFS.open(CONFIG_FILE_PATH, "r");
+  File configFile = fileSystem->open(path, "r");
   if (!configFile) {
-    Serial.println("Failed to open config file for reading");
+    LOG_E("Config", "Failed to open config file for reading");
     return false;
   }
   
   // 获取文件大小
   size_t size = configFile.size();
-  if (size > 4096) {
-    Serial.println("Config file size is too large");
+  if (size > SPIFFS_MAX_SIZE) {
+    LOG_E("Config", "Config file size is too large");
     configFile.close();
     return false;
   }
   
-  // 分配缓冲区并读取文件内容
-  std::unique_ptr<char[]> buf(new char[size]);
-  configFile.readBytes(buf.get(), size);
-  configFile.close();
-  
-  // 解析JSON
+  // 直接从文件解析JSON，不另外分配缓冲区
   DynamicJsonDocument doc(4096);
-  DeserializationError error = deserializeJson(doc, buf.get());
+  DeserializationError error = deserializeJson(doc, configFile);
+  configFile.close();
   if (error) {
-    Serial.println("Failed to parse config file");
+    LOG_E("Config", "Failed to parse config file");
     return false;
   }
   
-  // 解析网络配置
-  JsonObject network = doc["network"];
-  networkConfig.ssid = network["ssid"].as<String>();
-  networkConfig.password = network["password"].as<String>();
-  networkConfig.dhcpEnabled = network["dhcpEnabled"];
-  networkConfig.ip = network["ip"].as<String>();
-  networkConfig.gateway = network["gateway"].as<String>();
-  networkConfig.subnet = network["subnet"].as<String>();
-  
-  // 解析RS485配置
-  JsonObject rs485 = doc["rs485"];
-  rs485Config.baudRate = rs485["baudRate"];
-  rs485Config.dataBits = rs485["dataBits"];
-  rs485Config.parity = rs485["parity"];
-  rs485Config.stopBits = rs485["stopBits"];
-  
-  // 解析设备配置
-  JsonObject device = doc["device"];
-  deviceConfig.name = device["name"].as<String>();
-  deviceConfig.role = device["role"].as<String>();
-  deviceConfig.tcpPort = device["tcpPort"];
-  deviceConfig.syncPort = device["syncPort"];
+  void* sections[CONFIG_SECTION_COUNT] = {&networkConfig, &rs485Config, &deviceConfig};
+  if (!configFromJson(doc, sections)) {
+    LOG_E("Config", "Config file has out-of-range values");
+    return false;
+  }
   
   return true;
 }
 
 bool ConfigManager::writeConfigFile() {
-  // 创建JSON文档
   DynamicJsonDocument doc(4096);
-  
-  // 添加网络配置
-  JsonObject network = doc.createNestedObject("network");
-  network["ssid"] = networkConfig.ssid;
-  network["password"] = networkConfig.password;
-  network["dhcpEnabled"] = networkConfig.dhcpEnabled;
-  network["ip"] = networkConfig.ip;
-  network["gateway"] = networkConfig.gateway;
-  network["subnet"] = networkConfig.subnet;
-  
-  // 添加RS485配置
-  JsonObject rs485 = doc.createNestedObject("rs485");
-  rs485["baudRate"] = rs485Config.baudRate;
-  rs485["dataBits"] = rs485Config.dataBits;
-  rs485["parity"] = rs485Config.parity;
-  rs485["stopBits"] = rs485Config.stopBits;
-  
-  // 添加设备配置
-  JsonObject device = doc.createNestedObject("device");
-  device["name"] = deviceConfig.name;
-  device["role"] = deviceConfig.role;
-  device["tcpPort"] = deviceConfig.tcpPort;
-  device["syncPort"] = deviceConfig.syncPort;
-  
-  // 打开配置文件进行写入
-  File configFile = SPIFFS.open(CONFIG_FILE_PATH, "w");
-  if (!configFile) {
-    Serial.println("Failed to open config file for writing");
+  toJson(doc);
+
+  String content;
+  serializeJson(doc, content);
+
+  // 内容未变时不写入，减少闪存擦写
+  if (readFile(CONFIG_FILE_PATH) == content) {
+    return true;
+  }
+
+  // 先完整写入临时文件，断电时原配置文件不受影响
+  File tempFile = fileSystem->open(CONFIG_TEMP_FILE_PATH, "w");
+  if (!tempFile) {
+    LOG_E("Config", "Failed to open config file for writing");
     return false;
   }
-  
-  // 序列化JSON到文件
-  if (serializeJson(doc, configFile) == 0) {
-    Serial.println("Failed to write config file");
-    configFile.close();
+  size_t written = tempFile.print(content);
+  tempFile.close();
+  if (written != content.length()) {
+    LOG_E("Config", "Failed to write config file");
+    fileSystem->remove(CONFIG_TEMP_FILE_PATH);
+    return false;
+  }
+
+  // 原配置文件保留为备份，再把临时文件改名为配置文件；
+  // 任何一步中断时，配置文件或备份至少有一个是完整的
+  fileSystem->remove(CONFIG_BACKUP_FILE_PATH);
+  if (configFileExists() && !fileSystem->rename(CONFIG_FILE_PATH, CONFIG_BACKUP_FILE_PATH)) {
+    LOG_E("Config", "Failed to back up config file");
+    return false;
+  }
+  if (!fileSystem->rename(CONFIG_TEMP_FILE_PATH, CONFIG_FILE_PATH)) {
+    LOG_E("Config", "Failed to replace config file");
     return false;
   }
-  
-  configFile.close();
   return true;
-}
\ No newline at end of file
+}
+
+String ConfigManager::readFile(const char* path) {
+  // 按文件大小读取：readString()在文件末尾要等待流超时
+  String content;
+  File file = fileSystem->open(path, "r");
+  if (file) {
+    size_t size = file.size();
+    if (size <= SPIFFS_MAX_SIZE) {
+      content.reserve(size);
+      char buffer[128];
+      size_t n;
+      while ((n = file.readBytes(buffer, sizeof(buffer))) > 0) {
+        content.concat(buffer, n);
+      }
+    }
+    file.close();
+  }
+  return content;
+}
+
+// 启动用配置缓存：固定长度字段，整体不超过RTC_STORE_MAX_SIZE
+#define BOOT_CONFIG_RTC_MAGIC 0x43464732  // "CFG2"
+#define BOOT_CONFIG_FLAG_DHCP 0x01
+#define BOOT_CONFIG_FLAG_REPLAY_TIMING 0x02
+
+struct BootConfigCache {
+  char ssid[33];
+  char password[65];
+  uint8_t flags;  // BOOT_CONFIG_FLAG_*
+  uint8_t dataBits;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t baudRate;
+  uint8_t parity;
+  uint8_t stopBits;
+  uint16_t tcpPort;
+};
+
+bool ConfigManager::loadCachedConfig() {
+  BootConfigCache cache;
+  if (!rtcLoad(RTC_BOOT_CONFIG_OFFSET, BOOT_CONFIG_RTC_MAGIC, &cache, sizeof(cache))) {
+    return false;
+  }
+
+  networkConfig.ssid = cache.ssid;
+  networkConfig.password = cache.password;
+  networkConfig.dhcpEnabled = (cache.flags & BOOT_CONFIG_FLAG_DHCP) != 0;
+  networkConfig.ip = IPAddress(cache.ip).toString();
+  networkConfig.gateway = IPAddress(cache.gateway).toString();
+  networkConfig.subnet = IPAddress(cache.subnet).toString();
+
+  rs485Config.baudRate = cache.baudRate;
+  rs485Config.dataBits = cache.dataBits;
+  rs485Config.parity = cache.parity;
+  rs485Config.stopBits = cache.stopBits;
+  rs485Config.replayTiming = (cache.flags & BOOT_CONFIG_FLAG_REPLAY_TIMING) != 0;
+
+  deviceConfig.tcpPort = cache.tcpPort;
+  return true;
+}
+
+bool ConfigManager::saveCachedConfig() {
+  BootConfigCache cache;
+  memset(&cache, 0, sizeof(cache));
+  strncpy(cache.ssid, networkConfig.ssid.c_str(), sizeof(cache.ssid) - 1);
+  strncpy(cache.password, networkConfig.password.c_str(), sizeof(cache.password) - 1);
+  cache.flags = (networkConfig.dhcpEnabled ? BOOT_CONFIG_FLAG_DHCP : 0) |
+                (rs485Config.replayTiming ? BOOT_CONFIG_FLAG_REPLAY_TIMING : 0);
+
+  IPAddress address;
+  cache.ip = address.fromString(networkConfig.ip) ? (uint32_t)address : 0;
+  cache.gateway = address.fromString(networkConfig.gateway) ? (uint32_t)address : 0;
+  cache.subnet = address.fromString(networkConfig.subnet) ? (uint32_t)address : 0;
+
+  cache.baudRate = rs485Config.baudRate;
+  cache.dataBits = rs485Config.dataBits;
+  cache.parity = rs485Config.parity;
+  cache.stopBits = rs485Config.stopBits;
+  cache.tcpPort = deviceConfig.tcpPort;
+
+  // 内容未变时不重写
+  BootConfigCache current;
+  if (rtcLoad(RTC_BOOT_CONFIG_OFFSET, BOOT_CONFIG_RTC_MAGIC, &current, sizeof(current)) &&
+      memcmp(&current, &cache, sizeof(cache)) == 0) {
+    return true;
+  }
+  return rtcSave(RTC_BOOT_CONFIG_OFFSET, BOOT_CONFIG_RTC_MAGIC, &cache, sizeof(cache));
+}
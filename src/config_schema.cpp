@@ -0,0 +1,176 @@
+#include "config_schema.h"
+#include <ESP8266WiFi.h>
+#include <string.h>
+
+// 字段在配置结构体中的地址
+template <typename T>
+static inline T& fieldRef(const ConfigField& field, void* section) {
+  return *reinterpret_cast<T*>(static_cast<uint8_t*>(section) + field.offset);
+}
+
+template <typename T>
+static inline const T& fieldRef(const ConfigField& field, const void* section) {
+  return *reinterpret_cast<const T*>(static_cast<const uint8_t*>(section) + field.offset);
+}
+
+// 数值字段统一按32位读取
+static uint32_t readNumber(const ConfigField& field, const void* section) {
+  switch (field.type) {
+    case CONFIG_FIELD_BOOL:
+      return fieldRef<bool>(field, section) ? 1 : 0;
+    case CONFIG_FIELD_U8:
+      return fieldRef<uint8_t>(field, section);
+    case CONFIG_FIELD_U16:
+      return fieldRef<uint16_t>(field, section);
+    case CONFIG_FIELD_U32:
+      return fieldRef<uint32_t>(field, section);
+    default:
+      return 0;
+  }
+}
+
+static void writeNumber(const ConfigField& field, void* section, uint32_t value) {
+  switch (field.type) {
+    case CONFIG_FIELD_BOOL:
+      fieldRef<bool>(field, section) = value != 0;
+      break;
+    case CONFIG_FIELD_U8:
+      fieldRef<uint8_t>(field, section) = (uint8_t)value;
+      break;
+    case CONFIG_FIELD_U16:
+      fieldRef<uint16_t>(field, section) = (uint16_t)value;
+      break;
+    case CONFIG_FIELD_U32:
+      fieldRef<uint32_t>(field, section) = value;
+      break;
+    default:
+      break;
+  }
+}
+
+// 字段类型能保存的最大值
+static uint32_t typeMaxValue(ConfigFieldType type) {
+  switch (type) {
+    case CONFIG_FIELD_U8:
+      return UINT8_MAX;
+    case CONFIG_FIELD_U16:
+      return UINT16_MAX;
+    default:
+      return UINT32_MAX;
+  }
+}
+
+// 在转换为字段宽度之前检查JSON中的数值：必须是非负整数，且在字段范围和类型宽度之内
+// (否则如 74424 会截断为 8888 并通过验证)
+static bool readJsonNumber(const ConfigField& field, JsonVariantConst value, uint32_t& number) {
+  if (!value.is<uint32_t>()) {
+    return false;
+  }
+  number = value.as<uint32_t>();
+  return number >= field.minValue && number <= field.maxValue && number <= typeMaxValue(field.type);
+}
+
+static inline bool isStringField(const ConfigField& field) {
+  return field.type == CONFIG_FIELD_STRING || field.type == CONFIG_FIELD_IP || field.type == CONFIG_FIELD_CHOICE;
+}
+
+bool configFromJson(JsonVariantConst root, void* const sections[]) {
+  bool valid = true;
+  for (uint8_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    const ConfigField& field = CONFIG_FIELDS[i];
+    JsonVariantConst value = root[CONFIG_SECTION_NAMES[field.section]][field.key];
+    if (value.isNull()) {
+      continue;
+    }
+    void* section = sections[field.section];
+    if (isStringField(field)) {
+      fieldRef<String>(field, section) = value.as<const char*>();
+    } else if (field.type == CONFIG_FIELD_BOOL) {
+      writeNumber(field, section, value.as<bool>() ? 1 : 0);
+    } else {
+      uint32_t number;
+      if (readJsonNumber(field, value, number)) {
+        writeNumber(field, section, number);
+      } else {
+        valid = false;
+      }
+    }
+  }
+  return valid;
+}
+
+void configToJson(JsonDocument& doc, const void* const sections[], uint8_t skipFlags) {
+  JsonObject objects[CONFIG_SECTION_COUNT];
+  for (uint8_t s = 0; s < CONFIG_SECTION_COUNT; s++) {
+    objects[s] = doc.createNestedObject(CONFIG_SECTION_NAMES[s]);
+  }
+
+  for (uint8_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    const ConfigField& field = CONFIG_FIELDS[i];
+    if (field.flags & skipFlags) {
+      continue;
+    }
+    const void* section = sections[field.section];
+    JsonObject& object = objects[field.section];
+    if (isStringField(field)) {
+      object[field.key] = fieldRef<String>(field, section);
+    } else if (field.type == CONFIG_FIELD_BOOL) {
+      object[field.key] = fieldRef<bool>(field, section);
+    } else {
+      object[field.key] = readNumber(field, section);
+    }
+  }
+}
+
+bool configValidateField(const ConfigField& field, const void* section) {
+  if (!isStringField(field)) {
+    uint32_t value = readNumber(field, section);
+    return value >= field.minValue && value <= field.maxValue;
+  }
+
+  const String& value = fieldRef<String>(field, section);
+  switch (field.type) {
+    case CONFIG_FIELD_IP: {
+      IPAddress address;
+      return address.fromString(value);
+    }
+    case CONFIG_FIELD_CHOICE:
+      for (const char* const* choice = field.choices; *choice != nullptr; choice++) {
+        if (strcmp(value.c_str(), *choice) == 0) {
+          return true;
+        }
+      }
+      return false;
+    default:
+      return value.length() >= field.minValue && value.length() <= field.maxValue;
+  }
+}
+
+uint32_t configDiff(const void* const a[], const void* const b[]) {
+  uint32_t changed = 0;
+  for (uint8_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    const ConfigField& field = CONFIG_FIELDS[i];
+    const void* sectionA = a[field.section];
+    const void* sectionB = b[field.section];
+    bool equal;
+    if (isStringField(field)) {
+      equal = fieldRef<String>(field, sectionA) == fieldRef<String>(field, sectionB);
+    } else {
+      equal = readNumber(field, sectionA) == readNumber(field, sectionB);
+    }
+    if (!equal) {
+      changed |= (uint32_t)1 << i;
+    }
+  }
+  return changed;
+}
+
+uint8_t configDiffFlags(uint32_t changed) {
+  uint8_t flags = 0;
+  for (uint8_t i = 0; i < CONFIG_FIELD_COUNT; i++) {
+    if (changed & ((uint32_t)1 << i)) {
+      flags |= CONFIG_FIELDS[i].flags;
+    }
+  }
+  return flags;
+}
@@ -0,0 +1,211 @@
+#include "data_router.h"
+#include "logger.h"
+#include "frame_trace.h"
+#include "metrics.h"
+#include "modbus.h"
+
+DataRouter::DataRouter()
+    : bus(nullptr), link(nullptr), capture(nullptr), hasPendingFrame(false),
+      linkSentAt(0), busSentAt(0),
+      responseTimeouts(nullptr), awaitingAddress(0), awaitingSince(0), awaitingTimeoutUs(0), lateAddress(0),
+      busToLinkFrames(0), linkToBusFrames(0), droppedFrames(0), lastActivityMs(0) {
+  // 构造函数
+}
+
+DataRouter::~DataRouter() {
+  // 析构函数
+}
+
+bool DataRouter::begin(RS485* bus, TcpProtocol* link) {
+  if (bus == nullptr || link == nullptr) {
+    return false;
+  }
+  this->bus = bus;
+  this->link = link;
+  hasPendingFrame = false;
+  lanes[MODBUS_PRIORITY_HIGH].clear();
+  lanes[MODBUS_PRIORITY_NORMAL].clear();
+  awaitingAddress = 0;
+  lateAddress = 0;
+  return true;
+}
+
+void DataRouter::setResponseTimeouts(ResponseTimeouts* timeouts) {
+  responseTimeouts = timeouts;
+  awaitingAddress = 0;
+  lateAddress = 0;
+}
+
+void DataRouter::loop() {
+  if (bus == nullptr || link == nullptr) {
+    return;
+  }
+
+  // 总线 → 网络
+  if (bus->poll() && bus->readFrame(busFrame)) {
+    uint32_t readyAt = TRACE_NOW();
+    TRACE_STAGE(TRACE_UART_RX, busFrame.lastByteTime - busFrame.firstByteTime);
+    TRACE_STAGE(TRACE_FRAMING, readyAt - busFrame.lastByteTime);
+    if (busSentAt != 0) {
+      // 本机发到总线的帧得到了应答
+      TRACE_STAGE(TRACE_BUS_TURNAROUND, busFrame.firstByteTime - busSentAt);
+      busSentAt = 0;
+    }
+    matchResponse(busFrame);
+
+    // 只统计，不拦截：中继对帧内容透明
+    if (!modbusCheckCrc(busFrame.data, busFrame.length)) {
+      METRIC_INC(METRIC_BUS_CRC_ERRORS);
+    }
+
+    if (capture != nullptr) {
+      capture->record(CAPTURE_BUS_TO_LINK, busFrame.data, busFrame.length, busFrame.firstByteTime);
+    }
+    bool urgent = modbusClassify(busFrame.data, busFrame.length) == MODBUS_PRIORITY_HIGH;
+    if (link->sendFrame(busFrame.data, busFrame.length, busFrame.timing, busFrame.timingLength, urgent)) {
+      busToLinkFrames++;
+      markForwarded();
+      linkSentAt = TRACE_NOW();
+      TRACE_STAGE(TRACE_TCP_SEND, linkSentAt - readyAt);
+    } else {
+      // 未连接时丢弃：RS485请求由总线主站超时重发
+      droppedFrames++;
+      METRIC_INC(METRIC_ROUTER_DROPPED_FRAMES);
+      LOG_D("Router", "链路不可用，丢弃 %u 字节总线帧", busFrame.length);
+    }
+  }
+
+  // 网络 → 优先级队列
+  receiveFromLink();
+
+  // 应答已经开始接收时不判断超时
+  if (awaitingAddress != 0 && bus->isBusIdle()) {
+    checkResponseTimeout();
+  }
+
+  // 半双工：总线正在接收时推迟发送；从设备在上一个请求得到应答或超时之前也推迟
+  if (bus->isBusIdle() && awaitingAddress == 0) {
+    sendToBus();
+  }
+
+  // 总线空闲时将捕获数据写入文件
+  if (capture != nullptr && lanesEmpty() && bus->isBusIdle()) {
+    capture->loop();
+  }
+
+#ifdef WIFLY485_TRACE
+  frameTrace.loop();
+#endif
+}
+
+void DataRouter::receiveFromLink() {
+  // 取出所有已到达的帧，写命令可以越过排在它前面的轮询
+  while (true) {
+    if (!hasPendingFrame) {
+      hasPendingFrame = link->receiveFrame(pendingFrame);
+      if (!hasPendingFrame) {
+        return;
+      }
+      TRACE_STAGE(TRACE_TCP_RECV, pendingFrame.lastByteTime - pendingFrame.firstByteTime);
+      if (linkSentAt != 0) {
+        TRACE_STAGE(TRACE_LINK_RTT, pendingFrame.lastByteTime - linkSentAt);
+        linkSentAt = 0;
+      }
+    }
+    // 队列已满：保留这一帧，下一次循环再放入
+    if (!lanes[modbusClassify(pendingFrame.data, pendingFrame.length)].push(pendingFrame)) {
+      return;
+    }
+    hasPendingFrame = false;
+  }
+}
+
+void DataRouter::sendToBus() {
+  ModbusPriority priority = lanes[MODBUS_PRIORITY_HIGH].isEmpty() ? MODBUS_PRIORITY_NORMAL : MODBUS_PRIORITY_HIGH;
+  if (!lanes[priority].pop(txFrame)) {
+    return;
+  }
+  if (capture != nullptr) {
+    capture->record(CAPTURE_LINK_TO_BUS, txFrame.data, txFrame.length, micros());
+  }
+  // 从链路收到到开始发送的等待，按优先级分别统计
+  uint32_t sendStart = micros();
+  uint32_t waitUs = sendStart - txFrame.lastByteTime;
+  TRACE_STAGE(TRACE_BUS_WAIT, waitUs);
+  if (priority == MODBUS_PRIORITY_HIGH) {
+    TRACE_STAGE(TRACE_BUS_WAIT_PRIORITY, waitUs);
+    METRIC_INC(METRIC_ROUTER_PRIORITY_FRAMES);
+    METRIC_ADD(METRIC_ROUTER_PRIORITY_WAIT_US, waitUs);
+    if (!lanes[MODBUS_PRIORITY_NORMAL].isEmpty()) {
+      METRIC_INC(METRIC_ROUTER_OVERTAKES);
+    }
+  } else {
+    METRIC_INC(METRIC_ROUTER_NORMAL_FRAMES);
+    METRIC_ADD(METRIC_ROUTER_NORMAL_WAIT_US, waitUs);
+  }
+
+  if (bus->sendFrame(txFrame.data, txFrame.length, txFrame.timing, txFrame.timingLength)) {
+    linkToBusFrames++;
+    markForwarded();
+    busSentAt = TRACE_NOW();
+    TRACE_STAGE(TRACE_BUS_SEND, busSentAt - sendStart);
+    awaitResponse(txFrame);
+  } else {
+    droppedFrames++;
+    METRIC_INC(METRIC_ROUTER_DROPPED_FRAMES);
+  }
+}
+
+void DataRouter::markForwarded() {
+  uint32_t now = millis();
+  lastActivityMs = now;
+  if (metrics.getGauge(GAUGE_FIRST_FORWARD_MS) == 0) {
+    metrics.setGauge(GAUGE_FIRST_FORWARD_MS, now);
+    LOG_I("Router", "启动后 %u ms 第一次转发", now);
+  }
+}
+
+void DataRouter::awaitResponse(const RS485Frame& request) {
+  lateAddress = 0;
+  if (responseTimeouts == nullptr || request.length < MODBUS_MIN_FRAME_SIZE) {
+    return;
+  }
+  // 地址0是广播，248以上是保留地址，都没有应答
+  uint8_t address = request.data[0];
+  if (address == 0 || address > 247 || !modbusCheckCrc(request.data, request.length)) {
+    return;
+  }
+  awaitingAddress = address;
+  awaitingSince = micros();
+  awaitingTimeoutUs = responseTimeouts->getTimeoutUs(address);
+}
+
+void DataRouter::matchResponse(const RS485Frame& frame) {
+  if (responseTimeouts == nullptr || frame.length == 0) {
+    return;
+  }
+  uint8_t address = frame.data[0];
+  uint32_t responseUs = (int32_t)(frame.firstByteTime - awaitingSince) > 0 ? frame.firstByteTime - awaitingSince : 0;
+  if (awaitingAddress != 0 && address == awaitingAddress) {
+    responseTimeouts->addSample(address, responseUs);
+    awaitingAddress = 0;
+  } else if (lateAddress != 0 && address == lateAddress) {
+    // 超时之后、下一个请求之前到达：仍是有效的样本，使估计跟上变慢的设备
+    METRIC_INC(METRIC_BUS_LATE_RESPONSES);
+    if (responseUs < RESPONSE_TIMEOUT_MAX_MS * 1000UL) {
+      responseTimeouts->addSample(address, responseUs);
+    }
+    lateAddress = 0;
+  }
+}
+
+void DataRouter::checkResponseTimeout() {
+  if ((micros() - awaitingSince) < awaitingTimeoutUs) {
+    return;
+  }
+  // 放弃等待，总线转向下一个请求
+  METRIC_INC(METRIC_BUS_RESPONSE_TIMEOUTS);
+  responseTimeouts->onTimeout(awaitingAddress);
+  lateAddress = awaitingAddress;
+  awaitingAddress = 0;
+}
@@ -0,0 +1,66 @@
+#include "frame_queue.h"
+
+FrameQueue::FrameQueue() : head(0), used(0), frames(0) {
+  // 构造函数
+}
+
+bool FrameQueue::push(const RS485Frame& frame) {
+  uint16_t size = FRAME_QUEUE_ENTRY_HEADER + frame.length + frame.timingLength;
+  if (size > ROUTER_LANE_BUFFER_SIZE - used) {
+    return false;
+  }
+  uint8_t header[FRAME_QUEUE_ENTRY_HEADER];
+  header[0] = frame.length & 0xFF;
+  header[1] = frame.length >> 8;
+  header[2] = frame.timingLength;
+  memcpy(header + 3, &frame.firstByteTime, 4);
+  memcpy(header + 7, &frame.lastByteTime, 4);
+
+  uint16_t tail = (head + used) % ROUTER_LANE_BUFFER_SIZE;
+  ringWrite(tail, header, sizeof(header));
+  ringWrite((tail + FRAME_QUEUE_ENTRY_HEADER) % ROUTER_LANE_BUFFER_SIZE, frame.data, frame.length);
+  ringWrite((tail + FRAME_QUEUE_ENTRY_HEADER + frame.length) % ROUTER_LANE_BUFFER_SIZE, frame.timing,
+            frame.timingLength);
+  used += size;
+  frames++;
+  return true;
+}
+
+bool FrameQueue::pop(RS485Frame& frame) {
+  if (frames == 0) {
+    return false;
+  }
+  uint8_t header[FRAME_QUEUE_ENTRY_HEADER];
+  ringRead(head, header, sizeof(header));
+  frame.length = header[0] | ((uint16_t)header[1] << 8);
+  frame.timingLength = header[2];
+  memcpy(&frame.firstByteTime, header + 3, 4);
+  memcpy(&frame.lastByteTime, header + 7, 4);
+  ringRead((head + FRAME_QUEUE_ENTRY_HEADER) % ROUTER_LANE_BUFFER_SIZE, frame.data, frame.length);
+  ringRead((head + FRAME_QUEUE_ENTRY_HEADER + frame.length) % ROUTER_LANE_BUFFER_SIZE, frame.timing,
+           frame.timingLength);
+
+  uint16_t size = FRAME_QUEUE_ENTRY_HEADER + frame.length + frame.timingLength;
+  head = (head + size) % ROUTER_LANE_BUFFER_SIZE;
+  used -= size;
+  frames--;
+  return true;
+}
+
+void FrameQueue::clear() {
+  head = 0;
+  used = 0;
+  frames = 0;
+}
+
+void FrameQueue::ringWrite(uint16_t offset, const uint8_t* data, uint16_t length) {
+  uint16_t first = min<uint16_t>(length, ROUTER_LANE_BUFFER_SIZE - offset);
+  memcpy(buffer + offset, data, first);
+  memcpy(buffer, data + first, length - first);
+}
+
+void FrameQueue::ringRead(uint16_t offset, uint8_t* data, uint16_t length) {
+  uint16_t first = min<uint16_t>(length, ROUTER_LANE_BUFFER_SIZE - offset);
+  memcpy(data, buffer + offset, first);
+  memcpy(data + first, buffer, length - first);
+}
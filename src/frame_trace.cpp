@@ -0,0 +1,116 @@
+#include "frame_trace.h"
+#include "logger.h"
+
+// 全局追踪实例
+FrameTrace frameTrace;
+
+static const char* const STAGE_NAMES[TRACE_STAGE_COUNT] = {
+  "uart_rx",
+  "framing",
+  "tcp_send",
+  "tcp_recv",
+  "bus_wait",
+  "bus_send",
+  "link_rtt",
+  "bus_turnaround",
+  "wake",
+  "gap_jitter",
+  "ota_slice",
+  "batch_hold",
+  "bus_wait_priority"
+};
+
+FrameTrace::FrameTrace() : lastSummary(0) {
+  // 构造函数
+  reset();
+}
+
+void FrameTrace::reset() {
+  for (uint8_t s = 0; s < TRACE_STAGE_COUNT; s++) {
+    TraceHistogram& h = histograms[s];
+    for (uint8_t i = 0; i < TRACE_BUCKET_COUNT; i++) {
+      h.buckets[i] = 0;
+    }
+    h.count = 0;
+    h.maxUs = 0;
+  }
+}
+
+uint32_t FrameTrace::getPercentileUs(TraceStage stage, uint8_t percentile) {
+  TraceHistogram& h = histograms[stage];
+  uint32_t count = h.count;
+  if (count == 0) {
+    return 0;
+  }
+
+  // 最近秩法，在桶的累计计数上查找
+  uint32_t rank = (uint32_t)(((uint64_t)count * percentile + 99) / 100);
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < TRACE_BUCKET_COUNT; i++) {
+    cumulative += h.buckets[i];
+    if (cumulative >= rank) {
+      uint32_t upper = bucketUpperUs(i);
+      uint32_t maxUs = h.maxUs;
+      return upper < maxUs ? upper : maxUs;
+    }
+  }
+  return h.maxUs;
+}
+
+const char* FrameTrace::getStageName(TraceStage stage) {
+  return stage < TRACE_STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+void FrameTrace::printJson(Print& out) {
+#ifdef WIFLY485_TRACE
+  out.print("{\"enabled\":true,\"unit\":\"us\",\"stages\":{");
+#else
+  out.print("{\"enabled\":false,\"unit\":\"us\",\"stages\":{");
+#endif
+  for (uint8_t s = 0; s < TRACE_STAGE_COUNT; s++) {
+    TraceStage stage = (TraceStage)s;
+    TraceHistogram& h = histograms[s];
+    if (s > 0) {
+      out.print(',');
+    }
+    out.printf("\"%s\":{\"count\":%u,\"p50\":%u,\"p99\":%u,\"max\":%u,\"buckets\":[",
+               STAGE_NAMES[s], h.count, getPercentileUs(stage, 50), getPercentileUs(stage, 99), h.maxUs);
+
+    // 末尾的空桶省略
+    int8_t last = TRACE_BUCKET_COUNT - 1;
+    while (last >= 0 && h.buckets[last] == 0) {
+      last--;
+    }
+    for (int8_t i = 0; i <= last; i++) {
+      if (i > 0) {
+        out.print(',');
+      }
+      out.print(h.buckets[i]);
+    }
+    out.print("]}");
+  }
+  out.print("}}");
+}
+
+void FrameTrace::logSummary() {
+  for (uint8_t s = 0; s < TRACE_STAGE_COUNT; s++) {
+    TraceStage stage = (TraceStage)s;
+    if (histograms[s].count == 0) {
+      continue;
+    }
+    LOG_I("Trace", "%-14s n=%u p50<=%uus p99<=%uus max=%uus", STAGE_NAMES[s], histograms[s].count,
+          getPercentileUs(stage, 50), getPercentileUs(stage, 99), histograms[s].maxUs);
+  }
+}
+
+void FrameTrace::loop() {
+#ifdef WIFLY485_TRACE
+  if (millis() - lastSummary >= TRACE_SUMMARY_INTERVAL_MS) {
+    lastSummary = millis();
+    logSummary();
+  }
+#endif
+}
\ No newline at end of file
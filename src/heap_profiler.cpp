@@ -0,0 +1,165 @@
+#include "heap_profiler.h"
+#include "config.h"
+#include "logger.h"
+
+#ifndef WIFLY485_NATIVE
+extern "C" {
+#include <user_interface.h>
+}
+#endif
+
+// 系统上下文的栈从RAM顶部向下增长 (异常转储中 "ctx: sys" 的end地址)
+#define SYS_STACK_END 0x3FFFFFB0UL
+#define SYS_STACK_LIMIT 0x3FFFE000UL      // 填充窗口不低于该地址 (之下是SDK的数据区)
+#define STACK_PAINT_WORD 0xA5C3A5C3UL
+
+// 全局堆统计实例
+HeapProfiler heapProfiler;
+
+// 系统栈填充窗口 [sysPaintBottom, sysPaintTop)，未填充时为空
+static uint32_t* volatile sysPaintBottom = nullptr;
+static uint32_t* volatile sysPaintTop = nullptr;
+
+#ifndef WIFLY485_NATIVE
+static os_timer_t sysPaintTimer;
+
+// 在系统上下文中运行：当前栈指针以下留出保护区后填充窗口，期间关中断，
+// 填充的内存此刻没有被使用，之后系统上下文的调用越深改写得越多
+static void sysPaintCallback(void* arg) {
+  uint32_t sp = (uint32_t)__builtin_frame_address(0);
+  uint32_t top = (sp - STACK_SYS_GUARD_BYTES) & ~3UL;
+  uint32_t bottom = top - STACK_SYS_PAINT_BYTES;
+  if (bottom < SYS_STACK_LIMIT) {
+    bottom = SYS_STACK_LIMIT;
+  }
+  if (top <= bottom) {
+    return;
+  }
+  uint32_t savedPs = xt_rsil(15);
+  for (uint32_t* p = (uint32_t*)bottom; p < (uint32_t*)top; p++) {
+    *p = STACK_PAINT_WORD;
+  }
+  sysPaintBottom = (uint32_t*)bottom;
+  sysPaintTop = (uint32_t*)top;
+  xt_wsr_ps(savedPs);
+}
+#endif
+
+HeapProfiler::HeapProfiler() : current(HEAP_TAG_SYSTEM), lastFree(0) {
+  // 构造函数
+  memset(stats, 0, sizeof(stats));
+}
+
+void HeapProfiler::begin() {
+  memset(stats, 0, sizeof(stats));
+  current = HEAP_TAG_SYSTEM;
+  lastFree = ESP.getFreeHeap();
+  paintSysStack();
+}
+
+HeapTag HeapProfiler::enter(HeapTag tag) {
+  HeapTag previous = current;
+  account();
+  current = tag;
+  return previous;
+}
+
+void HeapProfiler::leave(HeapTag previous) {
+  account();
+  current = previous;
+}
+
+void HeapProfiler::account() {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  if (freeHeap == lastFree) {
+    return;
+  }
+  HeapTagStats& tagStats = stats[current];
+  tagStats.currentBytes += (int32_t)(lastFree - freeHeap);
+  lastFree = freeHeap;
+  if (tagStats.currentBytes > tagStats.peakBytes) {
+    tagStats.peakBytes = tagStats.currentBytes;
+  }
+  tagStats.fragmentation = ESP.getHeapFragmentation();
+  if (tagStats.fragmentation > tagStats.maxFragmentation) {
+    tagStats.maxFragmentation = tagStats.fragmentation;
+  }
+}
+
+uint32_t HeapProfiler::getLoopStackUsed() {
+  uint32_t freeStack = ESP.getFreeContStack();
+  return freeStack < STACK_LOOP_SIZE ? STACK_LOOP_SIZE - freeStack : 0;
+}
+
+uint32_t HeapProfiler::getSysStackUsed(bool& saturated) {
+  saturated = false;
+  uint32_t* bottom = sysPaintBottom;
+  uint32_t* top = sysPaintTop;
+  if (bottom == nullptr) {
+    return 0;
+  }
+  uint32_t* p = bottom;
+  while (p < top && *p == STACK_PAINT_WORD) {
+    p++;
+  }
+  saturated = (p == bottom);
+  return SYS_STACK_END - (uint32_t)(uintptr_t)p;
+}
+
+void HeapProfiler::resetPeaks() {
+  account();
+  for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+    stats[i].peakBytes = stats[i].currentBytes;
+    stats[i].maxFragmentation = stats[i].fragmentation;
+  }
+  ESP.resetFreeContStack();
+  paintSysStack();
+}
+
+void HeapProfiler::paintSysStack() {
+#ifndef WIFLY485_NATIVE
+  // 定时器回调在系统上下文中运行，由SDK在下一次调度时执行
+  os_timer_disarm(&sysPaintTimer);
+  os_timer_setfn(&sysPaintTimer, sysPaintCallback, nullptr);
+  os_timer_arm(&sysPaintTimer, 1, false);
+#endif
+}
+
+void HeapProfiler::printJson(Print& out) {
+  account();
+  bool saturated;
+  uint32_t sysUsed = getSysStackUsed(saturated);
+  out.printf("{\"free\":%u,\"max_block\":%u,\"frag_percent\":%u,\"tags\":[",
+             ESP.getFreeHeap(), ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation());
+  for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+    const HeapTagStats& tagStats = stats[i];
+    if (i > 0) {
+      out.print(',');
+    }
+    out.printf("{\"name\":\"%s\",\"current\":%d,\"peak\":%d,\"frag_percent\":%u,\"max_frag_percent\":%u}",
+               getTagName((HeapTag)i), tagStats.currentBytes, tagStats.peakBytes,
+               tagStats.fragmentation, tagStats.maxFragmentation);
+  }
+  out.printf("],\"stack\":{\"loop_used\":%u,\"loop_size\":%u,\"sys_used\":%u,\"sys_saturated\":%s}}",
+             getLoopStackUsed(), STACK_LOOP_SIZE, sysUsed, saturated ? "true" : "false");
+}
+
+void HeapProfiler::logSummary() {
+  account();
+  for (uint8_t i = 0; i < HEAP_TAG_COUNT; i++) {
+    const HeapTagStats& tagStats = stats[i];
+    LOG_I("Heap", "%-7s 当前 %6d B 峰值 %6d B 碎片 %3u%% (最大 %u%%)", getTagName((HeapTag)i),
+          tagStats.currentBytes, tagStats.peakBytes, tagStats.fragmentation, tagStats.maxFragmentation);
+  }
+  bool saturated;
+  uint32_t sysUsed = getSysStackUsed(saturated);
+  LOG_I("Heap", "栈高水位: 主循环 %u/%u B，系统 %s%u B", getLoopStackUsed(), STACK_LOOP_SIZE,
+        saturated ? ">=" : "", sysUsed);
+}
+
+const char* HeapProfiler::getTagName(HeapTag tag) {
+  static const char* const NAMES[HEAP_TAG_COUNT] = {
+    "system", "config", "logger", "web", "relay", "sync"
+  };
+  return tag < HEAP_TAG_COUNT ? NAMES[tag] : "?";
+}
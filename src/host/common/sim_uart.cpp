@@ -0,0 +1,160 @@
+#include "sim_uart.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <errno.h>
+
+// 发送队列上限：与ESP8266 UART的128字节硬件FIFO一致
+#define SIM_UART_TX_FIFO_SIZE 128
+
+SimUart::SimUart() : fd(-1), charTimeUs(0), nextTxTime(0) {
+  // 构造函数
+}
+
+SimUart::~SimUart() {
+  // 析构函数
+  close();
+}
+
+void SimUart::attach(int fd, uint32_t charTimeUs) {
+  close();
+  this->fd = fd;
+  this->charTimeUs = charTimeUs;
+  txQueue.clear();
+  rxBuffer.clear();
+}
+
+void SimUart::close() {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+void SimUart::fillRx() {
+  if (fd < 0) {
+    return;
+  }
+  uint8_t buffer[256];
+  ssize_t n;
+  while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+    rxBuffer.insert(rxBuffer.end(), buffer, buffer + n);
+  }
+}
+
+int SimUart::available() {
+  pump();
+  fillRx();
+  return (int)rxBuffer.size();
+}
+
+int SimUart::read() {
+  if (available() == 0) {
+    return -1;
+  }
+  uint8_t c = rxBuffer.front();
+  rxBuffer.pop_front();
+  return c;
+}
+
+int SimUart::peek() {
+  if (available() == 0) {
+    return -1;
+  }
+  return rxBuffer.front();
+}
+
+size_t SimUart::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t SimUart::write(const uint8_t* buffer, size_t size) {
+  if (fd < 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < size; i++) {
+    // FIFO满时与硬件UART一样阻塞等待
+    while (txQueue.size() >= SIM_UART_TX_FIFO_SIZE) {
+      pump();
+      delayMicroseconds(std::min<uint32_t>(charTimeUs, 50));
+    }
+    if (txQueue.empty() && (int32_t)(micros() - nextTxTime) >= 0) {
+      // 线路空闲：第一个字节在一个字符时间后到达接收方
+      nextTxTime = micros() + charTimeUs;
+    }
+    txQueue.push_back(buffer[i]);
+  }
+  pump();
+  return size;
+}
+
+int SimUart::availableForWrite() {
+  return SIM_UART_TX_FIFO_SIZE - (int)txQueue.size();
+}
+
+void SimUart::flush() {
+  while (!txIdle()) {
+    pump();
+    delayMicroseconds(std::min<uint32_t>(charTimeUs, 50));
+  }
+}
+
+void SimUart::pump() {
+  while (!txQueue.empty() && (int32_t)(micros() - nextTxTime) >= 0) {
+    uint8_t c = txQueue.front();
+    if (::write(fd, &c, 1) != 1) {
+      // 伪终端缓冲区满：下次再试
+      return;
+    }
+    txQueue.pop_front();
+    if (!txQueue.empty()) {
+      nextTxTime += charTimeUs;
+    }
+  }
+}
+
+uint32_t SimUart::txCompleteTime() {
+  return nextTxTime + (txQueue.size() > 1 ? (txQueue.size() - 1) * charTimeUs : 0);
+}
+
+bool SimUart::txIdle() {
+  pump();
+  return txQueue.empty() && (int32_t)(micros() - nextTxTime) >= 0;
+}
+
+bool SimUart::openPair(int& masterFd, int& slaveFd, char* slaveName, size_t slaveNameSize) {
+  masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (masterFd < 0) {
+    return false;
+  }
+  if (grantpt(masterFd) != 0 || unlockpt(masterFd) != 0) {
+    ::close(masterFd);
+    return false;
+  }
+
+  const char* name = ptsname(masterFd);
+  if (name == nullptr) {
+    ::close(masterFd);
+    return false;
+  }
+  if (slaveName != nullptr && slaveNameSize > 0) {
+    snprintf(slaveName, slaveNameSize, "%s", name);
+  }
+
+  slaveFd = open(name, O_RDWR | O_NOCTTY);
+  if (slaveFd < 0) {
+    ::close(masterFd);
+    return false;
+  }
+
+  // 原始模式：不做行缓冲、回显和字符转换
+  struct termios tio;
+  if (tcgetattr(slaveFd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(slaveFd, TCSANOW, &tio);
+  }
+
+  fcntl(masterFd, F_SETFL, fcntl(masterFd, F_GETFL, 0) | O_NONBLOCK);
+  fcntl(slaveFd, F_SETFL, fcntl(slaveFd, F_GETFL, 0) | O_NONBLOCK);
+  return true;
+}
\ No newline at end of file
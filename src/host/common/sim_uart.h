@@ -0,0 +1,51 @@
+#ifndef SIM_UART_H
+#define SIM_UART_H
+
+#include <Arduino.h>
+#include <deque>
+
+// 主机模拟用的串口：基于伪终端(pty)，按波特率节奏发送
+// 伪终端本身没有波特率概念，发送的字节先进入队列，每过一个字符时间才写入伪终端，
+// 接收方因此看到与真实UART相同的字节间隔
+class SimUart : public Stream {
+public:
+  SimUart();
+  ~SimUart();
+
+  // 接管文件描述符 (析构时关闭)
+  void attach(int fd, uint32_t charTimeUs);
+  void close();
+
+  // Stream接口
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int availableForWrite() override;
+  using Print::write;
+
+  // 阻塞直到发送队列中的字节全部"移出"，与ESP8266的Serial.flush()一致
+  void flush() override;
+
+  // 将到期的字节写入伪终端 (非阻塞，模拟器主循环调用)
+  void pump();
+
+  // 发送队列清空的时间点 (micros)，即最后一个字节发送完成的时间
+  uint32_t txCompleteTime();
+  bool txIdle();
+
+  // 创建一对伪终端，两端均设置为原始模式和非阻塞
+  static bool openPair(int& masterFd, int& slaveFd, char* slaveName = nullptr, size_t slaveNameSize = 0);
+
+private:
+  int fd;
+  uint32_t charTimeUs;
+  std::deque<uint8_t> txQueue;
+  uint32_t nextTxTime;
+  std::deque<uint8_t> rxBuffer;
+
+  void fillRx();
+};
+
+#endif // SIM_UART_H
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "impaired_link.h"
+#include <time.h>
+
+// 每次从套接字读取的最大字节数 (一个TCP报文段)
+#define IMPAIRED_LINK_CHUNK_SIZE 1460
+
+ImpairedLink::ImpairedLink()
+    : server(nullptr), upstreamPort(0), chunksForwarded(0), chunksLost(0), drops(0), connectedAt(0) {
+  // 构造函数
+  impairment = LinkImpairment();
+  toMaster.from = &downstream;
+  toMaster.to = &upstream;
+  toSlave.from = &upstream;
+  toSlave.to = &downstream;
+  toMaster.linkFreeAt = toMaster.lastDeliverAt = 0;
+  toSlave.linkFreeAt = toSlave.lastDeliverAt = 0;
+}
+
+ImpairedLink::~ImpairedLink() {
+  // 析构函数
+  end();
+}
+
+bool ImpairedLink::begin(uint16_t listenPort, uint16_t upstreamPort, const LinkImpairment& impairment, uint32_t seed) {
+  end();
+  this->upstreamPort = upstreamPort;
+  this->impairment = impairment;
+  rng.seed(seed);
+
+  server = new WiFiServer(listenPort);
+  server->begin();
+  return server->status() != 0;
+}
+
+void ImpairedLink::end() {
+  downstream.stop();
+  upstream.stop();
+  toMaster.queue.clear();
+  toSlave.queue.clear();
+  if (server != nullptr) {
+    server->stop();
+    delete server;
+    server = nullptr;
+  }
+}
+
+uint64_t ImpairedLink::now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+void ImpairedLink::loop() {
+  // 新的从设备连接：重新建立到主设备的连接
+  if (server != nullptr && server->hasClient()) {
+    downstream = server->available();
+    upstream.stop();
+    upstream.connect(IPAddress(127, 0, 0, 1), upstreamPort);
+    upstream.setNoDelay(true);
+    downstream.setNoDelay(true);
+    toMaster.queue.clear();
+    toSlave.queue.clear();
+    toMaster.linkFreeAt = toMaster.lastDeliverAt = 0;
+    toSlave.linkFreeAt = toSlave.lastDeliverAt = 0;
+    connectedAt = now();
+  }
+
+  // 任一端断开时断开另一端
+  if (!downstream.connected() || !upstream.connected()) {
+    downstream.stop();
+    upstream.stop();
+    return;
+  }
+
+  if (impairment.dropIntervalMs > 0 && now() - connectedAt >= (uint64_t)impairment.dropIntervalMs * 1000ULL) {
+    drop();
+    return;
+  }
+
+  forward(toMaster);
+  forward(toSlave);
+}
+
+void ImpairedLink::drop() {
+  // 两端同时断开，尚未投递的数据丢失
+  downstream.stop();
+  upstream.stop();
+  toMaster.queue.clear();
+  toSlave.queue.clear();
+  drops++;
+}
+
+void ImpairedLink::forward(Direction& direction) {
+  // 读取新数据并计算投递时间
+  uint8_t buffer[IMPAIRED_LINK_CHUNK_SIZE];
+  int n;
+  while (direction.from->available() > 0 && (n = direction.from->read(buffer, sizeof(buffer))) > 0) {
+    uint64_t t = now();
+
+    // 带宽限制：报文按顺序占用链路
+    if (impairment.bandwidthKbps > 0) {
+      uint64_t start = std::max(t, direction.linkFreeAt);
+      direction.linkFreeAt = start + (uint64_t)n * 8000ULL / impairment.bandwidthKbps;
+      t = direction.linkFreeAt;
+    }
+
+    // 时延和抖动
+    int64_t jitter = 0;
+    if (impairment.jitterUs > 0) {
+      std::uniform_int_distribution<int64_t> dist(-(int64_t)impairment.jitterUs, impairment.jitterUs);
+      jitter = dist(rng);
+    }
+    int64_t delay = std::max<int64_t>(0, (int64_t)impairment.delayUs + jitter);
+    uint64_t deliverAt = t + delay;
+
+    // 丢包：TCP会重传，表现为额外的重传时延
+    if (impairment.lossPercent > 0) {
+      std::uniform_real_distribution<float> dist(0.0f, 100.0f);
+      while (dist(rng) < impairment.lossPercent) {
+        deliverAt += impairment.retransmitUs;
+        chunksLost++;
+      }
+    }
+
+    // TCP按序投递
+    deliverAt = std::max(deliverAt, direction.lastDeliverAt);
+    direction.lastDeliverAt = deliverAt;
+
+    Chunk chunk;
+    chunk.deliverAt = deliverAt;
+    chunk.data.assign(buffer, buffer + n);
+    direction.queue.push_back(std::move(chunk));
+  }
+
+  // 投递到期的数据
+  uint64_t t = now();
+  while (!direction.queue.empty() && direction.queue.front().deliverAt <= t) {
+    Chunk& chunk = direction.queue.front();
+    direction.to->write(chunk.data.data(), chunk.data.size());
+    direction.queue.pop_front();
+    chunksForwarded++;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef IMPAIRED_LINK_H
+#define IMPAIRED_LINK_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <deque>
+#include <vector>
+#include <random>
+
+// WiFi链路损伤参数
+struct LinkImpairment {
+  uint32_t delayUs;         // 单向基础时延
+  uint32_t jitterUs;        // 时延抖动 (在 ±jitter 内均匀分布)
+  float lossPercent;        // 报文丢失率 (%)
+  uint32_t retransmitUs;    // 丢失报文的重传代价 (TCP会重传，丢包表现为额外时延)
+  uint32_t bandwidthKbps;   // 带宽上限，0表示不限
+  uint32_t dropIntervalMs;  // 每隔该时间断开一次连接 (模拟WiFi掉线，传输中的数据丢失)，0表示不断开
+};
+
+// 带损伤的TCP转发代理
+// 从设备连接代理端口，代理再连接主设备，双向转发时按参数注入时延、抖动、丢包和带宽限制
+class ImpairedLink {
+public:
+  ImpairedLink();
+  ~ImpairedLink();
+
+  bool begin(uint16_t listenPort, uint16_t upstreamPort, const LinkImpairment& impairment, uint32_t seed);
+  void end();
+
+  // 转发一轮 (非阻塞)
+  void loop();
+
+  // 统计
+  uint32_t getChunksForwarded() { return chunksForwarded; }
+  uint32_t getChunksLost() { return chunksLost; }
+  uint32_t getDrops() { return drops; }
+
+private:
+  // 一个方向上等待投递的数据
+  struct Chunk {
+    uint64_t deliverAt;
+    std::vector<uint8_t> data;
+  };
+
+  struct Direction {
+    WiFiClient* from;
+    WiFiClient* to;
+    std::deque<Chunk> queue;
+    uint64_t linkFreeAt;      // 带宽限制：链路空闲的时间点
+    uint64_t lastDeliverAt;   // TCP按序投递
+  };
+
+  WiFiServer* server;
+  uint16_t upstreamPort;
+  WiFiClient downstream;  // 从设备一侧
+  WiFiClient upstream;    // 主设备一侧
+  LinkImpairment impairment;
+  std::mt19937 rng;
+  Direction toMaster;
+  Direction toSlave;
+  uint32_t chunksForwarded;
+  uint32_t chunksLost;
+  uint32_t drops;
+  uint64_t connectedAt;
+
+  void drop();
+  void forward(Direction& direction);
+  uint64_t now();
+};
+
+#endif // IMPAIRED_LINK_H
\ No newline at end of file
@@ -0,0 +1,785 @@
+// WiFly485 主从中继主机模拟器
+//
+// 在一个进程中运行主设备和从设备的转发逻辑 (RS485 + TcpProtocol + DataRouter)：
+//   - 两个UART由伪终端代替，按波特率节奏收发
+//   - 主从之间的WiFi链路由回环地址上的TCP代理代替，可注入时延、抖动、丢包和带宽限制
+//   - 主设备一侧模拟VRF控制器轮询，从设备一侧模拟新风设备应答
+// 对每个波特率输出单向帧时延、往返时延的P50/P99和持续吞吐量
+// 指定 --gap-chars 时两端设备在帧内插入字节间隔，在远端总线上测量间隔的重现误差
+
+#include <Arduino.h>
+#include <getopt.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include "config_manager.h"
+#include "data_router.h"
+#include "logger.h"
+#include "modbus.h"
+#include "response_timeout.h"
+#include "rs485.h"
+#include "sim_uart.h"
+#include "tcp_protocol.h"
+#include "traffic_capture.h"
+#include "impaired_link.h"
+
+// 模拟参数
+struct SimOptions {
+  std::vector<uint32_t> baudRates;
+  uint32_t durationMs;
+  LinkImpairment link;
+  uint32_t turnaroundUs;     // 新风设备的应答延迟
+  uint8_t registers;         // 每次读取的寄存器数
+  uint8_t slaveCount;        // 轮询的从站地址数
+  uint32_t responseTimeoutMs;
+  uint16_t basePort;
+  uint32_t seed;
+  const char* capturePath;   // 将主设备的总线流量捕获到该文件
+  const char* replayPath;    // 回放该捕获文件代替合成流量
+  bool resume;               // 主从链路断线后恢复会话
+  float gapChars;            // 请求第2字节后、应答第3字节后插入的静默 (字符时间)，0表示连续发送
+  bool replayTiming;         // 中继记录并重现帧内字节间隔
+  bool batch;                // 链路聚合发送短帧 (与固件相同的预算)
+  bool json;
+  bool verbose;
+};
+
+// 单个波特率的模拟结果
+struct SimResult {
+  uint32_t baudRate;
+  uint32_t transactions;
+  uint32_t timeouts;
+  uint32_t corrupt;
+  std::vector<uint32_t> forwardUs;   // 请求：控制器发送完成 → 新风设备接收完成
+  std::vector<uint32_t> reverseUs;   // 应答：新风设备发送完成 → 控制器接收完成
+  std::vector<uint32_t> roundTripUs; // 控制器发送完成 → 控制器收到完整应答
+  uint64_t payloadBytes;
+  uint32_t elapsedUs;
+  // 链路断线与会话恢复 (--drop-every-ms)
+  uint32_t linkDrops;
+  uint32_t resumes;
+  uint32_t maxFailoverMs;     // 从设备发现断线到会话恢复的最长时间
+  uint32_t retransmits;
+  uint32_t duplicates;
+  uint32_t replayDropped;
+  // 字节间隔重现 (--gap-chars)：远端总线上观测到的间隔与原始间隔之差
+  std::vector<uint32_t> gapErrorUs;  // 绝对值
+  int64_t gapErrorSumUs;             // 带符号的和 (负数表示间隔被压缩)
+  uint32_t timedFrames;
+  // 链路聚合发送 (两个方向之和)
+  uint32_t linkFrames;
+  uint32_t linkPackets;
+  uint32_t batchedFrames;
+  uint32_t maxBatchHoldUs;
+  // 从设备的应答等待
+  uint32_t busTimeouts;
+  uint32_t maxResponseTimeoutUs;   // 结束时各地址等待时间的最大值
+};
+
+// 插入字节间隔的位置：请求的地址和功能码之后，应答的字节数字段之后
+#define SIM_REQUEST_GAP_INDEX 2
+#define SIM_RESPONSE_GAP_INDEX 3
+
+// 标准Modbus RTU波特率
+static const uint32_t SUPPORTED_BAUD_RATES[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+
+static void sleepMicros(uint32_t us) {
+  struct timespec ts = {0, (long)us * 1000L};
+  nanosleep(&ts, nullptr);
+}
+
+// ---------------------------------------------------------------------------
+// 一个中继节点 (主设备或从设备的转发逻辑)
+// ---------------------------------------------------------------------------
+
+struct RelayNode {
+  SimUart uart;
+  RS485 rs485;
+  TcpProtocol link;
+  DataRouter router;
+  ResponseTimeouts responses;
+
+  void run(std::atomic<bool>& running) {
+    while (running) {
+      link.loop();
+      router.loop();
+      sleepMicros(10);
+    }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// 总线两端的模拟设备：VRF控制器 (主设备总线) 和新风设备 (从设备总线)
+// ---------------------------------------------------------------------------
+
+// 一次总线事务：控制器发出的请求和新风设备的应答 (广播等无应答请求的应答为空)
+struct Transaction {
+  uint32_t offsetUs;              // 回放：相对第一条请求的原始发送时间
+  std::vector<uint8_t> request;
+  std::vector<uint8_t> response;
+};
+
+class BusSimulator {
+public:
+  // trace为nullptr时生成合成的轮询流量，否则按原始时间回放捕获的事务
+  BusSimulator(SimUart& controllerUart, SimUart& deviceUart, const RS485Config& config, const SimOptions& options,
+               const std::vector<Transaction>* trace, SimResult& result)
+      : controllerUart(controllerUart), deviceUart(deviceUart), options(options), trace(trace), result(result),
+        traceIndex(0), startAt(micros()), waitingResponse(false), requestDelivered(false), sequence(0),
+        requestDoneAt(0), responseDeadline(0), nextRequestAt(0), responseLength(0),
+        requestLength(0), responsePending(false), responseAt(0), responseDoneAt(0) {
+    frameGapUs = RS485::calcFrameGapUs(config);
+    charTimeUs = RS485::calcCharTimeUs(config);
+    gapUs = (uint32_t)(options.gapChars * charTimeUs);
+  }
+
+  void step() {
+    stepController();
+    stepDevice();
+  }
+
+  // 回放结束
+  bool finished() { return trace != nullptr && traceIndex >= trace->size() && !waitingResponse; }
+
+private:
+  SimUart& controllerUart;
+  SimUart& deviceUart;
+  const SimOptions& options;
+  const std::vector<Transaction>* trace;
+  SimResult& result;
+  uint32_t frameGapUs;
+  uint32_t charTimeUs;
+  uint32_t gapUs;
+  size_t traceIndex;
+  uint32_t startAt;
+
+  // 当前事务 (控制器和新风设备在同一线程中共享)
+  Transaction current;
+  bool waitingResponse;
+  bool requestDelivered;
+  uint16_t sequence;
+
+  // 控制器状态
+  uint32_t requestDoneAt;
+  uint32_t responseDeadline;
+  uint32_t nextRequestAt;
+  uint8_t response[RS485_FRAME_BUFFER_SIZE];
+  uint32_t responseTimes[RS485_FRAME_BUFFER_SIZE];  // 每个字节的读取时间
+  uint16_t responseLength;
+
+  // 新风设备状态
+  uint8_t request[RS485_FRAME_BUFFER_SIZE];
+  uint32_t requestTimes[RS485_FRAME_BUFFER_SIZE];
+  uint16_t requestLength;
+  bool responsePending;
+  uint32_t responseAt;
+  uint32_t responseDoneAt;
+
+  // 合成事务：读保持寄存器，起始地址字段和第一个寄存器携带序号用于匹配
+  void makeSyntheticTransaction() {
+    sequence++;
+    uint8_t frame[RS485_FRAME_BUFFER_SIZE];
+    frame[0] = 1 + sequence % options.slaveCount;
+    frame[1] = 0x03;
+    frame[2] = sequence >> 8;
+    frame[3] = sequence & 0xFF;
+    frame[4] = 0;
+    frame[5] = options.registers;
+    uint16_t length = modbusAppendCrc(frame, 6);
+    current.request.assign(frame, frame + length);
+
+    length = 0;
+    frame[length++] = 1 + sequence % options.slaveCount;
+    frame[length++] = 0x03;
+    frame[length++] = options.registers * 2;
+    for (uint8_t i = 0; i < options.registers; i++) {
+      uint16_t value = i == 0 ? sequence : (uint16_t)(i * 257);
+      frame[length++] = value >> 8;
+      frame[length++] = value & 0xFF;
+    }
+    length = modbusAppendCrc(frame, length);
+    current.response.assign(frame, frame + length);
+  }
+
+  // 发送一帧，gapIndex字节之前插入gapUs的静默
+  void writeFrame(SimUart& uart, const std::vector<uint8_t>& frame, size_t gapIndex) {
+    if (gapUs == 0 || gapIndex >= frame.size()) {
+      uart.write(frame.data(), frame.size());
+      return;
+    }
+    uart.write(frame.data(), gapIndex);
+    uint32_t resumeAt = uart.txCompleteTime() + gapUs;
+    uart.flush();
+    while ((int32_t)(micros() - resumeAt) < 0) {
+    }
+    uart.write(frame.data() + gapIndex, frame.size() - gapIndex);
+  }
+
+  // 比较接收方观测到的间隔与插入的间隔 (times为帧内每个字节的读取时间)
+  void measureGap(const uint32_t* times, size_t length, size_t gapIndex) {
+    if (gapUs == 0 || gapIndex >= length) {
+      return;
+    }
+    int32_t observed = (int32_t)(times[gapIndex] - times[gapIndex - 1] - charTimeUs);
+    int32_t error = observed - (int32_t)gapUs;
+    result.gapErrorUs.push_back((uint32_t)abs(error));
+    result.gapErrorSumUs += error;
+  }
+
+  void stepController() {
+    uint32_t now = micros();
+
+    if (!waitingResponse) {
+      if ((int32_t)(now - nextRequestAt) < 0) {
+        return;
+      }
+      if (trace == nullptr) {
+        makeSyntheticTransaction();
+      } else {
+        if (traceIndex >= trace->size()) {
+          return;
+        }
+        // 按原始时间发送；上一事务拖延时顺延
+        if ((int32_t)(now - (startAt + (*trace)[traceIndex].offsetUs)) < 0) {
+          return;
+        }
+        current = (*trace)[traceIndex++];
+      }
+      writeFrame(controllerUart, current.request, SIM_REQUEST_GAP_INDEX);
+      requestDoneAt = controllerUart.txCompleteTime();
+      responseDeadline = requestDoneAt + options.responseTimeoutMs * 1000;
+      responseLength = 0;
+      requestDelivered = false;
+      waitingResponse = true;
+      return;
+    }
+
+    while (controllerUart.available() > 0 && responseLength < sizeof(response)) {
+      responseTimes[responseLength] = micros();
+      response[responseLength++] = (uint8_t)controllerUart.read();
+    }
+
+    now = micros();
+    if (current.response.empty()) {
+      // 无应答的请求：送达新风设备即完成
+      if (requestDelivered) {
+        result.transactions++;
+        result.payloadBytes += current.request.size();
+        finishTransaction(now);
+      } else if ((int32_t)(now - responseDeadline) >= 0) {
+        result.timeouts++;
+        finishTransaction(now);
+      }
+    } else if (responseLength >= current.response.size()) {
+      if (responseLength == current.response.size() &&
+          memcmp(response, current.response.data(), responseLength) == 0) {
+        result.transactions++;
+        result.roundTripUs.push_back(now - requestDoneAt);
+        result.reverseUs.push_back(now - responseDoneAt);
+        result.payloadBytes += current.request.size() + responseLength;
+        measureGap(responseTimes, responseLength, SIM_RESPONSE_GAP_INDEX);
+      } else {
+        result.corrupt++;
+      }
+      finishTransaction(now);
+    } else if ((int32_t)(now - responseDeadline) >= 0) {
+      result.timeouts++;
+      finishTransaction(now);
+    }
+  }
+
+  void finishTransaction(uint32_t now) {
+    waitingResponse = false;
+    responsePending = false;
+    // 控制器在下一次请求前保持至少一个帧间隔的静默
+    nextRequestAt = now + frameGapUs;
+    while (controllerUart.available() > 0) {
+      controllerUart.read();
+    }
+  }
+
+  void stepDevice() {
+    uint32_t now = micros();
+
+    while (deviceUart.available() > 0) {
+      // 按内容而不是帧间隔匹配请求：单核主机上线程调度会在帧内插入停顿
+      if (requestLength == sizeof(request)) {
+        memmove(request, request + 1, sizeof(request) - 1);
+        memmove(requestTimes, requestTimes + 1, sizeof(requestTimes) - sizeof(requestTimes[0]));
+        requestLength--;
+      }
+      requestTimes[requestLength] = micros();
+      request[requestLength++] = (uint8_t)deviceUart.read();
+
+      size_t size = current.request.size();
+      if (!waitingResponse || requestDelivered || requestLength < size ||
+          memcmp(request + requestLength - size, current.request.data(), size) != 0) {
+        continue;
+      }
+      measureGap(requestTimes + requestLength - size, size, SIM_REQUEST_GAP_INDEX);
+      requestLength = 0;
+      result.forwardUs.push_back(now - requestDoneAt);
+      requestDelivered = true;
+      if (!current.response.empty()) {
+        responsePending = true;
+        responseAt = now + options.turnaroundUs;
+      }
+    }
+
+    if (responsePending && (int32_t)(micros() - responseAt) >= 0) {
+      writeFrame(deviceUart, current.response, SIM_RESPONSE_GAP_INDEX);
+      responseDoneAt = deviceUart.txCompleteTime();
+      responsePending = false;
+    }
+  }
+};
+
+// 从捕获文件构造回放事务
+// 捕获设备从总线上收到的帧：主设备上是控制器的请求，从设备上是新风设备的应答，
+// 因此按段头中的角色确定请求方向，每个请求与其后、下一个请求之前的第一个反向帧配对
+static bool loadTrace(const char* path, std::vector<Transaction>& trace, RS485Config& config) {
+  FILE* handle = fopen(path, "rb");
+  if (handle == nullptr) {
+    fprintf(stderr, "无法打开捕获文件: %s\n", path);
+    return false;
+  }
+  CaptureReader reader;
+  if (!reader.begin(File(handle, path))) {
+    return false;
+  }
+  config = reader.getConfig();
+  CaptureDirection requestDirection = reader.getRole() == CAPTURE_ROLE_MASTER ? CAPTURE_BUS_TO_LINK : CAPTURE_LINK_TO_BUS;
+
+  CaptureRecord record;
+  uint32_t firstTimestamp = 0;
+  while (reader.next(record)) {
+    if (record.direction() == requestDirection) {
+      if (trace.empty()) {
+        firstTimestamp = record.timestamp;
+      }
+      Transaction transaction;
+      transaction.offsetUs = record.timestamp - firstTimestamp;
+      transaction.request.assign(record.data, record.data + record.length);
+      trace.push_back(transaction);
+    } else if (!trace.empty() && trace.back().response.empty()) {
+      trace.back().response.assign(record.data, record.data + record.length);
+    }
+  }
+
+  if (trace.empty()) {
+    fprintf(stderr, "捕获文件中没有可回放的请求: %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// 统计与报告
+// ---------------------------------------------------------------------------
+
+static double percentileMs(std::vector<uint32_t>& samples, uint32_t percentile) {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  std::sort(samples.begin(), samples.end());
+  // 最近秩法
+  size_t rank = (samples.size() * percentile + 99) / 100;
+  size_t index = rank > 0 ? rank - 1 : 0;
+  return samples[std::min(index, samples.size() - 1)] / 1000.0;
+}
+
+static void printResult(SimResult& result, const SimOptions& options, const RS485Config& config) {
+  double seconds = result.elapsedUs / 1000000.0;
+  double throughput = seconds > 0 ? result.payloadBytes / seconds : 0;
+  // 每字节在总线上占用一个字符时间，请求和应答分别占用两条总线
+  double utilization = seconds > 0 ? result.payloadBytes * RS485::calcCharTimeUs(config) / (result.elapsedUs * 2.0) : 0;
+
+  double fwd50 = percentileMs(result.forwardUs, 50);
+  double fwd99 = percentileMs(result.forwardUs, 99);
+  double rev50 = percentileMs(result.reverseUs, 50);
+  double rev99 = percentileMs(result.reverseUs, 99);
+  double rtt50 = percentileMs(result.roundTripUs, 50);
+  double rtt99 = percentileMs(result.roundTripUs, 99);
+  double gap50 = percentileMs(result.gapErrorUs, 50) * 1000.0;
+  double gap99 = percentileMs(result.gapErrorUs, 99) * 1000.0;
+  double gapMean = result.gapErrorUs.empty() ? 0.0 : (double)result.gapErrorSumUs / result.gapErrorUs.size();
+  double packetRate = seconds > 0 ? result.linkPackets / seconds : 0;
+  double airtimeSavedMs = (result.linkFrames - result.linkPackets) * TCP_PACKET_AIRTIME_US / 1000.0;
+
+  if (options.json) {
+    printf("{\"type\":\"simulation\",\"baud\":%u,\"duration_s\":%.3f,\"transactions\":%u,\"timeouts\":%u,\"corrupt\":%u,"
+           "\"forward_p50_ms\":%.3f,\"forward_p99_ms\":%.3f,\"reverse_p50_ms\":%.3f,\"reverse_p99_ms\":%.3f,"
+           "\"rtt_p50_ms\":%.3f,\"rtt_p99_ms\":%.3f,\"throughput_Bps\":%.1f,\"bus_utilization\":%.3f,"
+           "\"delay_ms\":%.3f,\"jitter_ms\":%.3f,\"loss_pct\":%.2f,\"bandwidth_kbps\":%u,"
+           "\"link_drops\":%u,\"resumes\":%u,\"failover_max_ms\":%u,\"retransmits\":%u,\"duplicates\":%u,\"replay_dropped\":%u,"
+           "\"gap_chars\":%.2f,\"replay_timing\":%s,\"gap_samples\":%u,\"gap_err_p50_us\":%.0f,\"gap_err_p99_us\":%.0f,"
+           "\"gap_err_mean_us\":%.1f,\"timed_frames\":%u,\"batch\":%s,\"link_frames\":%u,\"link_packets\":%u,"
+           "\"link_packets_per_s\":%.1f,\"batched_frames\":%u,\"airtime_saved_ms\":%.1f,\"batch_hold_max_us\":%u,"
+           "\"bus_timeouts\":%u,\"response_timeout_max_ms\":%.3f}\n",
+           (unsigned)result.baudRate, seconds, (unsigned)result.transactions, (unsigned)result.timeouts, (unsigned)result.corrupt,
+           fwd50, fwd99, rev50, rev99, rtt50, rtt99, throughput, utilization,
+           options.link.delayUs / 1000.0, options.link.jitterUs / 1000.0, options.link.lossPercent, (unsigned)options.link.bandwidthKbps,
+           (unsigned)result.linkDrops, (unsigned)result.resumes, (unsigned)result.maxFailoverMs, (unsigned)result.retransmits,
+           (unsigned)result.duplicates, (unsigned)result.replayDropped,
+           options.gapChars, options.replayTiming ? "true" : "false", (unsigned)result.gapErrorUs.size(), gap50, gap99,
+           gapMean, (unsigned)result.timedFrames, options.batch ? "true" : "false", (unsigned)result.linkFrames,
+           (unsigned)result.linkPackets, packetRate, (unsigned)result.batchedFrames, airtimeSavedMs,
+           (unsigned)result.maxBatchHoldUs, (unsigned)result.busTimeouts, result.maxResponseTimeoutUs / 1000.0);
+  } else {
+    printf("%7u %8u %8u %7u %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %10.1f %6.1f%%\n",
+           (unsigned)result.baudRate, (unsigned)result.transactions, (unsigned)result.timeouts, (unsigned)result.corrupt,
+           fwd50, fwd99, rev50, rev99, rtt50, rtt99, throughput, utilization * 100.0);
+    if (result.linkDrops > 0) {
+      printf("        断线 %u 次, 恢复会话 %u 次, 最长切换 %u ms, 重发 %u 帧, 重复 %u 帧, 丢弃 %u 帧\n",
+             (unsigned)result.linkDrops, (unsigned)result.resumes, (unsigned)result.maxFailoverMs,
+             (unsigned)result.retransmits, (unsigned)result.duplicates, (unsigned)result.replayDropped);
+    }
+    if (!result.gapErrorUs.empty()) {
+      printf("        字节间隔 %.2f 字符 (定时重现%s): 误差 P50 %.0f us, P99 %.0f us, 平均 %+.1f us (%u 个间隔, %u 帧按间隔发送)\n",
+             options.gapChars, options.replayTiming ? "开启" : "关闭", gap50, gap99, gapMean,
+             (unsigned)result.gapErrorUs.size(), (unsigned)result.timedFrames);
+    }
+    if (result.batchedFrames > 0) {
+      printf("        聚合发送: %u 帧 / %u 个数据包 (%.1f 包/秒)，节省空口约 %.1f ms，最长等待 %u us\n",
+             (unsigned)result.linkFrames, (unsigned)result.linkPackets, packetRate, airtimeSavedMs,
+             (unsigned)result.maxBatchHoldUs);
+    }
+    if (result.busTimeouts > 0 || options.verbose) {
+      printf("        从设备应答等待: 超时 %u 次，结束时最长等待时间 %.2f ms\n", (unsigned)result.busTimeouts,
+             result.maxResponseTimeoutUs / 1000.0);
+    }
+  }
+  fflush(stdout);
+}
+
+// ---------------------------------------------------------------------------
+// 运行一个波特率
+// ---------------------------------------------------------------------------
+
+static bool runBaudRate(const RS485Config& config, uint16_t port, const SimOptions& options,
+                        const std::vector<Transaction>* trace, SimResult& result) {
+  uint32_t charTimeUs = RS485::calcCharTimeUs(config);
+
+  result = SimResult();
+  result.baudRate = config.baudRate;
+
+  // 伪终端：中继节点使用从端(相当于UART设备)，模拟设备使用主端
+  int masterBusPty, masterUartPty, slaveBusPty, slaveUartPty;
+  if (!SimUart::openPair(masterBusPty, masterUartPty) || !SimUart::openPair(slaveBusPty, slaveUartPty)) {
+    fprintf(stderr, "无法创建伪终端\n");
+    return false;
+  }
+
+  SimUart controllerUart;
+  SimUart deviceUart;
+  controllerUart.attach(masterBusPty, charTimeUs);
+  deviceUart.attach(slaveBusPty, charTimeUs);
+
+  RelayNode master;
+  RelayNode slave;
+  master.uart.attach(masterUartPty, charTimeUs);
+  slave.uart.attach(slaveUartPty, charTimeUs);
+  master.rs485.begin(master.uart, config);
+  slave.rs485.begin(slave.uart, config);
+
+  // 主设备监听，从设备经损伤代理连接主设备
+  ImpairedLink proxy;
+  master.link.setResumeEnabled(options.resume);
+  slave.link.setResumeEnabled(options.resume);
+  if (options.batch) {
+    master.link.setBatchBudgetUs(charTimeUs * TCP_BATCH_HOLD_CHARS);
+    slave.link.setBatchBudgetUs(charTimeUs * TCP_BATCH_HOLD_CHARS);
+  }
+  master.link.beginServer(port);
+  if (!proxy.begin(port + 1, port, options.link, options.seed + config.baudRate)) {
+    fprintf(stderr, "无法在端口 %u 上启动链路代理\n", port + 1);
+    return false;
+  }
+  slave.link.beginClient("127.0.0.1", port + 1);
+  master.router.begin(&master.rs485, &master.link);
+  slave.router.begin(&slave.rs485, &slave.link);
+  // 与固件相同：从设备按地址的应答时间估计等待应答
+  slave.responses.begin(config);
+  slave.router.setResponseTimeouts(&slave.responses);
+
+  // 捕获主设备的总线流量 (每个波特率覆盖同一文件，保留最后一次运行)
+  TrafficCapture capture;
+  if (options.capturePath != nullptr) {
+    FILE* handle = fopen(options.capturePath, "w+b");
+    if (handle == nullptr || !capture.begin(File(handle, options.capturePath), config, CAPTURE_ROLE_MASTER)) {
+      fprintf(stderr, "无法创建捕获文件: %s\n", options.capturePath);
+      return false;
+    }
+    master.router.setCapture(&capture);
+  }
+
+  std::atomic<bool> running(true);
+  std::thread proxyThread([&]() {
+    while (running) {
+      proxy.loop();
+      sleepMicros(10);
+    }
+  });
+  std::thread masterThread([&]() { master.run(running); });
+  std::thread slaveThread([&]() { slave.run(running); });
+
+  // 等待主从连接建立
+  uint32_t waitStart = millis();
+  while (!(master.link.isConnected() && slave.link.isConnected()) && millis() - waitStart < 3000) {
+    sleepMicros(1000);
+  }
+
+  // 总线模拟在当前线程运行
+  BusSimulator bus(controllerUart, deviceUart, config, options, trace, result);
+  uint32_t startUs = micros();
+  uint32_t startMs = millis();
+  while (millis() - startMs < options.durationMs && !bus.finished()) {
+    bus.step();
+    sleepMicros(10);
+  }
+  result.elapsedUs = micros() - startUs;
+
+  running = false;
+  masterThread.join();
+  slaveThread.join();
+  proxyThread.join();
+  result.linkDrops = proxy.getDrops();
+  result.resumes = slave.link.getResumes();
+  result.maxFailoverMs = slave.link.getMaxFailoverMs();
+  result.retransmits = master.link.getRetransmits() + slave.link.getRetransmits();
+  result.duplicates = master.link.getDuplicates() + slave.link.getDuplicates();
+  result.replayDropped = master.link.getReplayDropped() + slave.link.getReplayDropped();
+  result.timedFrames = master.rs485.getTimedFrames() + slave.rs485.getTimedFrames();
+  result.linkFrames = master.link.getFramesSent() + slave.link.getFramesSent();
+  result.linkPackets = master.link.getPacketsSent() + slave.link.getPacketsSent();
+  result.batchedFrames = master.link.getBatchedFrames() + slave.link.getBatchedFrames();
+  result.maxBatchHoldUs = std::max(master.link.getMaxBatchHoldUs(), slave.link.getMaxBatchHoldUs());
+  for (uint16_t address = 1; address <= 247; address++) {
+    const ResponseEstimate* estimate = slave.responses.find((uint8_t)address);
+    if (estimate != nullptr) {
+      result.busTimeouts += estimate->timeouts;
+      result.maxResponseTimeoutUs = std::max(result.maxResponseTimeoutUs, estimate->timeoutUs);
+    }
+  }
+  capture.end();
+  master.link.end();
+  slave.link.end();
+  proxy.end();
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// 命令行
+// ---------------------------------------------------------------------------
+
+static void printUsage(const char* program) {
+  printf("用法: %s [选项]\n", program);
+  printf("  --baud <波特率|all>     模拟的波特率，可重复指定 (默认: all)\n");
+  printf("  --duration <秒>         每个波特率的模拟时长 (默认: 10)\n");
+  printf("  --delay-ms <毫秒>       WiFi单向时延 (默认: 2)\n");
+  printf("  --jitter-ms <毫秒>      时延抖动 (默认: 1)\n");
+  printf("  --loss <百分比>         报文丢失率 (默认: 0)\n");
+  printf("  --rto-ms <毫秒>         丢失报文的重传代价 (默认: 200)\n");
+  printf("  --bandwidth-kbps <值>   链路带宽上限 (默认: 不限)\n");
+  printf("  --drop-every-ms <毫秒>  每隔该时间断开一次主从连接 (默认: 不断开)\n");
+  printf("  --no-resume             断线后不恢复会话 (对比用)\n");
+  printf("  --gap-chars <字符数>    帧内插入的字节间隔 (默认: 0，不插入)\n");
+  printf("  --replay-timing         中继记录并重现帧内字节间隔\n");
+  printf("  --no-batch              链路不聚合发送短帧 (对比用)\n");
+  printf("  --turnaround-ms <毫秒>  新风设备应答延迟 (默认: 2)\n");
+  printf("  --registers <数量>      每次读取的寄存器数 (默认: 10)\n");
+  printf("  --timeout-ms <毫秒>     控制器应答超时 (默认: 1000)\n");
+  printf("  --port <端口>           起始TCP端口 (默认: 18888)\n");
+  printf("  --seed <值>             随机种子 (默认: 1)\n");
+  printf("  --capture <文件>        将主设备的总线流量捕获到文件\n");
+  printf("  --replay <文件>         按原始时间回放捕获文件 (使用捕获时的串口参数)\n");
+  printf("  --json                  以JSON行格式输出结果\n");
+  printf("  --verbose               输出中继日志\n");
+}
+
+static bool parseOptions(int argc, char** argv, SimOptions& options) {
+  options.durationMs = 10000;
+  options.link.delayUs = 2000;
+  options.link.jitterUs = 1000;
+  options.link.lossPercent = 0;
+  options.link.retransmitUs = 200000;
+  options.link.bandwidthKbps = 0;
+  options.link.dropIntervalMs = 0;
+  options.turnaroundUs = 2000;
+  options.registers = 10;
+  options.slaveCount = 4;
+  options.responseTimeoutMs = 1000;
+  options.basePort = 18888;
+  options.seed = 1;
+  options.capturePath = nullptr;
+  options.replayPath = nullptr;
+  options.resume = true;
+  options.gapChars = 0;
+  options.replayTiming = false;
+  options.batch = true;
+  options.json = false;
+  options.verbose = false;
+
+  static const struct option longOptions[] = {
+      {"baud", required_argument, nullptr, 'b'},
+      {"duration", required_argument, nullptr, 'd'},
+      {"delay-ms", required_argument, nullptr, 'D'},
+      {"jitter-ms", required_argument, nullptr, 'j'},
+      {"loss", required_argument, nullptr, 'l'},
+      {"rto-ms", required_argument, nullptr, 'r'},
+      {"bandwidth-kbps", required_argument, nullptr, 'w'},
+      {"drop-every-ms", required_argument, nullptr, 'x'},
+      {"no-resume", no_argument, nullptr, 'N'},
+      {"gap-chars", required_argument, nullptr, 'g'},
+      {"replay-timing", no_argument, nullptr, 'G'},
+      {"no-batch", no_argument, nullptr, 'B'},
+      {"turnaround-ms", required_argument, nullptr, 't'},
+      {"registers", required_argument, nullptr, 'R'},
+      {"timeout-ms", required_argument, nullptr, 'T'},
+      {"port", required_argument, nullptr, 'p'},
+      {"seed", required_argument, nullptr, 's'},
+      {"capture", required_argument, nullptr, 'c'},
+      {"replay", required_argument, nullptr, 'P'},
+      {"json", no_argument, nullptr, 'J'},
+      {"verbose", no_argument, nullptr, 'v'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "b:d:h", longOptions, nullptr)) != -1) {
+    switch (opt) {
+      case 'b':
+        if (strcmp(optarg, "all") == 0) {
+          options.baudRates.assign(std::begin(SUPPORTED_BAUD_RATES), std::end(SUPPORTED_BAUD_RATES));
+        } else {
+          options.baudRates.push_back(strtoul(optarg, nullptr, 10));
+        }
+        break;
+      case 'd':
+        options.durationMs = (uint32_t)(atof(optarg) * 1000);
+        break;
+      case 'D':
+        options.link.delayUs = (uint32_t)(atof(optarg) * 1000);
+        break;
+      case 'j':
+        options.link.jitterUs = (uint32_t)(atof(optarg) * 1000);
+        break;
+      case 'l':
+        options.link.lossPercent = std::min(90.0f, std::max(0.0f, (float)atof(optarg)));
+        break;
+      case 'r':
+        options.link.retransmitUs = (uint32_t)(atof(optarg) * 1000);
+        break;
+      case 'w':
+        options.link.bandwidthKbps = strtoul(optarg, nullptr, 10);
+        break;
+      case 'x':
+        options.link.dropIntervalMs = strtoul(optarg, nullptr, 10);
+        break;
+      case 'N':
+        options.resume = false;
+        break;
+      case 'g':
+        options.gapChars = std::max(0.0f, (float)atof(optarg));
+        break;
+      case 'G':
+        options.replayTiming = true;
+        break;
+      case 'B':
+        options.batch = false;
+        break;
+      case 't':
+        options.turnaroundUs = (uint32_t)(atof(optarg) * 1000);
+        break;
+      case 'R':
+        options.registers = (uint8_t)std::min(120UL, std::max(1UL, strtoul(optarg, nullptr, 10)));
+        break;
+      case 'T':
+        options.responseTimeoutMs = strtoul(optarg, nullptr, 10);
+        break;
+      case 'p':
+        options.basePort = (uint16_t)strtoul(optarg, nullptr, 10);
+        break;
+      case 's':
+        options.seed = strtoul(optarg, nullptr, 10);
+        break;
+      case 'c':
+        options.capturePath = optarg;
+        break;
+      case 'P':
+        options.replayPath = optarg;
+        break;
+      case 'J':
+        options.json = true;
+        break;
+      case 'v':
+        options.verbose = true;
+        break;
+      default:
+        printUsage(argv[0]);
+        return false;
+    }
+  }
+
+  if (options.baudRates.empty()) {
+    options.baudRates.assign(std::begin(SUPPORTED_BAUD_RATES), std::end(SUPPORTED_BAUD_RATES));
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  SimOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    return 2;
+  }
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  logger.setLogLevel(options.verbose ? LOG_LEVEL_DEBUG : LOG_LEVEL_ERROR);
+
+  if (!options.json) {
+    printf("WiFly485 中继模拟: 时延 %.1fms, 抖动 ±%.1fms, 丢包 %.1f%%, 带宽 %s, 每个波特率 %.1fs\n",
+           options.link.delayUs / 1000.0, options.link.jitterUs / 1000.0, options.link.lossPercent,
+           options.link.bandwidthKbps > 0 ? (String(options.link.bandwidthKbps) + "kbps").c_str() : "不限",
+           options.durationMs / 1000.0);
+    printf("%7s %8s %8s %7s %9s %9s %9s %9s %9s %9s %10s %7s\n",
+           "baud", "frames", "timeout", "corrupt", "fwd_p50", "fwd_p99", "rev_p50", "rev_p99", "rtt_p50", "rtt_p99", "B/s", "bus");
+  }
+
+  // 回放：只运行捕获时的串口参数
+  if (options.replayPath != nullptr) {
+    std::vector<Transaction> trace;
+    RS485Config config;
+    SimResult result;
+    SimOptions replayOptions = options;
+    replayOptions.durationMs = UINT32_MAX;  // 运行到捕获结束
+    bool loaded = loadTrace(options.replayPath, trace, config);
+    config.replayTiming = options.replayTiming;
+    if (!loaded ||
+        !runBaudRate(config, options.basePort, replayOptions, &trace, result)) {
+      return 1;
+    }
+    printResult(result, options, config);
+    return result.timeouts + result.corrupt > 0 ? 1 : 0;
+  }
+
+  int failures = 0;
+  uint16_t port = options.basePort;
+  for (uint32_t baudRate : options.baudRates) {
+    SimResult result;
+    RS485Config config;
+    config.baudRate = baudRate;
+    config.dataBits = DEFAULT_DATA_BITS;
+    config.parity = DEFAULT_PARITY;
+    config.stopBits = DEFAULT_STOP_BITS;
+    config.replayTiming = options.replayTiming;
+    if (!runBaudRate(config, port, options, nullptr, result)) {
+      failures++;
+      continue;
+    }
+    printResult(result, options, config);
+    port += 2;
+  }
+
+  return failures > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include "logger.h"
+#include "heap_profiler.h"
 #include <ESP8266WiFi.h>
 
 // 全局日志实例
 Logger logger;
 
-Logger::Logger() : currentLogLevel(LOG_LEVEL_INFO) {
+Logger::Logger() : currentLogLevel(LOG_LEVEL_INFO), output(&Serial) {
   // 构造函数
 }
 
@@ -13,11 +14,16 @@ Logger::~Logger() {
 }
 
 void Logger::begin() {
+  begin(Serial);
+}
+
+void Logger::begin(HardwareSerial& port) {
   // 初始化日志系统
-  Serial.begin(115200);
-  delay(100);
+  // 不等待串口稳定：启动阶段的每一毫秒都推迟总线就绪 (见boot_profiler.h)
+  port.begin(115200);
+  output = &port;
   
-  Serial.println("\n=== WiFly485 日志系统初始化 ===");
+  output->println("\n=== WiFly485 日志系统初始化 ===");
 }
 
 void Logger::setLogLevel(LogLevel level) {
@@ -112,14 +118,16 @@ const char* Logger::getLogLevelString(LogLevel level) {
 }
 
 void Logger::logInternal(LogLevel level, const char* tag, const char* format, va_list args) {
+  HEAP_SCOPE(HEAP_TAG_LOGGER);
+
   // 获取时间戳
   unsigned long timestamp = millis();
   
   // 输出日志级别、时间戳和标签
-  Serial.printf("[%s][%lu][%s] ", getLogLevelString(level), timestamp, tag);
+  output->printf("[%s][%lu][%s] ", getLogLevelString(level), timestamp, tag);
   
   // 输出格式化消息
   char buffer[256];
   vsnprintf(buffer, sizeof(buffer), format, args);
-  Serial.println(buffer);
+  output->println(buffer);
 }
\ No newline at end of file
@@ -1,10 +1,188 @@
 #include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <ESP8266mDNS.h>
+#include "config.h"
+#include "boot_profiler.h"
+#include "config_manager.h"
+#include "config_schema.h"
+#include "data_router.h"
+#include "device.h"
+#include "frame_trace.h"
+#include "heap_profiler.h"
+#include "logger.h"
+#include "master_locator.h"
+#include "metrics.h"
+#include "ota_updater.h"
+#include "power_manager.h"
+#include "response_timeout.h"
+#include "rs485.h"
+#include "scheduler.h"
+#include "tcp_protocol.h"
+#include "web_server.h"
+#include "wifi_manager.h"
+
+Device device;
+ConfigManager configManager;
+RS485 rs485;
+TcpProtocol tcpLink;
+DataRouter router;
+WebServerManager webServer;
+Scheduler scheduler;
+WiFiManager wifiManager;
+MasterLocator masterLocator;
+
+// 中继：网络和总线之间的转发，每次循环都运行
+static void relayTask(void* context) {
+  HEAP_SCOPE(HEAP_TAG_RELAY);
+  tcpLink.loop();
+  router.loop();
+}
+
+static void webTask(void* context) {
+  HEAP_SCOPE(HEAP_TAG_WEB);
+  webServer.loop();
+}
+
+static void wifiTask(void* context) {
+  wifiManager.loop();
+}
+
+static void mdnsTask(void* context) {
+  HEAP_SCOPE(HEAP_TAG_SYNC);
+  MDNS.update();
+}
+
+// 固件升级：每次运行最多一次闪存操作，校验通过并回复后重启
+static void otaTask(void* context) {
+  otaUpdater.loop();
+  if (otaUpdater.isRestartDue()) {
+    LOG_I("Main", "固件升级完成，重新启动");
+    ESP.restart();
+  }
+}
+
+static void statsTask(void* context) {
+  HEAP_SCOPE(HEAP_TAG_LOGGER);
+  scheduler.logSummary();
+  heapProfiler.logSummary();
+}
+
+// 启动串口桥接：总线、主从链路和转发 (配置改变时重新启动)
+static void startBridge(const RS485Config& busConfig, uint16_t tcpPort) {
+  HEAP_SCOPE(HEAP_TAG_RELAY);
+  rs485.begin(Serial, busConfig);
+  tcpLink.end();
+  if (device.isMaster()) {
+    tcpLink.beginServer(tcpPort);
+  } else {
+    // 从设备配置中的端口为0 (不监听)，连接主设备的默认端口
+    tcpLink.beginClient(DEFAULT_MASTER_HOST, tcpPort != 0 ? tcpPort : DEFAULT_MASTER_TCP_PORT);
+  }
+  // 聚合等待不超过总线上几个字符的时间，相对总线本身的时延可以忽略
+  tcpLink.setBatchBudgetUs(RS485::calcCharTimeUs(busConfig) * TCP_BATCH_HOLD_CHARS);
+  router.begin(&rs485, &tcpLink);
+  // 从设备在总线上代替控制器等待应答：超时按每个地址的应答时间估计，离线的设备不阻塞其他请求
+  responseTimeouts.begin(busConfig);
+  router.setResponseTimeouts(device.isMaster() ? nullptr : &responseTimeouts);
+  metrics.setGauge(GAUGE_BUS_READY_MS, millis());
+}
 
 void setup()
 {
+  bootProfiler.begin();
+  heapProfiler.begin();
+
+  // Serial (UART0) 用于RS485总线，日志输出到Serial1
+  logger.begin(Serial1);
+  device.begin();
+  bootProfiler.mark("logger");
+
+  String hostname = device.isMaster() ? String(DEFAULT_MASTER_HOST) : device.getName();
+
+  // 从设备直接连接上次的主设备地址，mDNS只在缓存缺失或连接失败后使用
+  if (!device.isMaster()) {
+    HEAP_SCOPE(HEAP_TAG_SYNC);
+    masterLocator.begin(DEFAULT_MASTER_HOST);
+    tcpLink.setLocator(&masterLocator);
+  }
+
+  // 热启动：RTC中有上次使用的配置，不等待文件系统，立即启动WiFi和串口桥接；
+  // 冷启动：只能用SDK保存的WiFi凭据先开始连接，桥接等配置文件加载后启动
+  bool bridgeStarted = configManager.loadCachedConfig();
+  NetworkConfig cachedNetwork = configManager.getNetworkConfig();
+  RS485Config cachedBus = configManager.getRS485Config();
+  DeviceConfig cachedDevice = configManager.getDeviceConfig();
+  if (bridgeStarted) {
+    wifiManager.begin(cachedNetwork, hostname.c_str());
+    startBridge(cachedBus, cachedDevice.tcpPort);
+    bootProfiler.mark("bridge");
+  } else if (wifiManager.beginFromStoredCredentials(hostname.c_str())) {
+    bootProfiler.mark("wifi");
+  }
+
+  // 挂载文件系统并加载配置，与WiFi关联并行进行
+  {
+    HEAP_SCOPE(HEAP_TAG_CONFIG);
+    configManager.begin();
+  }
+  if (!device.isMaster()) {
+    HEAP_SCOPE(HEAP_TAG_SYNC);
+    masterLocator.loadFileCache(FILE_SYSTEM);
+  }
+  bootProfiler.mark("config");
+
+  // 配置文件与提前启动时使用的配置不同时重新启动对应部分
+  if (!wifiManager.isConfiguredFor(configManager.getNetworkConfig())) {
+    wifiManager.begin(configManager.getNetworkConfig(), hostname.c_str());
+  }
+  uint8_t changed = configManager.changedFlags(cachedNetwork, cachedBus, cachedDevice);
+  if (!bridgeStarted || (changed & CONFIG_FLAG_BRIDGE)) {
+    startBridge(configManager.getRS485Config(), configManager.getDeviceConfig().tcpPort);
+    bootProfiler.mark("bridge");
+  }
+  configManager.saveCachedConfig();
+  powerManager.begin(configManager.getDeviceConfig().powerMode, configManager.getDeviceConfig().maxWakeLatencyMs);
+
+  {
+    HEAP_SCOPE(HEAP_TAG_WEB);
+    webServer.setConfigManager(&configManager);
+    webServer.setLink(&tcpLink);
+    webServer.begin(&device, &scheduler);
+  }
+  {
+    HEAP_SCOPE(HEAP_TAG_SYNC);
+    if (MDNS.begin(hostname.c_str())) {
+      MDNS.addService("http", "tcp", WEB_SERVER_PORT);
+      if (device.isMaster()) {
+        MDNS.addService(MASTER_MDNS_SERVICE, "tcp", configManager.getDeviceConfig().tcpPort);
+      }
+    }
+  }
+
+  // 没有设置升级口令时不监听升级端口
+  if (configManager.getDeviceConfig().otaPassword.length() > 0) {
+    otaUpdater.begin(OTA_TCP_PORT, configManager.getDeviceConfig().otaPassword);
+  } else {
+    LOG_W("Main", "未设置升级口令 (device.otaPassword)，不开启固件升级");
+  }
+
+  scheduler.addTask("relay", relayTask, nullptr, TASK_PRIORITY_REALTIME);
+  scheduler.addTask("web", webTask, nullptr, TASK_PRIORITY_HIGH, 0, 2000);
+  scheduler.addTask("wifi", wifiTask, nullptr, TASK_PRIORITY_NORMAL, 50);
+  scheduler.addTask("mdns", mdnsTask, nullptr, TASK_PRIORITY_NORMAL, 100);
+  scheduler.addTask("ota", otaTask, nullptr, TASK_PRIORITY_NORMAL, 0, OTA_SLICE_BUDGET_US);
+  scheduler.addTask("stats", statsTask, nullptr, TASK_PRIORITY_LOW, SCHEDULER_STATS_INTERVAL_MS, 2000);
+
+  bootProfiler.finish();
+  LOG_I("Main", "%s 启动完成，总线就绪 %u ms", device.getRoleString().c_str(), metrics.getGauge(GAUGE_BUS_READY_MS));
 }
 
 void loop()
 {
-  // put your main code here, to run repeatedly:
+  scheduler.loop();
+
+  // 转发没有未完成的工作时等待 (浅睡眠模式下CPU在等待中睡眠)；升级期间不睡眠
+  if (router.isIdle() && tcpLink.isIdle() && !otaUpdater.isActive()) {
+    powerManager.idle(router.getLastActivityMs(), scheduler.getIdleMs());
+  }
 }
@@ -0,0 +1,170 @@
+#include "master_locator.h"
+#include <ESP8266mDNS.h>
+#include "heap_profiler.h"
+#include "logger.h"
+#include "metrics.h"
+#include "rtc_store.h"
+
+#define MASTER_RTC_MAGIC 0x4d535452  // "MSTR"
+
+MasterLocator::MasterLocator()
+    : fileSystem(nullptr), hasCachedAddress(false), fromCache(false), failures(0), lostAt(0),
+      lastResolveFailure(0), resolveFailed(false) {
+  // 构造函数
+  memset(&address, 0, sizeof(address));
+  memset(&fileAddress, 0, sizeof(fileAddress));
+}
+
+MasterLocator::~MasterLocator() {
+  // 析构函数
+}
+
+void MasterLocator::begin(const char* hostname) {
+  this->hostname = hostname;
+  failures = 0;
+  lostAt = millis();
+  hasCachedAddress = rtcLoad(RTC_MASTER_CACHE_OFFSET, MASTER_RTC_MAGIC, &address, sizeof(address));
+  fromCache = hasCachedAddress;
+  if (hasCachedAddress) {
+    LOG_I("Master", "使用RTC缓存的主设备地址 %s:%u", IPAddress(address.ip).toString().c_str(), address.port);
+  }
+}
+
+void MasterLocator::loadFileCache(FS& fs) {
+  fileSystem = &fs;
+  File file = fs.open(MASTER_CACHE_FILE_PATH, "r");
+  if (!file) {
+    return;
+  }
+  MasterAddressCache loaded;
+  bool valid = file.read((uint8_t*)&loaded, sizeof(loaded)) == sizeof(loaded) && loaded.ip != 0;
+  file.close();
+  if (!valid) {
+    return;
+  }
+  fileAddress = loaded;
+  if (!hasCachedAddress) {
+    address = loaded;
+    hasCachedAddress = true;
+    fromCache = true;
+    LOG_I("Master", "使用文件缓存的主设备地址 %s:%u", IPAddress(address.ip).toString().c_str(), address.port);
+  }
+}
+
+bool MasterLocator::canConnect() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+bool MasterLocator::resolve(IPAddress& ip, uint16_t& port) {
+  HEAP_SCOPE(HEAP_TAG_SYNC);
+
+  if (!canConnect()) {
+    return false;
+  }
+  if (!hasCachedAddress) {
+    if (resolveFailed && (millis() - lastResolveFailure) < MASTER_RESOLVE_RETRY_MS) {
+      return false;
+    }
+    address.port = port;
+    if (!queryMdns() && !queryDns()) {
+      LOG_W("Master", "无法解析主设备 %s", hostname.c_str());
+      resolveFailed = true;
+      lastResolveFailure = millis();
+      return false;
+    }
+    resolveFailed = false;
+    hasCachedAddress = true;
+    fromCache = false;
+  }
+  ip = IPAddress(address.ip);
+  if (address.port != 0) {
+    port = address.port;
+  }
+  return true;
+}
+
+void MasterLocator::onConnected() {
+  failures = 0;
+  uint32_t elapsed = millis() - lostAt;
+  if (fromCache) {
+    METRIC_INC(METRIC_MASTER_CACHE_CONNECTS);
+    metrics.setGauge(GAUGE_MASTER_RECONNECT_CACHED_MS, elapsed);
+  } else {
+    metrics.setGauge(GAUGE_MASTER_RECONNECT_RESOLVED_MS, elapsed);
+    saveCache();
+  }
+  LOG_I("Master", "连接主设备 %s:%u 用时 %u ms (%s)", IPAddress(address.ip).toString().c_str(), address.port, elapsed,
+        fromCache ? "缓存" : "解析");
+  // 之后的重连直接使用这个地址
+  fromCache = true;
+}
+
+void MasterLocator::onConnectFailed() {
+  // WiFi断开时的失败与地址无关
+  if (!hasCachedAddress || !canConnect()) {
+    return;
+  }
+  if (++failures >= MASTER_CACHE_MAX_FAILURES) {
+    LOG_W("Master", "主设备地址 %s 连续 %u 次连接失败，重新解析", IPAddress(address.ip).toString().c_str(), failures);
+    invalidateCache();
+  }
+}
+
+void MasterLocator::onDisconnected() {
+  lostAt = millis();
+}
+
+bool MasterLocator::queryMdns() {
+  METRIC_INC(METRIC_MASTER_MDNS_QUERIES);
+  uint32_t answers = MDNS.queryService(MASTER_MDNS_SERVICE, "tcp", MASTER_MDNS_TIMEOUT_MS);
+  bool found = false;
+  size_t length = hostname.length();
+  for (uint32_t i = 0; i < answers && !found; i++) {
+    // 同一网络中可能有多组中继，只接受本组主设备的主机名 (应答可能带 .local 后缀)
+    const char* answerHost = MDNS.answerHostname(i);
+    if (answerHost == nullptr || strncmp(answerHost, hostname.c_str(), length) != 0 ||
+        (answerHost[length] != '\0' && answerHost[length] != '.')) {
+      continue;
+    }
+    address.ip = (uint32_t)MDNS.answerIP(i);
+    address.port = MDNS.answerPort(i);
+    found = address.ip != 0;
+  }
+  MDNS.removeQuery();
+  return found;
+}
+
+bool MasterLocator::queryDns() {
+  IPAddress ip;
+  if (!WiFi.hostByName(hostname.c_str(), ip) || (uint32_t)ip == 0) {
+    return false;
+  }
+  address.ip = (uint32_t)ip;
+  return true;
+}
+
+void MasterLocator::saveCache() {
+  rtcSave(RTC_MASTER_CACHE_OFFSET, MASTER_RTC_MAGIC, &address, sizeof(address));
+
+  // 地址改变时才写文件，减少闪存擦写
+  if (fileSystem == nullptr || memcmp(&address, &fileAddress, sizeof(address)) == 0) {
+    return;
+  }
+  File file = fileSystem->open(MASTER_CACHE_FILE_PATH, "w");
+  if (!file) {
+    LOG_W("Master", "无法写入主设备地址缓存");
+    return;
+  }
+  if (file.write((const uint8_t*)&address, sizeof(address)) == sizeof(address)) {
+    fileAddress = address;
+  }
+  file.close();
+}
+
+void MasterLocator::invalidateCache() {
+  // 文件中的地址保留，解析到新地址并连接成功后覆盖
+  hasCachedAddress = false;
+  fromCache = false;
+  failures = 0;
+  rtcInvalidate(RTC_MASTER_CACHE_OFFSET);
+}
@@ -0,0 +1,122 @@
+#include "metrics.h"
+
+// 全局计数器实例
+Metrics metrics;
+
+// 与MetricId顺序一致
+static const MetricDescriptor DESCRIPTORS[METRIC_COUNT] = {
+  {"bus_rx_bytes", "Bytes received from the RS485 bus"},
+  {"bus_tx_bytes", "Bytes sent to the RS485 bus"},
+  {"bus_rx_frames", "Frames received from the RS485 bus"},
+  {"bus_tx_frames", "Frames sent to the RS485 bus"},
+  {"bus_crc_errors", "Bus frames with a bad Modbus CRC (still forwarded)"},
+  {"bus_overruns", "Bus frames discarded for exceeding the frame buffer"},
+  {"link_tx_bytes", "Packet bytes written to the master/slave link"},
+  {"link_rx_bytes", "Packet bytes read from the master/slave link"},
+  {"link_tx_frames", "Frames sent over the master/slave link"},
+  {"link_rx_frames", "Frames received over the master/slave link"},
+  {"link_connects", "Master/slave link connections established"},
+  {"link_protocol_errors", "Malformed packets that caused a link reset"},
+  {"router_dropped_frames", "Frames dropped by the router (link down or bus send failure)"},
+  {"capture_dropped_records", "Capture records dropped because the RAM ring was full"},
+  {"metrics_scrapes", "Metrics and status exports served"},
+  {"master_mdns_queries", "mDNS queries sent to locate the master"},
+  {"master_cache_connects", "Master connections made to the cached address without resolving"},
+  {"link_resumes", "Link reconnects that resumed the previous session"},
+  {"link_retransmits", "Frames resent from the replay buffer after a resume"},
+  {"link_duplicates", "Received frames discarded as duplicates by sequence number"},
+  {"link_replay_dropped", "Unacknowledged frames lost to replay buffer overflow, expiry or a new session"},
+  {"power_sleeps", "Idle periods in which the CPU was allowed to enter light sleep"},
+  {"power_sleep_ms", "Milliseconds spent in idle periods that allowed light sleep"},
+  {"power_uart_wakes", "Idle periods ended early by bus activity on UART RX"},
+  {"bus_timed_frames", "Frames sent to the bus with their recorded inter-byte gaps reproduced"},
+  {"link_tx_packets", "Data packets written to the master/slave link (a batch counts once)"},
+  {"link_batched_frames", "Frames sent inside a batch packet together with other frames"},
+  {"link_airtime_saved_us", "Estimated WiFi airtime saved by batching, in microseconds of per-packet overhead"},
+  {"bus_response_timeouts", "Bus requests abandoned after the per-address response timeout (slave)"},
+  {"bus_late_responses", "Bus responses that arrived after their request had timed out (slave)"},
+  {"router_priority_frames", "Frames sent to the bus from the high-priority lane (writes and exception responses)"},
+  {"router_priority_wait_us", "Microseconds high-priority frames waited from link receipt to bus send"},
+  {"router_normal_frames", "Frames sent to the bus from the normal lane (polls and other traffic)"},
+  {"router_normal_wait_us", "Microseconds normal frames waited from link receipt to bus send"},
+  {"router_overtakes", "High-priority frames sent to the bus ahead of queued normal frames"}
+};
+
+// 与GaugeId顺序一致
+static const MetricDescriptor GAUGE_DESCRIPTORS[GAUGE_COUNT] = {
+  {"boot_wifi_connect_ms", "Milliseconds from boot to WiFi association"},
+  {"boot_wifi_fast_connect", "1 if WiFi connected using the RTC cached BSSID/channel/lease"},
+  {"boot_first_forward_ms", "Milliseconds from boot to the first forwarded frame (0 until then)"},
+  {"boot_bus_ready_ms", "Milliseconds from boot until the UART bridge is listening"},
+  {"master_reconnect_cached_ms", "Milliseconds from link loss (or boot) to reconnect using the cached master address"},
+  {"master_reconnect_resolved_ms", "Milliseconds from link loss (or boot) to reconnect after resolving the master"},
+  {"link_failover_ms", "Milliseconds from the last link loss until the session was resumed"}
+};
+
+Metrics::Metrics() : lastScrapeUs(0), maxScrapeUs(0) {
+  // 构造函数
+  reset();
+}
+
+void Metrics::reset() {
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    values[i] = 0;
+  }
+  for (uint8_t i = 0; i < GAUGE_COUNT; i++) {
+    gauges[i] = 0;
+  }
+  lastScrapeUs = 0;
+  maxScrapeUs = 0;
+}
+
+const MetricDescriptor& Metrics::getDescriptor(MetricId id) {
+  return DESCRIPTORS[id];
+}
+
+void Metrics::recordScrape(uint32_t us) {
+  lastScrapeUs = us;
+  if (us > maxScrapeUs) {
+    maxScrapeUs = us;
+  }
+  add(METRIC_SCRAPES);
+}
+
+// 输出一个指标：HELP、TYPE和值
+static void writeMetric(Print& out, const char* name, const char* suffix, const char* type, const char* help, uint32_t value) {
+  out.printf("# HELP " METRIC_PREFIX "%s%s %s\n# TYPE " METRIC_PREFIX "%s%s %s\n" METRIC_PREFIX "%s%s %u\n",
+             name, suffix, help, name, suffix, type, name, suffix, value);
+}
+
+void Metrics::writePrometheus(Print& out) {
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    writeMetric(out, DESCRIPTORS[i].name, "_total", "counter", DESCRIPTORS[i].help, values[i]);
+  }
+
+  for (uint8_t i = 0; i < GAUGE_COUNT; i++) {
+    writeMetric(out, GAUGE_DESCRIPTORS[i].name, "", "gauge", GAUGE_DESCRIPTORS[i].help, gauges[i]);
+  }
+
+  // 运行状态：导出时采样
+  writeMetric(out, "uptime_seconds", "", "gauge", "Seconds since boot", millis() / 1000);
+  writeMetric(out, "heap_free_bytes", "", "gauge", "Free heap", ESP.getFreeHeap());
+  writeMetric(out, "heap_max_block_bytes", "", "gauge", "Largest allocatable heap block", ESP.getMaxFreeBlockSize());
+  writeMetric(out, "heap_fragmentation_percent", "", "gauge", "Heap fragmentation", ESP.getHeapFragmentation());
+  writeMetric(out, "scrape_duration_us", "", "gauge", "Duration of the previous export", lastScrapeUs);
+  writeMetric(out, "scrape_duration_max_us", "", "gauge", "Longest export since boot", maxScrapeUs);
+}
+
+void Metrics::writeJson(Print& out) {
+  out.print('{');
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    if (i > 0) {
+      out.print(',');
+    }
+    out.printf("\"%s\":%u", DESCRIPTORS[i].name, values[i]);
+  }
+  for (uint8_t i = 0; i < GAUGE_COUNT; i++) {
+    out.printf(",\"%s\":%u", GAUGE_DESCRIPTORS[i].name, gauges[i]);
+  }
+  out.printf(",\"heap_free_bytes\":%u,\"heap_max_block_bytes\":%u,\"heap_fragmentation_percent\":%u",
+             ESP.getFreeHeap(), ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation());
+  out.printf(",\"scrape_duration_us\":%u,\"scrape_duration_max_us\":%u}", lastScrapeUs, maxScrapeUs);
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "modbus.h"
+
+static uint16_t crcUpdate(uint16_t crc, uint8_t value) {
+  crc ^= value;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    if (crc & 0x0001) {
+      crc = (crc >> 1) ^ 0xA001;
+    } else {
+      crc >>= 1;
+    }
+  }
+  return crc;
+}
+
+uint16_t modbusCrc16(const uint8_t* data, uint16_t length) {
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc = crcUpdate(crc, data[i]);
+  }
+  return crc;
+}
+
+bool modbusCheckCrc(const uint8_t* frame, uint16_t length) {
+  if (length < MODBUS_MIN_FRAME_SIZE) {
+    return false;
+  }
+  uint16_t crc = modbusCrc16(frame, length - 2);
+  return frame[length - 2] == (crc & 0xFF) && frame[length - 1] == (crc >> 8);
+}
+
+uint16_t modbusAppendCrc(uint8_t* frame, uint16_t length) {
+  uint16_t crc = modbusCrc16(frame, length);
+  frame[length] = crc & 0xFF;
+  frame[length + 1] = crc >> 8;
+  return length + 2;
+}
+
+uint16_t modbusFrameLength(const uint8_t* data, uint16_t length) {
+  // 数据后面追加了它的CRC (低字节在前) 时，对整段计算的CRC为0，一遍扫描即可找到第一个帧尾
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc = crcUpdate(crc, data[i]);
+    if (crc == 0 && i + 1 >= MODBUS_MIN_FRAME_SIZE) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+ModbusPriority modbusClassify(const uint8_t* frame, uint16_t length) {
+  if (length < MODBUS_MIN_FRAME_SIZE) {
+    return MODBUS_PRIORITY_NORMAL;
+  }
+  uint8_t function = frame[1];
+  if (function & 0x80) {
+    return MODBUS_PRIORITY_HIGH;
+  }
+  switch (function) {
+    case 0x05:   // 写单个线圈
+    case 0x06:   // 写单个寄存器
+    case 0x0F:   // 写多个线圈
+    case 0x10:   // 写多个寄存器
+    case 0x16:   // 屏蔽写寄存器
+    case 0x17:   // 读写多个寄存器
+      return MODBUS_PRIORITY_HIGH;
+    default:
+      return MODBUS_PRIORITY_NORMAL;
+  }
+}
@@ -0,0 +1,369 @@
+#include "ota_updater.h"
+#include "frame_trace.h"
+#include "logger.h"
+
+#ifndef WIFLY485_NATIVE
+#include <eboot_command.h>
+extern "C" uint32_t _FS_start;
+#endif
+
+#define OTA_IMAGE_MAGIC 0xE9   // ESP8266固件映像的首字节
+
+// 全局升级实例
+OtaUpdater otaUpdater;
+
+static uint32_t readLe32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+OtaUpdater::OtaUpdater()
+  : server(nullptr), state(OTA_IDLE), lastError(""), headerLength(0), imageSize(0),
+    regionStart(0), written(0), erased(0), verified(0), pageLength(0),
+    startedAt(0), lastDataAt(0), doneAt(0), updates(0), failures(0), maxSliceUs(0), maxEraseUs(0) {
+  // 构造函数
+  memset(nonce, 0, sizeof(nonce));
+  memset(expectedMd5, 0, sizeof(expectedMd5));
+}
+
+OtaUpdater::~OtaUpdater() {
+  // 析构函数
+  end();
+}
+
+bool OtaUpdater::begin(uint16_t port, const String& password) {
+  end();
+  if (password.length() == 0) {
+    return false;
+  }
+  this->password = password;
+  server = new WiFiServer(port);
+  server->begin();
+  server->setNoDelay(true);
+  state = OTA_IDLE;
+  LOG_I("OTA", "在端口 %u 等待固件升级", port);
+  return true;
+}
+
+void OtaUpdater::end() {
+  client.stop();
+  if (server != nullptr) {
+    server->stop();
+    delete server;
+    server = nullptr;
+  }
+  state = OTA_IDLE;
+}
+
+void OtaUpdater::loop() {
+  if (server == nullptr || state == OTA_DONE) {
+    return;
+  }
+  acceptClient();
+  if (!isActive()) {
+    return;
+  }
+
+  // 每个时间片最多一次闪存操作，耗时即升级给中继增加的等待
+  uint32_t start = micros();
+  switch (state) {
+    case OTA_HEADER:
+      receiveHeader();
+      break;
+    case OTA_RECEIVING:
+      receiveImage();
+      break;
+    case OTA_VERIFYING:
+      verifyImage();
+      break;
+    default:
+      break;
+  }
+  uint32_t elapsed = micros() - start;
+  if (elapsed > maxSliceUs) {
+    maxSliceUs = elapsed;
+  }
+  TRACE_STAGE(TRACE_OTA_SLICE, elapsed);
+}
+
+void OtaUpdater::acceptClient() {
+  if (!server->hasClient()) {
+    return;
+  }
+  WiFiClient incoming = server->available();
+  if (isActive()) {
+    incoming.print("ERR busy\n");
+    incoming.stop();
+    return;
+  }
+  client = incoming;
+  client.setNoDelay(true);
+  state = OTA_HEADER;
+  lastError = "";
+  headerLength = 0;
+  imageSize = 0;
+  written = 0;
+  erased = 0;
+  verified = 0;
+  pageLength = 0;
+  startedAt = lastDataAt = millis();
+  LOG_I("OTA", "升级连接 %s", client.remoteIP().toString().c_str());
+
+  // 每次连接使用新的随机挑战，截获的认证码不能用于下一次连接
+  char line[8 + OTA_NONCE_SIZE * 2];
+  strcpy(line, "AUTH ");
+  for (uint8_t i = 0; i < OTA_NONCE_SIZE; i += 4) {
+    uint32_t value = ESP.random();
+    memcpy(nonce + i, &value, 4);
+  }
+  for (uint8_t i = 0; i < OTA_NONCE_SIZE; i++) {
+    sprintf(line + 5 + i * 2, "%02x", nonce[i]);
+  }
+  strcat(line, "\n");
+  client.print(line);
+}
+
+void OtaUpdater::receiveHeader() {
+  int available = client.available();
+  if (available > 0) {
+    int n = client.read(header + headerLength, min<int>(available, OTA_HEADER_SIZE - headerLength));
+    if (n > 0) {
+      headerLength += n;
+      lastDataAt = millis();
+    }
+  }
+  if (headerLength < OTA_HEADER_SIZE) {
+    if (!client.connected() && client.available() == 0) {
+      fail("connection closed");
+    } else if ((millis() - lastDataAt) > OTA_TIMEOUT_MS) {
+      fail("timeout");
+    }
+    return;
+  }
+
+  if (memcmp(header, OTA_MAGIC, 4) != 0) {
+    fail("bad header");
+    return;
+  }
+  imageSize = readLe32(header + 4);
+  memcpy(expectedMd5, header + 8, sizeof(expectedMd5));
+  if (!authenticate()) {
+    fail("auth");
+    return;
+  }
+  if (!allocateRegion()) {
+    fail("no space");
+    return;
+  }
+  state = OTA_RECEIVING;
+  LOG_I("OTA", "接收映像 %u 字节，写入 0x%06X", imageSize, regionStart);
+}
+
+bool OtaUpdater::authenticate() {
+  uint8_t message[OTA_NONCE_SIZE + 16];
+  memcpy(message, nonce, OTA_NONCE_SIZE);
+  memcpy(message + OTA_NONCE_SIZE, expectedMd5, 16);
+  uint8_t expected[16];
+  hmacMd5(password, message, sizeof(message), expected);
+
+  // 比较全部字节，耗时与第一个不同字节的位置无关
+  uint8_t difference = 0;
+  for (uint8_t i = 0; i < sizeof(expected); i++) {
+    difference |= expected[i] ^ header[24 + i];
+  }
+  return difference == 0;
+}
+
+void OtaUpdater::receiveImage() {
+  // 下一页所在的扇区还没有擦除时，本时间片只擦除
+  if (written >= erased) {
+    uint32_t start = micros();
+    bool ok = ESP.flashEraseSector((regionStart + erased) / FLASH_SECTOR_SIZE);
+    uint32_t elapsed = micros() - start;
+    if (elapsed > maxEraseUs) {
+      maxEraseUs = elapsed;
+    }
+    if (!ok) {
+      fail("flash erase");
+      return;
+    }
+    erased += FLASH_SECTOR_SIZE;
+    return;
+  }
+
+  // 最多读取一页，其余数据留在TCP接收窗口中
+  uint32_t pageTarget = min<uint32_t>(OTA_PAGE_SIZE, imageSize - written);
+  int available = client.available();
+  if (available > 0 && pageLength < pageTarget) {
+    int n = client.read((uint8_t*)page + pageLength, min<uint32_t>(available, pageTarget - pageLength));
+    if (n > 0) {
+      pageLength += n;
+      lastDataAt = millis();
+    }
+  }
+  if (pageLength < pageTarget) {
+    if (!client.connected() && client.available() == 0) {
+      fail("connection closed");
+    } else if ((millis() - lastDataAt) > OTA_TIMEOUT_MS) {
+      fail("timeout");
+    }
+    return;
+  }
+
+  if (written == 0 && ((uint8_t*)page)[0] != OTA_IMAGE_MAGIC) {
+    fail("not a firmware image");
+    return;
+  }
+  // 闪存按4字节写入，最后一页的尾部补0xFF (擦除后的值)
+  uint16_t alignedLength = (pageLength + 3) & ~3;
+  memset((uint8_t*)page + pageLength, 0xFF, alignedLength - pageLength);
+  if (!ESP.flashWrite(regionStart + written, page, alignedLength)) {
+    fail("flash write");
+    return;
+  }
+  written += pageLength;
+  pageLength = 0;
+  if (written == imageSize) {
+    state = OTA_VERIFYING;
+    verified = 0;
+    md5.begin();
+  }
+}
+
+void OtaUpdater::verifyImage() {
+  // 从闪存读回计算MD5，确认写入的内容而不只是收到的数据
+  uint32_t length = min<uint32_t>(OTA_PAGE_SIZE, imageSize - verified);
+  if (!ESP.flashRead(regionStart + verified, page, (length + 3) & ~3)) {
+    fail("flash read");
+    return;
+  }
+  md5.add((uint8_t*)page, length);
+  verified += length;
+  if (verified < imageSize) {
+    return;
+  }
+
+  uint8_t actual[16];
+  md5.calculate();
+  md5.getBytes(actual);
+  if (memcmp(actual, expectedMd5, sizeof(actual)) != 0) {
+    fail("md5 mismatch");
+    return;
+  }
+  if (!commitImage()) {
+    fail("commit");
+    return;
+  }
+  client.print("OK\n");
+  state = OTA_DONE;
+  doneAt = millis();
+  updates++;
+  LOG_I("OTA", "升级完成: %u 字节 %u ms，最长时间片 %u us (擦除 %u us)", imageSize, doneAt - startedAt,
+        maxSliceUs, maxEraseUs);
+}
+
+bool OtaUpdater::allocateRegion() {
+  // 与核心的Updater相同：映像放在文件系统之前的空闲区域末尾，不覆盖当前固件
+#ifdef WIFLY485_NATIVE
+  // 本机构建：模拟闪存中固件占前1MB，文件系统从2MB开始
+  uint32_t freeEnd = 0x200000;
+  uint32_t sketchEnd = 0x100000;
+#else
+  uint32_t freeEnd = (uint32_t)&_FS_start - 0x40200000;
+  uint32_t sketchEnd = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+#endif
+  // 先检查大小再按扇区取整：头部中接近4GB的大小取整时会回绕成很小的值
+  if (imageSize == 0 || freeEnd <= sketchEnd || imageSize > freeEnd - sketchEnd) {
+    return false;
+  }
+  uint32_t roundedSize = (imageSize + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+  if (roundedSize > freeEnd - sketchEnd) {
+    return false;
+  }
+  regionStart = freeEnd - roundedSize;
+  return true;
+}
+
+bool OtaUpdater::commitImage() {
+#ifdef WIFLY485_NATIVE
+  // 本机构建没有引导程序
+  return true;
+#else
+  eboot_command command;
+  command.action = ACTION_COPY_RAW;
+  command.args[0] = regionStart;
+  command.args[1] = 0x00000;
+  command.args[2] = imageSize;
+  eboot_command_write(&command);
+  return true;
+#endif
+}
+
+void OtaUpdater::fail(const char* reason) {
+  lastError = reason;
+  failures++;
+  LOG_W("OTA", "升级失败: %s (已写入 %u/%u 字节)", reason, written, imageSize);
+  if (client.connected()) {
+    client.printf("ERR %s\n", reason);
+  }
+  client.stop();
+  state = OTA_FAILED;
+}
+
+void OtaUpdater::printJson(Print& out) {
+  out.printf("{\"state\":\"%s\",\"size\":%u,\"written\":%u,\"updates\":%u,\"failures\":%u,"
+             "\"last_error\":\"%s\",\"max_slice_us\":%u,\"max_erase_us\":%u}",
+             getStateName(state), imageSize, written, updates, failures, lastError, maxSliceUs, maxEraseUs);
+}
+
+void OtaUpdater::hmacMd5(const String& key, const uint8_t* message, size_t length, uint8_t digest[16]) {
+  // 密钥超过一个块 (64字节) 时先取MD5
+  uint8_t block[64];
+  memset(block, 0, sizeof(block));
+  MD5Builder md5;
+  if (key.length() > sizeof(block)) {
+    md5.begin();
+    md5.add(key);
+    md5.calculate();
+    md5.getBytes(block);
+  } else {
+    memcpy(block, key.c_str(), key.length());
+  }
+
+  uint8_t pad[64];
+  for (uint8_t i = 0; i < sizeof(pad); i++) {
+    pad[i] = block[i] ^ 0x36;
+  }
+  md5.begin();
+  md5.add(pad, sizeof(pad));
+  md5.add(message, length);
+  md5.calculate();
+  md5.getBytes(digest);
+
+  for (uint8_t i = 0; i < sizeof(pad); i++) {
+    pad[i] = block[i] ^ 0x5C;
+  }
+  md5.begin();
+  md5.add(pad, sizeof(pad));
+  md5.add(digest, 16);
+  md5.calculate();
+  md5.getBytes(digest);
+}
+
+const char* OtaUpdater::getStateName(OtaState state) {
+  switch (state) {
+    case OTA_IDLE:
+      return "idle";
+    case OTA_HEADER:
+      return "header";
+    case OTA_RECEIVING:
+      return "receiving";
+    case OTA_VERIFYING:
+      return "verifying";
+    case OTA_DONE:
+      return "done";
+    case OTA_FAILED:
+      return "failed";
+    default:
+      return "unknown";
+  }
+}
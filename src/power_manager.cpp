@@ -0,0 +1,90 @@
+#include "power_manager.h"
+#include <ESP8266WiFi.h>
+#include <coredecls.h>
+#include "frame_trace.h"
+#include "logger.h"
+#include "metrics.h"
+
+// 全局实例
+PowerManager powerManager;
+
+volatile uint32_t PowerManager::wakeAt = 0;
+
+static const char* const MODE_NAMES[] = {"none", "modem", "light"};
+
+PowerManager::PowerManager()
+    : mode(POWER_MODE_MODEM), maxWakeLatencyMs(DEFAULT_MAX_WAKE_LATENCY_MS), listenInterval(0), sleeps(0),
+      sleepUs(0), uartWakes(0) {
+  // 构造函数
+}
+
+PowerManager::~PowerManager() {
+  // 析构函数
+}
+
+PowerMode PowerManager::parseMode(const String& mode) {
+  for (uint8_t i = 0; i < sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]); i++) {
+    if (mode == MODE_NAMES[i]) {
+      return (PowerMode)i;
+    }
+  }
+  return POWER_MODE_MODEM;
+}
+
+const char* PowerManager::getModeName(PowerMode mode) {
+  return mode <= POWER_MODE_LIGHT ? MODE_NAMES[mode] : "unknown";
+}
+
+void PowerManager::begin(const String& mode, uint16_t maxWakeLatencyMs) {
+  this->mode = parseMode(mode);
+  this->maxWakeLatencyMs = maxWakeLatencyMs;
+
+  // 射频最多每个信标醒来一次，时延上限不足一个信标间隔时不能睡眠
+  uint32_t beacons = maxWakeLatencyMs / POWER_BEACON_INTERVAL_MS;
+  if (this->mode != POWER_MODE_NONE && beacons == 0) {
+    LOG_W("Power", "最大唤醒时延 %u ms 小于信标间隔 %u ms，关闭省电", maxWakeLatencyMs, POWER_BEACON_INTERVAL_MS);
+    this->mode = POWER_MODE_NONE;
+  }
+  listenInterval = this->mode == POWER_MODE_NONE ? 0 : (uint8_t)min<uint32_t>(beacons, POWER_MAX_LISTEN_INTERVAL);
+
+  static const WiFiSleepType_t SLEEP_TYPES[] = {WIFI_NONE_SLEEP, WIFI_MODEM_SLEEP, WIFI_LIGHT_SLEEP};
+  WiFi.setSleepMode(SLEEP_TYPES[this->mode], listenInterval);
+  LOG_I("Power", "省电模式 %s，监听间隔 %u 个信标，最大唤醒时延 %u ms", getModeName(this->mode), listenInterval,
+        maxWakeLatencyMs);
+}
+
+void PowerManager::idle(uint32_t lastActivityMs, uint32_t idleMs) {
+  if (mode != POWER_MODE_LIGHT || (millis() - lastActivityMs) < POWER_IDLE_HOLD_MS) {
+    return;
+  }
+  uint32_t sleepMs = min<uint32_t>(idleMs, maxWakeLatencyMs);
+  if (sleepMs < POWER_MIN_SLEEP_MS) {
+    return;
+  }
+
+  // RX空闲为高电平，起始位拉低：低电平中断可将CPU从浅睡眠唤醒，并结束等待
+  wakeAt = 0;
+  uint32_t start = micros();
+  attachInterrupt(digitalPinToInterrupt(RS485_RX_PIN), onRxWake, ONLOW_WE);
+  esp_delay(sleepMs, []() { return wakeAt == 0; }, sleepMs);
+  detachInterrupt(digitalPinToInterrupt(RS485_RX_PIN));
+  uint32_t end = micros();
+
+  sleeps++;
+  sleepUs += end - start;
+  METRIC_INC(METRIC_POWER_SLEEPS);
+  METRIC_ADD(METRIC_POWER_SLEEP_MS, (end - start) / 1000);
+  if (wakeAt != 0) {
+    uartWakes++;
+    METRIC_INC(METRIC_POWER_UART_WAKES);
+    TRACE_STAGE(TRACE_WAKE, end - wakeAt);
+  }
+}
+
+void IRAM_ATTR PowerManager::onRxWake() {
+  // 电平中断在起始位期间重复触发，只记录第一次
+  if (wakeAt == 0) {
+    wakeAt = micros() | 1;
+    esp_schedule();
+  }
+}
@@ -0,0 +1,126 @@
+#include "response_timeout.h"
+#include "logger.h"
+#include "metrics.h"
+
+// 全局应答超时估计实例
+ResponseTimeouts responseTimeouts;
+
+// 每个地址导出的序列
+struct ResponseSeries {
+  const char* name;
+  const char* type;
+  const char* help;
+  uint32_t ResponseEstimate::*value;
+};
+
+static const ResponseSeries SERIES[] = {
+  {"bus_response_srtt_us", "gauge", "Smoothed bus response time per Modbus address", &ResponseEstimate::srttUs},
+  {"bus_response_rttvar_us", "gauge", "Bus response time mean deviation per Modbus address", &ResponseEstimate::rttvarUs},
+  {"bus_response_timeout_us", "gauge", "Current response timeout per Modbus address", &ResponseEstimate::timeoutUs},
+  {"bus_response_samples_total", "counter", "Responses measured per Modbus address", &ResponseEstimate::samples},
+  {"bus_response_timeouts_total", "counter", "Requests abandoned after the response timeout per Modbus address", &ResponseEstimate::timeouts}
+};
+
+ResponseTimeouts::ResponseTimeouts() : floorUs(0) {
+  // 构造函数
+  reset();
+}
+
+void ResponseTimeouts::begin(const RS485Config& config) {
+  floorUs = RS485::calcFrameGapUs(config) + RS485::calcCharTimeUs(config) * RESPONSE_TIMEOUT_FLOOR_CHARS;
+  reset();
+}
+
+void ResponseTimeouts::reset() {
+  memset(entries, 0, sizeof(entries));
+}
+
+uint32_t ResponseTimeouts::getTimeoutUs(uint8_t address) {
+  ResponseEstimate& entry = lookup(address);
+  entry.lastUsedMs = millis();
+  return entry.timeoutUs;
+}
+
+void ResponseTimeouts::addSample(uint8_t address, uint32_t responseUs) {
+  ResponseEstimate& entry = lookup(address);
+  if (entry.samples == 0) {
+    entry.srttUs = responseUs;
+    entry.rttvarUs = responseUs / 2;
+  } else {
+    uint32_t delta = entry.srttUs > responseUs ? entry.srttUs - responseUs : responseUs - entry.srttUs;
+    entry.rttvarUs = (entry.rttvarUs * 3 + delta) / 4;
+    entry.srttUs = (entry.srttUs * 7 + responseUs) / 8;
+  }
+  entry.samples++;
+  updateTimeout(entry);
+}
+
+void ResponseTimeouts::onTimeout(uint8_t address) {
+  ResponseEstimate& entry = lookup(address);
+  entry.timeouts++;
+  entry.timeoutUs = min<uint32_t>(entry.timeoutUs * 2, RESPONSE_TIMEOUT_MAX_MS * 1000UL);
+  LOG_D("Response", "地址 %u 应答超时，等待时间增加到 %u us", address, entry.timeoutUs);
+}
+
+const ResponseEstimate* ResponseTimeouts::find(uint8_t address) {
+  for (uint8_t i = 0; i < RESPONSE_TIMEOUT_ADDRESSES; i++) {
+    if (entries[i].address == address) {
+      return &entries[i];
+    }
+  }
+  return nullptr;
+}
+
+ResponseEstimate& ResponseTimeouts::lookup(uint8_t address) {
+  ResponseEstimate* oldest = &entries[0];
+  for (uint8_t i = 0; i < RESPONSE_TIMEOUT_ADDRESSES; i++) {
+    ResponseEstimate& entry = entries[i];
+    if (entry.address == address) {
+      return entry;
+    }
+    // 优先使用空闲表项，其次是最久未用的
+    if (oldest->address != 0 && (entry.address == 0 || (int32_t)(entry.lastUsedMs - oldest->lastUsedMs) < 0)) {
+      oldest = &entry;
+    }
+  }
+  memset(oldest, 0, sizeof(ResponseEstimate));
+  oldest->address = address;
+  oldest->timeoutUs = min<uint32_t>(RESPONSE_TIMEOUT_INITIAL_MS, RESPONSE_TIMEOUT_MAX_MS) * 1000UL;
+  oldest->lastUsedMs = millis();
+  return *oldest;
+}
+
+void ResponseTimeouts::updateTimeout(ResponseEstimate& entry) {
+  uint32_t margin = max<uint32_t>(entry.rttvarUs * 4, floorUs);
+  entry.timeoutUs = min<uint32_t>(entry.srttUs + margin, RESPONSE_TIMEOUT_MAX_MS * 1000UL);
+}
+
+void ResponseTimeouts::writePrometheus(Print& out) {
+  for (const ResponseSeries& series : SERIES) {
+    out.printf("# HELP " METRIC_PREFIX "%s %s\n# TYPE " METRIC_PREFIX "%s %s\n", series.name, series.help,
+               series.name, series.type);
+    for (uint8_t i = 0; i < RESPONSE_TIMEOUT_ADDRESSES; i++) {
+      if (entries[i].address != 0) {
+        out.printf(METRIC_PREFIX "%s{address=\"%u\"} %u\n", series.name, entries[i].address, entries[i].*series.value);
+      }
+    }
+  }
+}
+
+void ResponseTimeouts::printJson(Print& out) {
+  out.print('[');
+  bool first = true;
+  for (uint8_t i = 0; i < RESPONSE_TIMEOUT_ADDRESSES; i++) {
+    const ResponseEstimate& entry = entries[i];
+    if (entry.address == 0) {
+      continue;
+    }
+    if (!first) {
+      out.print(',');
+    }
+    first = false;
+    out.printf("{\"address\":%u,\"srtt_us\":%u,\"rttvar_us\":%u,\"timeout_us\":%u,\"samples\":%u,\"timeouts\":%u}",
+               entry.address, entry.srttUs, entry.rttvarUs, entry.timeoutUs, entry.samples, entry.timeouts);
+  }
+  out.print(']');
+}
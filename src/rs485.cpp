@@ -0,0 +1,310 @@
+#include "rs485.h"
+#include "metrics.h"
+#include "frame_trace.h"
+#include "modbus.h"
+
+RS485::RS485()
+    : port(nullptr), serial(nullptr), dePin(-1), charTimeUs(0), frameGapUs(0),
+      frameReady(false), frameOverflow(false), rxLastArrival(0), timingOverflow(false), lastReadTime(0),
+      rxBacklog(false), rxRemainder(0), rxFrames(0), txFrames(0), rxBytes(0), txBytes(0), overruns(0),
+      timedFrames(0), timingTruncated(0), splitFrames(0) {
+  // 构造函数
+  rxFrame.length = 0;
+  rxFrame.timingLength = 0;
+  config.baudRate = DEFAULT_BAUD_RATE;
+  config.dataBits = DEFAULT_DATA_BITS;
+  config.parity = DEFAULT_PARITY;
+  config.stopBits = DEFAULT_STOP_BITS;
+  config.replayTiming = DEFAULT_REPLAY_TIMING;
+}
+
+RS485::~RS485() {
+  // 析构函数
+}
+
+bool RS485::begin(HardwareSerial& serial, const RS485Config& config, int8_t dePin) {
+  // 硬件串口在setConfig()中按配置打开；接收缓冲区在打开前设置
+  this->serial = &serial;
+  serial.setRxBufferSize(RS485_RX_BUFFER_SIZE);
+  return begin((Stream&)serial, config, dePin);
+}
+
+bool RS485::begin(Stream& stream, const RS485Config& config, int8_t dePin) {
+  port = &stream;
+  this->dePin = dePin;
+
+  // 默认处于接收模式
+  if (dePin >= 0) {
+    pinMode(dePin, OUTPUT);
+    digitalWrite(dePin, LOW);
+  }
+
+  setConfig(config);
+  rxFrame.length = 0;
+  rxRemainder = 0;
+  frameReady = false;
+  frameOverflow = false;
+  lastReadTime = micros();
+  return true;
+}
+
+void RS485::setConfig(const RS485Config& config) {
+  this->config = config;
+  charTimeUs = calcCharTimeUs(config);
+  frameGapUs = calcFrameGapUs(config);
+
+  if (serial != nullptr) {
+    serial->begin(config.baudRate, toSerialConfig(config));
+  }
+}
+
+RS485Config RS485::getConfig() {
+  return config;
+}
+
+bool RS485::poll() {
+  if (port == nullptr) {
+    return false;
+  }
+
+  // 已完成的帧尚未取走时，新数据留在串口缓冲区中
+  if (frameReady) {
+    return true;
+  }
+
+  // 距上一次读取超过一个帧间隔时，缓冲区中的字节之间可能有帧边界
+  uint32_t readAt = micros();
+  int pending = port->available();
+  bool backlog = pending >= MODBUS_MIN_FRAME_SIZE && (uint32_t)(readAt - lastReadTime) >= frameGapUs;
+  lastReadTime = readAt;
+
+  // 读取串口中的所有数据
+  while ((pending = port->available()) > 0) {
+    int c = port->read();
+    if (c < 0) {
+      break;
+    }
+
+    uint32_t now = micros();
+    if (rxFrame.length == 0) {
+      rxFrame.firstByteTime = now;
+      rxFrame.timingLength = 0;
+      timingOverflow = false;
+      rxBacklog = false;
+    }
+    rxBacklog = rxBacklog || backlog;
+    rxFrame.lastByteTime = now;
+    if (config.replayTiming) {
+      // 一次读到多个字节时它们在线路上是连续的：最后一个字节刚到达，之前的按字符时间回推
+      recordArrival(now - (uint32_t)(pending - 1) * charTimeUs);
+    }
+    rxBytes++;
+    METRIC_INC(METRIC_BUS_RX_BYTES);
+
+    if (rxFrame.length < RS485_FRAME_BUFFER_SIZE) {
+      rxFrame.data[rxFrame.length++] = (uint8_t)c;
+    } else if (!frameOverflow) {
+      // 超长帧：丢弃多余字节并记录溢出
+      frameOverflow = true;
+      overruns++;
+      METRIC_INC(METRIC_BUS_OVERRUNS);
+    }
+  }
+
+  // 静默时间超过帧间隔，帧接收完成
+  if (rxFrame.length > 0 && (uint32_t)(micros() - rxFrame.lastByteTime) >= frameGapUs) {
+    if (frameOverflow) {
+      rxFrame.length = 0;
+      frameOverflow = false;
+      return false;
+    }
+    completeFrame();
+  }
+
+  return frameReady;
+}
+
+void RS485::completeFrame() {
+  if (rxBacklog && !modbusCheckCrc(rxFrame.data, rxFrame.length)) {
+    uint16_t length = modbusFrameLength(rxFrame.data, rxFrame.length);
+    if (length > 0 && length < rxFrame.length) {
+      rxRemainder = rxFrame.length - length;
+      rxFrame.length = length;
+      splitFrames++;
+    }
+  }
+  frameReady = true;
+  rxFrames++;
+  METRIC_INC(METRIC_BUS_RX_FRAMES);
+}
+
+bool RS485::readFrame(RS485Frame& frame) {
+  if (!frameReady) {
+    return false;
+  }
+
+  frame.length = rxFrame.length;
+  frame.firstByteTime = rxFrame.firstByteTime;
+  frame.lastByteTime = rxFrame.lastByteTime;
+  memcpy(frame.data, rxFrame.data, rxFrame.length);
+  // 间隔记录按字节序号递增，只取属于本帧的部分
+  uint8_t timingLength = 0;
+  while (timingLength + 1 < rxFrame.timingLength && rxFrame.timing[timingLength] < rxFrame.length) {
+    timingLength += 2;
+  }
+  frame.timingLength = timingLength;
+  memcpy(frame.timing, rxFrame.timing, timingLength);
+  frameReady = false;
+
+  if (rxRemainder == 0) {
+    rxFrame.length = 0;
+    return true;
+  }
+
+  // 分开后的剩余字节作为下一帧，帧间隔已经过去，立即完成；首字节时间按字符时间回推，不早于本帧
+  memmove(rxFrame.data, rxFrame.data + rxFrame.length, rxRemainder);
+  uint8_t remainderTiming = 0;
+  for (uint8_t i = timingLength; i + 1 < rxFrame.timingLength; i += 2) {
+    if (rxFrame.timing[i] > rxFrame.length) {
+      rxFrame.timing[remainderTiming++] = rxFrame.timing[i] - rxFrame.length;
+      rxFrame.timing[remainderTiming++] = rxFrame.timing[i + 1];
+    }
+  }
+  rxFrame.timingLength = remainderTiming;
+  rxFrame.firstByteTime = rxFrame.lastByteTime - (uint32_t)(rxRemainder - 1) * charTimeUs;
+  if ((int32_t)(rxFrame.firstByteTime - frame.firstByteTime) < 0) {
+    rxFrame.firstByteTime = frame.firstByteTime;
+  }
+  rxFrame.length = rxRemainder;
+  rxRemainder = 0;
+  completeFrame();
+  return true;
+}
+
+void RS485::recordArrival(uint32_t arrival) {
+  uint16_t index = rxFrame.length;
+  if (index > 0 && index <= 0xFF) {
+    // 字节不可能比一个字符时间更密，回推的估计值早于这个下限时按连续字节处理
+    int32_t extra = (int32_t)(arrival - rxLastArrival - charTimeUs);
+    if (extra >= (int32_t)(charTimeUs / 2)) {
+      if (rxFrame.timingLength + 2 <= RS485_TIMING_MAX_SIZE) {
+        uint32_t units = ((uint32_t)extra * RS485_TIMING_UNITS_PER_CHAR + charTimeUs / 2) / charTimeUs;
+        rxFrame.timing[rxFrame.timingLength++] = (uint8_t)index;
+        rxFrame.timing[rxFrame.timingLength++] = (uint8_t)min<uint32_t>(units, 0xFF);
+      } else if (!timingOverflow) {
+        // 间隔过多：之后的字节连续发送，每帧只计一次
+        timingOverflow = true;
+        timingTruncated++;
+      }
+    } else if (extra < 0) {
+      arrival = rxLastArrival + charTimeUs;
+    }
+  }
+  rxLastArrival = arrival;
+}
+
+size_t RS485::writeTimed(const uint8_t* data, uint16_t length, const uint8_t* timing, uint8_t timingLength) {
+  // 每段的开始时间按首字节写入时刻加上之前各字节的字符时间和间隔计算，误差不会逐段累积。
+  // 单个间隔比帧间隔至少短一个字符时间 (接收端不会把帧分开)，间隔总和不超过RS485_TIMING_MAX_TOTAL_US：
+  // 低波特率下8个最长的间隔要忙等约2秒，超出部分连续发送
+  uint32_t start = micros();
+  uint32_t offsetUs = 0;
+  uint32_t remainingUs = RS485_TIMING_MAX_TOTAL_US;
+  uint32_t maxGapUs = frameGapUs > charTimeUs ? frameGapUs - charTimeUs : 0;
+  uint16_t position = 0;
+  size_t written = 0;
+
+  for (uint8_t i = 0; i + 1 < timingLength && remainingUs > 0; i += 2) {
+    uint16_t index = timing[i];
+    if (index <= position || index >= length) {
+      break;  // 记录无效：剩余字节连续发送
+    }
+    uint32_t gapUs = (timing[i + 1] * charTimeUs + RS485_TIMING_UNITS_PER_CHAR / 2) / RS485_TIMING_UNITS_PER_CHAR;
+    gapUs = min<uint32_t>(gapUs, min<uint32_t>(maxGapUs, remainingUs));
+    remainingUs -= gapUs;
+    written += port->write(data + position, index - position);
+    offsetUs += (index - position) * charTimeUs + gapUs;
+    position = index;
+
+    // 等上一段移出后忙等到下一段的开始时间 (间隔只有几个字符时间，调度器的粒度不够)
+    port->flush();
+    while ((int32_t)(micros() - start - offsetUs) < 0) {
+    }
+    TRACE_STAGE(TRACE_GAP_JITTER, micros() - start - offsetUs);
+  }
+
+  written += port->write(data + position, length - position);
+  return written;
+}
+
+bool RS485::sendFrame(const uint8_t* data, uint16_t length, const uint8_t* timing, uint8_t timingLength) {
+  if (port == nullptr || length == 0) {
+    return false;
+  }
+
+  // 切换到发送模式
+  if (dePin >= 0) {
+    digitalWrite(dePin, HIGH);
+  }
+
+  size_t written;
+  if (config.replayTiming && timingLength > 0) {
+    written = writeTimed(data, length, timing, min<uint8_t>(timingLength, RS485_TIMING_MAX_SIZE));
+    timedFrames++;
+    METRIC_INC(METRIC_BUS_TIMED_FRAMES);
+  } else {
+    written = port->write(data, length);
+  }
+
+  // 等待发送完成后切回接收模式
+  port->flush();
+  if (dePin >= 0) {
+    digitalWrite(dePin, LOW);
+  }
+
+  txBytes += written;
+  METRIC_ADD(METRIC_BUS_TX_BYTES, written);
+  if (written != length) {
+    return false;
+  }
+  txFrames++;
+  METRIC_INC(METRIC_BUS_TX_FRAMES);
+  return true;
+}
+
+bool RS485::isBusIdle() {
+  return rxFrame.length == 0;
+}
+
+uint32_t RS485::getCharTimeUs() {
+  return charTimeUs;
+}
+
+uint32_t RS485::getFrameGapUs() {
+  return frameGapUs;
+}
+
+uint32_t RS485::calcCharTimeUs(const RS485Config& config) {
+  if (config.baudRate == 0) {
+    return 0;
+  }
+  // 起始位 + 数据位 + 校验位 + 停止位
+  uint32_t bits = 1 + config.dataBits + (config.parity != 0 ? 1 : 0) + config.stopBits;
+  return (bits * 1000000UL + config.baudRate - 1) / config.baudRate;
+}
+
+uint32_t RS485::calcFrameGapUs(const RS485Config& config) {
+  // Modbus RTU规定：波特率高于19200时使用固定的1750微秒，否则为3.5个字符时间
+  if (config.baudRate > 19200) {
+    return 1750;
+  }
+  return (calcCharTimeUs(config) * 7 + 1) / 2;
+}
+
+SerialConfig RS485::toSerialConfig(const RS485Config& config) {
+  // ESP8266串口配置的位布局：数据位(bit2-3) | 校验(bit0-1) | 停止位(bit4-5)
+  uint8_t dataBits = (uint8_t)((config.dataBits - 5) & 0x03) << 2;
+  uint8_t parity = config.parity == 1 ? 0x03 : (config.parity == 2 ? 0x02 : 0x00);
+  uint8_t stopBits = config.stopBits == 2 ? 0x30 : 0x10;
+  return (SerialConfig)(dataBits | parity | stopBits);
+}
\ No newline at end of file
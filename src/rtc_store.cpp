@@ -0,0 +1,59 @@
+#include "rtc_store.h"
+
+// 记录在RTC内存中的布局：头 + 数据，按4字节对齐
+struct RtcRecordHeader {
+  uint32_t magic;
+  uint32_t crc;
+};
+
+uint32_t rtcCrc32(const void* data, size_t size, uint32_t crc) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= p[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+bool rtcLoad(uint32_t offset, uint32_t magic, void* data, size_t size) {
+  if (size > RTC_STORE_MAX_SIZE) {
+    return false;
+  }
+
+  uint32_t buffer[(sizeof(RtcRecordHeader) + RTC_STORE_MAX_SIZE + 3) / 4];
+  size_t total = (sizeof(RtcRecordHeader) + size + 3) & ~3;
+  if (!ESP.rtcUserMemoryRead(offset, buffer, total)) {
+    return false;
+  }
+
+  RtcRecordHeader* header = (RtcRecordHeader*)buffer;
+  const uint8_t* payload = (const uint8_t*)buffer + sizeof(RtcRecordHeader);
+  if (header->magic != magic || header->crc != rtcCrc32(payload, size)) {
+    return false;
+  }
+  memcpy(data, payload, size);
+  return true;
+}
+
+bool rtcSave(uint32_t offset, uint32_t magic, const void* data, size_t size) {
+  if (size > RTC_STORE_MAX_SIZE) {
+    return false;
+  }
+
+  uint32_t buffer[(sizeof(RtcRecordHeader) + RTC_STORE_MAX_SIZE + 3) / 4] = {0};
+  RtcRecordHeader* header = (RtcRecordHeader*)buffer;
+  header->magic = magic;
+  header->crc = rtcCrc32(data, size);
+  memcpy((uint8_t*)buffer + sizeof(RtcRecordHeader), data, size);
+
+  size_t total = (sizeof(RtcRecordHeader) + size + 3) & ~3;
+  return ESP.rtcUserMemoryWrite(offset, buffer, total);
+}
+
+void rtcInvalidate(uint32_t offset) {
+  uint32_t zero = 0;
+  ESP.rtcUserMemoryWrite(offset, &zero, sizeof(zero));
+}
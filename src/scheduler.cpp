@@ -0,0 +1,163 @@
+#include "scheduler.h"
+#include "logger.h"
+
+Scheduler::Scheduler() : taskCount(0), realtimeCount(0), starvedTask(SCHEDULER_NO_TASK), loops(0), maxLoopUs(0) {
+  // 构造函数
+}
+
+int Scheduler::addTask(const char* name, TaskFunction function, void* context, TaskPriority priority,
+                       uint32_t intervalMs, uint32_t budgetUs) {
+  if (taskCount >= SCHEDULER_MAX_TASKS || function == nullptr) {
+    LOG_E("Sched", "无法添加任务: %s", name);
+    return -1;
+  }
+
+  // 按优先级插入，同优先级按添加顺序
+  int pos = taskCount;
+  while (pos > 0 && tasks[pos - 1].priority > priority) {
+    tasks[pos] = tasks[pos - 1];
+    pos--;
+  }
+
+  SchedulerTask& task = tasks[pos];
+  task.name = name;
+  task.function = function;
+  task.context = context;
+  task.priority = priority;
+  task.intervalMs = intervalMs;
+  task.budgetUs = budgetUs;
+  task.lastRunMs = millis();
+  task.penaltyLoops = 0;
+  task.runs = 0;
+  task.totalUs = 0;
+  task.maxUs = 0;
+  task.overruns = 0;
+  task.deferrals = 0;
+
+  taskCount++;
+  starvedTask = SCHEDULER_NO_TASK;  // 插入后编号改变
+  if (priority == TASK_PRIORITY_REALTIME) {
+    realtimeCount++;
+  }
+  return pos;
+}
+
+void Scheduler::runTask(SchedulerTask& task) {
+  uint32_t start = micros();
+  task.function(task.context);
+  uint32_t elapsed = micros() - start;
+
+  task.runs++;
+  task.totalUs += elapsed;
+  if (elapsed > task.maxUs) {
+    task.maxUs = elapsed;
+  }
+  if (task.priority != TASK_PRIORITY_REALTIME && elapsed > task.budgetUs) {
+    task.overruns++;
+    task.penaltyLoops = SCHEDULER_OVERRUN_PENALTY_LOOPS;
+  }
+}
+
+void Scheduler::runRealtime() {
+  for (uint8_t i = 0; i < realtimeCount; i++) {
+    runTask(tasks[i]);
+  }
+}
+
+void Scheduler::runBackground(SchedulerTask& task, uint32_t now) {
+  task.lastRunMs = now;
+  runTask(task);
+
+  // 每个后台任务之后立即服务中继，避免总线数据在UART FIFO中等待
+  runRealtime();
+}
+
+void Scheduler::loop() {
+  uint32_t loopStart = micros();
+  runRealtime();
+
+  // 后台任务共享本次循环的时间片
+  uint32_t sliceStart = micros();
+  uint32_t now = millis();
+  bool ranBackground = false;
+
+  // 上一次循环中被推迟的任务先运行 (仍然到期且不在超时暂停中)
+  uint8_t first = starvedTask;
+  starvedTask = SCHEDULER_NO_TASK;
+  if (first != SCHEDULER_NO_TASK && tasks[first].penaltyLoops == 0) {
+    runBackground(tasks[first], now);
+    ranBackground = true;
+  } else {
+    first = SCHEDULER_NO_TASK;
+  }
+
+  for (uint8_t i = realtimeCount; i < taskCount; i++) {
+    SchedulerTask& task = tasks[i];
+    if (i == first || (task.intervalMs > 0 && (now - task.lastRunMs) < task.intervalMs)) {
+      continue;
+    }
+
+    // 超时暂停中，或剩余时间片不足以容纳任务预算
+    if (task.penaltyLoops > 0) {
+      task.penaltyLoops--;
+      task.deferrals++;
+      continue;
+    }
+    // 每次循环至少运行一个到期任务，预算大于时间片的任务也不会被饿死
+    if (ranBackground && (micros() - sliceStart) + task.budgetUs > SCHEDULER_SLICE_BUDGET_US) {
+      task.deferrals++;
+      if (starvedTask == SCHEDULER_NO_TASK) {
+        starvedTask = i;
+      }
+      continue;
+    }
+
+    runBackground(task, now);
+    ranBackground = true;
+  }
+
+  uint32_t loopUs = micros() - loopStart;
+  if (loopUs > maxLoopUs) {
+    maxLoopUs = loopUs;
+  }
+  loops++;
+}
+
+uint32_t Scheduler::getIdleMs() {
+  uint32_t now = millis();
+  uint32_t idleMs = UINT32_MAX;
+  for (uint8_t i = realtimeCount; i < taskCount; i++) {
+    const SchedulerTask& task = tasks[i];
+    if (task.intervalMs == 0) {
+      continue;
+    }
+    uint32_t elapsed = now - task.lastRunMs;
+    uint32_t remaining = elapsed >= task.intervalMs ? 0 : task.intervalMs - elapsed;
+    idleMs = min(idleMs, remaining);
+  }
+  return idleMs;
+}
+
+void Scheduler::printJson(Print& out) {
+  out.printf("{\"loops\":%u,\"max_loop_us\":%u,\"tasks\":[", loops, maxLoopUs);
+  for (uint8_t i = 0; i < taskCount; i++) {
+    const SchedulerTask& task = tasks[i];
+    if (i > 0) {
+      out.print(',');
+    }
+    out.printf("{\"name\":\"%s\",\"priority\":%u,\"budget_us\":%u,\"runs\":%u,\"run_ms\":%u,"
+               "\"avg_us\":%u,\"max_us\":%u,\"overruns\":%u,\"deferrals\":%u}",
+               task.name, (unsigned)task.priority, task.budgetUs, task.runs, (uint32_t)(task.totalUs / 1000),
+               task.runs > 0 ? (uint32_t)(task.totalUs / task.runs) : 0, task.maxUs, task.overruns, task.deferrals);
+  }
+  out.print("]}");
+}
+
+void Scheduler::logSummary() {
+  LOG_I("Sched", "循环 %u 次, 最长 %u us", loops, maxLoopUs);
+  for (uint8_t i = 0; i < taskCount; i++) {
+    const SchedulerTask& task = tasks[i];
+    LOG_I("Sched", "%-8s 运行 %u 次, 平均 %u us, 最长 %u us, 超时 %u, 推迟 %u", task.name, task.runs,
+          task.runs > 0 ? (uint32_t)(task.totalUs / task.runs) : 0, task.maxUs, task.overruns, task.deferrals);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "status_events.h"
+#include "frame_trace.h"
+#include "metrics.h"
+
+// 与StatusField顺序一致
+static const char* const FIELD_NAMES[STATUS_FIELD_COUNT] = {
+  "link_up",
+  "link_rtt_p50_us",
+  "link_rtt_p99_us",
+  "bus_rx_bps",
+  "bus_tx_bps",
+  "link_rx_bps",
+  "link_tx_bps",
+  "bus_crc_errors",
+  "bus_overruns",
+  "link_protocol_errors",
+  "link_connects",
+  "router_dropped_frames",
+  "heap_free_bytes"
+};
+
+// 保活注释，防止代理和浏览器因空闲断开
+static const char KEEPALIVE[] = ": keepalive\n\n";
+
+StatusEvents::StatusEvents()
+    : link(nullptr), lastSampleMs(0), lastBusRxBytes(0), lastBusTxBytes(0), lastLinkRxBytes(0), lastLinkTxBytes(0),
+      eventsSent(0), eventsSkipped(0) {
+  // 构造函数
+  for (uint8_t i = 0; i < WEB_EVENT_MAX_CLIENTS; i++) {
+    clients[i].active = false;
+    clients[i].sentFull = false;
+    clients[i].lastWriteMs = 0;
+  }
+}
+
+StatusEvents::~StatusEvents() {
+  // 析构函数
+}
+
+void StatusEvents::begin(TcpProtocol* link) {
+  this->link = link;
+  lastSampleMs = millis();
+  lastBusRxBytes = metrics.get(METRIC_BUS_RX_BYTES);
+  lastBusTxBytes = metrics.get(METRIC_BUS_TX_BYTES);
+  lastLinkRxBytes = metrics.get(METRIC_LINK_RX_BYTES);
+  lastLinkTxBytes = metrics.get(METRIC_LINK_TX_BYTES);
+}
+
+bool StatusEvents::addClient(WiFiClient& client) {
+  for (uint8_t i = 0; i < WEB_EVENT_MAX_CLIENTS; i++) {
+    EventClient& eventClient = clients[i];
+    if (!eventClient.active) {
+      eventClient.client = client;
+      eventClient.active = true;
+      eventClient.sentFull = false;
+      eventClient.lastWriteMs = millis();
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t StatusEvents::getClientCount() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < WEB_EVENT_MAX_CLIENTS; i++) {
+    if (clients[i].active) {
+      count++;
+    }
+  }
+  return count;
+}
+
+const char* StatusEvents::getFieldName(StatusField field) {
+  return FIELD_NAMES[field];
+}
+
+// 按字节数差值和时间差计算每秒字节数
+static uint32_t rate(uint32_t bytes, uint32_t& lastBytes, uint32_t elapsedMs) {
+  uint32_t delta = bytes - lastBytes;
+  lastBytes = bytes;
+  return elapsedMs > 0 ? (uint32_t)((uint64_t)delta * 1000 / elapsedMs) : 0;
+}
+
+void StatusEvents::sample(StatusSnapshot& snapshot) {
+  uint32_t now = millis();
+  uint32_t elapsedMs = now - lastSampleMs;
+  lastSampleMs = now;
+
+  uint32_t* v = snapshot.values;
+  v[STATUS_LINK_UP] = (link != nullptr && link->isConnected()) ? 1 : 0;
+  v[STATUS_LINK_RTT_P50_US] = frameTrace.getPercentileUs(TRACE_LINK_RTT, 50);
+  v[STATUS_LINK_RTT_P99_US] = frameTrace.getPercentileUs(TRACE_LINK_RTT, 99);
+  v[STATUS_BUS_RX_BPS] = rate(metrics.get(METRIC_BUS_RX_BYTES), lastBusRxBytes, elapsedMs);
+  v[STATUS_BUS_TX_BPS] = rate(metrics.get(METRIC_BUS_TX_BYTES), lastBusTxBytes, elapsedMs);
+  v[STATUS_LINK_RX_BPS] = rate(metrics.get(METRIC_LINK_RX_BYTES), lastLinkRxBytes, elapsedMs);
+  v[STATUS_LINK_TX_BPS] = rate(metrics.get(METRIC_LINK_TX_BYTES), lastLinkTxBytes, elapsedMs);
+  v[STATUS_BUS_CRC_ERRORS] = metrics.get(METRIC_BUS_CRC_ERRORS);
+  v[STATUS_BUS_OVERRUNS] = metrics.get(METRIC_BUS_OVERRUNS);
+  v[STATUS_LINK_PROTOCOL_ERRORS] = metrics.get(METRIC_LINK_PROTOCOL_ERRORS);
+  v[STATUS_LINK_CONNECTS] = metrics.get(METRIC_LINK_CONNECTS);
+  v[STATUS_ROUTER_DROPPED_FRAMES] = metrics.get(METRIC_ROUTER_DROPPED_FRAMES);
+  v[STATUS_HEAP_FREE] = ESP.getFreeHeap();
+}
+
+size_t StatusEvents::formatDelta(const StatusSnapshot& current, const StatusSnapshot* previous, char* buffer, size_t size) {
+  size_t used = 0;
+  bool first = true;
+  for (uint8_t i = 0; i < STATUS_FIELD_COUNT; i++) {
+    if (previous != nullptr && previous->values[i] == current.values[i]) {
+      continue;
+    }
+    int n = snprintf(buffer + used, size - used, "%s\"%s\":%u", first ? "data: {" : ",", FIELD_NAMES[i],
+                     current.values[i]);
+    if (n < 0 || (size_t)n >= size - used) {
+      return 0;
+    }
+    used += n;
+    first = false;
+  }
+  if (first) {
+    return 0;
+  }
+
+  // 事件以空行结束
+  if (size - used < 4) {
+    return 0;
+  }
+  memcpy(buffer + used, "}\n\n", 4);
+  return used + 3;
+}
+
+void StatusEvents::push(EventClient& eventClient, const StatusSnapshot& snapshot, uint32_t now) {
+  size_t length = formatDelta(snapshot, eventClient.sentFull ? &eventClient.lastSent : nullptr, buffer, sizeof(buffer));
+  const char* data = buffer;
+  if (length == 0) {
+    if (now - eventClient.lastWriteMs < WEB_EVENT_KEEPALIVE_MS) {
+      return;
+    }
+    data = KEEPALIVE;
+    length = sizeof(KEEPALIVE) - 1;
+  }
+
+  // 发送缓冲区放不下整个事件时跳过，不等待对端确认
+  if ((size_t)eventClient.client.availableForWrite() < length) {
+    eventsSkipped++;
+    return;
+  }
+  eventClient.client.write((const uint8_t*)data, length);
+  eventClient.lastWriteMs = now;
+  if (data == buffer) {
+    eventClient.lastSent = snapshot;
+    eventClient.sentFull = true;
+    eventsSent++;
+  }
+}
+
+void StatusEvents::loop() {
+  uint32_t now = millis();
+  if (now - lastSampleMs < WEB_EVENT_INTERVAL_MS) {
+    return;
+  }
+
+  bool hasClient = false;
+  for (uint8_t i = 0; i < WEB_EVENT_MAX_CLIENTS; i++) {
+    EventClient& eventClient = clients[i];
+    if (eventClient.active && !eventClient.client.connected()) {
+      eventClient.client.stop();
+      eventClient.active = false;
+    }
+    hasClient = hasClient || eventClient.active;
+  }
+
+  // 没有连接时也采样，保证吞吐量按一个间隔计算
+  StatusSnapshot snapshot;
+  sample(snapshot);
+  if (!hasClient) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < WEB_EVENT_MAX_CLIENTS; i++) {
+    if (clients[i].active) {
+      push(clients[i], snapshot, now);
+    }
+  }
+}
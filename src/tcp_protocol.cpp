@@ -0,0 +1,719 @@
+#include "tcp_protocol.h"
+#include "frame_trace.h"
+#include "logger.h"
+#include "metrics.h"
+
+#define TCP_REPLAY_ENTRY_HEADER 9  // [序号 2][长度 2][入队时间 4][类型 1]
+
+static inline void put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+  return p[0] | ((uint16_t)p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+// 序号按16位回绕比较：a在b之前
+static inline bool seqBefore(uint16_t a, uint16_t b) {
+  return (int16_t)(a - b) < 0;
+}
+
+// 环形缓冲区读写 (可能跨越末尾)
+static void ringWrite(uint8_t* ring, uint16_t pos, const uint8_t* data, uint16_t length) {
+  uint16_t first = min<uint16_t>(length, TCP_REPLAY_BUFFER_SIZE - pos);
+  memcpy(ring + pos, data, first);
+  memcpy(ring, data + first, length - first);
+}
+
+static void ringRead(const uint8_t* ring, uint16_t pos, uint8_t* out, uint16_t length) {
+  uint16_t first = min<uint16_t>(length, TCP_REPLAY_BUFFER_SIZE - pos);
+  memcpy(out, ring + pos, first);
+  memcpy(out + first, ring, length - first);
+}
+
+TcpProtocol::TcpProtocol()
+    : server(nullptr), isServer(false), port(0), lastConnectAttempt(0), locator(nullptr), clientConnected(false),
+      lostAt(0), resumeEnabled(true), localSession(0), peerSession(0), helloReceived(false), txSeq(0), txUnsent(0),
+      rxNext(0), rxUnacked(0), rxUnackedSince(0), replayHead(0), replayUsed(0), replayFrames(0),
+      rxHeaderLength(0), rxPayloadLength(0), rxPayloadReceived(0), rxType(0), rxFirstByteTime(0),
+      rxBatchRemaining(0), rxBatchOffset(0), rxBatchSeq(0), batchBudgetUs(0), txBatchLength(0), txBatchCount(0),
+      txBatchSeq(0), txBatchStartUs(0), txBatchHoldUs(0), lastFrameUs(0), frameIntervalUs(0),
+      framesSent(0), framesReceived(0), connects(0), protocolErrors(0), resumes(0), retransmits(0), duplicates(0),
+      replayDropped(0), lastFailoverMs(0), maxFailoverMs(0), packetsSent(0), batchedFrames(0), packetsSaved(0),
+      maxBatchHoldUs(0) {
+  // 构造函数
+  // 会话ID区分设备的每次启动，0保留表示没有会话
+  while (localSession == 0) {
+    localSession = ESP.random();
+  }
+}
+
+TcpProtocol::~TcpProtocol() {
+  // 析构函数
+  end();
+}
+
+bool TcpProtocol::beginServer(uint16_t port) {
+  end();
+  isServer = true;
+  this->port = port;
+
+  server = new WiFiServer(port);
+  server->begin();
+  server->setNoDelay(true);
+
+  LOG_I("TCP", "数据服务器监听端口 %u", port);
+  return true;
+}
+
+bool TcpProtocol::beginClient(const String& host, uint16_t port) {
+  end();
+  isServer = false;
+  this->host = host;
+  this->port = port;
+
+  // 立即尝试连接，失败时由loop()按间隔重连
+  if (!connectToMaster() && (locator == nullptr || locator->canConnect())) {
+    LOG_W("TCP", "连接主设备 %s:%u 失败", host.c_str(), port);
+  }
+  return true;
+}
+
+bool TcpProtocol::connectToMaster() {
+  // WiFi未连接时不计入重连间隔，连接后立即尝试
+  if (locator != nullptr && !locator->canConnect()) {
+    return false;
+  }
+  lastConnectAttempt = millis();
+
+  bool connected;
+  if (locator != nullptr) {
+    IPAddress ip;
+    uint16_t masterPort = port;
+    if (!locator->resolve(ip, masterPort)) {
+      return false;
+    }
+    connected = client.connect(ip, masterPort);
+    if (connected) {
+      locator->onConnected();
+    } else {
+      locator->onConnectFailed();
+    }
+  } else {
+    connected = client.connect(host.c_str(), port);
+  }
+
+  if (connected) {
+    onConnected();
+  }
+  return connected;
+}
+
+void TcpProtocol::end() {
+  client.stop();
+  clientConnected = false;
+  if (server != nullptr) {
+    server->stop();
+    delete server;
+    server = nullptr;
+  }
+
+  // 重新配置后不恢复之前的会话
+  clearBatch();
+  replayClear(false);
+  peerSession = 0;
+  helloReceived = false;
+  rxUnacked = 0;
+  lostAt = 0;
+}
+
+void TcpProtocol::loop() {
+  if (isServer) {
+    // 主设备：新连接替换旧连接 (从设备重连时旧连接可能已失效)
+    if (server != nullptr && server->hasClient()) {
+      WiFiClient newClient = server->available();
+      if (client.connected()) {
+        LOG_W("TCP", "新的从设备连接替换旧连接");
+        client.stop();
+      }
+      checkDisconnected();
+      client = newClient;
+      onConnected();
+    }
+  }
+
+  if (client.connected()) {
+    if (txBatchCount > 0 && (micros() - txBatchStartUs) >= txBatchHoldUs) {
+      flushBatch();
+    }
+    // 没有反向数据可以携带确认号时单独确认，释放对端的重传缓冲区
+    if (helloReceived && rxUnacked > 0 &&
+        (rxUnacked >= TCP_ACK_EVERY_FRAMES || (millis() - rxUnackedSince) >= TCP_ACK_DELAY_MS)) {
+      sendAck();
+    }
+    return;
+  }
+  checkDisconnected();
+
+  // 从设备：断线后按间隔重连
+  if (!isServer && port != 0 && (millis() - lastConnectAttempt) >= TCP_RECONNECT_INTERVAL_MS) {
+    connectToMaster();
+  }
+}
+
+bool TcpProtocol::isConnected() {
+  return client.connected();
+}
+
+void TcpProtocol::setBatchBudgetUs(uint32_t budgetUs) {
+  if (budgetUs == 0) {
+    flushBatch();
+  }
+  batchBudgetUs = budgetUs;
+  frameIntervalUs = 0;
+}
+
+bool TcpProtocol::sendFrame(const uint8_t* data, uint16_t length, const uint8_t* timing, uint8_t timingLength,
+                            bool urgent) {
+  if (length == 0 || length > RS485_FRAME_BUFFER_SIZE || timingLength > RS485_TIMING_MAX_SIZE) {
+    return false;
+  }
+
+  // 有字节间隔时在帧前附加间隔记录；没有间隔的帧不增加任何开销
+  uint8_t type = TCP_PACKET_DATA;
+  uint8_t timed[TCP_DATA_MAX_SIZE];
+  if (timingLength > 0) {
+    timed[0] = timingLength;
+    memcpy(timed + 1, timing, timingLength);
+    memcpy(timed + 1 + timingLength, data, length);
+    type = TCP_PACKET_DATA_TIMED;
+    data = timed;
+    length += 1 + timingLength;
+  }
+
+  bool connected = client.connected();
+  if (!connected) {
+    checkDisconnected();
+    // 没有可以恢复的会话时直接丢弃
+    if (peerSession == 0 || !resumeEnabled) {
+      return false;
+    }
+  }
+
+  uint16_t seq = txSeq++;
+  replayPush(type, seq, data, length);
+
+  // 断线期间或HELLO交换完成之前只保存，会话建立后发送
+  if (!connected || !helloReceived) {
+    return true;
+  }
+
+  if (batchBudgetUs > 0) {
+    updateFrameInterval();
+    if (length <= TCP_BATCH_MAX_ENTRY) {
+      if (txBatchCount > 0 && txBatchLength + TCP_BATCH_ENTRY_HEADER + length > TCP_BATCH_BUFFER_SIZE) {
+        flushBatch();
+      }
+      uint32_t hold = txBatchCount > 0 ? txBatchHoldUs : batchHoldUs();
+      // 紧急的帧不等待：有等待中的聚合时加入后立即写入，否则单独发送
+      if (hold > 0 && !(urgent && txBatchCount == 0)) {
+        if (txBatchCount == 0) {
+          txBatchSeq = seq;
+          txBatchStartUs = lastFrameUs;
+          txBatchHoldUs = hold;
+        }
+        uint8_t* entry = txBatch + TCP_PACKET_HEADER_SIZE + TCP_BATCH_HEADER_SIZE + txBatchLength;
+        entry[0] = type;
+        entry[1] = (uint8_t)length;
+        memcpy(entry + TCP_BATCH_ENTRY_HEADER, data, length);
+        txBatchLength += TCP_BATCH_ENTRY_HEADER + length;
+        // 帧数字段只有一个字节
+        if (++txBatchCount == 0xFF || urgent) {
+          flushBatch();
+        }
+        return true;
+      }
+    }
+    // 不聚合的帧之前的帧先发出，保持顺序
+    if (!flushBatch()) {
+      return resumeEnabled;
+    }
+  }
+
+  if (!writeData(type, seq, data, length)) {
+    LOG_W("TCP", "发送数据包失败");
+    return resumeEnabled;
+  }
+  txUnsent = txSeq;
+  return true;
+}
+
+bool TcpProtocol::receiveFrame(RS485Frame& frame) {
+  // 先取完上一个聚合数据包中的帧
+  if (rxBatchRemaining > 0 && nextBatchFrame(frame)) {
+    return true;
+  }
+
+  while (client.available() > 0) {
+    // 接收包头
+    if (rxHeaderLength < TCP_PACKET_HEADER_SIZE) {
+      int c = client.read();
+      if (c < 0) {
+        return false;
+      }
+      rxHeader[rxHeaderLength++] = (uint8_t)c;
+
+      if (rxHeaderLength == 1 && rxHeader[0] != TCP_PACKET_MAGIC) {
+        dropConnection();
+        return false;
+      }
+
+      if (rxHeaderLength == TCP_PACKET_HEADER_SIZE) {
+        rxType = rxHeader[1];
+        rxPayloadLength = get16(rxHeader + 2);
+        rxPayloadReceived = 0;
+        rxFirstByteTime = micros();
+
+        if (rxPayloadLength > sizeof(rxPayload)) {
+          dropConnection();
+          return false;
+        }
+      } else {
+        continue;
+      }
+    }
+
+    // 接收负载
+    if (rxPayloadReceived < rxPayloadLength) {
+      int n = client.read(rxPayload + rxPayloadReceived, rxPayloadLength - rxPayloadReceived);
+      if (n <= 0) {
+        return false;
+      }
+      rxPayloadReceived += n;
+    }
+
+    if (rxPayloadReceived < rxPayloadLength) {
+      continue;
+    }
+
+    // 数据包接收完成
+    rxHeaderLength = 0;
+    if (rxType == TCP_PACKET_HELLO || rxType == TCP_PACKET_ACK) {
+      uint16_t expected = rxType == TCP_PACKET_HELLO ? TCP_HELLO_SIZE : TCP_ACK_SIZE;
+      if (rxPayloadLength != expected) {
+        dropConnection();
+        return false;
+      }
+      if (rxType == TCP_PACKET_HELLO) {
+        handleHello();
+      } else {
+        handleAck(get16(rxPayload));
+      }
+      continue;
+    }
+    if (rxType == TCP_PACKET_DATA_BATCH) {
+      if (rxPayloadLength < TCP_BATCH_HEADER_SIZE) {
+        dropConnection();
+        return false;
+      }
+      handleAck(get16(rxPayload + 2));
+      METRIC_ADD(METRIC_LINK_RX_BYTES, TCP_PACKET_HEADER_SIZE + rxPayloadLength);
+      rxBatchSeq = get16(rxPayload);
+      rxBatchRemaining = rxPayload[4];
+      rxBatchOffset = TCP_BATCH_HEADER_SIZE;
+      if (nextBatchFrame(frame)) {
+        return true;
+      }
+      continue;
+    }
+    if ((rxType != TCP_PACKET_DATA && rxType != TCP_PACKET_DATA_TIMED) || rxPayloadLength <= TCP_DATA_HEADER_SIZE) {
+      continue;
+    }
+
+    handleAck(get16(rxPayload + 2));
+    METRIC_ADD(METRIC_LINK_RX_BYTES, TCP_PACKET_HEADER_SIZE + rxPayloadLength);
+    if (acceptData(rxType, get16(rxPayload), rxPayload + TCP_DATA_HEADER_SIZE, rxPayloadLength - TCP_DATA_HEADER_SIZE,
+                   frame)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool TcpProtocol::acceptData(uint8_t type, uint16_t seq, const uint8_t* data, uint16_t length, RS485Frame& frame) {
+  // 间隔记录：长度为偶数且之后至少还有一个字节，其后的帧不超过帧缓冲区
+  uint16_t frameOffset = 0;
+  uint8_t timingLength = 0;
+  if (type == TCP_PACKET_DATA_TIMED) {
+    timingLength = length > 0 ? data[0] : 0;
+    frameOffset = 1 + timingLength;
+    if ((timingLength & 1) != 0 || timingLength > RS485_TIMING_MAX_SIZE || length <= frameOffset ||
+        length - frameOffset > RS485_FRAME_BUFFER_SIZE) {
+      dropConnection();
+      return false;
+    }
+  } else if (type != TCP_PACKET_DATA || length == 0 || length > RS485_FRAME_BUFFER_SIZE) {
+    dropConnection();
+    return false;
+  }
+
+  // 序号跳跃 (对端丢弃了过期的帧) 时照常接收
+  if (seqBefore(seq, rxNext)) {
+    duplicates++;
+    METRIC_INC(METRIC_LINK_DUPLICATES);
+    return false;
+  }
+  rxNext = seq + 1;
+  if (rxUnacked++ == 0) {
+    rxUnackedSince = millis();
+  }
+
+  frame.length = length - frameOffset;
+  frame.firstByteTime = rxFirstByteTime;
+  frame.lastByteTime = micros();
+  memcpy(frame.data, data + frameOffset, frame.length);
+  frame.timingLength = timingLength;
+  memcpy(frame.timing, data + 1, timingLength);
+  framesReceived++;
+  METRIC_INC(METRIC_LINK_RX_FRAMES);
+  return true;
+}
+
+bool TcpProtocol::nextBatchFrame(RS485Frame& frame) {
+  while (rxBatchRemaining > 0) {
+    if (rxBatchOffset + TCP_BATCH_ENTRY_HEADER > rxPayloadLength) {
+      dropConnection();
+      return false;
+    }
+    uint8_t type = rxPayload[rxBatchOffset];
+    uint8_t length = rxPayload[rxBatchOffset + 1];
+    const uint8_t* data = rxPayload + rxBatchOffset + TCP_BATCH_ENTRY_HEADER;
+    if (rxBatchOffset + TCP_BATCH_ENTRY_HEADER + length > rxPayloadLength) {
+      dropConnection();
+      return false;
+    }
+    rxBatchOffset += TCP_BATCH_ENTRY_HEADER + length;
+    rxBatchRemaining--;
+    if (acceptData(type, rxBatchSeq++, data, length, frame)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TcpProtocol::onConnected() {
+  client.setNoDelay(true);
+  clientConnected = true;
+  helloReceived = false;
+  rxHeaderLength = 0;
+  rxPayloadLength = 0;
+  rxPayloadReceived = 0;
+  rxBatchRemaining = 0;
+  clearBatch();
+  connects++;
+  METRIC_INC(METRIC_LINK_CONNECTS);
+  LOG_I("TCP", "主从连接已建立 (第%u次)", connects);
+
+  // 关闭恢复时不声明已知的对端会话，对端也不会恢复
+  uint8_t hello[TCP_HELLO_SIZE];
+  put32(hello, localSession);
+  put32(hello + 4, resumeEnabled ? peerSession : 0);
+  put16(hello + 8, rxNext);
+  put16(hello + 10, txUnsent);
+  writePacket(TCP_PACKET_HELLO, hello, sizeof(hello));
+}
+
+void TcpProtocol::checkDisconnected() {
+  if (!clientConnected || client.connected()) {
+    return;
+  }
+  clientConnected = false;
+  helloReceived = false;
+  clearBatch();
+  lostAt = millis();
+  if (lostAt == 0) {
+    lostAt = 1;
+  }
+  LOG_W("TCP", "主从连接断开 (%u 帧未确认)", replayFrames);
+  if (!isServer && locator != nullptr) {
+    locator->onDisconnected();
+  }
+}
+
+void TcpProtocol::dropConnection() {
+  protocolErrors++;
+  METRIC_INC(METRIC_LINK_PROTOCOL_ERRORS);
+  LOG_E("TCP", "数据包格式错误，断开连接");
+  client.stop();
+  rxHeaderLength = 0;
+  rxBatchRemaining = 0;
+}
+
+void TcpProtocol::handleHello() {
+  uint32_t session = get32(rxPayload);
+  uint32_t knownSession = get32(rxPayload + 4);
+  uint16_t ack = get16(rxPayload + 8);
+  uint16_t peerNext = get16(rxPayload + 10);
+
+  // 双方都认得对方上次的会话ID时恢复 (两端的判断条件对称，结果一致)
+  bool resume = resumeEnabled && peerSession != 0 && session == peerSession && knownSession == localSession;
+  peerSession = session;
+  helloReceived = true;
+
+  if (resume) {
+    handleAck(ack);
+    uint32_t pending = replayFrames;
+    replayResend();
+    resumes++;
+    METRIC_INC(METRIC_LINK_RESUMES);
+    if (lostAt != 0) {
+      lastFailoverMs = millis() - lostAt;
+      maxFailoverMs = max(maxFailoverMs, lastFailoverMs);
+      metrics.setGauge(GAUGE_LINK_FAILOVER_MS, lastFailoverMs);
+    }
+    LOG_I("TCP", "会话已恢复，重发 %u 帧，断线 %u ms", pending, lastFailoverMs);
+  } else {
+    // 对端重启 (或首次连接)：上次连接发出的帧对端已无法确认，只发送还没发过的帧
+    replayClear(true);
+    rxNext = peerNext;
+    rxUnacked = 0;
+    replayResend();
+    LOG_I("TCP", "新会话 %08x", session);
+  }
+  lostAt = 0;
+}
+
+void TcpProtocol::handleAck(uint16_t ack) {
+  while (replayFrames > 0) {
+    uint16_t seq, length;
+    uint32_t queuedAt;
+    replayPeek(0, seq, length, queuedAt);
+    if (!seqBefore(seq, ack)) {
+      break;
+    }
+    replayPop();
+  }
+}
+
+bool TcpProtocol::writePacket(uint8_t type, const uint8_t* payload, uint16_t length) {
+  uint8_t packet[TCP_PACKET_HEADER_SIZE + TCP_HELLO_SIZE];
+  packet[0] = TCP_PACKET_MAGIC;
+  packet[1] = type;
+  put16(packet + 2, length);
+  memcpy(packet + TCP_PACKET_HEADER_SIZE, payload, length);
+
+  size_t packetLength = TCP_PACKET_HEADER_SIZE + length;
+  return client.write(packet, packetLength) == packetLength;
+}
+
+bool TcpProtocol::writeData(uint8_t type, uint16_t seq, const uint8_t* data, uint16_t length) {
+  // 包头和负载一次写入，避免拆成两个TCP报文；每个数据包都携带确认号
+  uint8_t packet[TCP_PACKET_HEADER_SIZE + TCP_DATA_HEADER_SIZE + TCP_DATA_MAX_SIZE];
+  packet[0] = TCP_PACKET_MAGIC;
+  packet[1] = type;
+  put16(packet + 2, TCP_DATA_HEADER_SIZE + length);
+  put16(packet + 4, seq);
+  put16(packet + 6, rxNext);
+  memcpy(packet + TCP_PACKET_HEADER_SIZE + TCP_DATA_HEADER_SIZE, data, length);
+
+  size_t packetLength = TCP_PACKET_HEADER_SIZE + TCP_DATA_HEADER_SIZE + length;
+  if (client.write(packet, packetLength) != packetLength) {
+    return false;
+  }
+
+  rxUnacked = 0;
+  framesSent++;
+  packetsSent++;
+  METRIC_INC(METRIC_LINK_TX_FRAMES);
+  METRIC_INC(METRIC_LINK_TX_PACKETS);
+  METRIC_ADD(METRIC_LINK_TX_BYTES, packetLength);
+  return true;
+}
+
+void TcpProtocol::sendAck() {
+  uint8_t ack[TCP_ACK_SIZE];
+  put16(ack, rxNext);
+  if (writePacket(TCP_PACKET_ACK, ack, sizeof(ack))) {
+    rxUnacked = 0;
+  }
+}
+
+void TcpProtocol::updateFrameInterval() {
+  // 滑动平均 (1/4权重)；单次间隔最多按预算的两倍计入，空闲后几帧密集的流量即可重新开始聚合
+  uint32_t now = micros();
+  uint32_t interval = min<uint32_t>(now - lastFrameUs, batchBudgetUs * 2);
+  lastFrameUs = now;
+  if (frameIntervalUs == 0) {
+    frameIntervalUs = interval;
+  } else {
+    frameIntervalUs = frameIntervalUs - frameIntervalUs / 4 + interval / 4;
+  }
+}
+
+uint32_t TcpProtocol::batchHoldUs() {
+  // 预计预算内等不到下一帧时立即发送 (轻负载下聚合只会增加时延)
+  if (frameIntervalUs == 0 || frameIntervalUs >= batchBudgetUs) {
+    return 0;
+  }
+  return min<uint32_t>(batchBudgetUs, frameIntervalUs * (TCP_BATCH_TARGET_FRAMES - 1));
+}
+
+bool TcpProtocol::flushBatch() {
+  if (txBatchCount == 0) {
+    return true;
+  }
+  uint8_t count = txBatchCount;
+  uint16_t length = txBatchLength;
+  uint8_t* packet = txBatch;
+  uint8_t* entries = packet + TCP_PACKET_HEADER_SIZE + TCP_BATCH_HEADER_SIZE;
+  uint32_t holdUs = micros() - txBatchStartUs;
+  clearBatch();
+
+  // 只有一帧时按普通数据包发送，不增加聚合头部
+  if (count == 1) {
+    if (!writeData(entries[0], txBatchSeq, entries + TCP_BATCH_ENTRY_HEADER, entries[1])) {
+      return false;
+    }
+  } else {
+    packet[0] = TCP_PACKET_MAGIC;
+    packet[1] = TCP_PACKET_DATA_BATCH;
+    put16(packet + 2, TCP_BATCH_HEADER_SIZE + length);
+    put16(packet + 4, txBatchSeq);
+    put16(packet + 6, rxNext);
+    packet[8] = count;
+    size_t packetLength = TCP_PACKET_HEADER_SIZE + TCP_BATCH_HEADER_SIZE + length;
+    if (client.write(packet, packetLength) != packetLength) {
+      LOG_W("TCP", "发送聚合数据包失败");
+      return false;
+    }
+    rxUnacked = 0;
+    framesSent += count;
+    packetsSent++;
+    batchedFrames += count;
+    packetsSaved += count - 1;
+    METRIC_ADD(METRIC_LINK_TX_FRAMES, count);
+    METRIC_INC(METRIC_LINK_TX_PACKETS);
+    METRIC_ADD(METRIC_LINK_TX_BYTES, packetLength);
+    METRIC_ADD(METRIC_LINK_BATCHED_FRAMES, count);
+    METRIC_ADD(METRIC_LINK_AIRTIME_SAVED_US, (count - 1) * TCP_PACKET_AIRTIME_US);
+  }
+  txUnsent = txBatchSeq + count;
+  maxBatchHoldUs = max(maxBatchHoldUs, holdUs);
+  TRACE_STAGE(TRACE_BATCH_HOLD, holdUs);
+  return true;
+}
+
+void TcpProtocol::clearBatch() {
+  txBatchCount = 0;
+  txBatchLength = 0;
+}
+
+bool TcpProtocol::replayPush(uint8_t type, uint16_t seq, const uint8_t* data, uint16_t length) {
+  uint16_t size = TCP_REPLAY_ENTRY_HEADER + length;
+  if (size > TCP_REPLAY_BUFFER_SIZE) {
+    replayDropped++;
+    METRIC_INC(METRIC_LINK_REPLAY_DROPPED);
+    return false;
+  }
+  // 缓冲区满时丢弃最早的帧 (长时间未确认，恢复后多半也已过期)
+  while (TCP_REPLAY_BUFFER_SIZE - replayUsed < size) {
+    replayPop();
+    replayDropped++;
+    METRIC_INC(METRIC_LINK_REPLAY_DROPPED);
+  }
+
+  uint8_t header[TCP_REPLAY_ENTRY_HEADER];
+  put16(header, seq);
+  put16(header + 2, length);
+  put32(header + 4, millis());
+  header[8] = type;
+  uint16_t tail = (replayHead + replayUsed) % TCP_REPLAY_BUFFER_SIZE;
+  ringWrite(replay, tail, header, sizeof(header));
+  ringWrite(replay, (tail + sizeof(header)) % TCP_REPLAY_BUFFER_SIZE, data, length);
+  replayUsed += size;
+  replayFrames++;
+  return true;
+}
+
+void TcpProtocol::replayPop() {
+  uint16_t seq, length;
+  uint32_t queuedAt;
+  replayPeek(0, seq, length, queuedAt);
+  uint16_t size = TCP_REPLAY_ENTRY_HEADER + length;
+  replayHead = (replayHead + size) % TCP_REPLAY_BUFFER_SIZE;
+  replayUsed -= size;
+  replayFrames--;
+}
+
+void TcpProtocol::replayPeek(uint16_t offset, uint16_t& seq, uint16_t& length, uint32_t& queuedAt, uint8_t* type) {
+  uint8_t header[TCP_REPLAY_ENTRY_HEADER];
+  ringRead(replay, (replayHead + offset) % TCP_REPLAY_BUFFER_SIZE, header, sizeof(header));
+  seq = get16(header);
+  length = get16(header + 2);
+  queuedAt = get32(header + 4);
+  if (type != nullptr) {
+    *type = header[8];
+  }
+}
+
+void TcpProtocol::replayResend() {
+  uint16_t seq, length;
+  uint32_t queuedAt;
+
+  // 帧按入队时间排列，过期的帧都在前面
+  uint32_t now = millis();
+  while (replayFrames > 0) {
+    replayPeek(0, seq, length, queuedAt);
+    if ((now - queuedAt) <= TCP_REPLAY_MAX_AGE_MS) {
+      break;
+    }
+    replayPop();
+    replayDropped++;
+    METRIC_INC(METRIC_LINK_REPLAY_DROPPED);
+  }
+
+  uint16_t offset = 0;
+  for (uint16_t i = 0; i < replayFrames; i++) {
+    uint8_t type;
+    replayPeek(offset, seq, length, queuedAt, &type);
+    uint8_t data[TCP_DATA_MAX_SIZE];
+    ringRead(replay, (replayHead + offset + TCP_REPLAY_ENTRY_HEADER) % TCP_REPLAY_BUFFER_SIZE, data, length);
+    if (!writeData(type, seq, data, length)) {
+      return;
+    }
+    if (seqBefore(seq, txUnsent)) {
+      retransmits++;
+      METRIC_INC(METRIC_LINK_RETRANSMITS);
+    }
+    offset += TCP_REPLAY_ENTRY_HEADER + length;
+  }
+  txUnsent = txSeq;
+}
+
+void TcpProtocol::replayClear(bool writtenOnly) {
+  while (replayFrames > 0) {
+    uint16_t seq, length;
+    uint32_t queuedAt;
+    replayPeek(0, seq, length, queuedAt);
+    if (writtenOnly && !seqBefore(seq, txUnsent)) {
+      break;
+    }
+    replayPop();
+    replayDropped++;
+    METRIC_INC(METRIC_LINK_REPLAY_DROPPED);
+  }
+  if (!writtenOnly) {
+    txUnsent = txSeq;
+  }
+}
@@ -1,59 +1,388 @@
 #include "test_framework.h"
 #include "logger.h"
+#include <algorithm>
+#include <memory>
+
+#ifdef WIFLY485_NATIVE
+#include <FS.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#endif
 
 // 全局测试框架实例
 TestFramework testFramework;
 
-TestFramework::TestFramework() : testList(nullptr), totalTests(0), passedTests(0), failedTests(0) {
+// 零初始化，先于任何测试项的构造函数
+TestList TestFramework::testList;
+TestList TestFramework::benchmarkList;
+
+TestItem::TestItem(void (*func)(), const char* name, const char* tags, bool benchmark)
+    : func(func), name(name), tags(tags), next(nullptr) {
+  TestFramework::addItem(this, benchmark);
+}
+
+TestFramework::TestFramework() : totalTests(0), passedTests(0), failedTests(0) {
   // 构造函数
 }
 
 TestFramework::~TestFramework() {
   // 析构函数
-  // 清理测试列表
-  TestItem* current = testList;
-  while (current != nullptr) {
-    TestItem* next = current->next;
-    delete current;
-    current = next;
-  }
 }
 
 void TestFramework::begin() {
   // 初始化测试框架
   Serial.println("=== WiFly485 测试框架初始化 ===");
+  resetCounters();
+}
+
+void TestFramework::resetCounters() {
   totalTests = 0;
   passedTests = 0;
   failedTests = 0;
 }
 
-void TestFramework::runAllTests() {
-  // 运行所有测试
-  Serial.println("=== 开始运行所有测试 ===");
+void TestFramework::addItem(TestItem* item, bool benchmark) {
+  // 记录尾指针，每次加入都是O(1)
+  TestList& list = benchmark ? benchmarkList : testList;
+  if (list.tail == nullptr) {
+    list.head = item;
+  } else {
+    list.tail->next = item;
+  }
+  list.tail = item;
+  list.count++;
+}
+
+// 名称匹配，*匹配任意长度 (包括空串)
+static bool globMatch(const char* pattern, size_t patternLength, const char* name) {
+  const char* star = nullptr;
+  size_t starIndex = 0;
+  const char* resume = name;
+  size_t i = 0;
+  while (*name != '\0') {
+    if (i < patternLength && (pattern[i] == *name)) {
+      i++;
+      name++;
+    } else if (i < patternLength && pattern[i] == '*') {
+      star = name;
+      starIndex = ++i;
+      resume = name;
+    } else if (star != nullptr) {
+      i = starIndex;
+      name = ++resume;
+    } else {
+      return false;
+    }
+  }
+  while (i < patternLength && pattern[i] == '*') {
+    i++;
+  }
+  return i == patternLength;
+}
+
+// 标签表中是否有该标签 (整词匹配)
+static bool hasTag(const char* tags, const char* tag, size_t tagLength) {
+  const char* p = tags;
+  while (*p != '\0') {
+    while (*p == ' ') {
+      p++;
+    }
+    const char* end = p;
+    while (*end != '\0' && *end != ' ') {
+      end++;
+    }
+    if ((size_t)(end - p) == tagLength && strncmp(p, tag, tagLength) == 0) {
+      return true;
+    }
+    p = end;
+  }
+  return false;
+}
+
+bool TestFramework::matchesFilter(const TestItem& item, const char* filter) {
+  if (filter == nullptr) {
+    return true;
+  }
+  bool anyPositive = false;
+  bool included = false;
+  const char* p = filter;
+  while (*p != '\0') {
+    if (*p == ' ' || *p == ',') {
+      p++;
+      continue;
+    }
+    const char* end = p;
+    while (*end != '\0' && *end != ' ' && *end != ',') {
+      end++;
+    }
+    bool exclude = *p == '-';
+    const char* term = exclude ? p + 1 : p;
+    bool matched = *term == '@' ? hasTag(item.tags, term + 1, end - term - 1)
+                                : globMatch(term, end - term, item.name);
+    if (exclude && matched) {
+      return false;
+    }
+    if (!exclude) {
+      anyPositive = true;
+      included = included || matched;
+    }
+    p = end;
+  }
+  return included || !anyPositive;
+}
+
+int TestFramework::runAllTests(const char* filter) {
+  // 运行匹配的测试，断言计数从零开始
+  Serial.println("=== 开始运行测试 ===");
+  resetCounters();
   
-  TestItem* current = testList;
-  while (current != nullptr) {
-    Serial.printf("运行测试: %s\n", current->testName);
-    LOG_I("TestFramework", "运行测试: %s", current->testName);
+  for (TestItem* current = testList.head; current != nullptr; current = current->next) {
+    if (!matchesFilter(*current, filter)) {
+      continue;
+    }
+    Serial.printf("运行测试: %s\n", current->name);
+    LOG_I("TestFramework", "运行测试: %s", current->name);
     
     // 运行测试函数
-    current->testFunc();
+    current->func();
+    totalTests++;
+  }
+  
+  Serial.printf("=== 测试运行完成 (%d/%u) ===\n", totalTests, testList.count);
+  return totalTests;
+}
+
+#ifdef WIFLY485_NATIVE
+int TestFramework::runTestsParallel(const char* filter, uint8_t jobs) {
+  // 带serial标签的测试 (断言时延等，对CPU争用敏感) 在所有分片结束后在本进程中依次运行
+  std::vector<TestItem*> selected;
+  std::vector<TestItem*> serial;
+  for (TestItem* current = testList.head; current != nullptr; current = current->next) {
+    if (matchesFilter(*current, filter)) {
+      (hasTag(current->tags, TEST_TAG_SERIAL, strlen(TEST_TAG_SERIAL)) ? serial : selected).push_back(current);
+    }
+  }
+  resetCounters();
+  if (selected.empty() && serial.empty()) {
+    Serial.println("=== 没有匹配的测试 ===");
+    return 0;
+  }
+  // 只有serial测试时不创建分片
+  jobs = std::min<size_t>(jobs, selected.size());
+  Serial.printf("=== 并行运行 %u 个测试 (%u 个分片)，之后依次运行 %u 个 ===\n", (unsigned)selected.size(), jobs,
+                (unsigned)serial.size());
+  Serial.flush();
+  Serial1.flush();
+  uint32_t start = millis();
+
+  // 每个分片两个管道：输出 (标准输出和标准错误) 和结束时的断言计数
+  struct Shard {
+    pid_t pid;
+    int output;
+    int result;
+    std::string text;
+  };
+  std::vector<Shard> shards(jobs);
+  for (uint8_t s = 0; s < jobs; s++) {
+    int output[2], result[2];
+    if (pipe(output) != 0 || pipe(result) != 0) {
+      Serial.println("无法创建管道");
+      return 0;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(output[0]);
+      close(result[0]);
+      dup2(output[1], STDOUT_FILENO);
+      dup2(output[1], STDERR_FILENO);
+      close(output[1]);
+      nativeFsIsolate();
+      resetCounters();
+      for (size_t i = s; i < selected.size(); i += jobs) {
+        Serial.printf("运行测试: %s\n", selected[i]->name);
+        LOG_I("TestFramework", "运行测试: %s", selected[i]->name);
+        selected[i]->func();
+        totalTests++;
+      }
+      int counts[3] = {totalTests, passedTests, failedTests};
+      ssize_t written = write(result[1], counts, sizeof(counts));
+      (void)written;
+      fflush(stdout);
+      fflush(stderr);
+      exit(failedTests > 0 ? 1 : 0);
+    }
+    close(output[1]);
+    close(result[1]);
+    shards[s].pid = pid;
+    shards[s].output = output[0];
+    shards[s].result = result[0];
+  }
+
+  // 同时读取所有分片的输出，避免管道写满时子进程阻塞
+  std::vector<struct pollfd> fds(jobs);
+  for (uint8_t s = 0; s < jobs; s++) {
+    fds[s].fd = shards[s].output;
+    fds[s].events = POLLIN;
+  }
+  uint8_t open = jobs;
+  while (open > 0) {
+    if (poll(fds.data(), jobs, -1) < 0) {
+      break;
+    }
+    for (uint8_t s = 0; s < jobs; s++) {
+      if (fds[s].fd < 0 || fds[s].revents == 0) {
+        continue;
+      }
+      char buffer[4096];
+      ssize_t n = read(fds[s].fd, buffer, sizeof(buffer));
+      if (n > 0) {
+        shards[s].text.append(buffer, n);
+      } else {
+        close(fds[s].fd);
+        fds[s].fd = -1;
+        open--;
+      }
+    }
+  }
+
+  resetCounters();
+  for (uint8_t s = 0; s < jobs; s++) {
+    int counts[3] = {0, 0, 0};
+    bool complete = read(shards[s].result, counts, sizeof(counts)) == (ssize_t)sizeof(counts);
+    close(shards[s].result);
+    int status = 0;
+    waitpid(shards[s].pid, &status, 0);
+
+    Serial.printf("=== 分片 %u/%u ===\n", s + 1, jobs);
+    Serial.write((const uint8_t*)shards[s].text.data(), shards[s].text.size());
+    totalTests += counts[0];
+    passedTests += counts[1];
+    failedTests += counts[2];
+    // 子进程崩溃时没有计数，按一次失败计
+    if (!complete) {
+      failedTests++;
+      Serial.printf("  失败: 分片 %u 异常退出 (状态 %d)\n", s + 1, status);
+    }
+  }
+  for (TestItem* item : serial) {
+    Serial.printf("运行测试: %s\n", item->name);
+    LOG_I("TestFramework", "运行测试: %s", item->name);
+    item->func();
+    totalTests++;
+  }
+  Serial.printf("=== 并行测试完成: %d 个测试，%u ms ===\n", totalTests, (unsigned)(millis() - start));
+  return totalTests;
+}
+#endif
+
+void TestFramework::listTests(const char* filter) {
+  for (TestItem* current = testList.head; current != nullptr; current = current->next) {
+    if (matchesFilter(*current, filter)) {
+      Serial.printf("test  %-24s %s\n", current->name, current->tags);
+    }
+  }
+  for (TestItem* current = benchmarkList.head; current != nullptr; current = current->next) {
+    if (matchesFilter(*current, filter)) {
+      Serial.printf("bench %-24s %s\n", current->name, current->tags);
+    }
+  }
+}
+
+void TestFramework::runAllBenchmarks(const char* filter) {
+  // 运行匹配的基准测试
+  Serial.println("=== 开始运行基准测试 ===");
+  
+  for (TestItem* current = benchmarkList.head; current != nullptr; current = current->next) {
+    if (!matchesFilter(*current, filter)) {
+      continue;
+    }
+    LOG_I("TestFramework", "运行基准测试: %s", current->name);
     
-    current = current->next;
+    BenchmarkResult result = runBenchmark(current->func, current->name);
+    printBenchmarkResult(result);
   }
   
-  Serial.println("=== 测试运行完成 ===");
+  Serial.println("=== 基准测试完成 ===");
 }
 
-void TestFramework::registerTest(void (*testFunc)(), const char* testName) {
-  // 注册测试函数
-  TestItem* item = new TestItem();
-  item->testFunc = testFunc;
-  item->testName = testName;
-  item->next = nullptr;
+BenchmarkResult TestFramework::runBenchmark(void (*benchFunc)(), const char* benchName) {
+  BenchmarkResult result = {};
+  result.name = benchName;
+  
+  uint32_t elapsedUs = 0;
+  uint32_t elapsedCycles = 0;
+  
+  // 预热：让缓存、堆和Flash映射进入稳定状态
+  uint32_t warmupStart = micros();
+  do {
+    benchFunc();
+  } while ((uint32_t)(micros() - warmupStart) < BENCH_WARMUP_US);
+  yield();
+  
+  // 自动确定迭代次数，使每个样本的耗时远大于micros()的分辨率
+  uint32_t iterations = 1;
+  while (iterations < BENCH_MAX_ITERATIONS) {
+    measureBatch(benchFunc, iterations, elapsedUs, elapsedCycles);
+    if (elapsedUs >= BENCH_SAMPLE_TARGET_US) {
+      break;
+    }
+    // 按实测耗时估算所需迭代次数，至少翻倍
+    uint32_t scaled = elapsedUs > 0 ? (uint32_t)((uint64_t)iterations * BENCH_SAMPLE_TARGET_US / elapsedUs) : 0;
+    iterations = std::max(iterations * 2, scaled);
+    iterations = std::min(iterations, (uint32_t)BENCH_MAX_ITERATIONS);
+    yield();
+  }
+  result.iterations = iterations;
+  
+  // 采样：每个样本间让出CPU，避免触发看门狗
+  std::unique_ptr<uint32_t[]> sampleUs(new uint32_t[BENCH_SAMPLE_COUNT]);
+  std::unique_ptr<uint32_t[]> sampleCycles(new uint32_t[BENCH_SAMPLE_COUNT]);
+  for (uint16_t i = 0; i < BENCH_SAMPLE_COUNT; i++) {
+    measureBatch(benchFunc, iterations, sampleUs[i], sampleCycles[i]);
+    yield();
+  }
+  result.samples = BENCH_SAMPLE_COUNT;
+  
+  // 统计最小值、中位数和P99 (最近秩法)
+  std::sort(sampleUs.get(), sampleUs.get() + BENCH_SAMPLE_COUNT);
+  std::sort(sampleCycles.get(), sampleCycles.get() + BENCH_SAMPLE_COUNT);
+  const uint16_t medianIndex = (BENCH_SAMPLE_COUNT - 1) / 2;
+  const uint16_t p99Index = (BENCH_SAMPLE_COUNT * 99 + 99) / 100 - 1;
   
-  addTestItem(item);
-  totalTests++;
+  result.minUs = (float)sampleUs[0] / iterations;
+  result.medianUs = (float)sampleUs[medianIndex] / iterations;
+  result.p99Us = (float)sampleUs[p99Index] / iterations;
+  result.minCycles = sampleCycles[0] / iterations;
+  result.medianCycles = sampleCycles[medianIndex] / iterations;
+  result.p99Cycles = sampleCycles[p99Index] / iterations;
+  
+  return result;
+}
+
+void TestFramework::printBenchmarkResult(const BenchmarkResult& result) {
+  // 每个结果一行JSON，便于在不同固件版本之间比较
+  Serial.printf("{\"type\":\"benchmark\",\"name\":\"%s\",\"build\":\"%s %s\",\"cpu_mhz\":%u,"
+                "\"iterations\":%u,\"samples\":%u,"
+                "\"min_us\":%.3f,\"median_us\":%.3f,\"p99_us\":%.3f,"
+                "\"min_cycles\":%u,\"median_cycles\":%u,\"p99_cycles\":%u}\n",
+                result.name, __DATE__, __TIME__, (unsigned)ESP.getCpuFreqMHz(),
+                (unsigned)result.iterations, (unsigned)result.samples,
+                result.minUs, result.medianUs, result.p99Us,
+                (unsigned)result.minCycles, (unsigned)result.medianCycles, (unsigned)result.p99Cycles);
+}
+
+void TestFramework::measureBatch(void (*benchFunc)(), uint32_t iterations, uint32_t& elapsedUs, uint32_t& elapsedCycles) {
+  // 测量一批迭代的耗时 (周期计数器在80MHz下约53秒回绕，单批耗时远小于此)
+  uint32_t startCycles = ESP.getCycleCount();
+  uint32_t startUs = micros();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchFunc();
+  }
+  elapsedCycles = ESP.getCycleCount() - startCycles;
+  elapsedUs = micros() - startUs;
 }
 
 void TestFramework::assertTrue(bool condition, const char* testName, const char* message) {
@@ -107,16 +436,3 @@ void TestFramework::printTestResults() {
     LOG_E("TestFramework", "测试失败! 通过: %d, 失败: %d", passedTests, failedTests);
   }
 }
-
-void TestFramework::addTestItem(TestItem* item) {
-  // 添加测试项到列表
-  if (testList == nullptr) {
-    testList = item;
-  } else {
-    TestItem* current = testList;
-    while (current->next != nullptr) {
-      current = current->next;
-    }
-    current->next = item;
-  }
-}
\ No newline at end of file
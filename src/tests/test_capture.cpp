@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include "file_system.h"
+#include "logger.h"
+#include "test_framework.h"
+#include "traffic_capture.h"
+
+// 流量捕获测试：写入后按顺序读回，以及文件写满后的循环覆盖
+
+#define TEST_CAPTURE_PATH "/test_capture.bin"
+
+static RS485Config testCaptureConfig() {
+  RS485Config config;
+  config.baudRate = 19200;
+  config.dataBits = 8;
+  config.parity = 2;
+  config.stopBits = 1;
+  config.replayTiming = false;
+  return config;
+}
+
+// 第index帧的内容：长度和数据都由序号决定，读回时可以校验
+static uint16_t fillTestFrame(uint32_t index, uint8_t* data) {
+  uint16_t length = 8 + index % 40;
+  for (uint16_t i = 0; i < length; i++) {
+    data[i] = (uint8_t)(index * 31 + i);
+  }
+  return length;
+}
+
+static bool checkTestRecord(const CaptureRecord& record, uint32_t index) {
+  uint8_t expected[RS485_FRAME_BUFFER_SIZE];
+  uint16_t length = fillTestFrame(index, expected);
+  return record.length == length &&
+         record.timestamp == index * 1000 &&
+         record.direction() == (index % 2 == 0 ? CAPTURE_BUS_TO_LINK : CAPTURE_LINK_TO_BUS) &&
+         memcmp(record.data, expected, length) == 0;
+}
+
+TEST(CaptureRoundTrip, "capture") {
+  LOG_I("Test", "开始流量捕获读写测试");
+  ASSERT_TRUE(FILE_SYSTEM.begin());
+
+  TrafficCapture capture;
+  ASSERT_TRUE(capture.begin(FILE_SYSTEM, testCaptureConfig(), CAPTURE_ROLE_SLAVE, TEST_CAPTURE_PATH, 4 * CAPTURE_SEGMENT_SIZE));
+
+  uint8_t data[RS485_FRAME_BUFFER_SIZE];
+  for (uint32_t i = 0; i < 100; i++) {
+    uint16_t length = fillTestFrame(i, data);
+    capture.record(i % 2 == 0 ? CAPTURE_BUS_TO_LINK : CAPTURE_LINK_TO_BUS, data, length, i * 1000);
+    capture.flush();
+  }
+  capture.end();
+  ASSERT_EQUAL(100, (int)capture.getRecordsCaptured());
+  ASSERT_EQUAL(0, (int)capture.getRecordsDropped());
+
+  CaptureReader reader;
+  ASSERT_TRUE(reader.begin(FILE_SYSTEM, TEST_CAPTURE_PATH));
+  ASSERT_EQUAL(19200, (int)reader.getConfig().baudRate);
+  ASSERT_EQUAL(2, (int)reader.getConfig().parity);
+  ASSERT_TRUE(reader.getRole() == CAPTURE_ROLE_SLAVE);
+
+  CaptureRecord record;
+  uint32_t count = 0;
+  bool ordered = true;
+  while (reader.next(record)) {
+    ordered = ordered && checkTestRecord(record, count);
+    count++;
+  }
+  ASSERT_EQUAL(100, (int)count);
+  ASSERT_TRUE(ordered);
+
+  reader.end();
+  FILE_SYSTEM.remove(TEST_CAPTURE_PATH);
+  LOG_I("Test", "流量捕获读写测试完成");
+}
+
+TEST(CaptureWrap, "capture") {
+  LOG_I("Test", "开始流量捕获循环覆盖测试");
+  ASSERT_TRUE(FILE_SYSTEM.begin());
+
+  // 2段的文件写入远超容量的记录，读回的应是最新的一段连续记录
+  TrafficCapture capture;
+  ASSERT_TRUE(capture.begin(FILE_SYSTEM, testCaptureConfig(), CAPTURE_ROLE_MASTER, TEST_CAPTURE_PATH, 2 * CAPTURE_SEGMENT_SIZE));
+
+  uint8_t data[RS485_FRAME_BUFFER_SIZE];
+  const uint32_t total = 1000;
+  for (uint32_t i = 0; i < total; i++) {
+    uint16_t length = fillTestFrame(i, data);
+    capture.record(i % 2 == 0 ? CAPTURE_BUS_TO_LINK : CAPTURE_LINK_TO_BUS, data, length, i * 1000);
+    capture.loop();
+  }
+  capture.end();
+  ASSERT_TRUE(capture.getSegmentsWritten() > 2);
+
+  CaptureReader reader;
+  ASSERT_TRUE(reader.begin(FILE_SYSTEM, TEST_CAPTURE_PATH));
+  ASSERT_EQUAL(2, (int)reader.getSegmentCount());
+
+  CaptureRecord record;
+  uint32_t count = 0;
+  uint32_t first = 0;
+  bool contiguous = true;
+  while (reader.next(record)) {
+    if (count == 0) {
+      first = record.timestamp / 1000;
+    }
+    contiguous = contiguous && checkTestRecord(record, first + count);
+    count++;
+  }
+  ASSERT_TRUE(count > 0);
+  ASSERT_TRUE(contiguous);
+  ASSERT_EQUAL((int)total, (int)(first + count));
+
+  reader.end();
+  FILE_SYSTEM.remove(TEST_CAPTURE_PATH);
+  LOG_I("Test", "流量捕获循环覆盖测试完成");
+}
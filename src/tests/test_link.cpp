@@ -0,0 +1,315 @@
+#include <Arduino.h>
+#include <ESP8266mDNS.h>
+#include "logger.h"
+#include "master_locator.h"
+#include "metrics.h"
+#include "rs485.h"
+#include "rtc_store.h"
+#include "tcp_protocol.h"
+#include "test_framework.h"
+#include "test_loopback.h"
+
+// 主从链路测试：从设备查找主设备时的地址缓存，断开后的会话恢复，字节间隔的传输与重现，聚合发送，以及超长的数据包
+
+#define TEST_MASTER_PORT 18870
+
+TEST(MasterLocator, "wifi link") {
+  LOG_I("Test", "开始主设备地址缓存测试");
+  rtcInvalidate(RTC_MASTER_CACHE_OFFSET);
+  FILE_SYSTEM.remove(MASTER_CACHE_FILE_PATH);
+
+  TcpProtocol master;
+  master.beginServer(TEST_MASTER_PORT);
+  MDNS.begin(DEFAULT_MASTER_HOST);
+  MDNS.addService(MASTER_MDNS_SERVICE, "tcp", TEST_MASTER_PORT);
+
+  // 冷启动，没有缓存：通过mDNS解析地址和端口
+  MasterLocator coldBoot;
+  coldBoot.begin(DEFAULT_MASTER_HOST);
+  coldBoot.loadFileCache(FILE_SYSTEM);
+  ASSERT_TRUE(!coldBoot.hasAddress());
+  uint32_t queries = metrics.get(METRIC_MASTER_MDNS_QUERIES);
+  TcpProtocol slave;
+  slave.setLocator(&coldBoot);
+  slave.beginClient(DEFAULT_MASTER_HOST, DEFAULT_MASTER_TCP_PORT);
+  ASSERT_TRUE(slave.isConnected());
+  ASSERT_EQUAL((int)queries + 1, (int)metrics.get(METRIC_MASTER_MDNS_QUERIES));
+  ASSERT_EQUAL(TEST_MASTER_PORT, coldBoot.getPort());
+  slave.end();
+
+  // 热启动：直接连接RTC中的地址，不查询mDNS
+  uint32_t cacheConnects = metrics.get(METRIC_MASTER_CACHE_CONNECTS);
+  MasterLocator warmBoot;
+  warmBoot.begin(DEFAULT_MASTER_HOST);
+  ASSERT_TRUE(warmBoot.hasAddress());
+  slave.setLocator(&warmBoot);
+  slave.beginClient(DEFAULT_MASTER_HOST, DEFAULT_MASTER_TCP_PORT);
+  ASSERT_TRUE(slave.isConnected());
+  ASSERT_EQUAL((int)queries + 1, (int)metrics.get(METRIC_MASTER_MDNS_QUERIES));
+  ASSERT_EQUAL((int)cacheConnects + 1, (int)metrics.get(METRIC_MASTER_CACHE_CONNECTS));
+  slave.end();
+
+  // 断电后RTC内存丢失：使用文件中的地址
+  rtcInvalidate(RTC_MASTER_CACHE_OFFSET);
+  MasterLocator powerOn;
+  powerOn.begin(DEFAULT_MASTER_HOST);
+  ASSERT_TRUE(!powerOn.hasAddress());
+  powerOn.loadFileCache(FILE_SYSTEM);
+  ASSERT_TRUE(powerOn.hasAddress());
+  ASSERT_EQUAL(TEST_MASTER_PORT, powerOn.getPort());
+
+  // 缓存的地址连续连接失败后才重新解析
+  master.end();
+  slave.setLocator(&powerOn);
+  for (int i = 0; i < MASTER_CACHE_MAX_FAILURES; i++) {
+    slave.beginClient(DEFAULT_MASTER_HOST, DEFAULT_MASTER_TCP_PORT);
+    ASSERT_TRUE(!slave.isConnected());
+  }
+  ASSERT_TRUE(!powerOn.hasAddress());
+  ASSERT_EQUAL((int)queries + 1, (int)metrics.get(METRIC_MASTER_MDNS_QUERIES));
+  slave.beginClient(DEFAULT_MASTER_HOST, DEFAULT_MASTER_TCP_PORT);
+  ASSERT_EQUAL((int)queries + 2, (int)metrics.get(METRIC_MASTER_MDNS_QUERIES));
+
+  slave.end();
+  MDNS.end();
+  rtcInvalidate(RTC_MASTER_CACHE_OFFSET);
+  FILE_SYSTEM.remove(MASTER_CACHE_FILE_PATH);
+  LOG_I("Test", "主设备地址缓存测试完成");
+}
+
+#define TEST_RESUME_PORT 18872
+
+TEST(SessionResume, "wifi link") {
+  LOG_I("Test", "开始会话恢复测试");
+  const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  const uint8_t response[] = {0x01, 0x03, 0x02, 0x12, 0x34, 0xB5, 0x33};
+
+  LinkLoopback link;
+  link.begin(TEST_RESUME_PORT);
+  ASSERT_TRUE(link.slave.isConnected());
+
+  // HELLO交换完成前发送的帧在会话建立后发出
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 1; }));
+  ASSERT_EQUAL(sizeof(request), link.masterFrame.length);
+
+  // 另一个连接替换从设备的连接 (主设备认为从设备重连)，从设备的连接被关闭
+  WiFiClient intruder;
+  ASSERT_TRUE(intruder.connect("127.0.0.1", TEST_RESUME_PORT));
+  ASSERT_TRUE(link.pump(1000, [&]() { return !link.slave.isConnected(); }));
+  intruder.stop();
+
+  // 断线期间两个方向的帧都保存在重传缓冲区中。从设备在上一次连接尝试的TCP_RECONNECT_INTERVAL_MS之后重连，
+  // 与TCP_REPLAY_MAX_AGE_MS相同：断线后立即入队的帧在主机负载下会在重连时刚好过期，因此等待半个重连间隔后再入队
+  link.pump(TCP_RECONNECT_INTERVAL_MS / 2, []() { return false; });
+  ASSERT_TRUE(link.master.sendFrame(response, sizeof(response)));
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+
+  // 从设备重连后恢复会话：两个帧各收到一次，之前已收到的帧不重复
+  ASSERT_TRUE(link.pump(TCP_RECONNECT_INTERVAL_MS * 3,
+                        [&]() { return link.masterFrames == 2 && link.slaveFrames == 1; }));
+  link.pump(TCP_ACK_DELAY_MS * 5, []() { return false; });
+  ASSERT_EQUAL(2, (int)link.masterFrames);
+  ASSERT_EQUAL(1, (int)link.slaveFrames);
+  ASSERT_EQUAL(sizeof(response), link.slaveFrame.length);
+  ASSERT_TRUE(memcmp(response, link.slaveFrame.data, sizeof(response)) == 0);
+  ASSERT_EQUAL(1, (int)link.master.getResumes());
+  ASSERT_EQUAL(1, (int)link.slave.getResumes());
+  ASSERT_EQUAL(0, (int)link.master.getReplayDropped() + (int)link.slave.getReplayDropped());
+
+  // 从设备重新初始化 (相当于重启)：开始新会话，已确认的帧不受影响
+  link.slave.beginClient("127.0.0.1", TEST_RESUME_PORT);
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 3; }));
+  ASSERT_EQUAL(1, (int)link.master.getResumes());
+  ASSERT_EQUAL(0, (int)link.master.getDuplicates() + (int)link.slave.getDuplicates());
+
+  link.end();
+  LOG_I("Test", "会话恢复测试完成");
+}
+
+#define TEST_TIMED_PORT 18873
+#define TEST_TIMED_RUNS 5
+#define TEST_TIMED_SLACK_US 200
+
+// 重复发送同一帧，返回替身记录的前两次写入之间最短的间隔。
+// 计划时间从写入首字节之前开始计算，最短间隔只比计划多出忙等退出和记录的几微秒；
+// 主机上的忙等可能被调度器抢占，只影响个别次的结果
+static uint32_t timedWriteGapUs(RS485& bus, BusStub& stream, const uint8_t* frame, uint16_t length,
+                                const uint8_t* timing, uint8_t timingLength) {
+  uint32_t shortest = UINT32_MAX;
+  for (int i = 0; i < TEST_TIMED_RUNS; i++) {
+    stream.writes = 0;
+    if (!bus.sendFrame(frame, length, timing, timingLength) || stream.writes < 2) {
+      return UINT32_MAX;
+    }
+    shortest = min<uint32_t>(shortest, stream.writeTimes[1] - stream.writeTimes[0]);
+  }
+  return shortest;
+}
+
+TEST(TimedReplay, "wifi link bus serial") {
+  LOG_I("Test", "开始字节间隔重现测试");
+  const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  const uint8_t timing[] = {2, RS485_TIMING_UNITS_PER_CHAR * 2};  // 第2字节之前多出2个字符时间
+
+  // 带间隔记录的帧以DATA_TIMED传输，没有间隔的帧不变
+  LinkLoopback link;
+  link.begin(TEST_TIMED_PORT);
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request), timing, sizeof(timing)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 1; }));
+  ASSERT_EQUAL(sizeof(request), link.masterFrame.length);
+  ASSERT_TRUE(memcmp(request, link.masterFrame.data, sizeof(request)) == 0);
+  ASSERT_EQUAL(sizeof(timing), link.masterFrame.timingLength);
+  ASSERT_TRUE(memcmp(timing, link.masterFrame.timing, sizeof(timing)) == 0);
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 2; }));
+  ASSERT_EQUAL(0, link.masterFrame.timingLength);
+  link.end();
+
+  // 开启定时重现时第二段在首字节写入后 (2个字节 + 2个字符的间隔) 开始
+  RS485Config config = testBusConfig(9600);
+  config.replayTiming = true;
+  BusStub stream;
+  RS485 bus;
+  bus.begin(stream, config);
+  uint32_t planned = bus.getCharTimeUs() * 4;
+  uint32_t actual = timedWriteGapUs(bus, stream, request, sizeof(request), timing, sizeof(timing));
+  ASSERT_EQUAL(2, stream.writes);
+  ASSERT_EQUAL(2, (int)stream.writeSizes[0]);
+  ASSERT_TRUE(actual + 20 >= planned && actual < planned + TEST_TIMED_SLACK_US);
+  ASSERT_EQUAL(TEST_TIMED_RUNS, (int)bus.getTimedFrames());
+
+  // 最长的间隔限制为帧间隔减一个字符时间，接收端不会把帧分开
+  const uint8_t longGap[] = {2, 0xFF};
+  planned = bus.getCharTimeUs() + bus.getFrameGapUs();
+  actual = timedWriteGapUs(bus, stream, request, sizeof(request), longGap, sizeof(longGap));
+  ASSERT_EQUAL(2, stream.writes);
+  ASSERT_TRUE(actual + 20 >= planned && actual < planned + TEST_TIMED_SLACK_US);
+
+  // 1200波特下一个间隔就用完忙等的总时间，之后的字节连续发送
+  const uint8_t longGaps[] = {2, 0xFF, 4, 0xFF};
+  config = testBusConfig(1200);
+  config.replayTiming = true;
+  bus.setConfig(config);
+  planned = bus.getCharTimeUs() * 2 + RS485_TIMING_MAX_TOTAL_US;
+  actual = timedWriteGapUs(bus, stream, request, sizeof(request), longGaps, sizeof(longGaps));
+  ASSERT_EQUAL(2, stream.writes);
+  ASSERT_TRUE(actual + 20 >= planned && actual < planned + TEST_TIMED_SLACK_US);
+
+  // 关闭时连续发送
+  config.replayTiming = false;
+  bus.setConfig(config);
+  stream.writes = 0;
+  ASSERT_TRUE(bus.sendFrame(request, sizeof(request), timing, sizeof(timing)));
+  ASSERT_EQUAL(1, stream.writes);
+  LOG_I("Test", "字节间隔重现测试完成");
+}
+
+#define TEST_BATCH_PORT 18876
+#define TEST_BATCH_BUDGET_US 20000
+
+TEST(LinkBatching, "wifi link") {
+  LOG_I("Test", "开始聚合发送测试");
+  uint8_t request[] = {0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  const uint8_t timing[] = {2, RS485_TIMING_UNITS_PER_CHAR};
+
+  LinkLoopback link;
+  link.begin(TEST_BATCH_PORT);
+  link.slave.setBatchBudgetUs(TEST_BATCH_BUDGET_US);
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 1; }));
+
+  // 稀疏的帧立即发送，不等待
+  delay(50);
+  uint32_t packets = link.slave.getPacketsSent();
+  ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+  ASSERT_EQUAL((int)packets + 1, (int)link.slave.getPacketsSent());
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 2; }));
+
+  // 密集的帧合并发送，对端按顺序逐帧收到，带间隔记录的帧也可以聚合
+  const uint8_t burst = 16;
+  packets = link.slave.getPacketsSent();
+  uint8_t next = 1;
+  bool ordered = true;
+  // 聚合在预算到期后的第一次loop()中发送，即不晚于前一次loop()开始到这一次结束的时间：
+  // 记录相邻两次loop()覆盖的最长时间 (主机上的调度器可能在任意位置抢占测试)
+  uint32_t previousLoopUs = micros();
+  uint32_t maxLoopSpanUs = 0;
+  auto loopSlave = [&]() {
+    uint32_t loopStart = micros();
+    link.slave.loop();
+    maxLoopSpanUs = max<uint32_t>(maxLoopSpanUs, micros() - previousLoopUs);
+    previousLoopUs = loopStart;
+  };
+  for (uint8_t i = 1; i <= burst; i++) {
+    request[0] = i;
+    if (i == burst / 2) {
+      ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request), timing, sizeof(timing)));
+    } else {
+      ASSERT_TRUE(link.slave.sendFrame(request, sizeof(request)));
+    }
+    loopSlave();
+    delayMicroseconds(300);
+  }
+  uint32_t start = millis();
+  while (next <= burst && millis() - start < 1000) {
+    link.master.loop();
+    loopSlave();
+    while (link.master.receiveFrame(link.masterFrame)) {
+      ordered = ordered && link.masterFrame.data[0] == next && link.masterFrame.length == sizeof(request) &&
+                link.masterFrame.timingLength == (next == burst / 2 ? sizeof(timing) : 0);
+      next++;
+    }
+    delay(1);
+  }
+  ASSERT_EQUAL(burst + 1, (int)next);
+  ASSERT_TRUE(ordered);
+  ASSERT_TRUE(link.slave.getPacketsSaved() > 0);
+  ASSERT_EQUAL((int)burst, (int)(link.slave.getPacketsSent() - packets + link.slave.getPacketsSaved()));
+  ASSERT_TRUE(link.slave.getMaxBatchHoldUs() <= TEST_BATCH_BUDGET_US + maxLoopSpanUs);
+  ASSERT_EQUAL(0, (int)link.master.getDuplicates());
+  ASSERT_EQUAL(0, (int)link.master.getProtocolErrors());
+
+  // 主设备逐帧计入待确认，确认发出后两端都空闲
+  ASSERT_TRUE(link.pump(TCP_ACK_DELAY_MS * 5, [&]() { return link.master.isIdle() && link.slave.isIdle(); }));
+
+  link.end();
+  LOG_I("Test", "聚合发送测试完成");
+}
+
+#define TEST_OVERSIZE_PORT 18880
+
+TEST(LinkOversizeFrame, "wifi link") {
+  // 带间隔记录的数据包中帧长超过帧缓冲区：断开连接，不交付，不写出帧缓冲区
+  LinkLoopback link;
+  link.begin(TEST_OVERSIZE_PORT);
+  ASSERT_TRUE(link.connect());
+  uint32_t errors = link.master.getProtocolErrors();
+
+  const uint16_t frameLength = RS485_FRAME_BUFFER_SIZE + 44;
+  static uint8_t packet[TCP_PACKET_HEADER_SIZE + TCP_DATA_HEADER_SIZE + 1 + RS485_FRAME_BUFFER_SIZE + 44];
+  uint16_t payloadLength = TCP_DATA_HEADER_SIZE + 1 + frameLength;
+  memset(packet, 0x55, sizeof(packet));
+  packet[0] = TCP_PACKET_MAGIC;
+  packet[1] = TCP_PACKET_DATA_TIMED;
+  packet[2] = payloadLength & 0xFF;
+  packet[3] = payloadLength >> 8;
+  // 序号0、确认号0，没有间隔记录
+  memset(packet + TCP_PACKET_HEADER_SIZE, 0, TCP_DATA_HEADER_SIZE + 1);
+
+  WiFiClient peer;
+  link.slave.end();
+  ASSERT_TRUE(link.pump(1000, [&]() { return !link.master.isConnected(); }));
+  ASSERT_TRUE(peer.connect("127.0.0.1", TEST_OVERSIZE_PORT));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.master.isConnected(); }));
+  ASSERT_EQUAL(sizeof(packet), peer.write(packet, sizeof(packet)));
+
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.master.getProtocolErrors() != errors; }));
+  ASSERT_EQUAL((int)errors + 1, (int)link.master.getProtocolErrors());
+  ASSERT_EQUAL(0, (int)link.masterFrames);
+  ASSERT_TRUE(!link.master.isConnected());
+
+  peer.stop();
+  link.end();
+}
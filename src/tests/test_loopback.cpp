@@ -0,0 +1,67 @@
+#include "test_loopback.h"
+
+// 会话握手 (HELLO交换) 所需的时间
+#define TEST_LINK_HANDSHAKE_MS 50
+
+void BusStub::inject(const uint8_t* data, uint8_t length) {
+  length = min<uint8_t>(length, TEST_BUS_RX_SIZE);
+  memcpy(rx, data, length);
+  rxLength = length;
+  rxIndex = 0;
+}
+
+size_t BusStub::write(const uint8_t* buffer, size_t size) {
+  if (writes < TEST_BUS_RECORDED_WRITES) {
+    writeTimes[writes] = micros();
+    writeSizes[writes] = size;
+    writeAddresses[writes] = buffer[0];
+  }
+  writes++;
+  return size;
+}
+
+void LinkLoopback::begin(uint16_t port) {
+  masterFrames = 0;
+  slaveFrames = 0;
+  master.beginServer(port);
+  slave.beginClient("127.0.0.1", port);
+}
+
+bool LinkLoopback::connect(uint32_t timeoutMs) {
+  if (!pump(timeoutMs, [&]() { return master.isConnected() && slave.isConnected(); })) {
+    return false;
+  }
+  // 主设备只在接收时处理从设备的HELLO
+  pump(TEST_LINK_HANDSHAKE_MS, []() { return false; });
+  return master.isConnected() && slave.isConnected();
+}
+
+void LinkLoopback::end() {
+  slave.end();
+  master.end();
+}
+
+void LinkLoopback::step() {
+  master.loop();
+  slave.loop();
+  if (masterRouter != nullptr) {
+    masterRouter->loop();
+  } else if (master.receiveFrame(masterFrame)) {
+    masterFrames++;
+  }
+  if (slaveRouter != nullptr) {
+    slaveRouter->loop();
+  } else if (slave.receiveFrame(slaveFrame)) {
+    slaveFrames++;
+  }
+}
+
+RS485Config testBusConfig(uint32_t baudRate) {
+  RS485Config config;
+  config.baudRate = baudRate;
+  config.dataBits = 8;
+  config.parity = 0;
+  config.stopBits = 1;
+  config.replayTiming = false;
+  return config;
+}
@@ -0,0 +1,76 @@
+#ifndef TEST_LOOPBACK_H
+#define TEST_LOOPBACK_H
+
+#include <Arduino.h>
+#include "data_router.h"
+#include "rs485.h"
+#include "tcp_protocol.h"
+
+// 测试和基准测试共用的替身：本机主从链路和总线
+
+#define TEST_BUS_RECORDED_WRITES 4
+#define TEST_BUS_RX_SIZE 32
+
+// 总线替身：记录前几次写入的时间、长度和首字节 (从站地址)，inject()的字节作为总线上收到的数据
+class BusStub : public Stream {
+public:
+  uint32_t writeTimes[TEST_BUS_RECORDED_WRITES];
+  size_t writeSizes[TEST_BUS_RECORDED_WRITES];
+  uint8_t writeAddresses[TEST_BUS_RECORDED_WRITES];
+  uint32_t writes = 0;
+
+  void inject(const uint8_t* data, uint8_t length);
+
+  int available() override { return rxLength - rxIndex; }
+  int read() override { return rxIndex < rxLength ? rx[rxIndex++] : -1; }
+  int peek() override { return rxIndex < rxLength ? rx[rxIndex] : -1; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+private:
+  uint8_t rx[TEST_BUS_RX_SIZE];
+  uint8_t rxLength = 0;
+  uint8_t rxIndex = 0;
+};
+
+// 本机主从链路：主设备在指定端口监听，从设备连接127.0.0.1。
+// 设置了转发器的一端由转发器取走收到的帧，否则收到的帧保存在masterFrame/slaveFrame中并计数
+class LinkLoopback {
+public:
+  TcpProtocol master;
+  TcpProtocol slave;
+  DataRouter* masterRouter = nullptr;
+  DataRouter* slaveRouter = nullptr;
+  RS485Frame masterFrame;
+  RS485Frame slaveFrame;
+  uint32_t masterFrames = 0;
+  uint32_t slaveFrames = 0;
+
+  // 开始监听和连接，不等待握手
+  void begin(uint16_t port);
+
+  // 等待连接和会话握手完成
+  bool connect(uint32_t timeoutMs = 1000);
+
+  void end();
+
+  // 运行一次两端的loop()和转发器，接收到达的帧
+  void step();
+
+  // 反复运行step()直到条件成立或超时
+  template <typename Condition>
+  bool pump(uint32_t timeoutMs, Condition done) {
+    uint32_t start = millis();
+    while (!done() && millis() - start < timeoutMs) {
+      step();
+      delayMicroseconds(100);
+    }
+    return done();
+  }
+};
+
+// 测试用的总线参数 (8N1，不记录字节间隔)
+RS485Config testBusConfig(uint32_t baudRate);
+
+#endif // TEST_LOOPBACK_H
@@ -0,0 +1,284 @@
+#include <Arduino.h>
+#include "frame_trace.h"
+#include "logger.h"
+#include "modbus.h"
+#include "ota_updater.h"
+#include "rs485.h"
+#include "scheduler.h"
+#include "test_framework.h"
+#include "test_loopback.h"
+
+// 固件升级测试：口令认证，MD5校验失败时不提交，校验通过后提交，以及升级期间的转发和总线组帧
+
+#define TEST_OTA_PORT 18874
+#define TEST_OTA_LINK_PORT 18875
+#define TEST_OTA_IMAGE_SIZE (FLASH_SECTOR_SIZE + OTA_PAGE_SIZE + 37)  // 跨扇区，最后一页不完整
+#define TEST_OTA_PASSWORD "test-ota"
+
+// 读取设备发送的一行，等待期间运行升级的时间片
+static String readOtaReply(OtaUpdater& updater, WiFiClient& sender) {
+  String reply;
+  uint32_t start = millis();
+  while (millis() - start < 1000) {
+    updater.loop();
+    while (sender.available() > 0) {
+      char c = (char)sender.read();
+      if (c == '\n') {
+        return reply;
+      }
+      reply += c;
+    }
+    delay(1);
+  }
+  return reply;
+}
+
+// 读取挑战并发送升级头部，认证码用password计算；declaredSize不为0时头部声明该大小 (MD5仍按映像计算)
+static bool sendOtaHeader(OtaUpdater& updater, WiFiClient& sender, const uint8_t* image, uint32_t size,
+                          const char* password, bool corruptMd5, uint32_t declaredSize = 0) {
+  String challenge = readOtaReply(updater, sender);
+  if (!challenge.startsWith("AUTH ") || challenge.length() != 5 + OTA_NONCE_SIZE * 2) {
+    return false;
+  }
+  uint8_t message[OTA_NONCE_SIZE + 16];
+  for (uint8_t i = 0; i < OTA_NONCE_SIZE; i++) {
+    char hex[3] = {challenge[5 + i * 2], challenge[6 + i * 2], 0};
+    message[i] = (uint8_t)strtoul(hex, nullptr, 16);
+  }
+
+  uint8_t header[OTA_HEADER_SIZE];
+  memcpy(header, OTA_MAGIC, 4);
+  uint32_t headerSize = declaredSize ? declaredSize : size;
+  for (int i = 0; i < 4; i++) {
+    header[4 + i] = (uint8_t)(headerSize >> (8 * i));
+  }
+  MD5Builder md5;
+  md5.begin();
+  md5.add(image, size);
+  md5.calculate();
+  md5.getBytes(header + 8);
+  if (corruptMd5) {
+    header[8] ^= 0xFF;
+  }
+  memcpy(message + OTA_NONCE_SIZE, header + 8, 16);
+  OtaUpdater::hmacMd5(password, message, sizeof(message), header + 24);
+  sender.write(header, sizeof(header));
+  return true;
+}
+
+// 发送升级头部和映像
+static bool sendOtaImage(OtaUpdater& updater, WiFiClient& sender, const uint8_t* image, uint32_t size,
+                         bool corruptMd5) {
+  if (!sendOtaHeader(updater, sender, image, size, TEST_OTA_PASSWORD, corruptMd5)) {
+    return false;
+  }
+  sender.write(image, size);
+  return true;
+}
+
+static String toHex(const uint8_t* data, size_t length) {
+  String hex;
+  char digits[3];
+  for (size_t i = 0; i < length; i++) {
+    sprintf(digits, "%02x", data[i]);
+    hex += digits;
+  }
+  return hex;
+}
+
+// 升级期间的转发：中继任务每5ms经主从链路发送一帧并记录时延
+struct OtaRelayState {
+  OtaUpdater* updater;
+  LinkLoopback* link;
+  uint32_t sentAt;
+  uint32_t maxLatencyMs;
+  uint32_t relayed;
+  uint32_t webRuns;
+  bool inFlight;
+};
+
+static void otaRelayTask(void* context) {
+  const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  OtaRelayState& state = *(OtaRelayState*)context;
+  if (!state.inFlight && millis() - state.sentAt >= 5 && state.link->slave.sendFrame(request, sizeof(request))) {
+    state.sentAt = millis();
+    state.inFlight = true;
+  }
+  uint32_t received = state.link->masterFrames;
+  state.link->step();
+  if (state.link->masterFrames != received) {
+    state.maxLatencyMs = max<uint32_t>(state.maxLatencyMs, millis() - state.sentAt);
+    state.inFlight = false;
+    state.relayed++;
+  }
+}
+
+static void otaWebTask(void* context) {
+  ((OtaRelayState*)context)->webRuns++;
+}
+
+static void otaSliceTask(void* context) {
+  ((OtaRelayState*)context)->updater->loop();
+}
+
+// 按main.cpp的任务表经调度器运行升级直到结束：每次循环都到期的高优先级任务 (web) 排在升级任务之前。
+// 返回转发的最大时延 (ms)
+static uint32_t runOtaWithRelay(OtaUpdater& updater, LinkLoopback& link, uint32_t& relayed) {
+  OtaRelayState state = {&updater, &link, 0, 0, 0, 0, false};
+  Scheduler scheduler;
+  scheduler.addTask("relay", otaRelayTask, &state, TASK_PRIORITY_REALTIME);
+  scheduler.addTask("web", otaWebTask, &state, TASK_PRIORITY_HIGH, 0, 2000);
+  scheduler.addTask("ota", otaSliceTask, &state, TASK_PRIORITY_NORMAL, 0, OTA_SLICE_BUDGET_US);
+  uint32_t finished = updater.getUpdates() + updater.getFailures();
+  uint32_t start = millis();
+  while (updater.getUpdates() + updater.getFailures() == finished && millis() - start < 5000) {
+    scheduler.loop();
+  }
+  relayed += state.relayed;
+  LOG_I("Test", "调度循环 %u 次: web %u 次, ota %u 次", scheduler.getLoops(), state.webRuns,
+        scheduler.getTask(2).runs);
+  return state.maxLatencyMs;
+}
+
+TEST(OtaUpdate, "wifi ota serial") {
+  LOG_I("Test", "开始固件升级测试");
+  static uint8_t image[TEST_OTA_IMAGE_SIZE];
+  for (uint32_t i = 0; i < sizeof(image); i++) {
+    image[i] = (uint8_t)(i * 7 + 3);
+  }
+  image[0] = 0xE9;
+
+  // HMAC-MD5与RFC 2202的测试向量一致 (包括超过一个块的密钥)
+  uint8_t digest[16];
+  const char* message = "what do ya want for nothing?";
+  OtaUpdater::hmacMd5("Jefe", (const uint8_t*)message, strlen(message), digest);
+  ASSERT_STRING_EQUAL("750c783e6ab0b503eaa86e310a5db738", toHex(digest, sizeof(digest)).c_str());
+  String longKey;
+  for (int i = 0; i < 80; i++) {
+    longKey += (char)0xAA;
+  }
+  message = "Test Using Larger Than Block-Size Key - Hash Key First";
+  OtaUpdater::hmacMd5(longKey, (const uint8_t*)message, strlen(message), digest);
+  ASSERT_STRING_EQUAL("6b1ab7fe4bd7bf8f0b62e6ce61b9d0cd", toHex(digest, sizeof(digest)).c_str());
+
+  // 没有口令时不监听升级端口
+  OtaUpdater updater;
+  WiFiClient sender;
+  ASSERT_TRUE(!updater.begin(TEST_OTA_PORT, ""));
+  ASSERT_TRUE(!sender.connect("127.0.0.1", TEST_OTA_PORT));
+
+  LinkLoopback link;
+  ASSERT_TRUE(updater.begin(TEST_OTA_PORT, TEST_OTA_PASSWORD));
+  link.begin(TEST_OTA_LINK_PORT);
+
+  // 口令错误：在擦除闪存之前拒绝
+  uint32_t relayed = 0;
+  ASSERT_TRUE(sender.connect("127.0.0.1", TEST_OTA_PORT));
+  ASSERT_TRUE(sendOtaHeader(updater, sender, image, sizeof(image), "wrong", false));
+  ASSERT_STRING_EQUAL("ERR auth", readOtaReply(updater, sender).c_str());
+  ASSERT_EQUAL(OTA_FAILED, updater.getState());
+  ASSERT_STRING_EQUAL("auth", updater.getLastError());
+  ASSERT_EQUAL(0, (int)updater.getBytesWritten());
+  sender.stop();
+
+  // 超出空闲区域的大小 (按扇区取整会回绕) 在擦除之前拒绝
+  ASSERT_TRUE(sender.connect("127.0.0.1", TEST_OTA_PORT));
+  ASSERT_TRUE(sendOtaHeader(updater, sender, image, sizeof(image), TEST_OTA_PASSWORD, false, 0xFFFFFFFF));
+  ASSERT_STRING_EQUAL("ERR no space", readOtaReply(updater, sender).c_str());
+  ASSERT_EQUAL(OTA_FAILED, updater.getState());
+  ASSERT_STRING_EQUAL("no space", updater.getLastError());
+  ASSERT_EQUAL(0, (int)updater.getBytesWritten());
+  sender.stop();
+
+  // MD5不一致：映像写完后读回校验失败，不提交
+  ASSERT_TRUE(sender.connect("127.0.0.1", TEST_OTA_PORT));
+  ASSERT_TRUE(sendOtaImage(updater, sender, image, sizeof(image), true));
+  runOtaWithRelay(updater, link, relayed);
+  ASSERT_EQUAL(OTA_FAILED, updater.getState());
+  ASSERT_STRING_EQUAL("md5 mismatch", updater.getLastError());
+  ASSERT_STRING_EQUAL("ERR md5 mismatch", readOtaReply(updater, sender).c_str());
+  ASSERT_EQUAL(sizeof(image), updater.getBytesWritten());
+  sender.stop();
+
+#ifdef WIFLY485_NATIVE
+  // 校验通过后提交 (设备上会在重启时安装映像，只在本机构建中运行)
+  // 每个时间片最多一次闪存操作：擦除2个扇区，写入和读回各18页
+  uint32_t slices = frameTrace.getCount(TRACE_OTA_SLICE);
+  relayed = 0;
+  ASSERT_TRUE(sender.connect("127.0.0.1", TEST_OTA_PORT));
+  ASSERT_TRUE(sendOtaImage(updater, sender, image, sizeof(image), false));
+  uint32_t maxLatencyMs = runOtaWithRelay(updater, link, relayed);
+  ASSERT_EQUAL(OTA_DONE, updater.getState());
+  ASSERT_STRING_EQUAL("OK", readOtaReply(updater, sender).c_str());
+  ASSERT_TRUE(frameTrace.getCount(TRACE_OTA_SLICE) - slices >= 2 + 18 * 2);
+  static uint32_t flash[(TEST_OTA_IMAGE_SIZE + 3) / 4];
+  ASSERT_TRUE(ESP.flashRead(updater.getRegionStart(), flash, sizeof(flash)));
+  ASSERT_TRUE(memcmp(image, flash, sizeof(image)) == 0);
+
+  // 升级期间转发不中断
+  ASSERT_TRUE(relayed > 0);
+  ASSERT_TRUE(maxLatencyMs < 100);
+  sender.stop();
+#endif
+
+  link.end();
+  updater.end();
+  LOG_I("Test", "固件升级测试完成");
+}
+
+// 升级的时间片阻塞主循环超过一个帧间隔时，串口缓冲区中连在一起的帧按CRC分开
+TEST(BusBacklog, "ota bus") {
+  const uint8_t request[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x01, 0x84, 0x0A};
+  uint8_t response[7] = {0x01, 0x03, 0x02, 0x12, 0x34};
+  modbusAppendCrc(response, 5);
+  const uint8_t noise[] = {0x55, 0xAA, 0x55};
+  uint8_t burst[sizeof(request) + sizeof(response) + sizeof(noise)];
+  memcpy(burst, request, sizeof(request));
+  memcpy(burst + sizeof(request), response, sizeof(response));
+  memcpy(burst + sizeof(request) + sizeof(response), noise, sizeof(noise));
+
+  ASSERT_EQUAL(sizeof(request), modbusFrameLength(burst, sizeof(burst)));
+  ASSERT_EQUAL(sizeof(response), modbusFrameLength(response, sizeof(response)));
+  ASSERT_EQUAL(0, modbusFrameLength(noise, sizeof(noise)));
+
+  BusStub stream;
+  RS485 bus;
+  RS485Frame frame;
+  bus.begin(stream, testBusConfig(115200));
+  uint32_t gapUs = bus.getFrameGapUs();
+
+  // 按时读取：连续到达的字节是一帧，不检查内容
+  ASSERT_TRUE(!bus.poll());
+  stream.inject(burst, sizeof(request) + sizeof(response));
+  ASSERT_TRUE(!bus.poll());
+  delayMicroseconds(gapUs + 200);
+  ASSERT_TRUE(bus.poll() && bus.readFrame(frame));
+  ASSERT_EQUAL(sizeof(request) + sizeof(response), frame.length);
+
+  // 积压的单个完整帧不分开
+  delayMicroseconds(gapUs + 200);
+  stream.inject(response, sizeof(response));
+  bus.poll();
+  delayMicroseconds(gapUs + 200);
+  ASSERT_TRUE(bus.poll() && bus.readFrame(frame));
+  ASSERT_EQUAL(sizeof(response), frame.length);
+  ASSERT_EQUAL(0, (int)bus.getSplitFrames());
+
+  // 积压的多帧按CRC分开，末尾CRC不正确的字节单独作为一帧
+  delayMicroseconds(gapUs + 200);
+  stream.inject(burst, sizeof(burst));
+  bus.poll();
+  delayMicroseconds(gapUs + 200);
+  ASSERT_TRUE(bus.poll() && bus.readFrame(frame));
+  ASSERT_EQUAL(sizeof(request), frame.length);
+  ASSERT_TRUE(memcmp(request, frame.data, sizeof(request)) == 0);
+  ASSERT_TRUE(bus.poll() && bus.readFrame(frame));
+  ASSERT_EQUAL(sizeof(response), frame.length);
+  ASSERT_TRUE(memcmp(response, frame.data, sizeof(response)) == 0);
+  ASSERT_TRUE(bus.poll() && bus.readFrame(frame));
+  ASSERT_EQUAL(sizeof(noise), frame.length);
+  ASSERT_TRUE(!bus.poll());
+  ASSERT_TRUE(bus.isBusIdle());
+  ASSERT_EQUAL(2, (int)bus.getSplitFrames());
+  ASSERT_EQUAL(5, (int)bus.getRxFrames());
+}
@@ -0,0 +1,286 @@
+#include <Arduino.h>
+#include "config_manager.h"
+#include "data_router.h"
+#include "logger.h"
+#include "test_framework.h"
+#include "traffic_capture.h"
+#include "frame_trace.h"
+#include "metrics.h"
+#include "modbus.h"
+#include "rs485.h"
+#include "scheduler.h"
+#include "status_events.h"
+#include "tcp_protocol.h"
+#include "test_loopback.h"
+
+// 性能基准测试 (目标15)
+// 结果以JSON行输出，可用 grep '^{"type":"benchmark"' 提取后在不同固件版本之间比较
+
+// 纳秒级的操作每次迭代重复BENCH_BATCH次，中位数在微秒量级：
+// 单次耗时接近计时分辨率时，主机调度的噪声就会超出回归检查 (tools/perf_gate.py) 的容差
+#define BENCH_BATCH 1000
+
+// 基准测试使用独立的配置管理器实例，只操作内存中的配置，不访问文件系统
+static ConfigManager benchConfigManager;
+
+// 文件系统基准测试：挂载、配置原子写入和加载的耗时，分别在SPIFFS ([env:test]) 和
+// LittleFS ([env:test_littlefs]) 构建中运行后比较
+static ConfigManager benchFsConfigManager;
+
+// 流量捕获基准测试使用的捕获文件 (运行基准测试期间存在)
+#define BENCH_CAPTURE_PATH "/bench_capture.bin"
+static TrafficCapture benchCapture;
+static bool benchCaptureStarted = false;
+
+BENCHMARK(FsMount, "fs") {
+  FILE_SYSTEM.end();
+  bool mounted = FILE_SYSTEM.begin();
+  BENCH_KEEP(mounted);
+}
+
+BENCHMARK(ConfigSave, "fs config") {
+  // 每次修改一个字段，保证真正写入 (内容不变时saveConfig不写闪存)
+  static uint16_t syncPort = DEFAULT_SYNC_PORT;
+  DeviceConfig deviceConfig = benchFsConfigManager.getDeviceConfig();
+  deviceConfig.syncPort = ++syncPort;
+  benchFsConfigManager.setDeviceConfig(deviceConfig);
+  bool saved = benchFsConfigManager.saveConfig();
+  BENCH_KEEP(saved);
+}
+
+BENCHMARK(ConfigLoad, "fs config") {
+  bool loaded = benchFsConfigManager.loadConfig();
+  BENCH_KEEP(loaded);
+}
+
+BENCHMARK(ConfigValidate, "config") {
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    bool valid = benchConfigManager.validateConfig();
+    BENCH_KEEP(valid);
+  }
+}
+
+BENCHMARK(ConfigToJson, "config") {
+  DynamicJsonDocument doc(1024);
+  benchConfigManager.toJson(doc);
+  BENCH_KEEP(doc);
+}
+
+BENCHMARK(ConfigGenerateDefault, "config") {
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    benchConfigManager.generateDefaultConfig();
+  }
+}
+
+BENCHMARK(ConfigGetRS485, "config") {
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    RS485Config rs485Config = benchConfigManager.getRS485Config();
+    BENCH_KEEP(rs485Config);
+  }
+}
+
+BENCHMARK(LoggerFiltered, "logger") {
+  // 低于当前日志级别的日志应尽早返回，这是热路径上最常见的情况
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    LOG_V("Bench", "filtered %d", i);
+  }
+}
+
+BENCHMARK(CaptureRecord, "fs capture") {
+  // 转发路径上的捕获开销：记录一帧，并按路由器的方式在阈值后批量写入文件 (均摊)
+  static const uint8_t frame[] = {0x01, 0x03, 0x00, 0x10, 0x00, 0x0A, 0xC4, 0x09};
+  // 在文件系统基准测试之后打开捕获文件 (FsMount会重新挂载文件系统)
+  if (!benchCaptureStarted) {
+    benchCaptureStarted = benchCapture.begin(FILE_SYSTEM, benchConfigManager.getRS485Config(), CAPTURE_ROLE_MASTER,
+                                             BENCH_CAPTURE_PATH);
+  }
+  benchCapture.record(CAPTURE_BUS_TO_LINK, frame, sizeof(frame), micros());
+  benchCapture.loop();
+}
+
+#ifdef WIFLY485_TRACE
+BENCHMARK(TraceFrame, "trace") {
+  // 一帧在一个方向上的全部追踪开销：3次时间戳和3个阶段的记录
+  uint32_t t0 = TRACE_NOW();
+  uint32_t t1 = TRACE_NOW();
+  TRACE_STAGE(TRACE_UART_RX, t1 - t0);
+  TRACE_STAGE(TRACE_FRAMING, t1 - t0 + 1750);
+  uint32_t t2 = TRACE_NOW();
+  TRACE_STAGE(TRACE_TCP_SEND, t2 - t1);
+}
+#endif
+
+// 丢弃输出只统计字节数，用于测量导出格式化本身的开销
+class BenchNullPrint : public Print {
+public:
+  size_t write(uint8_t /* c */) override { bytes++; return 1; }
+  size_t write(const uint8_t* /* buffer */, size_t size) override { bytes += size; return size; }
+  uint32_t bytes = 0;
+};
+
+BENCHMARK(MetricsPrometheus, "metrics") {
+  // /metrics 的格式化开销 (不含网络发送)
+  BenchNullPrint out;
+  metrics.writePrometheus(out);
+  BENCH_KEEP(out.bytes);
+}
+
+BENCHMARK(MetricsIncrement, "metrics") {
+  METRIC_INC(METRIC_BUS_RX_BYTES);
+}
+
+BENCHMARK(ModbusCrc, "crc") {
+  // 转发路径对每个总线帧检查一次CRC (只统计错误)
+  static const uint8_t frame[] = {0x01, 0x03, 0x00, 0x10, 0x00, 0x0A, 0xC4, 0x09};
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    bool valid = modbusCheckCrc(frame, sizeof(frame));
+    BENCH_KEEP(valid);
+  }
+}
+
+// 中继路径：总线替身丢弃写入的数据，没有接收数据
+class BenchNullStream : public Stream {
+public:
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t /* c */) override { return 1; }
+  size_t write(const uint8_t* /* buffer */, size_t size) override { return size; }
+  using Print::write;
+};
+
+static BenchNullStream benchBusStream;
+static RS485 benchBus;
+static TcpProtocol benchLink;
+static DataRouter benchRouter;
+static bool benchRelayStarted = false;
+
+static void beginBenchRelay() {
+  if (benchRelayStarted) {
+    return;
+  }
+  // 链路不连接：接收端立即返回
+  RS485Config config = benchConfigManager.getRS485Config();
+  config.replayTiming = false;
+  benchBus.begin(benchBusStream, config);
+  benchRouter.begin(&benchBus, &benchLink);
+  benchRelayStarted = true;
+}
+
+BENCHMARK(RelayBusSend, "relay") {
+  // 一帧从链路写到总线：方向切换、写入和计数 (不含线路上的发送时间)
+  static const uint8_t frame[] = {0x01, 0x03, 0x00, 0x10, 0x00, 0x0A, 0xC4, 0x09};
+  beginBenchRelay();
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    bool sent = benchBus.sendFrame(frame, sizeof(frame));
+    BENCH_KEEP(sent);
+  }
+}
+
+BENCHMARK(RelayLoopIdle, "relay") {
+  // 每次主循环的转发开销：总线和链路都没有数据
+  beginBenchRelay();
+  for (int i = 0; i < BENCH_BATCH; i++) {
+    benchRouter.loop();
+  }
+}
+
+// 端到端转发：从设备总线 → DataRouter → TcpProtocol (本机回环连接) → DataRouter → 主设备总线
+#define BENCH_RELAY_PORT 18879
+#define BENCH_RELAY_TIMEOUT_MS 100
+
+static BusStub benchSlaveStream;
+static BusStub benchMasterStream;
+static RS485 benchSlaveBus;
+static RS485 benchMasterBus;
+static DataRouter benchSlaveRouter;
+static DataRouter benchMasterRouter;
+static LinkLoopback benchRelayLink;
+static bool benchRelayLinkStarted = false;
+
+static bool beginBenchRelayLink() {
+  if (benchRelayLinkStarted) {
+    return true;
+  }
+  benchSlaveBus.begin(benchSlaveStream, testBusConfig(115200));
+  benchMasterBus.begin(benchMasterStream, testBusConfig(115200));
+  benchSlaveRouter.begin(&benchSlaveBus, &benchRelayLink.slave);
+  benchMasterRouter.begin(&benchMasterBus, &benchRelayLink.master);
+  benchRelayLink.slaveRouter = &benchSlaveRouter;
+  benchRelayLink.masterRouter = &benchMasterRouter;
+  benchRelayLink.begin(BENCH_RELAY_PORT);
+  benchRelayLinkStarted = benchRelayLink.connect();
+  return benchRelayLinkStarted;
+}
+
+BENCHMARK(RelayEndToEnd, "relay") {
+  // 一帧从进入从设备的总线到写入主设备的总线，包括组帧等待的一个帧间隔 (115200下1750us)
+  static const uint8_t frame[] = {0x01, 0x03, 0x00, 0x10, 0x00, 0x0A, 0xC4, 0x09};
+  if (!beginBenchRelayLink()) {
+    return;
+  }
+  uint32_t writes = benchMasterStream.writes;
+  uint32_t start = millis();
+  benchSlaveStream.inject(frame, sizeof(frame));
+  while (benchMasterStream.writes == writes && millis() - start < BENCH_RELAY_TIMEOUT_MS) {
+    benchRelayLink.step();
+  }
+  BENCH_KEEP(benchMasterStream.writes);
+}
+
+// 调度器开销：一个实时任务和三个未到期的后台任务
+static Scheduler benchScheduler;
+static uint32_t benchTaskRuns = 0;
+
+static void benchTask(void* /* context */) {
+  benchTaskRuns++;
+}
+
+BENCHMARK(SchedulerLoop, "scheduler") {
+  if (benchScheduler.getTaskCount() == 0) {
+    benchScheduler.addTask("relay", benchTask, nullptr, TASK_PRIORITY_REALTIME);
+    benchScheduler.addTask("web", benchTask, nullptr, TASK_PRIORITY_HIGH, 60000);
+    benchScheduler.addTask("mdns", benchTask, nullptr, TASK_PRIORITY_NORMAL, 60000);
+    benchScheduler.addTask("stats", benchTask, nullptr, TASK_PRIORITY_LOW, 60000);
+  }
+  benchScheduler.loop();
+  BENCH_KEEP(benchTaskRuns);
+}
+
+// 状态推送：两个字段变化的增量事件
+BENCHMARK(StatusEventDelta, "web") {
+  static StatusSnapshot previous = {};
+  static StatusSnapshot current = {};
+  static char buffer[WEB_EVENT_BUFFER_SIZE];
+  current.values[STATUS_BUS_RX_BPS]++;
+  current.values[STATUS_LINK_TX_BPS]++;
+  size_t length = StatusEvents::formatDelta(current, &previous, buffer, sizeof(buffer));
+  previous = current;
+  BENCH_KEEP(length);
+}
+
+// 运行匹配过滤条件的性能基准测试
+void runPerformanceBenchmarks(const char* filter) {
+  // 基准测试期间降低日志级别，避免串口输出干扰计时
+  LogLevel savedLevel = logger.getLogLevel();
+  logger.setLogLevel(LOG_LEVEL_WARN);
+  
+  FILE_SYSTEM.begin();
+  
+  testFramework.runAllBenchmarks(filter);
+  
+  benchCapture.end();
+  benchCaptureStarted = false;
+  if (benchRelayLinkStarted) {
+    benchRelayLink.end();
+    benchRelayLinkStarted = false;
+  }
+  FILE_SYSTEM.remove(BENCH_CAPTURE_PATH);
+  benchFsConfigManager.deleteConfigFile();
+  // 基准测试写入的计数和追踪样本不代表真实流量
+  metrics.reset();
+#ifdef WIFLY485_TRACE
+  frameTrace.reset();
+#endif
+  logger.setLogLevel(savedLevel);
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "frame_trace.h"
+#include "logger.h"
+#include "power_manager.h"
+#include "test_framework.h"
+
+// 省电模式测试：监听间隔和浅睡眠的时延上限，以及总线起始位唤醒
+
+TEST(PowerManager, "wifi power serial") {
+  LOG_I("Test", "开始省电模式测试");
+  PowerManager power;
+
+  // 监听间隔按时延上限计算；上限不足一个信标间隔时射频不睡眠
+  power.begin("modem", POWER_BEACON_INTERVAL_MS * 3 + 10);
+  ASSERT_EQUAL(POWER_MODE_MODEM, power.getMode());
+  ASSERT_EQUAL(3, power.getListenInterval());
+  ASSERT_EQUAL(WIFI_MODEM_SLEEP, WiFi.getSleepMode());
+  power.begin("light", POWER_BEACON_INTERVAL_MS / 2);
+  ASSERT_EQUAL(POWER_MODE_NONE, power.getMode());
+  ASSERT_EQUAL(WIFI_NONE_SLEEP, WiFi.getSleepMode());
+  power.begin("light", 60000);
+  ASSERT_EQUAL(POWER_MAX_LISTEN_INTERVAL, power.getListenInterval());
+
+  // 浅睡眠：刚转发过帧时不睡眠，空闲时最长睡眠到时延上限
+#ifdef WIFLY485_NATIVE
+  digitalWrite(RS485_RX_PIN, HIGH);  // UART空闲电平
+#endif
+  power.begin("light", POWER_BEACON_INTERVAL_MS + 20);
+  ASSERT_EQUAL(WIFI_LIGHT_SLEEP, WiFi.getSleepMode());
+  uint32_t start = millis();
+  power.idle(millis(), 1000);
+  ASSERT_EQUAL(0, (int)power.getSleeps());
+  power.idle(millis() - POWER_IDLE_HOLD_MS, 1000);
+  uint32_t elapsed = millis() - start;
+  ASSERT_EQUAL(1, (int)power.getSleeps());
+  ASSERT_TRUE(elapsed >= POWER_BEACON_INTERVAL_MS && elapsed <= POWER_BEACON_INTERVAL_MS + 20 + 50);
+
+  // 下一个定时任务先到期时只睡眠到任务到期
+  start = millis();
+  power.idle(millis() - POWER_IDLE_HOLD_MS, 10);
+  ASSERT_TRUE(millis() - start < 50);
+
+#ifdef WIFLY485_NATIVE
+  // 总线起始位 (RX低电平) 立即结束睡眠，记录唤醒时延
+  uint32_t wakes = frameTrace.getCount(TRACE_WAKE);
+  digitalWrite(RS485_RX_PIN, LOW);
+  start = millis();
+  power.idle(millis() - POWER_IDLE_HOLD_MS, 1000);
+  digitalWrite(RS485_RX_PIN, HIGH);
+  ASSERT_TRUE(millis() - start < 50);
+  ASSERT_EQUAL(1, (int)power.getUartWakes());
+  ASSERT_EQUAL((int)wakes + 1, (int)frameTrace.getCount(TRACE_WAKE));
+#endif
+
+  power.begin(DEFAULT_POWER_MODE, DEFAULT_MAX_WAKE_LATENCY_MS);
+  LOG_I("Test", "省电模式测试完成");
+}
@@ -0,0 +1,198 @@
+#include <Arduino.h>
+#include "data_router.h"
+#include "logger.h"
+#include "metrics.h"
+#include "modbus.h"
+#include "response_timeout.h"
+#include "rs485.h"
+#include "test_framework.h"
+#include "test_loopback.h"
+
+// 转发测试：从设备的应答等待，以及链路→总线的优先级队列
+
+#define TEST_RESPONSE_PORT 18877
+
+TEST(ResponseTimeout, "wifi link bus") {
+  LOG_I("Test", "开始应答等待测试");
+  RS485Config config = testBusConfig(115200);
+
+  // 没有样本时使用初始值，稳定的应答收敛到 SRTT + 下限
+  ResponseTimeouts timeouts;
+  timeouts.begin(config);
+  uint32_t floorUs = RS485::calcFrameGapUs(config) + RS485::calcCharTimeUs(config) * RESPONSE_TIMEOUT_FLOOR_CHARS;
+  ASSERT_EQUAL((int)floorUs, (int)timeouts.getFloorUs());
+  ASSERT_EQUAL(RESPONSE_TIMEOUT_INITIAL_MS * 1000, (int)timeouts.getTimeoutUs(5));
+  for (uint8_t i = 0; i < 20; i++) {
+    timeouts.addSample(5, 5000);
+  }
+  const ResponseEstimate* steady = timeouts.find(5);
+  ASSERT_TRUE(steady != nullptr);
+  ASSERT_EQUAL(5000, (int)steady->srttUs);
+  ASSERT_EQUAL((int)(5000 + floorUs), (int)steady->timeoutUs);
+
+  // 抖动的设备：余量由偏差决定
+  for (uint8_t i = 0; i < 20; i++) {
+    timeouts.addSample(6, (i % 2) != 0 ? 2000 : 18000);
+  }
+  const ResponseEstimate* jittery = timeouts.find(6);
+  ASSERT_TRUE(jittery->timeoutUs > jittery->srttUs + floorUs);
+  ASSERT_EQUAL((int)(jittery->srttUs + jittery->rttvarUs * 4), (int)jittery->timeoutUs);
+
+  // 超时后加倍直到上限，下一个样本重新计算
+  timeouts.onTimeout(5);
+  ASSERT_EQUAL((int)(5000 + floorUs) * 2, (int)steady->timeoutUs);
+  for (uint8_t i = 0; i < 10; i++) {
+    timeouts.onTimeout(5);
+  }
+  ASSERT_EQUAL(RESPONSE_TIMEOUT_MAX_MS * 1000, (int)steady->timeoutUs);
+  ASSERT_EQUAL(11, (int)steady->timeouts);
+  timeouts.addSample(5, 5000);
+  ASSERT_EQUAL((int)(5000 + floorUs), (int)steady->timeoutUs);
+
+  // 表满时替换最久未用的地址
+  for (uint8_t address = 10; address < 10 + RESPONSE_TIMEOUT_ADDRESSES - 2; address++) {
+    timeouts.getTimeoutUs(address);
+  }
+  delay(2);
+  timeouts.getTimeoutUs(5);
+  timeouts.getTimeoutUs(100);
+  ASSERT_TRUE(timeouts.find(5) != nullptr);
+  ASSERT_TRUE(timeouts.find(100) != nullptr);
+  ASSERT_TRUE(timeouts.find(6) == nullptr);
+
+  // 从设备转发：地址5不应答，等待超时后才发送地址6的请求
+  timeouts.begin(config);
+  for (uint8_t i = 0; i < 8; i++) {
+    timeouts.addSample(5, 5000);
+  }
+  uint32_t expectedWaitUs = timeouts.getTimeoutUs(5);
+  uint8_t request5[MODBUS_MIN_FRAME_SIZE + 4] = {0x05, 0x03, 0x00, 0x00, 0x00, 0x01};
+  uint8_t request6[MODBUS_MIN_FRAME_SIZE + 4] = {0x06, 0x03, 0x00, 0x00, 0x00, 0x01};
+  uint8_t response6[7] = {0x06, 0x03, 0x02, 0x12, 0x34};
+  modbusAppendCrc(request5, 6);
+  modbusAppendCrc(request6, 6);
+  modbusAppendCrc(response6, 5);
+
+  LinkLoopback link;
+  BusStub stream;
+  RS485 bus;
+  bus.begin(stream, config);
+  DataRouter router;
+  router.begin(&bus, &link.slave);
+  router.setResponseTimeouts(&timeouts);
+  link.slaveRouter = &router;
+  link.begin(TEST_RESPONSE_PORT);
+  ASSERT_TRUE(link.connect());
+
+  uint32_t timeoutsBefore = metrics.get(METRIC_BUS_RESPONSE_TIMEOUTS);
+  ASSERT_TRUE(link.master.sendFrame(request5, sizeof(request5)));
+  ASSERT_TRUE(link.master.sendFrame(request6, sizeof(request6)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return stream.writes == 2; }));
+  ASSERT_EQUAL(5, stream.writeAddresses[0]);
+  ASSERT_EQUAL(6, stream.writeAddresses[1]);
+  // 等待从请求发送完成开始计算，替身记录写入时间的几微秒不计；上限只排除没有超时的情况
+  uint32_t waitedUs = stream.writeTimes[1] - stream.writeTimes[0];
+  ASSERT_TRUE(waitedUs + 50 >= expectedWaitUs && waitedUs < RESPONSE_TIMEOUT_INITIAL_MS * 1000UL);
+  ASSERT_EQUAL((int)timeoutsBefore + 1, (int)metrics.get(METRIC_BUS_RESPONSE_TIMEOUTS));
+  ASSERT_EQUAL(1, (int)timeouts.find(5)->timeouts);
+  ASSERT_EQUAL(6, router.getAwaitingAddress());
+
+  // 地址6的应答结束等待并作为样本，同时转发给主设备
+  stream.inject(response6, sizeof(response6));
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 1 && router.getAwaitingAddress() == 0; }));
+  ASSERT_EQUAL(sizeof(response6), link.masterFrame.length);
+  ASSERT_EQUAL(1, (int)timeouts.find(6)->samples);
+  ASSERT_TRUE(timeouts.find(6)->srttUs < RESPONSE_TIMEOUT_INITIAL_MS * 1000UL);
+
+  link.end();
+  LOG_I("Test", "应答等待测试完成");
+}
+
+#define TEST_PRIORITY_PORT 18878
+
+TEST(PriorityLanes, "wifi link bus") {
+  LOG_I("Test", "开始优先级队列测试");
+  uint8_t poll[MODBUS_MIN_FRAME_SIZE + 4] = {0x05, 0x03, 0x00, 0x00, 0x00, 0x01};
+  uint8_t write[MODBUS_MIN_FRAME_SIZE + 4] = {0x08, 0x06, 0x00, 0x10, 0x00, 0x01};
+  uint8_t exception[MODBUS_MIN_FRAME_SIZE + 1] = {0x05, 0x83, 0x02};
+  modbusAppendCrc(poll, 6);
+  modbusAppendCrc(write, 6);
+  modbusAppendCrc(exception, 3);
+
+  // 写命令和异常应答为高优先级，读请求和不完整的帧为普通优先级
+  ASSERT_EQUAL(MODBUS_PRIORITY_NORMAL, modbusClassify(poll, sizeof(poll)));
+  ASSERT_EQUAL(MODBUS_PRIORITY_HIGH, modbusClassify(write, sizeof(write)));
+  ASSERT_EQUAL(MODBUS_PRIORITY_HIGH, modbusClassify(exception, sizeof(exception)));
+  ASSERT_EQUAL(MODBUS_PRIORITY_NORMAL, modbusClassify(write, 2));
+
+  // 队列按实际帧长保存，空间不足时拒绝
+  FrameQueue queue;
+  RS485Frame frame;
+  memcpy(frame.data, poll, sizeof(poll));
+  frame.length = sizeof(poll);
+  frame.timingLength = 0;
+  uint16_t capacity = 0;
+  while (queue.push(frame)) {
+    capacity++;
+  }
+  ASSERT_EQUAL(ROUTER_LANE_BUFFER_SIZE / (FRAME_QUEUE_ENTRY_HEADER + (int)sizeof(poll)), (int)capacity);
+  ASSERT_TRUE(queue.pop(frame));
+  ASSERT_TRUE(queue.push(frame));
+  ASSERT_EQUAL((int)capacity, (int)queue.getFrames());
+
+  RS485Config config = testBusConfig(115200);
+  ResponseTimeouts timeouts;
+  timeouts.begin(config);
+
+  LinkLoopback link;
+  BusStub stream;
+  RS485 bus;
+  bus.begin(stream, config);
+  DataRouter router;
+  router.begin(&bus, &link.slave);
+  router.setResponseTimeouts(&timeouts);
+  link.slaveRouter = &router;
+  link.begin(TEST_PRIORITY_PORT);
+  ASSERT_TRUE(link.connect());
+
+  // 等待地址5应答期间到达两个轮询和一个写命令
+  uint32_t priorityBefore = metrics.get(METRIC_ROUTER_PRIORITY_FRAMES);
+  uint32_t overtakesBefore = metrics.get(METRIC_ROUTER_OVERTAKES);
+  ASSERT_TRUE(link.master.sendFrame(poll, sizeof(poll)));
+  ASSERT_TRUE(link.pump(1000, [&]() { return stream.writes == 1; }));
+  poll[0] = 0x06;
+  modbusAppendCrc(poll, 6);
+  ASSERT_TRUE(link.master.sendFrame(poll, sizeof(poll)));
+  poll[0] = 0x07;
+  modbusAppendCrc(poll, 6);
+  ASSERT_TRUE(link.master.sendFrame(poll, sizeof(poll)));
+  ASSERT_TRUE(link.master.sendFrame(write, sizeof(write)));
+  ASSERT_TRUE(link.pump(1000, [&]() {
+    return router.getQueuedFrames(MODBUS_PRIORITY_NORMAL) == 2 && router.getQueuedFrames(MODBUS_PRIORITY_HIGH) == 1;
+  }));
+  ASSERT_EQUAL(1, stream.writes);
+
+  // 地址5应答后写命令越过排队的轮询
+  uint8_t response[7] = {0x05, 0x03, 0x02, 0x12, 0x34};
+  modbusAppendCrc(response, 5);
+  stream.inject(response, sizeof(response));
+  ASSERT_TRUE(link.pump(1000, [&]() { return stream.writes == 2; }));
+  ASSERT_EQUAL(8, stream.writeAddresses[1]);
+  ASSERT_EQUAL((int)priorityBefore + 1, (int)metrics.get(METRIC_ROUTER_PRIORITY_FRAMES));
+  ASSERT_EQUAL((int)overtakesBefore + 1, (int)metrics.get(METRIC_ROUTER_OVERTAKES));
+
+  // 写命令的应答 (原样返回) 之后轮询按到达顺序发送
+  stream.inject(write, sizeof(write));
+  ASSERT_TRUE(link.pump(1000, [&]() { return stream.writes == 3; }));
+  response[0] = 0x06;
+  modbusAppendCrc(response, 5);
+  stream.inject(response, sizeof(response));
+  ASSERT_TRUE(link.pump(1000, [&]() { return stream.writes == 4; }));
+  ASSERT_EQUAL(6, stream.writeAddresses[2]);
+  ASSERT_EQUAL(7, stream.writeAddresses[3]);
+  ASSERT_TRUE(link.pump(1000, [&]() { return link.masterFrames == 3; }));
+  ASSERT_EQUAL((int)overtakesBefore + 1, (int)metrics.get(METRIC_ROUTER_OVERTAKES));
+
+  link.end();
+  LOG_I("Test", "优先级队列测试完成");
+}
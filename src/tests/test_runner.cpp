@@ -2,6 +2,8 @@
 #include "device.h"
 #include "logger.h"
 #include "config_manager.h"
+#include "config_schema.h"
+#include "heap_profiler.h"
 #include "test_framework.h"
 
 // 全局变量
@@ -9,8 +11,14 @@ Device device;
 extern Logger logger;
 ConfigManager configManager;
 
-// 测试函数声明 (使用 TEST 宏定义)
-TEST(DeviceRole) {
+// 性能基准测试 (test_performance.cpp)
+void runPerformanceBenchmarks(const char* filter);
+
+// 回环吞吐量和长时间运行测试 (test_soak.cpp)
+void runLoopbackSoak(const String& args);
+
+// 测试函数 (TEST 宏定义即注册，各测试文件中的测试同样自动注册)
+TEST(DeviceRole, "device") {
   LOG_I("Test", "开始设备角色测试");
   
   DeviceRole role = device.getRole();
@@ -37,7 +45,7 @@ TEST(DeviceRole) {
   LOG_I("Test", "设备角色测试完成");
 }
 
-TEST(DeviceName) {
+TEST(DeviceName, "device") {
   LOG_I("Test", "开始设备名称测试");
   
   String name = device.getName();
@@ -62,13 +70,21 @@ void showTestMenu() {
   Serial.println("2 - 设备名称测试");
   Serial.println("3 - 日志系统测试");
   Serial.println("4 - 配置管理器测试");
+  Serial.println("5 - 流量捕获测试");
+  Serial.println("6 - WiFi快速重连测试");
+  Serial.println("t|test <过滤> - 运行匹配的测试 (如 \"t @wifi -OtaUpdate\"、\"t Config*\")");
+  Serial.println("l|list [过滤] - 列出测试和基准测试及其标签");
+  Serial.println("j|jobs <分片数> [过滤] - 在多个子进程中并行运行测试 (本机构建)");
+  Serial.println("b|bench [过滤] - 性能基准测试 (JSON行输出)");
+  Serial.println("s|soak [秒] [主机] - 回环吞吐量和长时间运行测试 (JSON行输出)");
+  Serial.println("m|mem - 各模块堆占用和栈高水位 (JSON行输出)");
   Serial.println("h|help - 输出测试菜单");
   Serial.println("q|quit - 退出测试程序");
   Serial.println("==================================================");
   Serial.println();
 }
 
-TEST(Logger) {
+TEST(Logger, "logger") {
   LOG_I("Test", "开始日志系统测试");
   
   // 测试不同级别的日志输出
@@ -89,7 +105,7 @@ TEST(Logger) {
   LOG_I("Test", "日志系统测试完成");
 }
 
-TEST(ConfigManager) {
+TEST(ConfigManager, "config") {
   LOG_I("Test", "开始配置管理器测试");
   
   // 测试获取配置
@@ -121,6 +137,129 @@ TEST(ConfigManager) {
   LOG_I("Test", "配置管理器测试完成");
 }
 
+TEST(ConfigBackupFallback, "config fs") {
+  ConfigManager manager;
+  manager.generateDefaultConfig();
+  DeviceConfig deviceConfig = manager.getDeviceConfig();
+  deviceConfig.syncPort = 9001;
+  manager.setDeviceConfig(deviceConfig);
+  ASSERT_TRUE(manager.saveConfig());
+  deviceConfig.syncPort = 9002;
+  manager.setDeviceConfig(deviceConfig);
+  ASSERT_TRUE(manager.saveConfig());
+  ASSERT_TRUE(FILE_SYSTEM.exists(CONFIG_BACKUP_FILE_PATH));
+  ASSERT_TRUE(!FILE_SYSTEM.exists(CONFIG_TEMP_FILE_PATH));
+
+  // 配置文件写坏 (写入中断) 时加载上一版本的备份
+  File configFile = FILE_SYSTEM.open(DEFAULT_CONFIG_FILE_PATH, "w");
+  configFile.print("{\"network\":");
+  configFile.close();
+  ConfigManager loaded;
+  ASSERT_TRUE(loaded.loadConfig());
+  ASSERT_EQUAL(9001, loaded.getDeviceConfig().syncPort);
+
+  // 改名前中断：只剩备份
+  FILE_SYSTEM.remove(DEFAULT_CONFIG_FILE_PATH);
+  ASSERT_TRUE(loaded.loadConfig());
+  ASSERT_EQUAL(9001, loaded.getDeviceConfig().syncPort);
+
+  // 恢复测试运行器使用的配置文件
+  manager.deleteConfigFile();
+  ASSERT_TRUE(configManager.saveConfig());
+}
+
+TEST(ConfigSchema, "config") {
+  ConfigManager manager;
+  manager.generateDefaultConfig();
+  ASSERT_TRUE(manager.validateConfig());
+
+  // 字段范围和可选值由描述表检查
+  RS485Config rs485 = manager.getRS485Config();
+  rs485.parity = 3;
+  manager.setRS485Config(rs485);
+  ASSERT_TRUE(!manager.validateConfig());
+  rs485.parity = 2;
+  manager.setRS485Config(rs485);
+  DeviceConfig deviceConfig = manager.getDeviceConfig();
+  deviceConfig.role = "relay";
+  manager.setDeviceConfig(deviceConfig);
+  ASSERT_TRUE(!manager.validateConfig());
+  deviceConfig.role = "slave";
+  manager.setDeviceConfig(deviceConfig);
+  ASSERT_TRUE(manager.validateConfig());
+
+  // 静态IP只在关闭DHCP时检查
+  NetworkConfig network = manager.getNetworkConfig();
+  network.ip = "not-an-ip";
+  manager.setNetworkConfig(network);
+  ASSERT_TRUE(manager.validateConfig());
+  network.dhcpEnabled = false;
+  manager.setNetworkConfig(network);
+  ASSERT_TRUE(!manager.validateConfig());
+
+  // JSON中的数值在截断为字段宽度之前检查范围：74424 不会变成 8888
+  void* sections[CONFIG_SECTION_COUNT] = {&network, &rs485, &deviceConfig};
+  DynamicJsonDocument input(256);
+  deserializeJson(input, "{\"device\":{\"tcpPort\":74424}}");
+  deviceConfig.tcpPort = 502;
+  ASSERT_TRUE(!configFromJson(input, sections));
+  ASSERT_EQUAL(502, (int)deviceConfig.tcpPort);
+  deserializeJson(input, "{\"rs485\":{\"dataBits\":-8}}");
+  ASSERT_TRUE(!configFromJson(input, sections));
+  ASSERT_EQUAL(8, (int)rs485.dataBits);
+  deserializeJson(input, "{\"device\":{\"tcpPort\":8888}}");
+  ASSERT_TRUE(configFromJson(input, sections));
+  ASSERT_EQUAL(8888, (int)deviceConfig.tcpPort);
+
+  // 比较结果按字段标志汇总
+  ConfigManager defaults;
+  uint8_t changed = manager.changedFlags(defaults.getNetworkConfig(), defaults.getRS485Config(),
+                                         defaults.getDeviceConfig());
+  ASSERT_TRUE((changed & CONFIG_FLAG_WIFI) != 0);
+  ASSERT_TRUE((changed & CONFIG_FLAG_BRIDGE) != 0);
+  ASSERT_EQUAL(0, defaults.changedFlags(defaults.getNetworkConfig(), defaults.getRS485Config(),
+                                        defaults.getDeviceConfig()));
+
+  // Web接口不输出密码
+  DynamicJsonDocument doc(1024);
+  manager.toJson(doc, CONFIG_FLAG_SECRET);
+  ASSERT_TRUE(doc["network"]["password"].isNull());
+  ASSERT_STRING_EQUAL("slave", doc["device"]["role"].as<String>().c_str());
+  ASSERT_EQUAL(2, doc["rs485"]["parity"].as<int>());
+}
+
+TEST(HeapProfiler, "mem") {
+  heapProfiler.account();
+  int32_t syncBefore = heapProfiler.getStats(HEAP_TAG_SYNC).currentBytes;
+  int32_t webBefore = heapProfiler.getStats(HEAP_TAG_WEB).currentBytes;
+
+  // 作用域内的分配记到该模块，嵌套的作用域结束后恢复外层模块
+  uint8_t* block;
+  {
+    HEAP_SCOPE(HEAP_TAG_WEB);
+    {
+      HEAP_SCOPE(HEAP_TAG_SYNC);
+      block = (uint8_t*)malloc(2048);
+    }
+    ASSERT_TRUE(heapProfiler.getCurrentTag() == HEAP_TAG_WEB);
+  }
+  ASSERT_TRUE(block != nullptr);
+  ASSERT_TRUE(heapProfiler.getCurrentTag() == HEAP_TAG_SYSTEM);
+  const HeapTagStats& sync = heapProfiler.getStats(HEAP_TAG_SYNC);
+  ASSERT_TRUE(sync.currentBytes - syncBefore >= 2048);
+  ASSERT_TRUE(sync.peakBytes >= sync.currentBytes);
+  ASSERT_EQUAL(webBefore, heapProfiler.getStats(HEAP_TAG_WEB).currentBytes);
+
+  // 在其它模块中释放的内存记到释放的模块，峰值保留
+  int32_t syncPeak = sync.peakBytes;
+  {
+    HEAP_SCOPE(HEAP_TAG_WEB);
+    free(block);
+  }
+  ASSERT_TRUE(heapProfiler.getStats(HEAP_TAG_WEB).currentBytes - webBefore <= -2048);
+  ASSERT_EQUAL(syncPeak, heapProfiler.getStats(HEAP_TAG_SYNC).peakBytes);
+}
+
 void setup() {
   // 初始化串口
   Serial.begin(115200);
@@ -130,6 +269,7 @@ void setup() {
   
   // 初始化测试框架
   testFramework.begin();
+  heapProfiler.begin();
   
   // 初始化日志系统
   logger.begin();
@@ -153,12 +293,6 @@ void setup() {
   
   LOG_I("Test", "配置管理器初始化成功");
   
-  // 注册测试 (使用 RUN_TEST 宏)
-  RUN_TEST(DeviceRole);
-  RUN_TEST(DeviceName);
-  RUN_TEST(Logger);
-  RUN_TEST(ConfigManager);
-  
   // 显示测试菜单
   showTestMenu();
   
@@ -171,32 +305,47 @@ void setup() {
   }
 }
 
-// 运行选定的测试
-void runSelectedTest(int testNumber) {
-  // 重置测试框架的计数器
-  // 注意：这里我们直接调用测试函数，而不是通过测试框架
-  // 因为测试框架没有提供运行单个测试的接口
-  switch (testNumber) {
-    case 1:
-      test_DeviceRole();
-      break;
-    case 2:
-      test_DeviceName();
-      break;
-    case 3:
-      test_Logger();
-      break;
-    case 4:
-      test_ConfigManager();
-      break;
-    default:
-      Serial.println("无效的测试编号");
-      break;
+// 菜单编号对应的过滤条件
+static const char* const MENU_FILTERS[] = {
+  nullptr,
+  "DeviceRole",
+  "DeviceName",
+  "Logger",
+  "@config -@wifi",
+  "@capture",
+  "@wifi"
+};
+
+// 命令之后的参数 (去除首尾空格)
+static String commandArgs(const String& input) {
+  int space = input.indexOf(' ');
+  if (space < 0) {
+    return String();
   }
+  String args = input.substring(space + 1);
+  args.trim();
+  return args;
 }
 
-// 前向声明
-void runSelectedTest(int testNumber);
+// 输入是完整的命令名，或命令名后跟空格和参数 ("testfoo" 不是 "test")
+static bool matchesCommand(const String& input, const char* name) {
+  size_t length = strlen(name);
+  return input.startsWith(name) && (input.length() == length || input[length] == ' ');
+}
+
+static bool isCommand(const String& input, const char* shortName, const char* longName) {
+  return matchesCommand(input, shortName) || matchesCommand(input, longName);
+}
+
+// 输出断言统计；本机构建以进程退出码报告测试结果 (任一次运行失败即为1)
+static void reportTestResults() {
+  testFramework.printTestResults();
+#ifdef WIFLY485_NATIVE
+  if (testFramework.getFailedTests() > 0) {
+    nativeSetExitCode(1);
+  }
+#endif
+}
 
 void loop() {
   // 检查串口是否有数据
@@ -209,29 +358,58 @@ void loop() {
     if (input == "0" || input == "all") {
       Serial.println("运行所有测试...");
       testFramework.runAllTests();
-      testFramework.printTestResults();
+      reportTestResults();
+      showTestMenu();
+    } else if (input.length() == 1 && input[0] >= '1' && input[0] <= '6') {
+      const char* filter = MENU_FILTERS[input[0] - '0'];
+      Serial.printf("运行测试: %s\n", filter);
+      testFramework.runAllTests(filter);
+      reportTestResults();
+      showTestMenu();
+    } else if (isCommand(input, "t", "test")) {
+      String filter = commandArgs(input);
+      testFramework.runAllTests(filter.c_str());
+      reportTestResults();
       showTestMenu();
-    } else if (input == "1") {
-      Serial.println("运行设备角色测试...");
-      runSelectedTest(1);
+    } else if (isCommand(input, "l", "list")) {
+      testFramework.listTests(commandArgs(input).c_str());
+    } else if (isCommand(input, "j", "jobs")) {
+      String args = commandArgs(input);
+      int space = args.indexOf(' ');
+      long requested = args.toInt();
+      uint8_t jobs = requested < 1 ? 1 : (requested > 64 ? 64 : (uint8_t)requested);
+      String filter = space < 0 ? String() : args.substring(space + 1);
+#ifdef WIFLY485_NATIVE
+      testFramework.runTestsParallel(filter.c_str(), jobs);
+#else
+      // 设备上没有多进程，按顺序运行
+      (void)jobs;
+      testFramework.runAllTests(filter.c_str());
+#endif
+      reportTestResults();
       showTestMenu();
-    } else if (input == "2") {
-      Serial.println("运行设备名称测试...");
-      runSelectedTest(2);
+    } else if (isCommand(input, "b", "bench")) {
+      Serial.println("运行性能基准测试...");
+      runPerformanceBenchmarks(commandArgs(input).c_str());
       showTestMenu();
-    } else if (input == "3") {
-      Serial.println("运行日志系统测试...");
-      runSelectedTest(3);
+    } else if (isCommand(input, "s", "soak")) {
+      Serial.println("运行回环吞吐量测试...");
+      runLoopbackSoak(input.substring(input.indexOf(' ') < 0 ? input.length() : input.indexOf(' ')));
       showTestMenu();
-    } else if (input == "4") {
-      Serial.println("运行配置管理器测试...");
-      runSelectedTest(4);
+    } else if (input == "m" || input == "mem") {
+      heapProfiler.printJson(Serial);
+      Serial.println();
+      heapProfiler.logSummary();
       showTestMenu();
     } else if (input == "h" || input == "help") {
       showTestMenu();
     } else if (input == "q" || input == "quit") {
       Serial.println("退出测试程序。");
       Serial.println("再见！");
+#ifdef WIFLY485_NATIVE
+      // 本机构建直接结束进程
+      nativeExit();
+#endif
       // 停止处理输入，但保持程序运行
       // 在Arduino中，我们不能真正退出loop()函数
       // 但可以停止处理串口输入
@@ -0,0 +1,454 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "config_manager.h"
+#include "data_router.h"
+#include "logger.h"
+#include "modbus.h"
+#include "rs485.h"
+#include "tcp_protocol.h"
+
+// 回环吞吐量和长时间运行 (soak) 基准测试
+// 合成帧经过完整的 网络 → UART → 回环线 → UART → 网络 路径：
+//   - 本机模式 (soak [秒])：测试程序内运行一个中继 (RS485 + TcpProtocol服务器 + DataRouter)。
+//     UART0切换到GPIO15(TX)/GPIO13(RX)，两个引脚用跳线连接 (经收发器时接收器需保持使能)；
+//     发生器作为TcpProtocol客户端经127.0.0.1连接中继，中继把帧发到总线，回环收到的同一帧再转发回发生器
+//   - 配对模式 (soak [秒] <主机>)：发生器连接另一块运行主设备固件、总线接回环线的板子，
+//     路径中包含WiFi空中传输，波特率由对方的配置决定
+// 每个波特率输出一行JSON：持续吞吐量、丢失、时延P50/P99和堆内存漂移，可用 grep '^{"type":"soak"' 提取
+
+#define SOAK_PORT 18890
+#define SOAK_DEFAULT_DURATION_S 10        // 每个波特率的运行时间
+#define SOAK_FRAME_SIZE 32                // 合成帧长度 (含CRC)
+#define SOAK_WINDOW 4                     // 同时在途的帧数 (保持总线连续忙碌)
+#define SOAK_FRAME_TIMEOUT_MS 2000        // 超过该时间未返回的帧计为丢失
+#define SOAK_CONNECT_TIMEOUT_MS 15000
+#define SOAK_HEAP_SAMPLE_MS 1000
+#define SOAK_PROGRESS_INTERVAL_MS 60000   // 长时间运行时输出进度的间隔
+#define SOAK_ADDRESS 0xF7                 // 合成帧的从站地址和功能码 (用户自定义功能码，不会被真实设备应答)
+#define SOAK_FUNCTION 0x41
+
+static const uint32_t SOAK_BAUD_RATES[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+
+// 时延直方图：每个2的幂区间再分8个子桶 (相对误差不超过12.5%)，长时间运行也只占固定内存
+#define SOAK_SUB_BUCKETS 8
+#define SOAK_BUCKET_COUNT (30 * SOAK_SUB_BUCKETS)
+
+struct LatencyHistogram {
+  uint32_t buckets[SOAK_BUCKET_COUNT];
+  uint32_t count;
+  uint32_t maxUs;
+
+  void reset() {
+    memset(this, 0, sizeof(*this));
+  }
+
+  static uint16_t bucketOf(uint32_t us) {
+    if (us < SOAK_SUB_BUCKETS) {
+      return us;
+    }
+    uint8_t msb = 31 - __builtin_clz(us);
+    uint8_t sub = (us >> (msb - 3)) & (SOAK_SUB_BUCKETS - 1);
+    return (msb - 2) * SOAK_SUB_BUCKETS + sub;
+  }
+
+  static uint32_t bucketUpperUs(uint16_t bucket) {
+    if (bucket < SOAK_SUB_BUCKETS) {
+      return bucket;
+    }
+    uint8_t msb = bucket / SOAK_SUB_BUCKETS + 2;
+    uint32_t lower = (uint32_t)(SOAK_SUB_BUCKETS + bucket % SOAK_SUB_BUCKETS) << (msb - 3);
+    return lower + (1UL << (msb - 3)) - 1;
+  }
+
+  void record(uint32_t us) {
+    buckets[bucketOf(us)]++;
+    count++;
+    if (us > maxUs) {
+      maxUs = us;
+    }
+  }
+
+  uint32_t percentileUs(uint8_t percentile) {
+    if (count == 0) {
+      return 0;
+    }
+    uint32_t rank = ((uint64_t)count * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (uint16_t i = 0; i < SOAK_BUCKET_COUNT; i++) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        return min(bucketUpperUs(i), maxUs);
+      }
+    }
+    return maxUs;
+  }
+};
+
+struct SoakResult {
+  uint32_t baudRate;
+  uint32_t sent;
+  uint32_t received;
+  uint32_t lost;
+  uint32_t corrupt;
+  uint32_t late;            // 超时之后才返回的帧 (已计入丢失)
+  uint32_t elapsedMs;
+  uint32_t heapStart;
+  uint32_t heapEnd;
+  uint32_t heapMin;
+  uint8_t fragmentationMax;
+  LatencyHistogram latency;
+};
+
+// 在途的帧
+struct SoakInFlight {
+  uint32_t seq;
+  uint32_t sentUs;
+  uint32_t sentMs;
+  bool active;
+};
+
+#ifdef WIFLY485_NATIVE
+// 回环线替身：写入的字节按字符时间逐个出现在接收端，flush()阻塞到最后一个字节移出
+#define SOAK_LOOPBACK_SIZE 1024
+
+class LoopbackStream : public Stream {
+public:
+  void begin(uint32_t charTimeUs) {
+    this->charTimeUs = charTimeUs;
+    head = 0;
+    count = 0;
+    lineFreeAt = micros();
+  }
+
+  int available() override {
+    uint32_t now = micros();
+    int ready = 0;
+    while (ready < (int)count && (int32_t)(now - due[(head + ready) % SOAK_LOOPBACK_SIZE]) >= 0) {
+      ready++;
+    }
+    return ready;
+  }
+
+  int read() override {
+    if (available() == 0) {
+      return -1;
+    }
+    uint8_t c = buffer[head];
+    head = (head + 1) % SOAK_LOOPBACK_SIZE;
+    count--;
+    return c;
+  }
+
+  int peek() override {
+    return available() > 0 ? buffer[head] : -1;
+  }
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* data, size_t size) override {
+    size_t written = 0;
+    while (written < size && count < SOAK_LOOPBACK_SIZE) {
+      uint32_t now = micros();
+      uint32_t start = (int32_t)(lineFreeAt - now) > 0 ? lineFreeAt : now;
+      lineFreeAt = start + charTimeUs;
+      uint16_t tail = (head + count) % SOAK_LOOPBACK_SIZE;
+      buffer[tail] = data[written++];
+      due[tail] = lineFreeAt;
+      count++;
+    }
+    return written;
+  }
+
+  void flush() override {
+    while ((int32_t)(micros() - lineFreeAt) < 0) {
+    }
+  }
+
+  using Print::write;
+
+private:
+  uint8_t buffer[SOAK_LOOPBACK_SIZE];
+  uint32_t due[SOAK_LOOPBACK_SIZE];
+  uint16_t head = 0;
+  uint16_t count = 0;
+  uint32_t charTimeUs = 0;
+  uint32_t lineFreeAt = 0;
+};
+
+static LoopbackStream soakLoopback;
+#endif
+
+// 被测中继和发生器 (静态分配，不占用运行期间的堆)
+static RS485 soakBus;
+static TcpProtocol soakRelayLink;
+static DataRouter soakRouter;
+static TcpProtocol soakGenerator;
+static RS485Frame soakFrame;
+static SoakResult soakResult;
+
+// 合成帧：序号之后的内容由序号决定，返回时可以逐字节校验
+static uint16_t makeSoakFrame(uint32_t seq, uint8_t* frame) {
+  frame[0] = SOAK_ADDRESS;
+  frame[1] = SOAK_FUNCTION;
+  frame[2] = seq & 0xFF;
+  frame[3] = (seq >> 8) & 0xFF;
+  frame[4] = (seq >> 16) & 0xFF;
+  frame[5] = seq >> 24;
+  for (uint16_t i = 6; i < SOAK_FRAME_SIZE - 2; i++) {
+    frame[i] = (uint8_t)(seq * 31 + i);
+  }
+  return modbusAppendCrc(frame, SOAK_FRAME_SIZE - 2);
+}
+
+static bool checkSoakFrame(const RS485Frame& frame, uint32_t& seq) {
+  if (frame.length != SOAK_FRAME_SIZE || frame.data[0] != SOAK_ADDRESS || frame.data[1] != SOAK_FUNCTION) {
+    return false;
+  }
+  seq = frame.data[2] | ((uint32_t)frame.data[3] << 8) | ((uint32_t)frame.data[4] << 16) |
+        ((uint32_t)frame.data[5] << 24);
+  uint8_t expected[SOAK_FRAME_SIZE];
+  makeSoakFrame(seq, expected);
+  return memcmp(expected, frame.data, SOAK_FRAME_SIZE) == 0;
+}
+
+// 本机模式：按波特率配置总线 (UART0在重新配置后切换到回环引脚)
+static void configureSoakBus(uint32_t baudRate) {
+  RS485Config config;
+  config.baudRate = baudRate;
+  config.dataBits = DEFAULT_DATA_BITS;
+  config.parity = DEFAULT_PARITY;
+  config.stopBits = DEFAULT_STOP_BITS;
+  config.replayTiming = false;
+#ifdef WIFLY485_NATIVE
+  soakLoopback.begin(RS485::calcCharTimeUs(config));
+  soakBus.begin(soakLoopback, config);
+#else
+  soakBus.begin(Serial, config);
+  Serial.swap();
+#endif
+}
+
+// 运行一次：发生器保持SOAK_WINDOW个帧在途，直到时间结束且在途的帧都返回或超时
+static void runSoakPass(bool local, uint32_t durationMs, SoakResult& result) {
+  SoakInFlight inFlight[SOAK_WINDOW];
+  memset(inFlight, 0, sizeof(inFlight));
+  static uint32_t nextSeq = 1;
+
+  uint32_t start = millis();
+  uint32_t lastHeapSample = start;
+  uint32_t lastProgress = start;
+  result.heapStart = result.heapMin = ESP.getFreeHeap();
+  result.fragmentationMax = ESP.getHeapFragmentation();
+
+  while (true) {
+    uint32_t now = millis();
+    bool sending = now - start < durationMs;
+    uint8_t active = 0;
+    for (uint8_t i = 0; i < SOAK_WINDOW; i++) {
+      active += inFlight[i].active ? 1 : 0;
+    }
+    if (!sending && active == 0) {
+      break;
+    }
+
+    if (local) {
+      soakRelayLink.loop();
+      soakRouter.loop();
+    }
+    soakGenerator.loop();
+
+    // 返回的帧
+    while (soakGenerator.receiveFrame(soakFrame)) {
+      uint32_t seq;
+      if (!checkSoakFrame(soakFrame, seq)) {
+        result.corrupt++;
+        continue;
+      }
+      bool matched = false;
+      for (uint8_t i = 0; i < SOAK_WINDOW; i++) {
+        if (inFlight[i].active && inFlight[i].seq == seq) {
+          result.latency.record(micros() - inFlight[i].sentUs);
+          result.received++;
+          inFlight[i].active = false;
+          matched = true;
+          break;
+        }
+      }
+      if (!matched) {
+        result.late++;
+      }
+    }
+
+    // 超时和发送
+    now = millis();
+    for (uint8_t i = 0; i < SOAK_WINDOW; i++) {
+      if (inFlight[i].active && now - inFlight[i].sentMs >= SOAK_FRAME_TIMEOUT_MS) {
+        inFlight[i].active = false;
+        result.lost++;
+      }
+      if (!inFlight[i].active && sending) {
+        uint8_t frame[SOAK_FRAME_SIZE];
+        uint16_t length = makeSoakFrame(nextSeq, frame);
+        if (soakGenerator.sendFrame(frame, length)) {
+          inFlight[i].seq = nextSeq++;
+          inFlight[i].sentUs = micros();
+          inFlight[i].sentMs = now;
+          inFlight[i].active = true;
+          result.sent++;
+        }
+      }
+    }
+
+    // 堆内存采样
+    if (now - lastHeapSample >= SOAK_HEAP_SAMPLE_MS) {
+      lastHeapSample = now;
+      result.heapMin = min<uint32_t>(result.heapMin, ESP.getFreeHeap());
+      result.fragmentationMax = max<uint8_t>(result.fragmentationMax, ESP.getHeapFragmentation());
+    }
+    if (now - lastProgress >= SOAK_PROGRESS_INTERVAL_MS) {
+      lastProgress = now;
+      LOG_I("Soak", "%u bps: 已发送 %u, 已返回 %u, 丢失 %u, 空闲堆 %u", result.baudRate, result.sent,
+            result.received, result.lost, ESP.getFreeHeap());
+    }
+    yield();
+  }
+
+  result.elapsedMs = millis() - start;
+  result.heapEnd = ESP.getFreeHeap();
+}
+
+static void printSoakResult(SoakResult& result, const char* mode) {
+  float seconds = result.elapsedMs / 1000.0f;
+  uint32_t bytes = result.received * SOAK_FRAME_SIZE;
+  float throughput = seconds > 0 ? bytes / seconds : 0;
+  // 每个字节在总线上占用一个字符时间
+  uint32_t charTimeUs = 0;
+  if (result.baudRate > 0) {
+    RS485Config config;
+    config.baudRate = result.baudRate;
+    config.dataBits = DEFAULT_DATA_BITS;
+    config.parity = DEFAULT_PARITY;
+    config.stopBits = DEFAULT_STOP_BITS;
+    charTimeUs = RS485::calcCharTimeUs(config);
+  }
+  float utilization = result.elapsedMs > 0 ? (float)bytes * charTimeUs / (result.elapsedMs * 1000.0f) : 0;
+
+  Serial.printf("{\"type\":\"soak\",\"mode\":\"%s\",\"baud\":%u,\"duration_s\":%.1f,\"frame_bytes\":%u,"
+                "\"sent\":%u,\"received\":%u,\"lost\":%u,\"corrupt\":%u,\"late\":%u,"
+                "\"throughput_Bps\":%.1f,\"bus_utilization\":%.3f,"
+                "\"latency_p50_ms\":%.3f,\"latency_p99_ms\":%.3f,\"latency_max_ms\":%.3f,"
+                "\"heap_start\":%u,\"heap_end\":%u,\"heap_min\":%u,\"heap_drift\":%d,\"fragmentation_max\":%u}\n",
+                mode, (unsigned)result.baudRate, seconds, SOAK_FRAME_SIZE,
+                (unsigned)result.sent, (unsigned)result.received, (unsigned)result.lost, (unsigned)result.corrupt,
+                (unsigned)result.late, throughput, utilization,
+                result.latency.percentileUs(50) / 1000.0f, result.latency.percentileUs(99) / 1000.0f,
+                result.latency.maxUs / 1000.0f,
+                (unsigned)result.heapStart, (unsigned)result.heapEnd, (unsigned)result.heapMin,
+                (int)result.heapStart - (int)result.heapEnd, (unsigned)result.fragmentationMax);
+}
+
+// 等待发生器与对端完成连接
+static bool waitSoakConnected(bool local) {
+  uint32_t start = millis();
+  while (millis() - start < SOAK_CONNECT_TIMEOUT_MS) {
+    if (local) {
+      soakRelayLink.loop();
+    }
+    soakGenerator.loop();
+    if (soakGenerator.isConnected() && (!local || soakRelayLink.isConnected())) {
+      return true;
+    }
+    delay(10);
+  }
+  return false;
+}
+
+// 配对模式需要WiFi：使用配置文件中的网络
+static bool connectSoakWiFi() {
+  if (WiFi.status() == WL_CONNECTED) {
+    return true;
+  }
+  ConfigManager manager;
+  if (!manager.begin()) {
+    return false;
+  }
+  NetworkConfig network = manager.getNetworkConfig();
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(network.ssid.c_str(), network.password.c_str());
+  uint32_t start = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - start < SOAK_CONNECT_TIMEOUT_MS) {
+    delay(100);
+  }
+  return WiFi.status() == WL_CONNECTED;
+}
+
+// 参数：[每个波特率的秒数] [配对模式的主机]
+void runLoopbackSoak(const String& args) {
+  String rest = args;
+  rest.trim();
+  uint32_t durationS = SOAK_DEFAULT_DURATION_S;
+  String host;
+  if (rest.length() > 0) {
+    int space = rest.indexOf(' ');
+    String first = space < 0 ? rest : rest.substring(0, space);
+    if (first.toInt() > 0) {
+      durationS = first.toInt();
+      rest = space < 0 ? String() : rest.substring(space + 1);
+      rest.trim();
+    }
+    host = rest;
+  }
+  bool local = host.length() == 0;
+
+  if (local) {
+    LOG_I("Soak", "本机回环：每个波特率 %u 秒，UART0切换到GPIO15/GPIO13 (需跳线连接)", durationS);
+    soakRelayLink.beginServer(SOAK_PORT);
+    soakGenerator.beginClient("127.0.0.1", SOAK_PORT);
+  } else {
+    LOG_I("Soak", "配对模式：连接 %s:%u，运行 %u 秒", host.c_str(), DEFAULT_MASTER_TCP_PORT, durationS);
+    if (!connectSoakWiFi()) {
+      LOG_E("Soak", "WiFi未连接");
+      return;
+    }
+    soakGenerator.beginClient(host, DEFAULT_MASTER_TCP_PORT);
+  }
+  if (!waitSoakConnected(local)) {
+    LOG_E("Soak", "发生器未能连接");
+    soakGenerator.end();
+    soakRelayLink.end();
+    return;
+  }
+
+  if (!local) {
+    soakResult = SoakResult();
+    soakResult.latency.reset();
+    runSoakPass(false, durationS * 1000, soakResult);
+    printSoakResult(soakResult, "paired");
+    soakGenerator.end();
+    return;
+  }
+
+  // 总线占用UART0期间日志输出到Serial1，结果在恢复控制台后输出
+  soakRouter.begin(&soakBus, &soakRelayLink);
+  for (uint32_t baudRate : SOAK_BAUD_RATES) {
+#ifndef WIFLY485_NATIVE
+    logger.begin(Serial1);
+#endif
+    configureSoakBus(baudRate);
+    soakResult = SoakResult();
+    soakResult.latency.reset();
+    soakResult.baudRate = baudRate;
+    runSoakPass(true, durationS * 1000, soakResult);
+#ifndef WIFLY485_NATIVE
+    Serial.begin(115200);
+    logger.begin(Serial);
+#endif
+    printSoakResult(soakResult, "loopback");
+  }
+
+  soakGenerator.end();
+  soakRelayLink.end();
+}
@@ -0,0 +1,117 @@
+#include <Arduino.h>
+#include "config_manager.h"
+#include "logger.h"
+#include "rtc_store.h"
+#include "test_framework.h"
+#include "wifi_manager.h"
+
+// WiFi快速重连和热启动测试：RTC缓存记录的校验，缓存命中/失效时的连接方式，以及启动用配置缓存
+
+#define TEST_RTC_MAGIC 0x54455354  // "TEST"
+
+static NetworkConfig testNetworkConfig(const char* password) {
+  NetworkConfig config;
+  config.ssid = "WiFly485_Test";
+  config.password = password;
+  config.dhcpEnabled = true;
+  config.ip = DEFAULT_IP;
+  config.gateway = DEFAULT_GATEWAY;
+  config.subnet = DEFAULT_SUBNET;
+  return config;
+}
+
+TEST(RtcStore, "wifi rtc") {
+  LOG_I("Test", "开始RTC缓存记录测试");
+
+  uint8_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  uint8_t loaded[10];
+  ASSERT_TRUE(rtcSave(RTC_WIFI_CACHE_OFFSET, TEST_RTC_MAGIC, data, sizeof(data)));
+  ASSERT_TRUE(rtcLoad(RTC_WIFI_CACHE_OFFSET, TEST_RTC_MAGIC, loaded, sizeof(loaded)));
+  ASSERT_TRUE(memcmp(data, loaded, sizeof(data)) == 0);
+
+  // magic不符
+  ASSERT_TRUE(!rtcLoad(RTC_WIFI_CACHE_OFFSET, TEST_RTC_MAGIC + 1, loaded, sizeof(loaded)));
+
+  // 数据损坏 (如断电后的随机内容)
+  uint32_t block;
+  ESP.rtcUserMemoryRead(RTC_WIFI_CACHE_OFFSET + 2, &block, sizeof(block));
+  block ^= 0x00010000;
+  ESP.rtcUserMemoryWrite(RTC_WIFI_CACHE_OFFSET + 2, &block, sizeof(block));
+  ASSERT_TRUE(!rtcLoad(RTC_WIFI_CACHE_OFFSET, TEST_RTC_MAGIC, loaded, sizeof(loaded)));
+
+  rtcInvalidate(RTC_WIFI_CACHE_OFFSET);
+  LOG_I("Test", "RTC缓存记录测试完成");
+}
+
+TEST(WiFiFastReconnect, "wifi") {
+  LOG_I("Test", "开始WiFi快速重连测试");
+  rtcInvalidate(RTC_WIFI_CACHE_OFFSET);
+
+  // 冷启动：没有缓存，完整连接，连接后写入缓存
+  WiFiManager coldBoot;
+  coldBoot.begin(testNetworkConfig("password1"), "wifly485-test");
+  ASSERT_TRUE(coldBoot.getConnectMode() == WIFI_CONNECT_FULL);
+  coldBoot.loop();
+  ASSERT_TRUE(coldBoot.isConnected());
+
+  // 热启动：使用缓存
+  WiFiManager warmBoot;
+  warmBoot.begin(testNetworkConfig("password1"), "wifly485-test");
+  ASSERT_TRUE(warmBoot.getConnectMode() == WIFI_CONNECT_FAST);
+  warmBoot.loop();
+  ASSERT_TRUE(warmBoot.isConnected());
+  // 复用的租约连接后交还DHCP续约
+  ASSERT_TRUE(warmBoot.isRenewingLease());
+  ASSERT_TRUE(!coldBoot.isRenewingLease());
+
+  // 凭据改变后缓存失效
+  WiFiManager changedConfig;
+  changedConfig.begin(testNetworkConfig("password2"), "wifly485-test");
+  ASSERT_TRUE(changedConfig.getConnectMode() == WIFI_CONNECT_FULL);
+  changedConfig.loop();
+
+  // 租约连续复用达到上限后运行一次DHCP
+  int fastCount = 0;
+  for (int i = 0; i < WIFI_LEASE_MAX_REUSE + 1; i++) {
+    WiFiManager reboot;
+    reboot.begin(testNetworkConfig("password2"), "wifly485-test");
+    if (reboot.getConnectMode() == WIFI_CONNECT_FAST) {
+      fastCount++;
+    }
+    reboot.loop();
+  }
+  ASSERT_EQUAL(WIFI_LEASE_MAX_REUSE, fastCount);
+
+  rtcInvalidate(RTC_WIFI_CACHE_OFFSET);
+  LOG_I("Test", "WiFi快速重连测试完成");
+}
+
+TEST(BootConfigCache, "wifi config") {
+  LOG_I("Test", "开始启动用配置缓存测试");
+  rtcInvalidate(RTC_BOOT_CONFIG_OFFSET);
+
+  ConfigManager saved;
+  NetworkConfig network = testNetworkConfig("password1");
+  network.dhcpEnabled = false;
+  network.ip = "192.168.10.20";
+  saved.setNetworkConfig(network);
+  RS485Config bus = saved.getRS485Config();
+  bus.baudRate = 19200;
+  bus.parity = 2;
+  saved.setRS485Config(bus);
+
+  ConfigManager loaded;
+  ASSERT_TRUE(!loaded.loadCachedConfig());
+  ASSERT_TRUE(saved.saveCachedConfig());
+  ASSERT_TRUE(loaded.loadCachedConfig());
+  ASSERT_STRING_EQUAL("WiFly485_Test", loaded.getNetworkConfig().ssid.c_str());
+  ASSERT_STRING_EQUAL("password1", loaded.getNetworkConfig().password.c_str());
+  ASSERT_STRING_EQUAL("192.168.10.20", loaded.getNetworkConfig().ip.c_str());
+  ASSERT_TRUE(!loaded.getNetworkConfig().dhcpEnabled);
+  ASSERT_EQUAL(19200, (int)loaded.getRS485Config().baudRate);
+  ASSERT_EQUAL(2, (int)loaded.getRS485Config().parity);
+  ASSERT_EQUAL(DEFAULT_MASTER_TCP_PORT, (int)loaded.getDeviceConfig().tcpPort);
+
+  rtcInvalidate(RTC_BOOT_CONFIG_OFFSET);
+  LOG_I("Test", "启动用配置缓存测试完成");
+}
@@ -0,0 +1,414 @@
+#include "traffic_capture.h"
+#include "logger.h"
+#include "metrics.h"
+
+// 小端整数读写
+static void putU16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+static void putU32(uint8_t* p, uint32_t value) {
+  p[0] = value & 0xFF;
+  p[1] = (value >> 8) & 0xFF;
+  p[2] = (value >> 16) & 0xFF;
+  p[3] = value >> 24;
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ---------------------------------------------------------------------------
+// TrafficCapture
+// ---------------------------------------------------------------------------
+
+TrafficCapture::TrafficCapture()
+    : active(false), role(CAPTURE_ROLE_MASTER), segmentCount(0),
+      ringHead(0), ringTail(0), ringUsed(0), pendingGap(false),
+      segmentSequence(0), segmentIndex(0), segmentOffset(0), lastFlush(0),
+      recordsCaptured(0), recordsDropped(0), bytesWritten(0), segmentsWritten(0) {
+  // 构造函数
+}
+
+TrafficCapture::~TrafficCapture() {
+  // 析构函数
+  end();
+}
+
+bool TrafficCapture::begin(FS& fs, const RS485Config& config, CaptureRole role, const char* path, uint32_t fileSize) {
+  File file = fs.open(path, "w+");
+  if (!file) {
+    LOG_E("Capture", "无法创建捕获文件: %s", path);
+    return false;
+  }
+  return begin(file, config, role, fileSize);
+}
+
+bool TrafficCapture::begin(File file, const RS485Config& config, CaptureRole role, uint32_t fileSize) {
+  end();
+  if (!file) {
+    return false;
+  }
+
+  segmentCount = fileSize / CAPTURE_SEGMENT_SIZE;
+  if (segmentCount > CAPTURE_MAX_SEGMENTS) {
+    segmentCount = CAPTURE_MAX_SEGMENTS;
+  }
+  if (segmentCount == 0) {
+    LOG_E("Capture", "捕获文件大小无效: %u", fileSize);
+    return false;
+  }
+
+  this->file = file;
+  this->config = config;
+  this->role = role;
+  ringHead = ringTail = ringUsed = 0;
+  pendingGap = false;
+  segmentSequence = 0;
+  segmentIndex = segmentCount - 1;  // startSegment() 从第0段开始
+  recordsCaptured = recordsDropped = bytesWritten = segmentsWritten = 0;
+  startSegment();
+
+  lastFlush = millis();
+  active = true;
+  LOG_I("Capture", "开始捕获: %s (%u 段)", file.name(), segmentCount);
+  return true;
+}
+
+void TrafficCapture::end() {
+  if (!active) {
+    return;
+  }
+  flush();
+  file.close();
+  active = false;
+  LOG_I("Capture", "捕获结束: %u 条记录, 丢弃 %u 条", recordsCaptured, recordsDropped);
+}
+
+void TrafficCapture::record(CaptureDirection direction, const uint8_t* data, uint16_t length, uint32_t timestamp) {
+  if (!active || length == 0 || length > RS485_FRAME_BUFFER_SIZE) {
+    return;
+  }
+
+  uint16_t total = CAPTURE_RECORD_HEADER_SIZE + length;
+  if (ringUsed + total > CAPTURE_RAM_BUFFER_SIZE) {
+    // 缓冲区满：丢弃，并在下一条记录上标记缺口
+    recordsDropped++;
+    METRIC_INC(METRIC_CAPTURE_DROPPED_RECORDS);
+    pendingGap = true;
+    return;
+  }
+
+  uint8_t header[CAPTURE_RECORD_HEADER_SIZE];
+  putU32(header, timestamp);
+  header[4] = (uint8_t)direction | (pendingGap ? CAPTURE_FLAG_GAP : 0);
+  header[5] = 0;
+  putU16(header + 6, length);
+
+  ringWrite(header, sizeof(header));
+  ringWrite(data, length);
+  pendingGap = false;
+  recordsCaptured++;
+}
+
+void TrafficCapture::loop() {
+  if (!active || ringUsed == 0) {
+    return;
+  }
+  if (ringUsed >= CAPTURE_FLUSH_THRESHOLD || millis() - lastFlush >= CAPTURE_FLUSH_INTERVAL_MS) {
+    flush();
+  }
+}
+
+void TrafficCapture::flush() {
+  if (!active) {
+    return;
+  }
+
+  uint8_t buffer[CAPTURE_RECORD_HEADER_SIZE + RS485_FRAME_BUFFER_SIZE];
+  while (ringUsed >= CAPTURE_RECORD_HEADER_SIZE) {
+    ringPeek(buffer, CAPTURE_RECORD_HEADER_SIZE);
+    uint16_t total = CAPTURE_RECORD_HEADER_SIZE + getU16(buffer + 6);
+
+    // 记录不跨段
+    if (segmentOffset + total > CAPTURE_SEGMENT_SIZE) {
+      startSegment();
+    }
+
+    ringRead(buffer, total);
+    file.write(buffer, total);
+    segmentOffset += total;
+    bytesWritten += total;
+  }
+
+  file.flush();
+  lastFlush = millis();
+}
+
+void TrafficCapture::startSegment() {
+  segmentIndex = (segmentIndex + 1) % segmentCount;
+  segmentSequence++;
+  segmentsWritten++;
+
+  // 清零整段，读取时遇到长度为0的记录即为段尾
+  static const uint8_t zeros[256] = {0};
+  file.seek(segmentIndex * CAPTURE_SEGMENT_SIZE, SeekSet);
+  for (uint32_t i = 0; i < CAPTURE_SEGMENT_SIZE; i += sizeof(zeros)) {
+    file.write(zeros, sizeof(zeros));
+  }
+
+  uint8_t header[CAPTURE_SEGMENT_HEADER_SIZE];
+  putU32(header, CAPTURE_MAGIC);
+  putU32(header + 4, segmentSequence);
+  putU32(header + 8, config.baudRate);
+  header[12] = config.dataBits;
+  header[13] = config.parity;
+  header[14] = config.stopBits;
+  header[15] = (uint8_t)role;
+
+  file.seek(segmentIndex * CAPTURE_SEGMENT_SIZE, SeekSet);
+  file.write(header, sizeof(header));
+  segmentOffset = CAPTURE_SEGMENT_HEADER_SIZE;
+}
+
+void TrafficCapture::ringWrite(const uint8_t* data, uint16_t length) {
+  uint16_t first = CAPTURE_RAM_BUFFER_SIZE - ringHead;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(ring + ringHead, data, first);
+  memcpy(ring, data + first, length - first);
+  ringHead = (ringHead + length) % CAPTURE_RAM_BUFFER_SIZE;
+  ringUsed += length;
+}
+
+void TrafficCapture::ringPeek(uint8_t* data, uint16_t length) {
+  uint16_t first = CAPTURE_RAM_BUFFER_SIZE - ringTail;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(data, ring + ringTail, first);
+  memcpy(data + first, ring, length - first);
+}
+
+void TrafficCapture::ringRead(uint8_t* data, uint16_t length) {
+  ringPeek(data, length);
+  ringTail = (ringTail + length) % CAPTURE_RAM_BUFFER_SIZE;
+  ringUsed -= length;
+}
+
+// ---------------------------------------------------------------------------
+// CaptureReader
+// ---------------------------------------------------------------------------
+
+CaptureReader::CaptureReader() : role(CAPTURE_ROLE_MASTER), orderCount(0), orderPosition(0), segmentOffset(0) {
+  // 构造函数
+  config.baudRate = DEFAULT_BAUD_RATE;
+  config.dataBits = DEFAULT_DATA_BITS;
+  config.parity = DEFAULT_PARITY;
+  config.stopBits = DEFAULT_STOP_BITS;
+  config.replayTiming = DEFAULT_REPLAY_TIMING;
+}
+
+CaptureReader::~CaptureReader() {
+  // 析构函数
+  end();
+}
+
+bool CaptureReader::begin(FS& fs, const char* path) {
+  File file = fs.open(path, "r");
+  if (!file) {
+    LOG_E("Capture", "无法打开捕获文件: %s", path);
+    return false;
+  }
+  return begin(file);
+}
+
+bool CaptureReader::begin(File file) {
+  end();
+  if (!file) {
+    return false;
+  }
+  this->file = file;
+
+  // 收集有效段并按序号排序 (插入排序，段数很少)
+  uint32_t sequences[CAPTURE_MAX_SEGMENTS];
+  uint32_t segments = file.size() / CAPTURE_SEGMENT_SIZE;
+  if (segments > CAPTURE_MAX_SEGMENTS) {
+    segments = CAPTURE_MAX_SEGMENTS;
+  }
+
+  orderCount = 0;
+  for (uint32_t i = 0; i < segments; i++) {
+    uint8_t header[CAPTURE_SEGMENT_HEADER_SIZE];
+    file.seek(i * CAPTURE_SEGMENT_SIZE, SeekSet);
+    if (file.read(header, sizeof(header)) != sizeof(header) || getU32(header) != CAPTURE_MAGIC) {
+      continue;
+    }
+
+    uint32_t sequence = getU32(header + 4);
+    int pos = orderCount;
+    while (pos > 0 && sequences[pos - 1] > sequence) {
+      sequences[pos] = sequences[pos - 1];
+      order[pos] = order[pos - 1];
+      pos--;
+    }
+    sequences[pos] = sequence;
+    order[pos] = i;
+    orderCount++;
+
+    // 串口配置取自最早的段
+    if (pos == 0) {
+      config.baudRate = getU32(header + 8);
+      config.dataBits = header[12];
+      config.parity = header[13];
+      config.stopBits = header[14];
+      role = (CaptureRole)header[15];
+    }
+  }
+
+  if (orderCount == 0) {
+    LOG_W("Capture", "捕获文件中没有有效数据: %s", file.name());
+  }
+
+  rewind();
+  return true;
+}
+
+void CaptureReader::end() {
+  if (file) {
+    file.close();
+  }
+  orderCount = 0;
+}
+
+void CaptureReader::rewind() {
+  orderPosition = 0;
+  segmentOffset = CAPTURE_SEGMENT_HEADER_SIZE;
+  if (orderCount > 0) {
+    file.seek(order[0] * CAPTURE_SEGMENT_SIZE + segmentOffset, SeekSet);
+  }
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+  while (orderPosition < orderCount) {
+    uint8_t header[CAPTURE_RECORD_HEADER_SIZE];
+    bool valid = segmentOffset + CAPTURE_RECORD_HEADER_SIZE <= CAPTURE_SEGMENT_SIZE &&
+                 file.read(header, sizeof(header)) == sizeof(header);
+
+    uint16_t length = valid ? getU16(header + 6) : 0;
+    if (length == 0 || length > RS485_FRAME_BUFFER_SIZE ||
+        segmentOffset + CAPTURE_RECORD_HEADER_SIZE + length > CAPTURE_SEGMENT_SIZE) {
+      // 段尾：转到下一段
+      orderPosition++;
+      segmentOffset = CAPTURE_SEGMENT_HEADER_SIZE;
+      if (orderPosition < orderCount) {
+        file.seek(order[orderPosition] * CAPTURE_SEGMENT_SIZE + segmentOffset, SeekSet);
+      }
+      continue;
+    }
+
+    if (file.read(record.data, length) != length) {
+      orderPosition = orderCount;
+      return false;
+    }
+    record.timestamp = getU32(header);
+    record.flags = header[4];
+    record.length = length;
+    segmentOffset += CAPTURE_RECORD_HEADER_SIZE + length;
+    return true;
+  }
+  return false;
+}
+
+// ---------------------------------------------------------------------------
+// TrafficReplay
+// ---------------------------------------------------------------------------
+
+TrafficReplay::TrafficReplay()
+    : bus(nullptr), direction(CAPTURE_BUS_TO_LINK), hasPending(false), active(false),
+      captureStart(0), replayStart(0), framesSent(0), maxLateUs(0) {
+  // 构造函数
+}
+
+bool TrafficReplay::begin(FS& fs, RS485* bus, CaptureDirection direction, const char* path) {
+  if (bus == nullptr || !reader.begin(fs, path)) {
+    return false;
+  }
+
+  this->bus = bus;
+  this->direction = direction;
+  framesSent = 0;
+  maxLateUs = 0;
+
+  if (!loadNext()) {
+    LOG_W("Capture", "捕获文件中没有可回放的帧");
+    reader.end();
+    return false;
+  }
+
+  captureStart = pending.timestamp;
+  replayStart = micros();
+  active = true;
+  LOG_I("Capture", "开始回放: %s", path);
+  return true;
+}
+
+void TrafficReplay::end() {
+  if (active) {
+    LOG_I("Capture", "回放结束: 发送 %u 帧, 最大滞后 %u us", framesSent, maxLateUs);
+  }
+  reader.end();
+  active = false;
+  hasPending = false;
+}
+
+bool TrafficReplay::loop() {
+  if (!active) {
+    return false;
+  }
+
+  // 读走被测中继转发回来的应答，保持总线接收状态
+  RS485Frame response;
+  if (bus->poll()) {
+    bus->readFrame(response);
+  }
+
+  if (!hasPending) {
+    end();
+    return false;
+  }
+
+  // 按原始时间间隔发送 (时间戳差值对micros()回绕安全)
+  uint32_t due = replayStart + (pending.timestamp - captureStart);
+  uint32_t now = micros();
+  if ((int32_t)(now - due) < 0 || !bus->isBusIdle()) {
+    return true;
+  }
+
+  uint32_t late = now - due;
+  if (late > maxLateUs) {
+    maxLateUs = late;
+  }
+  if (bus->sendFrame(pending.data, pending.length)) {
+    framesSent++;
+  }
+  loadNext();
+  return true;
+}
+
+bool TrafficReplay::loadNext() {
+  while (reader.next(pending)) {
+    if (pending.direction() == direction) {
+      hasPending = true;
+      return true;
+    }
+  }
+  hasPending = false;
+  return false;
+}
\ No newline at end of file
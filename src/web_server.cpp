@@ -0,0 +1,302 @@
+#include "web_server.h"
+#include "boot_profiler.h"
+#include "config_schema.h"
+#include "frame_trace.h"
+#include "heap_profiler.h"
+#include "logger.h"
+#include "metrics.h"
+#include "ota_updater.h"
+#include "response_timeout.h"
+
+// ---------------------------------------------------------------------------
+// WebResponseWriter
+// ---------------------------------------------------------------------------
+
+WebResponseWriter::WebResponseWriter(ESP8266WebServer& server) : server(server), used(0), bytesWritten(0) {
+  // 构造函数
+}
+
+WebResponseWriter::~WebResponseWriter() {
+  // 析构函数
+}
+
+void WebResponseWriter::begin(int code, const char* contentType) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, contentType, "");
+  used = 0;
+  bytesWritten = 0;
+}
+
+void WebResponseWriter::end() {
+  sendBuffer();
+  // 空块表示分块传输结束
+  server.sendContent("");
+}
+
+size_t WebResponseWriter::write(uint8_t c) {
+  if (used == sizeof(buffer)) {
+    sendBuffer();
+  }
+  buffer[used++] = (char)c;
+  bytesWritten++;
+  return 1;
+}
+
+size_t WebResponseWriter::write(const uint8_t* data, size_t size) {
+  size_t remaining = size;
+  while (remaining > 0) {
+    if (used == sizeof(buffer)) {
+      sendBuffer();
+    }
+    size_t n = sizeof(buffer) - used;
+    if (n > remaining) {
+      n = remaining;
+    }
+    memcpy(buffer + used, data, n);
+    used += n;
+    data += n;
+    remaining -= n;
+  }
+  bytesWritten += size;
+  return size;
+}
+
+void WebResponseWriter::sendBuffer() {
+  if (used > 0) {
+    server.sendContent(buffer, used);
+    used = 0;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// WebAssetStreamer
+// ---------------------------------------------------------------------------
+
+WebAssetStreamer::WebAssetStreamer() {
+  // 构造函数
+  for (uint8_t i = 0; i < WEB_ASSET_MAX_STREAMS; i++) {
+    transfers[i].asset = nullptr;
+    transfers[i].offset = 0;
+    transfers[i].active = false;
+  }
+}
+
+WebAssetStreamer::~WebAssetStreamer() {
+  // 析构函数
+}
+
+bool WebAssetStreamer::start(WiFiClient& client, const WebAsset* asset) {
+  for (uint8_t i = 0; i < WEB_ASSET_MAX_STREAMS; i++) {
+    AssetTransfer& transfer = transfers[i];
+    if (!transfer.active) {
+      // 保留连接的引用，请求处理函数返回后连接仍然有效
+      transfer.client = client;
+      transfer.asset = asset;
+      transfer.offset = 0;
+      transfer.active = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WebAssetStreamer::loop() {
+  for (uint8_t i = 0; i < WEB_ASSET_MAX_STREAMS; i++) {
+    AssetTransfer& transfer = transfers[i];
+    if (!transfer.active) {
+      continue;
+    }
+    if (!transfer.client.connected()) {
+      transfer.active = false;
+      transfer.client.stop();
+      continue;
+    }
+
+    // 只写入发送缓冲区能立即接受的数据，不等待对端确认
+    uint32_t n = transfer.asset->length - transfer.offset;
+    if (n > WEB_RESPONSE_CHUNK_SIZE) {
+      n = WEB_RESPONSE_CHUNK_SIZE;
+    }
+    uint32_t writable = transfer.client.availableForWrite();
+    if (n > writable) {
+      n = writable;
+    }
+    if (n > 0) {
+      transfer.offset += transfer.client.write_P((PGM_P)(transfer.asset->data + transfer.offset), n);
+    }
+
+    if (transfer.offset >= transfer.asset->length) {
+      // 响应以Connection: close结束，关闭连接让服务器接受下一个请求
+      transfer.client.stop();
+      transfer.active = false;
+    }
+  }
+}
+
+uint8_t WebAssetStreamer::getActiveCount() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < WEB_ASSET_MAX_STREAMS; i++) {
+    if (transfers[i].active) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// ---------------------------------------------------------------------------
+// WebServerManager
+// ---------------------------------------------------------------------------
+
+WebServerManager::WebServerManager() : server(nullptr), device(nullptr), scheduler(nullptr), configManager(nullptr) {
+  // 构造函数
+}
+
+WebServerManager::~WebServerManager() {
+  // 析构函数
+  if (server != nullptr) {
+    server->stop();
+    delete server;
+  }
+}
+
+bool WebServerManager::begin(Device* device, Scheduler* scheduler, uint16_t port) {
+  this->device = device;
+  this->scheduler = scheduler;
+
+  server = new ESP8266WebServer(port);
+
+  // 条件请求需要读取If-None-Match
+  static const char* collectedHeaders[] = {"If-None-Match"};
+  server->collectHeaders(collectedHeaders, 1);
+
+  for (uint8_t i = 0; i < WEB_ASSET_COUNT; i++) {
+    const WebAsset* asset = &WEB_ASSETS[i];
+    server->on(asset->path, HTTP_GET, [this, asset]() { handleAsset(asset); });
+    if (strcmp(asset->path, "/index.html") == 0) {
+      server->on("/", HTTP_GET, [this, asset]() { handleAsset(asset); });
+    }
+  }
+
+  server->on("/metrics", HTTP_GET, [this]() { handleMetrics(); });
+  server->on("/api/status", HTTP_GET, [this]() { handleStatus(); });
+  server->on("/api/config", HTTP_GET, [this]() { handleConfig(); });
+  server->on("/events", HTTP_GET, [this]() { handleEvents(); });
+  server->onNotFound([this]() { handleNotFound(); });
+  server->begin();
+
+  LOG_I("Web", "Web服务器监听端口 %u", port);
+  return true;
+}
+
+void WebServerManager::loop() {
+  if (server != nullptr) {
+    server->handleClient();
+  }
+  assetStreamer.loop();
+  statusEvents.loop();
+}
+
+void WebServerManager::handleAsset(const WebAsset* asset) {
+  server->sendHeader("Cache-Control", WEB_ASSET_CACHE_CONTROL);
+  server->sendHeader("ETag", asset->etag);
+
+  // 浏览器缓存的版本仍然有效
+  if (server->header("If-None-Match") == asset->etag) {
+    server->send(304, asset->contentType, "");
+    return;
+  }
+
+  // 资源只以gzip形式存储，所有目标浏览器都支持gzip
+  server->sendHeader("Content-Encoding", "gzip");
+  server->setContentLength(asset->length);
+  server->send(200, asset->contentType, "");
+
+  WiFiClient client = server->client();
+  if (!assetStreamer.start(client, asset)) {
+    // 没有空闲的发送槽，直接发送 (阻塞到数据进入发送缓冲区)
+    LOG_W("Web", "资源发送槽已满，同步发送 %s", asset->path);
+    client.write_P((PGM_P)asset->data, asset->length);
+  }
+}
+
+void WebServerManager::handleMetrics() {
+  uint32_t start = micros();
+
+  WebResponseWriter writer(*server);
+  writer.begin(200, "text/plain; version=0.0.4");
+  metrics.writePrometheus(writer);
+  responseTimeouts.writePrometheus(writer);
+  writer.end();
+
+  // 包含网络发送在内的完整耗时，下一次导出时可见
+  metrics.recordScrape(micros() - start);
+}
+
+void WebServerManager::handleStatus() {
+  uint32_t start = micros();
+
+  WebResponseWriter writer(*server);
+  writer.begin(200, "application/json");
+  writer.printf("{\"device\":{\"name\":\"%s\",\"role\":\"%s\",\"uptime_ms\":%u},\"counters\":",
+                device != nullptr ? device->getName().c_str() : "",
+                device != nullptr ? device->getRoleString().c_str() : "unknown",
+                (uint32_t)millis());
+  metrics.writeJson(writer);
+  writer.print(",\"trace\":");
+  frameTrace.printJson(writer);
+  writer.print(",\"boot\":");
+  bootProfiler.printJson(writer);
+  writer.print(",\"heap\":");
+  heapProfiler.printJson(writer);
+  writer.print(",\"ota\":");
+  otaUpdater.printJson(writer);
+  writer.print(",\"responses\":");
+  responseTimeouts.printJson(writer);
+  writer.printf(",\"events\":{\"clients\":%u,\"sent\":%u,\"skipped\":%u}", statusEvents.getClientCount(),
+                statusEvents.getEventsSent(), statusEvents.getEventsSkipped());
+  if (scheduler != nullptr) {
+    writer.print(",\"scheduler\":");
+    scheduler->printJson(writer);
+  }
+  writer.print('}');
+  writer.end();
+
+  metrics.recordScrape(micros() - start);
+}
+
+void WebServerManager::handleConfig() {
+  if (configManager == nullptr) {
+    handleNotFound();
+    return;
+  }
+
+  // 字段由配置描述表决定，不输出密码
+  DynamicJsonDocument doc(1024);
+  configManager->toJson(doc, CONFIG_FLAG_SECRET);
+
+  WebResponseWriter writer(*server);
+  writer.begin(200, "application/json");
+  serializeJson(doc, writer);
+  writer.end();
+}
+
+void WebServerManager::handleEvents() {
+  WiFiClient client = server->client();
+  if (statusEvents.getClientCount() >= WEB_EVENT_MAX_CLIENTS) {
+    server->send(503, "text/plain", "Too many event streams");
+    return;
+  }
+
+  // 事件流没有长度，也不使用分块编码，响应头直接写入连接，连接关闭即结束
+  client.print("HTTP/1.1 200 OK\r\n"
+               "Content-Type: text/event-stream\r\n"
+               "Cache-Control: no-cache\r\n"
+               "Connection: close\r\n"
+               "\r\n"
+               "retry: 5000\n\n");
+  statusEvents.addClient(client);
+}
+
+void WebServerManager::handleNotFound() {
+  server->send(404, "text/plain", "Not Found");
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "wifi_manager.h"
+#include "logger.h"
+#include "metrics.h"
+#include "rtc_store.h"
+
+#define WIFI_RTC_MAGIC 0x57494649  // "WIFI"
+
+WiFiManager::WiFiManager()
+    : state(STATE_IDLE), connectMode(WIFI_CONNECT_NONE), connectStartMs(0), connectTimeMs(0), credentialHash(0),
+      leaseReuses(0), renewingLease(false), leaseIp(0) {
+  // 构造函数
+}
+
+WiFiManager::~WiFiManager() {
+  // 析构函数
+}
+
+bool WiFiManager::begin(const NetworkConfig& config, const char* hostname) {
+  this->config = config;
+  credentialHash = rtcCrc32(config.ssid.c_str(), config.ssid.length());
+  credentialHash = rtcCrc32(config.password.c_str(), config.password.length(), credentialHash);
+
+  // SDK保存凭据供下次冷启动尽早连接 (见beginFromStoredCredentials)，凭据未变时SDK不写闪存
+  WiFi.persistent(true);
+  WiFi.mode(WIFI_STA);
+  WiFi.hostname(hostname);
+  WiFi.setAutoReconnect(true);
+
+  connectStartMs = millis();
+  state = STATE_CONNECTING;
+  renewingLease = false;
+  if (!beginFast()) {
+    beginFull();
+  }
+  return true;
+}
+
+bool WiFiManager::beginFromStoredCredentials(const char* hostname) {
+  NetworkConfig stored;
+  stored.ssid = WiFi.SSID();
+  stored.password = WiFi.psk();
+  stored.dhcpEnabled = true;
+  if (stored.ssid.length() == 0) {
+    return false;
+  }
+  return begin(stored, hostname);
+}
+
+bool WiFiManager::isConfiguredFor(const NetworkConfig& other) {
+  if (state == STATE_IDLE || other.ssid != config.ssid || other.password != config.password ||
+      other.dhcpEnabled != config.dhcpEnabled) {
+    return false;
+  }
+  return other.dhcpEnabled ||
+         (other.ip == config.ip && other.gateway == config.gateway && other.subnet == config.subnet);
+}
+
+bool WiFiManager::beginFast() {
+  WiFiRtcCache cache;
+  if (!rtcLoad(RTC_WIFI_CACHE_OFFSET, WIFI_RTC_MAGIC, &cache, sizeof(cache)) ||
+      cache.credentialHash != credentialHash) {
+    return false;
+  }
+  // 没有租约或租约已多次复用时运行DHCP
+  if (config.dhcpEnabled && (!cache.hasLease || cache.leaseReuses >= WIFI_LEASE_MAX_REUSE)) {
+    return false;
+  }
+  leaseReuses = cache.leaseReuses + 1;
+
+  if (config.dhcpEnabled) {
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+  } else {
+    IPAddress ip, gateway, subnet;
+    ip.fromString(config.ip);
+    gateway.fromString(config.gateway);
+    subnet.fromString(config.subnet);
+    WiFi.config(ip, gateway, subnet);
+  }
+  WiFi.begin(config.ssid.c_str(), config.password.c_str(), cache.channel, cache.bssid);
+
+  connectMode = WIFI_CONNECT_FAST;
+  LOG_I("WiFi", "快速连接 %s (信道 %u, %02X:%02X:%02X:%02X:%02X:%02X)", config.ssid.c_str(), cache.channel,
+        cache.bssid[0], cache.bssid[1], cache.bssid[2], cache.bssid[3], cache.bssid[4], cache.bssid[5]);
+  return true;
+}
+
+void WiFiManager::beginFull() {
+  if (config.dhcpEnabled) {
+    // 全零地址恢复DHCP
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+  } else {
+    IPAddress ip, gateway, subnet;
+    ip.fromString(config.ip);
+    gateway.fromString(config.gateway);
+    subnet.fromString(config.subnet);
+    WiFi.config(ip, gateway, subnet);
+  }
+  WiFi.begin(config.ssid.c_str(), config.password.c_str());
+
+  connectMode = WIFI_CONNECT_FULL;
+  leaseReuses = 0;
+  LOG_I("WiFi", "连接WiFi: %s", config.ssid.c_str());
+}
+
+void WiFiManager::loop() {
+  wl_status_t status = WiFi.status();
+
+  switch (state) {
+    case STATE_CONNECTING:
+      if (status == WL_CONNECTED) {
+        onConnected();
+      } else if (connectMode == WIFI_CONNECT_FAST &&
+                 (status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED ||
+                  millis() - connectStartMs > WIFI_FAST_CONNECT_TIMEOUT_MS)) {
+        // 接入点换了信道、下线或缓存的租约不再可用
+        LOG_W("WiFi", "快速连接失败 (状态 %d)，清除缓存并重新扫描", (int)status);
+        rtcInvalidate(RTC_WIFI_CACHE_OFFSET);
+        WiFi.disconnect();
+        beginFull();
+      }
+      break;
+
+    case STATE_CONNECTED:
+      if (status != WL_CONNECTED) {
+        state = STATE_DISCONNECTED;
+        LOG_W("WiFi", "WiFi连接断开");
+      } else if (renewingLease && WiFi.localIP().isSet() && (uint32_t)WiFi.localIP() != leaseIp) {
+        // 服务器分配了新地址：下次热启动使用新的租约
+        LOG_W("WiFi", "DHCP续约得到新地址: %s", WiFi.localIP().toString().c_str());
+        leaseIp = (uint32_t)WiFi.localIP();
+        saveCache();
+      }
+      break;
+
+    case STATE_DISCONNECTED:
+      // SDK自动重连，可能连到另一个接入点，连接后重新保存缓存
+      if (status == WL_CONNECTED) {
+        state = STATE_CONNECTED;
+        saveCache();
+        LOG_I("WiFi", "WiFi重新连接: %s", WiFi.localIP().toString().c_str());
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void WiFiManager::onConnected() {
+  state = STATE_CONNECTED;
+  connectTimeMs = millis();
+  metrics.setGauge(GAUGE_WIFI_CONNECT_MS, connectTimeMs);
+  metrics.setGauge(GAUGE_WIFI_FAST_CONNECT, connectMode == WIFI_CONNECT_FAST ? 1 : 0);
+  saveCache();
+  if (connectMode == WIFI_CONNECT_FAST && config.dhcpEnabled) {
+    renewLease();
+  }
+
+  LOG_I("WiFi", "WiFi已连接: %s (%s连接，启动后 %u ms)", WiFi.localIP().toString().c_str(),
+        connectMode == WIFI_CONNECT_FAST ? "快速" : "完整", connectTimeMs);
+}
+
+void WiFiManager::renewLease() {
+  // 全零地址恢复DHCP客户端：向服务器请求续约，租约由DHCP按租期维护
+  leaseIp = (uint32_t)WiFi.localIP();
+  WiFi.config(IPAddress(), IPAddress(), IPAddress());
+  renewingLease = true;
+  LOG_D("WiFi", "快速连接复用租约，重新启动DHCP续约");
+}
+
+void WiFiManager::saveCache() {
+  WiFiRtcCache cache;
+  memset(&cache, 0, sizeof(cache));
+  cache.credentialHash = credentialHash;
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.channel = (uint8_t)WiFi.channel();
+  cache.hasLease = config.dhcpEnabled ? 1 : 0;
+  cache.leaseReuses = connectMode == WIFI_CONNECT_FAST ? leaseReuses : 0;
+  cache.ip = (uint32_t)WiFi.localIP();
+  cache.gateway = (uint32_t)WiFi.gatewayIP();
+  cache.subnet = (uint32_t)WiFi.subnetMask();
+  cache.dns = (uint32_t)WiFi.dnsIP();
+  rtcSave(RTC_WIFI_CACHE_OFFSET, WIFI_RTC_MAGIC, &cache, sizeof(cache));
+}
+
+bool WiFiManager::isConnected() {
+  return state == STATE_CONNECTED;
+}
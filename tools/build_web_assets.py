@@ -0,0 +1,87 @@
+"""把 data/ 中的Web界面文件压缩后生成 src/web_assets.cpp。
+
+资源以gzip形式存放在程序闪存 (PROGMEM) 中，请求时不读取SPIFFS，也不在运行时压缩。
+ETag取压缩后内容的SHA-1前16位，资源不变时生成的文件保持不变。
+
+PlatformIO构建前自动运行 (extra_scripts = pre:tools/build_web_assets.py)，
+也可以单独运行: python3 tools/build_web_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+
+# 参与打包的文件及其Content-Type，URL为 "/" + 文件名
+ASSETS = [
+    ("index.html", "text/html; charset=utf-8"),
+    ("config.html", "text/html; charset=utf-8"),
+    ("style.css", "text/css"),
+    ("script.js", "application/javascript"),
+]
+
+OUTPUT = os.path.join("src", "web_assets.cpp")
+
+
+def c_identifier(name):
+    return "ASSET_" + "".join(c.upper() if c.isalnum() else "_" for c in name)
+
+
+def compress(data):
+    # mtime固定为0，保证相同输入得到相同输出
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def render(project_dir):
+    lines = [
+        "// 由 tools/build_web_assets.py 从 data/ 生成，请勿手工修改",
+        '#include "web_assets.h"',
+        "",
+    ]
+    table = []
+    total_raw = 0
+    total_gz = 0
+    for name, content_type in ASSETS:
+        with open(os.path.join(project_dir, "data", name), "rb") as f:
+            raw = f.read()
+        gz = compress(raw)
+        total_raw += len(raw)
+        total_gz += len(gz)
+        ident = c_identifier(name)
+        etag = '\\"%s\\"' % hashlib.sha1(gz).hexdigest()[:16]
+
+        lines.append("// %s: %u -> %u bytes" % (name, len(raw), len(gz)))
+        lines.append("static const uint8_t %s[] PROGMEM = {" % ident)
+        for i in range(0, len(gz), 16):
+            lines.append("  " + ", ".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+        table.append('  {"/%s", "%s", "%s", %s, sizeof(%s)},' % (name, content_type, etag, ident, ident))
+
+    lines.append("const WebAsset WEB_ASSETS[] = {")
+    lines.extend(table)
+    lines.append("};")
+    lines.append("")
+    lines.append("const uint8_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    lines.append("")
+    return "\n".join(lines), total_raw, total_gz
+
+
+def build(project_dir):
+    content, total_raw, total_gz = render(project_dir)
+    path = os.path.join(project_dir, OUTPUT)
+    # 内容不变时不重写，避免触发重新编译
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == content:
+                return
+    with open(path, "w") as f:
+        f.write(content)
+    print("web assets: %u -> %u bytes (gzip) -> %s" % (total_raw, total_gz, OUTPUT))
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO/SCons提供)
+    build(env.subst("$PROJECT_DIR"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        build(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,91 @@
+"""通过升级端口向设备发送固件映像，升级期间设备继续转发总线数据。
+
+协议见 include/ota_updater.h：设备先发送一行 "AUTH <随机挑战>"，随后发送
+[魔数 "WOTA"][映像长度 4][MD5 16][HMAC-MD5(口令, 挑战 + MD5) 16][映像]，设备回复一行 "OK" 或 "ERR <原因>"。
+设备按闪存写入的速度从连接中读取，发送速度由TCP流量控制决定。
+
+用法: python3 tools/ota_upload.py <设备地址> <固件.bin> --password <升级口令> [--port 8890]
+口令即配置中的 device.otaPassword，也可以通过环境变量 WIFLY485_OTA_PASSWORD 给出
+固件通常位于 .pio/build/wifly485_master/firmware.bin
+"""
+
+import argparse
+import hashlib
+import hmac
+import os
+import socket
+import struct
+import sys
+import time
+
+OTA_MAGIC = b"WOTA"
+DEFAULT_PORT = 8890   # 与 config.h 中的 OTA_TCP_PORT 一致
+CHUNK_SIZE = 1024
+REPLY_TIMEOUT_S = 30  # 最后一段写入后还需要读回校验
+
+
+def read_line(sock):
+    line = b""
+    while not line.endswith(b"\n"):
+        data = sock.recv(1)
+        if not data:
+            break
+        line += data
+    return line.decode("ascii", "replace").strip()
+
+
+def upload(host, port, image, password):
+    digest = hashlib.md5(image).digest()
+    start = time.monotonic()
+    with socket.create_connection((host, port), timeout=15) as sock:
+        challenge = read_line(sock)
+        if not challenge.startswith("AUTH "):
+            return challenge, time.monotonic() - start
+        nonce = bytes.fromhex(challenge[5:])
+        auth = hmac.new(password.encode("utf-8"), nonce + digest, hashlib.md5).digest()
+        sock.sendall(OTA_MAGIC + struct.pack("<I", len(image)) + digest + auth)
+        sent = 0
+        try:
+            while sent < len(image):
+                sock.sendall(image[sent:sent + CHUNK_SIZE])
+                sent = min(sent + CHUNK_SIZE, len(image))
+                print("\r已发送 %d/%d 字节 (%d%%)" % (sent, len(image), sent * 100 // len(image)), end="",
+                      flush=True)
+        except OSError:
+            # 设备拒绝 (如口令错误) 后关闭连接，回复可能已经到达
+            pass
+        print()
+        sock.settimeout(REPLY_TIMEOUT_S)
+        try:
+            reply = read_line(sock)
+        except OSError:
+            reply = ""
+    elapsed = time.monotonic() - start
+    return reply, elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="WiFly485 固件升级")
+    parser.add_argument("host")
+    parser.add_argument("firmware")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--password", default=os.environ.get("WIFLY485_OTA_PASSWORD"),
+                        help="升级口令 (device.otaPassword)")
+    args = parser.parse_args()
+    if not args.password:
+        print("需要升级口令: --password 或环境变量 WIFLY485_OTA_PASSWORD")
+        return 1
+
+    with open(args.firmware, "rb") as f:
+        image = f.read()
+    if not image or image[0] != 0xE9:
+        print("不是ESP8266固件映像: %s" % args.firmware)
+        return 1
+
+    reply, elapsed = upload(args.host, args.port, image, args.password)
+    print("%s (%.1f s, %.1f KB/s)" % (reply or "连接已关闭", elapsed, len(image) / 1024 / elapsed))
+    return 0 if reply == "OK" else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,235 @@
+"""性能和固件大小的回归检查：与提交的基线 (tools/perf_baseline.json) 比较，超出容差时失败。
+
+两类指标：
+- bench.<名称>.median_us：本机构建 ([env:native]) 的基准测试中位数，运行配置、日志、CRC和中继路径
+  (基线中的 bench_filter)，多次运行取最小值以减少主机调度的干扰
+- size.<环境>.<区域>_bytes：wifly485_master / wifly485_slave 固件ELF按地址统计的大小：
+  flash (写入闪存的映像)、irom (闪存中执行的代码)、iram (IRAM中的代码)、dram (静态RAM，含.bss)
+
+每个指标的上限 = 基线值 × (1 + tolerance_pct/100) + tolerance_abs，容差取基线的 defaults，
+单个指标可以覆盖。超出上限、或基线中的指标不再存在时退出码为1。没有基线值的指标 (新的基准测试、
+第一次在运行检查的主机上运行、第一次用工具链生成固件大小) 把当前结果记录为基线并通过，
+基线只在运行检查的同一台机器上生成，不比较其他主机的结果。
+
+用法:
+  pio run -e native -e wifly485_master -e wifly485_slave
+  python3 tools/perf_gate.py                  # 检查
+  python3 tools/perf_gate.py --update         # 接受当前结果作为新的基线 (保留容差设置)
+  python3 tools/perf_gate.py --update --no-bench   # 只写入固件大小的基线
+  python3 tools/perf_gate.py --no-size        # 只检查基准测试 (没有ESP8266工具链时)
+  python3 tools/perf_gate.py --bench-output bench.txt   # 使用已有的基准测试输出 (如设备串口日志)
+"""
+
+import argparse
+import json
+import os
+import struct
+import subprocess
+import sys
+
+DEFAULT_BASELINE = os.path.join("tools", "perf_baseline.json")
+DEFAULT_PROGRAM = os.path.join(".pio", "build", "native", "program")
+DEFAULT_BUILD_DIR = os.path.join(".pio", "build")
+BENCH_PREFIX = '{"type":"benchmark"'
+
+# ESP8266地址空间 (与链接脚本一致)
+DRAM_RANGE = (0x3FF00000, 0x40000000)
+IRAM_RANGE = (0x40100000, 0x40200000)
+IROM_START = 0x40200000
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+def run_benchmarks(program, bench_filter, runs):
+    """运行本机基准测试，返回 {名称: 各次运行中最小的中位数}"""
+    results = {}
+    for _ in range(runs):
+        proc = subprocess.run([program, "b " + bench_filter, "q"], stdout=subprocess.PIPE,
+                              stderr=subprocess.DEVNULL, universal_newlines=True, check=False)
+        if proc.returncode != 0:
+            raise RuntimeError("基准测试程序退出码 %d: %s" % (proc.returncode, program))
+        parse_benchmarks(proc.stdout.splitlines(), results)
+    return results
+
+
+def parse_benchmarks(lines, results):
+    for line in lines:
+        line = line.strip()
+        if not line.startswith(BENCH_PREFIX):
+            continue
+        record = json.loads(line)
+        name = record["name"]
+        results[name] = min(results.get(name, record["median_us"]), record["median_us"])
+    return results
+
+
+def elf_sizes(path):
+    """按地址统计ELF中分配了内存的节 (不依赖工具链的size命令)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise RuntimeError("不是32位小端ELF文件: %s" % path)
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+    sizes = {"flash": 0, "irom": 0, "iram": 0, "dram": 0}
+    for i in range(shnum):
+        _, sh_type, flags, addr, _, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+        if not flags & SHF_ALLOC or size == 0:
+            continue
+        if sh_type != SHT_NOBITS:
+            sizes["flash"] += size
+        if addr >= IROM_START:
+            sizes["irom"] += size
+        elif IRAM_RANGE[0] <= addr < IRAM_RANGE[1]:
+            sizes["iram"] += size
+        elif DRAM_RANGE[0] <= addr < DRAM_RANGE[1]:
+            sizes["dram"] += size
+    return sizes
+
+
+def collect_sizes(build_dir, envs):
+    metrics = {}
+    for env in envs:
+        path = os.path.join(build_dir, env, "firmware.elf")
+        if not os.path.exists(path):
+            raise RuntimeError("找不到 %s (先运行 pio run -e %s，或使用 --no-size)" % (path, env))
+        for region, size in elf_sizes(path).items():
+            metrics["size.%s.%s_bytes" % (env, region)] = size
+    return metrics
+
+
+def limit_for(name, entry, defaults):
+    kind = defaults.get(name.split(".", 1)[0], {})
+    pct = entry.get("tolerance_pct", kind.get("tolerance_pct", 0))
+    absolute = entry.get("tolerance_abs", kind.get("tolerance_abs", 0))
+    return entry["value"] * (1 + pct / 100.0) + absolute
+
+
+def format_value(value):
+    return "%d" % value if isinstance(value, int) else "%.3f" % value
+
+
+def compare(baseline, current, checked_kinds):
+    """输出对比表，返回 (退化和缺失的指标数, 没有基线值而记录的指标)"""
+    defaults = baseline.get("defaults", {})
+    metrics = baseline.get("metrics", {})
+    rows = []
+    failures = 0
+    recorded = {}
+    for name in sorted(set(metrics) | set(current)):
+        if name.split(".", 1)[0] not in checked_kinds:
+            continue
+        entry = metrics.get(name)
+        value = current.get(name)
+        if entry is None or "value" not in entry:
+            # 条目可以只有容差设置，基线值在第一次运行时记录
+            if value is not None:
+                rows.append((name, "-", format_value(value), "", "", "记录"))
+                recorded[name] = value
+            continue
+        if value is None:
+            rows.append((name, format_value(entry["value"]), "-", "", "", "缺失"))
+            failures += 1
+            continue
+        limit = limit_for(name, entry, defaults)
+        base = entry["value"]
+        change = "%+.1f%%" % ((value - base) * 100.0 / base) if base else "%+g" % (value - base)
+        if value > limit:
+            status = "退化"
+            failures += 1
+        elif value < base and limit_for(name, dict(entry, value=value), defaults) < base:
+            status = "改善"   # 超出容差的改善：可以用 --update 收紧基线
+        else:
+            status = "ok"
+        rows.append((name, format_value(base), format_value(value), change, format_value(limit), status))
+
+    headers = ("指标", "基线", "当前", "变化", "上限", "结果")
+    widths = [max(len(headers[i]), *(len(row[i]) for row in rows)) if rows else len(headers[i])
+              for i in range(len(headers))]
+    print("  ".join(h.ljust(w) if i == 0 else h.rjust(w) for i, (h, w) in enumerate(zip(headers, widths))))
+    for row in rows:
+        marker = "!" if row[5] in ("退化", "缺失") else " "
+        print("  ".join(c.ljust(w) if i == 0 else c.rjust(w) for i, (c, w) in enumerate(zip(row, widths))), marker)
+    return failures, recorded
+
+
+def write_baseline(path, baseline):
+    with open(path, "w") as f:
+        json.dump(baseline, f, indent=2, ensure_ascii=False, sort_keys=True)
+        f.write("\n")
+
+
+def record_baseline(path, baseline, recorded):
+    """只写入没有基线值的指标，已有的基线不变"""
+    metrics = baseline.setdefault("metrics", {})
+    for name, value in recorded.items():
+        metrics.setdefault(name, {})["value"] = value
+    write_baseline(path, baseline)
+    print("已把 %d 个没有基线的指标记录到 %s (提交该文件以固定基线)" % (len(recorded), path))
+
+
+def update_baseline(path, baseline, current, checked_kinds):
+    metrics = baseline.setdefault("metrics", {})
+    # 本次检查的类别中已不存在的指标 (改名或删除的基准测试) 从基线中移除
+    for name in list(metrics):
+        if name.split(".", 1)[0] in checked_kinds and name not in current:
+            del metrics[name]
+    for name, value in current.items():
+        entry = metrics.setdefault(name, {})
+        entry["value"] = value
+    write_baseline(path, baseline)
+    print("已更新基线 %s (%d 个指标)" % (path, len(current)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="WiFly485 性能和固件大小回归检查")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE)
+    parser.add_argument("--program", default=DEFAULT_PROGRAM, help="本机构建的测试程序")
+    parser.add_argument("--runs", type=int, default=3, help="基准测试运行次数 (取最小的中位数)")
+    parser.add_argument("--bench-output", help="使用已有的基准测试输出 (JSON行) 代替运行测试程序")
+    parser.add_argument("--build-dir", default=DEFAULT_BUILD_DIR)
+    parser.add_argument("--no-bench", action="store_true", help="不检查基准测试")
+    parser.add_argument("--no-size", action="store_true", help="不检查固件大小")
+    parser.add_argument("--update", action="store_true", help="把当前结果写入基线")
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+    current = {}
+    kinds = set()
+    try:
+        if not args.no_bench:
+            if args.bench_output:
+                with open(args.bench_output) as f:
+                    results = parse_benchmarks(f, {})
+            else:
+                results = run_benchmarks(args.program, baseline.get("bench_filter", ""), args.runs)
+            for name, median in results.items():
+                current["bench.%s.median_us" % name] = median
+            kinds.add("bench")
+        if not args.no_size:
+            current.update(collect_sizes(args.build_dir, baseline.get("size_envs", [])))
+            kinds.add("size")
+    except (OSError, RuntimeError) as error:
+        print("错误: %s" % error)
+        return 2
+
+    if args.update:
+        update_baseline(args.baseline, baseline, current, kinds)
+        return 0
+
+    failures, recorded = compare(baseline, current, kinds)
+    if recorded:
+        print()
+        record_baseline(args.baseline, baseline, recorded)
+    if failures:
+        print("\n%d 个指标超出容差或缺失 (确认是预期的变化后用 --update 更新基线)" % failures)
+        return 1
+    print("\n全部指标在容差之内")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())